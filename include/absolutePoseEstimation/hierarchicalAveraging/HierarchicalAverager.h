@@ -0,0 +1,63 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#ifndef GDR_HIERARCHICALAVERAGER_H
+#define GDR_HIERARCHICALAVERAGER_H
+
+#include <vector>
+#include <Eigen/Eigen>
+
+#include "parametrization/SE3.h"
+#include "parametrization/SO3.h"
+
+#include "absolutePoseEstimation/rotationAveraging/RotationAverager.h"
+#include "absolutePoseEstimation/rotationAveraging/RotationMeasurement.h"
+#include "absolutePoseEstimation/translationAveraging/TranslationMeasurement.h"
+
+namespace gdr {
+
+    /** Rotation and translation averaging for large pose graphs split into clusters:
+     *      each cluster is averaged independently in parallel with its own gauge,
+     *      then gauges of clusters are found from inter-cluster measurements and results are stitched
+     */
+    class HierarchicalAverager {
+
+    public:
+        HierarchicalAverager() = delete;
+
+        /**
+         * @param relativeRotations relative rotation measurements, only pairs with indexFrom < indexTo are used
+         * @param indexPoseFixed index of pose with identity rotation
+         * @param clusterByPose cluster index of each pose, poses of each cluster should form connected subgraph
+         * @param averagingTypeInsideCluster method of rotation averaging used inside each cluster
+         *
+         * @returns absolute rotations of all poses
+         */
+        static std::vector<SO3> averageRotations(
+                const std::vector<RotationMeasurement> &relativeRotations,
+                int indexPoseFixed,
+                const std::vector<int> &clusterByPose,
+                const RotationAverager::RotationAveragingType &averagingTypeInsideCluster =
+                RotationAverager::RotationAveragingType::CHORDAL_SHONAN);
+
+        /**
+         * @param relativeTranslations relative translation measurements with indexFrom < indexTo
+         * @param absolutePoses poses with already computed rotations
+         * @param indexPoseFixed index of pose with zero translation
+         * @param clusterByPose cluster index of each pose, poses of each cluster should form connected subgraph
+         * @param numberOfIterationsIRLS number of IRLS iterations used inside clusters and for cluster alignment
+         *
+         * @returns absolute translations of all poses
+         */
+        static std::vector<Eigen::Vector3d> averageTranslations(
+                const std::vector<TranslationMeasurement> &relativeTranslations,
+                const std::vector<SE3> &absolutePoses,
+                int indexPoseFixed,
+                const std::vector<int> &clusterByPose,
+                int numberOfIterationsIRLS = 5);
+    };
+}
+
+#endif
@@ -0,0 +1,43 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#ifndef GDR_POSEGRAPHPARTITIONER_H
+#define GDR_POSEGRAPHPARTITIONER_H
+
+#include <vector>
+
+namespace gdr {
+
+    /** Splits pose graph into clusters of bounded size with METIS k-way partitioning */
+    class PoseGraphPartitioner {
+
+    public:
+        PoseGraphPartitioner() = delete;
+
+        /**
+         * @param numberOfPoses number of vertices in pose graph
+         * @param edges pairs of connected pose indices, each undirected edge can be listed several times
+         * @param edgeWeights positive weights of edges (for example number of inlier matches),
+         *      edges with bigger weights are less likely to be cut, can be empty
+         * @param maxPosesPerCluster desired upper bound of cluster size, number of clusters is
+         *      ceil(numberOfPoses / maxPosesPerCluster)
+         *
+         * @returns cluster index for each pose, clusters are numbered from 0
+         *      and poses of each cluster form connected subgraph
+         */
+        static std::vector<int> partition(int numberOfPoses,
+                                          const std::vector<std::pair<int, int>> &edges,
+                                          const std::vector<int> &edgeWeights,
+                                          int maxPosesPerCluster);
+
+        /**
+         * @param clusterByPose cluster index for each pose
+         * @returns pose indices of each cluster in increasing order
+         */
+        static std::vector<std::vector<int>> getPosesByCluster(const std::vector<int> &clusterByPose);
+    };
+}
+
+#endif
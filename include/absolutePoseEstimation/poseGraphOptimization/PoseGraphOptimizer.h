@@ -0,0 +1,75 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#ifndef GDR_POSEGRAPHOPTIMIZER_H
+#define GDR_POSEGRAPHOPTIMIZER_H
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <ceres/ceres.h>
+
+#include "parametrization/SE3.h"
+#include "parametrization/RelativeSE3.h"
+
+namespace gdr {
+
+    /** Robust SE(3) pose graph optimization over relative pose measurements,
+     *      cheap global refinement of rotation and translation averaging results without landmarks.
+     *
+     *      Each measurement is weighted by its number of inliers and translation error spread
+     *      relative to median values over the graph, so a typical measurement has unit weight.
+     */
+    class PoseGraphOptimizer {
+
+        int numberOfThreads = static_cast<int>(std::thread::hardware_concurrency());
+        int iterations = 50;
+        ceres::LinearSolverType linearSolverType = ceres::SPARSE_NORMAL_CHOLESKY;
+
+        // expected errors of a typical relative pose measurement
+        double deviationRotation = 0.01;
+        double deviationTranslation = 0.02;
+
+        std::string solverInfo;
+
+    public:
+
+        /**
+         * @param posesCameraToWorld initial camera to world poses
+         * @param relativePoses measurements T_from^{-1} * T_to, each pair of poses should be used once
+         * @param indexFixed index of the pose which is not changed
+         * @param[out] success is true if solution is usable
+         *
+         * @returns optimized camera to world poses
+         */
+        std::vector<SE3> getOptimizedPoses(const std::vector<SE3> &posesCameraToWorld,
+                                           const std::vector<RelativeSE3> &relativePoses,
+                                           int indexFixed,
+                                           bool &success);
+
+        /**
+         * @returns description of solver configuration and timing of the last optimization
+         */
+        std::string getSolverInfo() const;
+
+        /**
+         * @param deviationRotationToSet expected rotation error of typical measurement in radians
+         * @param deviationTranslationToSet expected translation error of typical measurement in meters
+         */
+        void setDeviations(double deviationRotationToSet, double deviationTranslationToSet);
+
+        void setNumberOfThreads(int numberOfThreadsToSet);
+
+        void setMaxNumberIterations(int iterationsNumber);
+
+        /**
+         * @param linearSolverTypeToSet ceres linear solver, SPARSE_NORMAL_CHOLESKY is default
+         */
+        void setLinearSolver(const ceres::LinearSolverType &linearSolverTypeToSet);
+    };
+}
+
+#endif
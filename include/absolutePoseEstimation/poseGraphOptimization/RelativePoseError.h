@@ -0,0 +1,82 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#ifndef GDR_RELATIVEPOSEERROR_H
+#define GDR_RELATIVEPOSEERROR_H
+
+#include <ceres/ceres.h>
+#include <sophus/so3.hpp>
+
+#include "parametrization/SE3.h"
+
+namespace gdr {
+
+    /** Error of relative pose T_from^{-1} * T_to measurement between camera to world poses:
+     *      rotation part is 2 * log(R_measured * (R_from^{-1} * R_to)^{-1}) multiplied by rotation weight,
+     *      translation part is R_from^{-1} * (t_to - t_from) - t_measured multiplied by translation weight
+     *
+     *      Parameter blocks are translation (tx, ty, tz) and orientation (qx, qy, qz, qw) of pose "from"
+     *      and then of pose "to".
+     */
+    class RelativePoseError {
+
+    private:
+        SE3 relativePose;
+
+        double weightRotation;
+        double weightTranslation;
+
+    public:
+
+        /**
+         * @param relativePoseToSet measured relative pose T_from^{-1} * T_to
+         * @param weightRotationToSet inverse standard deviation of rotation error in radians
+         * @param weightTranslationToSet inverse standard deviation of translation error in meters
+         */
+        RelativePoseError(const SE3 &relativePoseToSet,
+                          double weightRotationToSet,
+                          double weightTranslationToSet);
+
+        template<typename T>
+        bool operator()(const T *const translationFrom,
+                        const T *const orientationFrom,
+                        const T *const translationTo,
+                        const T *const orientationTo,
+                        T *residuals) const {
+
+            Eigen::Map<const Eigen::Matrix<T, 3, 1>> tFrom(translationFrom);
+            Eigen::Map<const Eigen::Quaternion<T>> qFrom(orientationFrom);
+            Eigen::Map<const Eigen::Matrix<T, 3, 1>> tTo(translationTo);
+            Eigen::Map<const Eigen::Quaternion<T>> qTo(orientationTo);
+
+            Eigen::Quaternion<T> relativeRotationComputed = qFrom.inverse() * qTo;
+            Eigen::Matrix<T, 3, 1> relativeTranslationComputed = qFrom.inverse() * (tTo - tFrom);
+
+            Eigen::Quaterniond relativeRotationQuaternion = relativePose.getRotationQuatd();
+            Eigen::Quaternion<T> relRotMeasured(T(relativeRotationQuaternion.w()),
+                                                T(relativeRotationQuaternion.x()),
+                                                T(relativeRotationQuaternion.y()),
+                                                T(relativeRotationQuaternion.z()));
+            Eigen::Matrix<T, 3, 1> relTranslationMeasured = relativePose.getTranslation().template cast<T>();
+
+            Eigen::Quaternion<T> relRotRes = relRotMeasured * relativeRotationComputed.inverse();
+            Sophus::SO3<T> quatErrorSophus(relRotRes.normalized().toRotationMatrix());
+
+            Eigen::Map<Eigen::Matrix<T, 6, 1>> residualsM(residuals);
+
+            residualsM.template block<3, 1>(0, 0) = T(2.0 * weightRotation) * quatErrorSophus.log();
+            residualsM.template block<3, 1>(3, 0) =
+                    T(weightTranslation) * (relativeTranslationComputed - relTranslationMeasured);
+
+            return true;
+        }
+
+        static ceres::CostFunction *Create(const SE3 &relativePose,
+                                           double weightRotation,
+                                           double weightTranslation);
+    };
+}
+
+#endif
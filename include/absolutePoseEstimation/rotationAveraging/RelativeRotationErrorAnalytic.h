@@ -0,0 +1,38 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#ifndef GDR_RELATIVEROTATIONERRORANALYTIC_H
+#define GDR_RELATIVEROTATIONERRORANALYTIC_H
+
+#include <ceres/ceres.h>
+
+#include "parametrization/SO3.h"
+
+namespace gdr {
+
+    /** Same residual as RelativeRotationError: 2 * log(R_measured * (R_from^-1 * R_to)^-1)
+     *      with analytic Jacobians. Jacobians are computed with respect to quaternion coordinates
+     *      qx, qy, qz, qw such that their product with Jacobian of ceres::EigenQuaternionParameterization
+     *      is the exact Jacobian in tangent space
+     */
+    class RelativeRotationErrorAnalytic : public ceres::SizedCostFunction<3, 4, 4> {
+
+    private:
+        Eigen::Quaterniond relativeRotationMeasured;
+
+    public:
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+        explicit RelativeRotationErrorAnalytic(const SO3 &relativeRotationToSet);
+
+        bool Evaluate(double const *const *parameters,
+                      double *residuals,
+                      double **jacobians) const override;
+
+        static ceres::CostFunction *Create(const SO3 &relativeRotation);
+    };
+}
+
+#endif
@@ -18,13 +18,94 @@ namespace gdr {
     class RotationAverager {
 
     public:
+        enum class RotationAveragingType {
+            /** Shonan averaging from random initialization */
+            SHONAN,
+            /** spanning tree initialization refined by linear chordal relaxation */
+            CHORDAL,
+            /** Shonan averaging warm started with chordal relaxation solution */
+            CHORDAL_SHONAN
+        };
+
+        enum class ShonanStartStatus {
+            /** run reached certified global optimum */
+            CERTIFIED,
+            /** run reached maximum level without certificate */
+            NOT_CERTIFIED,
+            /** run was stopped because other run was certified, its partial solution is discarded */
+            CANCELLED
+        };
+
+        /**
+         * Compute absolute rotations with Shonan averaging, measurements are passed to gtsam directly
+         * @param relativeRotations relative rotation measurements, only pairs with indexFrom < indexTo are used
+         * @param indexPoseFixed index of pose with identity rotation
+         * @param pathToRelativeRotationsOut if not empty relative rotations are also dumped
+         *      to this file in g2o format for debugging
+         * @param maxDimension maximum level of Shonan averaging
+         * @param initialRotations initial guess for absolute rotations, random initialization is used if empty
+         * @param numberOfStarts number of Shonan runs executed concurrently: the first one starts from
+         *      initialRotations (if not empty) and the others from different random initializations,
+         *      when one run reaches certified global optimum the remaining runs are cancelled,
+         *      cancellation is checked only before each Shonan level, so a level being optimized is not interrupted
+         * @param statusByStart[out] if not null, filled with status of each run
+         *
+         * @returns absolute rotations of all poses
+         */
         static std::vector<SO3>
         shanonAveraging(
                 const std::vector<RotationMeasurement> &relativeRotations,
                 int indexPoseFixed,
-                const std::string &pathToRelativeRotationsOut = "default_relative_rotations_file.txt",
-                int maxDimension = 10);
+                const std::string &pathToRelativeRotationsOut = "",
+                int maxDimension = 10,
+                const std::vector<SO3> &initialRotations = std::vector<SO3>(),
+                int numberOfStarts = 1,
+                std::vector<ShonanStartStatus> *statusByStart = nullptr);
+
+        /**
+         * Compute absolute rotations by composing relative rotations along maximum weight spanning tree
+         * @param relativeRotations relative rotation measurements, only pairs with indexFrom < indexTo are used,
+         *      weight of each measurement is used as edge weight
+         * @param indexPoseFixed index of pose with identity rotation, root of spanning tree
+         *
+         * @returns absolute rotations of all poses
+         */
+        static std::vector<SO3>
+        spanningTreeInitialization(
+                const std::vector<RotationMeasurement> &relativeRotations,
+                int indexPoseFixed);
 
+        /**
+         * Compute absolute rotations with weighted chordal relaxation: relaxed rotation matrices are found
+         *      as linear least squares solution and projected to SO3, sparse solver is warm started
+         *      with spanning tree initialization
+         * @param relativeRotations relative rotation measurements, only pairs with indexFrom < indexTo are used
+         * @param indexPoseFixed index of pose with identity rotation
+         *
+         * @returns absolute rotations of all poses
+         */
+        static std::vector<SO3>
+        chordalAveraging(
+                const std::vector<RotationMeasurement> &relativeRotations,
+                int indexPoseFixed);
+
+        /**
+         * Compute absolute rotations with chosen averaging method
+         * @param relativeRotations relative rotation measurements, only pairs with indexFrom < indexTo are used
+         * @param indexPoseFixed index of pose with identity rotation
+         * @param averagingType method of rotation averaging
+         * @param pathToRelativeRotationsOut if not empty relative rotations are dumped to this file in g2o format
+         * @param numberOfShonanStarts number of concurrent Shonan runs from different initializations
+         *
+         * @returns absolute rotations of all poses
+         */
+        static std::vector<SO3>
+        averageRotations(
+                const std::vector<RotationMeasurement> &relativeRotations,
+                int indexPoseFixed,
+                const RotationAveragingType &averagingType = RotationAveragingType::SHONAN,
+                const std::string &pathToRelativeRotationsOut = "",
+                int numberOfShonanStarts = 1);
     };
 }
 
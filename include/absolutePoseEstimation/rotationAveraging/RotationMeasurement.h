@@ -19,12 +19,15 @@ namespace gdr {
         int indexFromDestination;
         int indexToToBeTransformed;
 
+        double weight;
+
     public:
         EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 
         RotationMeasurement(const SO3 &relativeRotation,
                             int indexFromDestination,
-                            int indexToToBeTransformed);
+                            int indexToToBeTransformed,
+                            double weight = 1.0);
 
         const SO3 &getRotationSO3() const;
 
@@ -32,6 +35,9 @@ namespace gdr {
 
         int getIndexToToBeTransformed() const;
 
+        /** @returns measurement confidence, for example number of inlier correspondences between images */
+        double getWeight() const;
+
     };
 }
 
@@ -18,7 +18,10 @@ namespace gdr {
         RotationRobustOptimizerCreator() = delete;
 
         enum class RobustParameterType {
-            DEFAULT
+            /** ceres optimization with Cauchy loss */
+            DEFAULT,
+            /** L1 and IRLS averaging in Lie algebra with sparse linear solves */
+            L1_IRLS
         };
 
         static std::unique_ptr<RotationRobustOptimizer> getRefiner(const RobustParameterType &robustParameterType);
@@ -0,0 +1,59 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#ifndef GDR_ROTATIONROBUSTOPTIMIZERL1IRLS_H
+#define GDR_ROTATIONROBUSTOPTIMIZERL1IRLS_H
+
+#include <cmath>
+#include <vector>
+
+#include "parametrization/SO3.h"
+
+#include "absolutePoseEstimation/rotationAveraging/RotationMeasurement.h"
+#include "absolutePoseEstimation/rotationAveraging/RotationRobustOptimizer.h"
+
+namespace gdr {
+
+    /** Robust rotation averaging in Lie algebra: on each iteration absolute rotations are updated with
+     *      left-multiplied increments exp(w_i) found from linearized relations w_from - w_to = log(R_to R_rel^-1 R_from^-1)
+     *      as weighted least squares solution of sparse system.
+     *      First iterations use L1 weights 1/|r| and then Geman-McClure weights are used (IRLS)
+     */
+    class RotationRobustOptimizerL1IRLS : public RotationRobustOptimizer {
+
+        int numberOfIterationsL1 = 10;
+        int numberOfIterationsIRLS = 20;
+        double sigmaGemanMcClure = 5.0 * M_PI / 180.0;
+        double epsilonResidualL1 = 1e-6;
+        double thresholdUpdateConvergence = 1e-7;
+
+        /**
+         * Solve weighted linearized system for left-multiplied rotation increments
+         * @param orientations current estimate of absolute rotations
+         * @param relativeRotations relative rotation measurements
+         * @param indexFixed pose which orientation is not changed
+         * @param useL1Weights if true L1 weights are used, otherwise Geman-McClure weights
+         *
+         * @returns tangent space increments for all poses, zero for fixed pose
+         */
+        std::vector<Eigen::Vector3d> computeIncrements(const std::vector<SO3> &orientations,
+                                                       const std::vector<RotationMeasurement> &relativeRotations,
+                                                       int indexFixed,
+                                                       bool useL1Weights) const;
+
+    public:
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+        void setNumberOfIterations(int numberOfIterationsL1ToSet, int numberOfIterationsIRLSToSet);
+
+        void setSigmaGemanMcClure(double sigmaGemanMcClureToSet);
+
+        std::vector<SO3> getOptimizedOrientation(const std::vector<SO3> &orientations,
+                                                 const std::vector<RotationMeasurement> &pairWiseRotations,
+                                                 int indexFixed) override;
+    };
+}
+
+#endif
@@ -7,6 +7,7 @@
 #define GDR_ROTATIONROBUSTOPTIMIZERLOGSO3_H
 
 #include <map>
+#include <thread>
 
 #include <ceres/ceres.h>
 #include <ceres/rotation.h>
@@ -16,6 +17,7 @@
 #include "absolutePoseEstimation/rotationAveraging/RotationMeasurement.h"
 #include "absolutePoseEstimation/rotationAveraging/RotationRobustOptimizer.h"
 #include "absolutePoseEstimation/rotationAveraging/RelativeRotationError.h"
+#include "absolutePoseEstimation/rotationAveraging/RelativeRotationErrorAnalytic.h"
 
 namespace gdr {
 
@@ -24,9 +26,29 @@ namespace gdr {
         std::vector<SO3> orientations;
         std::vector<RotationMeasurement> relativeRotations;
 
+        bool useAnalyticJacobians = true;
+        int numberOfThreads = static_cast<int>(std::thread::hardware_concurrency());
+        ceres::LinearSolverType linearSolverType = ceres::SPARSE_NORMAL_CHOLESKY;
+        ceres::PreconditionerType preconditionerType = ceres::JACOBI;
+
     public:
         EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 
+        /**
+         * @param useAnalyticJacobiansToSet if false autodiff RelativeRotationError cost function is used
+         */
+        void setUseAnalyticJacobians(bool useAnalyticJacobiansToSet);
+
+        void setNumberOfThreads(int numberOfThreadsToSet);
+
+        /**
+         * @param linearSolverTypeToSet ceres linear solver, SPARSE_NORMAL_CHOLESKY is default,
+         *      iterative CGNR solver can be used for huge pose graphs
+         * @param preconditionerTypeToSet preconditioner used by iterative solver
+         */
+        void setLinearSolver(const ceres::LinearSolverType &linearSolverTypeToSet,
+                             const ceres::PreconditionerType &preconditionerTypeToSet = ceres::JACOBI);
+
         std::vector<SO3> getOptimizedOrientation(const std::vector<SO3> &orientations,
                                                  const std::vector<RotationMeasurement> &pairWiseRotations,
                                                  int indexFixed) override;
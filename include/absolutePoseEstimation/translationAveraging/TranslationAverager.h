@@ -12,14 +12,28 @@
 #include <Eigen/Eigen>
 #include <vector>
 #include <map>
+#include <memory>
 
 #include "TranslationMeasurement.h"
+#include "TranslationNormalEquationsSolver.h"
 #include "parametrization/Vectors3d.h"
 
 namespace gdr {
 
     class TranslationAverager {
 
+    public:
+        enum class TranslationSolverType {
+            /** LSCG on weighted system W A x = W b rebuilt at each IRLS iteration */
+            LEAST_SQUARES_CG,
+            /** sparse Cholesky on normal equations with symbolic factorization reused between IRLS iterations */
+            SPARSE_CHOLESKY,
+            /** matrix-free block-Jacobi PCG on normal equations warm started from previous IRLS solution */
+            BLOCK_JACOBI_PCG
+        };
+
+    private:
+
         static SparseMatrixd constructSparseMatrix(const std::vector<TranslationMeasurement> &relativeTranslations,
                                                    const std::vector<SE3> &absolutePoses,
                                                    int indexPoseFixed);
@@ -36,7 +50,23 @@ namespace gdr {
                                  bool useInitialGuess = false,
                                  Vectors3d initialGuessX = Vectors3d());
 
-        static SparseMatrixd getWeightMatrixRaw(const std::vector<double> &weights,
+        static std::unique_ptr<TranslationNormalEquationsSolver> getNormalEquationsSolver(
+                const std::vector<TranslationMeasurement> &relativeTranslations,
+                int numberOfPoses,
+                int indexPoseFixed,
+                const TranslationSolverType &solverType);
+
+        /** @returns weights of measurements computed from pairwise estimation statistics,
+         *      weights of measurements with known statistics have mean 1 */
+        static std::vector<double> getMeasurementWeights(
+                const std::vector<TranslationMeasurement> &relativeTranslations);
+
+        static std::vector<double> getWeightsRaw(const std::vector<double> &residualNorms,
+                                                 const std::vector<double> &measurementWeights,
+                                                 double epsilonWeightMin);
+
+        static SparseMatrixd getWeightMatrixRaw(const std::vector<double> &residualNorms,
+                                                const std::vector<double> &measurementWeights,
                                                 double epsilonWeightMin);
 
         static Vectors3d
@@ -44,10 +74,21 @@ namespace gdr {
              const Vectors3d &b,
              SparseMatrixd &weightDiagonalMatrix,
              const Vectors3d &translationsGuess,
+             const std::vector<double> &measurementWeights,
              bool &success,
              int numOfIterations,
              double epsilonIRLS);
 
+        static Vectors3d
+        IRLSNormalEquations(const SparseMatrixd &systemMatrix,
+                            const Vectors3d &b,
+                            TranslationNormalEquationsSolver &normalEquationsSolver,
+                            const Vectors3d &translationsGuess,
+                            const std::vector<double> &measurementWeights,
+                            bool &success,
+                            int numOfIterations,
+                            double epsilonIRLS);
+
         static std::vector<TranslationMeasurement> getInversedTranslationMeasurements(
                 const std::vector<TranslationMeasurement> &relativeTranslations,
                 const std::vector<SE3> &absolutePoses);
@@ -55,7 +96,8 @@ namespace gdr {
     public:
 
         /**
-         * Compute IRLS solution for sparse linear system
+         * Compute IRLS solution for sparse linear system,
+         *      IRLS weights are multiplied by weights from pairwise estimation statistics of measurements
          *
          * @param relativeTranslations contains given relative translations between poses
          * @param absolutePoses contains precomputed SE3 poses where SO3 rotations are already fixed
@@ -65,6 +107,7 @@ namespace gdr {
          * @param successIRLS[out] is true if IRLS did converge
          * @param numOfIterations max number of iterations
          * @param epsilonWeightIRLS is a value w such that all weights in weight matrix are less than 1/w
+         * @param solverType defines how weighted linear system is solved at each iteration
          * @returns IRLS solution
          */
         static Vectors3d
@@ -74,21 +117,25 @@ namespace gdr {
                                 int indexPoseFixed,
                                 bool &successIRLS,
                                 int numOfIterations = 5,
-                                double epsilonWeightIRLS = 1e-6);
+                                double epsilonWeightIRLS = 1e-6,
+                                const TranslationSolverType &solverType =
+                                TranslationSolverType::SPARSE_CHOLESKY);
 
         /**
-         * Compute L2-solution for sparse linear problem
+         * Compute L2-solution for sparse linear problem weighted by pairwise estimation statistics of measurements
          *
          * @param relativeTranslations contains given relative translations between poses
          * @param absolutePoses contains precomputed SE3 poses where SO3 rotations are already fixed
          *      and translations are not currently utilized
+         * @param solverType defines how linear system is solved
          *
          * @returns L2 solution
          */
         static Vectors3d
         recoverTranslations(const std::vector<TranslationMeasurement> &relativeTranslations,
                             const std::vector<SE3> &absolutePoses,
-                            int indexPoseFixed);
+                            int indexPoseFixed,
+                            const TranslationSolverType &solverType = TranslationSolverType::SPARSE_CHOLESKY);
     };
 }
 
@@ -8,6 +8,8 @@
 
 #include <Eigen/Eigen>
 
+#include "parametrization/RelativePoseQuality.h"
+
 namespace gdr {
 
     class TranslationMeasurement {
@@ -17,18 +19,24 @@ namespace gdr {
         int indexFrom;
         int indexTo;
 
+        RelativePoseQuality quality;
+
     public:
         EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 
         TranslationMeasurement(const Eigen::Vector3d &iranslation3d,
                                int indexFrom,
-                               int indexTo);
+                               int indexTo,
+                               const RelativePoseQuality &quality = RelativePoseQuality());
 
         const Eigen::Vector3d &getTranslation() const;
 
         int getIndexFromToBeTransformed() const;
 
         int getIndexToDestination() const;
+
+        /** @returns statistics of pairwise estimation used to weight this measurement */
+        const RelativePoseQuality &getQuality() const;
     };
 }
 #endif
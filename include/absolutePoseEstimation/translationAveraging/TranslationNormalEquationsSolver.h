@@ -0,0 +1,49 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#ifndef GDR_TRANSLATIONNORMALEQUATIONSSOLVER_H
+#define GDR_TRANSLATIONNORMALEQUATIONSSOLVER_H
+
+#include <vector>
+
+#include "parametrization/Vectors3d.h"
+
+namespace gdr {
+
+    /** Solves weighted translation averaging problem min sum w_i^2 ||t_from - t_to - b_i||^2
+     *      via normal equations A^T W^2 A x = A^T W^2 b.
+     *
+     *  Normal equations matrix is a Kronecker product of weighted pose graph Laplacian (without fixed pose)
+     *      and 3x3 identity, so implementations work with Laplacian
+     *      and solve x, y, z coordinates as three right hand sides.
+     *      Pose graph structure is fixed at construction, weights can change between solves.
+     */
+    class TranslationNormalEquationsSolver {
+
+    protected:
+        /** @returns index of pose in system without fixed pose, -1 for fixed pose */
+        static int getReducedIndex(int poseIndex, int indexPoseFixed);
+
+    public:
+
+        /**
+         * @param weights weight of each measurement residual, squared weights are used in normal equations
+         * @param b right hand side with one vector for each measurement
+         * @param initialGuess solution guess for iterative solvers, translations of all poses except fixed one,
+         *      can be empty
+         * @param solution[out] translations of all poses except fixed one
+         *
+         * @returns true if solve succeeded
+         */
+        virtual bool solve(const std::vector<double> &weights,
+                           const Vectors3d &b,
+                           const Vectors3d &initialGuess,
+                           Vectors3d &solution) = 0;
+
+        virtual ~TranslationNormalEquationsSolver() = default;
+    };
+}
+
+#endif
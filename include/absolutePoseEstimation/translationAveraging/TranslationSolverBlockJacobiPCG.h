@@ -0,0 +1,72 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#ifndef GDR_TRANSLATIONSOLVERBLOCKJACOBIPCG_H
+#define GDR_TRANSLATIONSOLVERBLOCKJACOBIPCG_H
+
+#include <vector>
+
+#include <Eigen/Eigen>
+
+#include "absolutePoseEstimation/translationAveraging/TranslationNormalEquationsSolver.h"
+#include "absolutePoseEstimation/translationAveraging/TranslationMeasurement.h"
+
+namespace gdr {
+
+    /** Matrix-free preconditioned conjugate gradient solver of translation averaging normal equations.
+     *      A^T W^2 A is never built: its product with a vector is computed from pose graph adjacency.
+     *      Preconditioner is inverse of 3x3 diagonal blocks of A^T W^2 A,
+     *      each block is sum of squared weights of measurements incident to pose times identity.
+     */
+    class TranslationSolverBlockJacobiPCG : public TranslationNormalEquationsSolver {
+
+        using MatrixX3d = Eigen::Matrix<double, Eigen::Dynamic, 3, Eigen::RowMajor>;
+
+        int numberOfPoses;
+        int indexPoseFixed;
+
+        int maxNumberOfIterations;
+        double tolerance;
+        int numberOfIterationsLastSolve = 0;
+
+        std::vector<std::pair<int, int>> reducedIndicesFromTo;
+
+        /** measurements incident to each not fixed pose in CSR format */
+        std::vector<int> incidentMeasurementsStarts;
+        std::vector<int> incidentMeasurements;
+
+        std::vector<double> weightsSquared;
+        Eigen::VectorXd diagonalInversed;
+
+        void computeLaplacianProduct(const MatrixX3d &x, MatrixX3d &result) const;
+
+        void computeRightHandSide(const Vectors3d &b, MatrixX3d &result) const;
+
+    public:
+
+        /**
+         * @param relativeTranslations measurements defining pose graph, only indices are used
+         * @param numberOfPosesToSet number of poses including fixed one
+         * @param indexPoseFixedToSet index of pose with zero translation
+         * @param maxNumberOfIterationsToSet max number of PCG iterations for each solve
+         * @param toleranceToSet PCG stops when residual norm is less than tolerance times norm of right hand side
+         */
+        TranslationSolverBlockJacobiPCG(const std::vector<TranslationMeasurement> &relativeTranslations,
+                                        int numberOfPosesToSet,
+                                        int indexPoseFixedToSet,
+                                        int maxNumberOfIterationsToSet = 1000,
+                                        double toleranceToSet = 1e-10);
+
+        /** PCG is started from initial guess if it is not empty and from zero otherwise */
+        bool solve(const std::vector<double> &weights,
+                   const Vectors3d &b,
+                   const Vectors3d &initialGuess,
+                   Vectors3d &solution) override;
+
+        int getNumberOfIterationsLastSolve() const;
+    };
+}
+
+#endif
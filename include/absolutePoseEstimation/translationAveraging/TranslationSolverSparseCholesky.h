@@ -0,0 +1,57 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#ifndef GDR_TRANSLATIONSOLVERSPARSECHOLESKY_H
+#define GDR_TRANSLATIONSOLVERSPARSECHOLESKY_H
+
+#include <array>
+#include <vector>
+
+#include <Eigen/Eigen>
+#include <Eigen/SparseCholesky>
+
+#include "absolutePoseEstimation/translationAveraging/TranslationMeasurement.h"
+#include "absolutePoseEstimation/translationAveraging/TranslationNormalEquationsSolver.h"
+
+namespace gdr {
+
+    /** Sparse Cholesky solver of translation averaging normal equations.
+     *      Sparsity pattern and symbolic factorization are computed once in constructor,
+     *      each solve with new weights does only numeric refactorization.
+     */
+    class TranslationSolverSparseCholesky : public TranslationNormalEquationsSolver {
+
+        int numberOfPoses;
+        int indexPoseFixed;
+
+        std::vector<std::pair<int, int>> reducedIndicesFromTo;
+
+        /** positions of (from, from), (to, to), (from, to), (to, from) Laplacian entries in its value array,
+         *      -1 if entry does not exist because one of the poses is fixed */
+        std::vector<std::array<int, 4>> valueIndicesByMeasurement;
+
+        SparseMatrixd laplacian;
+        Eigen::SimplicialLDLT<SparseMatrixd> choleskySolver;
+
+    public:
+
+        /**
+         * @param relativeTranslations measurements defining pose graph, only indices are used
+         * @param numberOfPosesToSet number of poses including fixed one
+         * @param indexPoseFixedToSet index of pose with zero translation
+         */
+        TranslationSolverSparseCholesky(const std::vector<TranslationMeasurement> &relativeTranslations,
+                                        int numberOfPosesToSet,
+                                        int indexPoseFixedToSet);
+
+        /** initial guess is not used by direct solver */
+        bool solve(const std::vector<double> &weights,
+                   const Vectors3d &b,
+                   const Vectors3d &initialGuess,
+                   Vectors3d &solution) override;
+    };
+}
+
+#endif
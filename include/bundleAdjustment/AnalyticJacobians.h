@@ -0,0 +1,43 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#ifndef GDR_ANALYTICJACOBIANS_H
+#define GDR_ANALYTICJACOBIANS_H
+
+#include <Eigen/Eigen>
+
+namespace gdr {
+
+    /** Rotation and projection formulas shared by residuals with analytic Jacobians.
+     *      Point is rotated with quaternion (u, w) as p + 2w (u x p) + 2 u x (u x p),
+     *      so derivatives with respect to quaternion (qx, qy, qz, qw) are valid for non-unit quaternions
+     *      which ceres passes between local parameterization updates.
+     */
+    class AnalyticJacobians {
+
+    public:
+        AnalyticJacobians() = delete;
+
+        static Eigen::Vector3d rotate(const Eigen::Quaterniond &orientation, const Eigen::Vector3d &point);
+
+        /** @returns derivative of rotated point with respect to point */
+        static Eigen::Matrix3d getRotatedPointByPoint(const Eigen::Quaterniond &orientation);
+
+        /** @returns derivative of rotated point with respect to quaternion (qx, qy, qz, qw) */
+        static Eigen::Matrix<double, 3, 4> getRotatedPointByOrientation(const Eigen::Quaterniond &orientation,
+                                                                        const Eigen::Vector3d &point);
+
+        /**
+         * @param pointCamera point in camera coordinates with positive depth
+         * @returns derivative of pixel coordinates (fx * x / z + cx, fy * y / z + cy) and depth z
+         *      with respect to point in camera coordinates
+         */
+        static Eigen::Matrix3d getProjectionDepthByPointCamera(const Eigen::Vector3d &pointCamera,
+                                                               double fx,
+                                                               double fy);
+    };
+}
+
+#endif
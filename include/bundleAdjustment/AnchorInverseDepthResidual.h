@@ -0,0 +1,43 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#ifndef GDR_ANCHORINVERSEDEPTHRESIDUAL_H
+#define GDR_ANCHORINVERSEDEPTHRESIDUAL_H
+
+#include <ceres/ceres.h>
+
+namespace gdr {
+
+    /** Residuals of the anchor observation of an inverse depth landmark:
+     *      (0, 0, (depth_observed - 1 / inverseDepth) / deviationDepth)
+     *
+     *      Landmark lies on the ray of the anchor keypoint, so its reprojection error is always zero
+     *      and only the depth measurement constrains the single parameter.
+     *      Zero residuals are kept so all observations have the same residual layout.
+     */
+    class AnchorInverseDepthResidual : public ceres::SizedCostFunction<3, 1> {
+
+        double observedDepth;
+        double deviationDepth;
+
+    public:
+
+        /**
+         * @param observedDepthToSet observed anchor keypoint depth in meters
+         * @param deviationDepthToSet expected standard deviation of depth error in meters
+         */
+        AnchorInverseDepthResidual(double observedDepthToSet,
+                                   double deviationDepthToSet);
+
+        bool Evaluate(double const *const *parameters,
+                      double *residuals,
+                      double **jacobians) const override;
+
+        static ceres::CostFunction *Create(double observedDepth,
+                                           double deviationDepth);
+    };
+}
+
+#endif
@@ -10,6 +10,7 @@
 #include "parametrization/Point3d.h"
 #include "cameraModel/CameraRGBD.h"
 #include "keyPoints/KeyPointInfo.h"
+#include <string>
 #include <unordered_map>
 
 namespace gdr {
@@ -35,6 +36,11 @@ namespace gdr {
 
         virtual std::vector<Point3d> getOptimizedPoints() const = 0;
 
+        /**
+         * @returns description of solver configuration and timing of the last optimization
+         */
+        virtual std::string getSolverInfo() const = 0;
+
         virtual ~BundleAdjuster() = default;
     };
 }
@@ -12,6 +12,7 @@
 
 #include "cameraModel/CameraRGBD.h"
 #include "keyPoints/KeyPointInfo.h"
+#include "keyPoints/KeyPointMatches.h"
 
 namespace gdr {
 
@@ -22,10 +23,25 @@ namespace gdr {
         BundleAdjusterCreator() = delete;
 
         enum class BundleAdjustmentType {
-            USE_DEPTH_INFO
+            USE_DEPTH_INFO,
+            USE_DEPTH_INFO_INVERSE_DEPTH_LANDMARKS,
+            // structure-less refinement, partitioning and outlier rejection rounds are not supported
+            POSES_ONLY_DEPTH_CORRESPONDENCES
         };
 
-        static std::unique_ptr<BundleAdjuster> getBundleAdjuster(const BundleAdjustmentType &bundleAdjustmentType);
+        /**
+         * @param bundleAdjustmentType type of optimized residuals
+         * @param maxPosesPerClusterPartitioned if positive and component is bigger, poses are split into clusters
+         *      of at most this size which are optimized in parallel and reconciled by consensus iterations
+         * @param maxRoundsOutlierRejection number of solves with outlier observations removed between them,
+         *      1 disables outlier rejection, ignored if optimization is partitioned
+         * @param inlierCorrespondences inlier keypoint matches used by poses only refinement,
+         *      should outlive the adjuster, ignored by other types
+         */
+        static std::unique_ptr<BundleAdjuster> getBundleAdjuster(const BundleAdjustmentType &bundleAdjustmentType,
+                                                                 int maxPosesPerClusterPartitioned = 0,
+                                                                 int maxRoundsOutlierRejection = 1,
+                                                                 const KeyPointMatches *inlierCorrespondences = nullptr);
     };
 }
 
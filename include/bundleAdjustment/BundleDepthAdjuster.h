@@ -6,6 +6,7 @@
 #ifndef GDR_BUNDLEDEPTHADJUSTER_H
 #define GDR_BUNDLEDEPTHADJUSTER_H
 
+#include <string>
 #include <vector>
 #include <unordered_map>
 #include <thread>
@@ -42,6 +43,8 @@ namespace gdr {
 
         std::vector<Point3d> getOptimizedPoints() const override;
 
+        std::string getSolverInfo() const override;
+
     private:
         static const int dimPoint = 3;
         static const int dimPose = 3;
@@ -55,6 +58,36 @@ namespace gdr {
         int maxNumberTreadsCeres = static_cast<int>(std::thread::hardware_concurrency());
         int iterations = 50;
 
+        bool selectLinearSolverBySize = true;
+        ceres::LinearSolverType linearSolverType = ceres::SPARSE_SCHUR;
+        ceres::PreconditionerType preconditionerType = ceres::JACOBI;
+
+        std::string solverInfo;
+        int numberOfIterationsLastOptimization = 0;
+
+        // pairs {pose index, point index} of observations removed by outlier rejection in the last optimization
+        std::vector<std::pair<int, int>> outlierObservationsLastOptimization;
+
+        // bundle adjustment is split into clusters optimized in parallel if number of poses exceeds this value,
+        // 0 disables partitioning
+        int maxPosesPerClusterPartitioned = 0;
+        int maxIterationsConsensus = 20;
+
+        // inverse square root of ADMM penalty: expected disagreement of shared point between clusters in meters
+        double deviationConsensus = 0.005;
+        double toleranceConsensus = 1e-4;
+
+        // observations with whitened reprojection or depth error above threshold are removed between rounds,
+        // 1 round means a single solve with robust loss only
+        int maxRoundsOutlierRejection = 1;
+        double thresholdOutlierRejection = 3.0;
+
+        // landmarks are optimized as inverse depth along the ray of their first observation instead of x, y, z
+        bool useInverseDepthParameterization = false;
+
+        // each observer of a point is connected with this number of next observers in covisibility graph
+        static constexpr int covisibilityWindow = 8;
+
         std::function<double(double)> computeInitialScaleByMedian =
                 [this](double medianError) {
 
@@ -67,23 +100,27 @@ namespace gdr {
 
                 };
 
-        // size of each vector is 3
-        // x, y, z
-        // 0, 1, 2
-        // contains point coordinates being optimized
-        std::vector<std::vector<double>> pointsXYZbyIndex;
+        // parameters being optimized are stored contiguously:
+        // x, y, z of each point
+        std::vector<double> pointsXYZ;
 
-        // size of each vector is 3:
-        // tx, ty, tz
-        // 0   1   2
-        // contains pose parameters being optimized
-        std::vector<std::vector<double>> poseWorldToCameraTxTyTzByPoseNumber;
+        // tx, ty, tz of each world to camera pose
+        std::vector<double> translationsWorldToCamera;
 
-        // size of each vector is 4:
-        // qx, qy, qz, qw
-        // 0   1   2    3
-        // contains camera orientation being optimized
-        std::vector<std::vector<double>> orientationWorldToCameraqxyzwByPoseNumber;
+        // qx, qy, qz, qw of each world to camera orientation
+        std::vector<double> orientationsWorldToCameraQxyzw;
+
+        // observations in CSR format sorted by pose and then by point index:
+        // observations of pose i are stored at [observationStartsByPose[i], observationStartsByPose[i + 1])
+        std::vector<int> observationStartsByPose;
+        std::vector<int> observationPointIndices;
+        std::vector<KeyPointInfo> observationKeyPointInfos;
+
+        // inverse depth parameterization of landmarks: one inverse depth value of each point,
+        // pose of the first observation of each point and this observation index
+        std::vector<double> inverseDepths;
+        std::vector<int> anchorPoseByPoint;
+        std::vector<int> anchorObservationByPoint;
 
         // size should be equal to number of poses
         // contains intrinsics camera parameters
@@ -104,6 +141,13 @@ namespace gdr {
         std::pair<std::vector<double>, std::vector<double>>
         getNormalizedErrorsReprojectionAndDepth(bool performNormalizing = true);
 
+        /** Kernel of getNormalizedErrorsReprojectionAndDepth instantiated with noise model policies of cameras,
+         *      NoiseModelFunction is used for custom models
+         */
+        template<class NoiseModelReprojection, class NoiseModelDepth>
+        std::pair<std::vector<double>, std::vector<double>>
+        getErrorsReprojectionAndDepth(bool performNormalizing);
+
         /** filter all errors and leave only those which satisfy |r_i/s_0| <= thresholdInlier
          *
          * @param r_n contains residues
@@ -135,149 +179,120 @@ namespace gdr {
         std::pair<double, double> getSigmaReprojectionAndDepth(double threshold = thresholdInlierDefault);
 
 
-        Sophus::SE3d getSE3TransformationMatrixByPoseNumber(int poseNumber) const;
-
-        Eigen::Vector3d getPointVector3dByPointGlobalIndex(int pointGlobalIndex) const;
-
-        Eigen::Vector4d getPointVector4dByPointGlobalIndex(int pointGlobalIndex) const;
-
-        std::vector<std::unordered_map<int, KeyPointInfo>> keyPointInfoByPoseNumberAndPointNumber;
-
-
-        struct DepthOnlyResidual {
-
-            template<typename T>
-            bool operator()(const T *const point,
-                            const T *const pose,
-                            const T *const orientation,
-                            T *residuals) const {
-
-                Sophus::Vector<T, 3> pointInLocalCoordinates =
-                        getPointLocalCameraSystemCoordinates<T>(point,
-                                                                pose,
-                                                                orientation);
-
-                T &computedDepth = pointInLocalCoordinates[2];
-
-                // depth error computation (noise modeled as sigma = a * depth^2 [meters])
-                {
-                    T normResidual = T(observedDepth) - computedDepth;
-                    normResidual = normResidual / T(deviationDividerDepth);
-                    residuals[0] = normResidual;
-                }
-
-                return true;
-            }
-
-            double observedDepth;
-
-            double deviationDividerDepth;
-
-            double deviationEstimationNormalizedDepth;
-
-            double medianResidualDepth;
-
-            const CameraRGBD &camera;
-
-            static ceres::CostFunction *Create(double newObservedDepth,
-                                               const CameraRGBD &camera,
-                                               double estNormalizedDepth,
-                                               double devDividerDepth,
-                                               double medianResDepth);
+        int getNumberOfPoses() const;
 
-            DepthOnlyResidual(double newObservedDepth,
-                              const CameraRGBD &cameraRgbd,
-                              double devNormalizedEstDepth,
-                              double devDividerDepth,
-                              double medianResDepth);
-        };
+        int getNumberOfPoints() const;
 
-        template<class T>
-        Sophus::Vector<T, 3> static getPointLocalCameraSystemCoordinates(
-                const T *const point,
-                const T *const poseWorldToCameraTranslation,
-                const T *const poseWorldToCameraOrientation) {
+        double *getPointData(int pointIndex);
 
-            Eigen::Map<const Sophus::SO3<T>> orientationWtoC(poseWorldToCameraOrientation);
-            Eigen::Map<const Sophus::Vector<T, 3>> translationWtoC(poseWorldToCameraTranslation);
+        double *getTranslationData(int poseIndex);
 
-            Eigen::Map<const Sophus::Vector<T, 3>> point3d(point);
-            Sophus::Vector<T, 3> pointCameraCoordinates = orientationWtoC * point3d + translationWtoC;
+        double *getOrientationData(int poseIndex);
 
-            return pointCameraCoordinates;
-        }
+        ceres::CostFunction *createReprojectionDepthCostFunction(int poseIndex,
+                                                                 int observation,
+                                                                 double sigmaReproj,
+                                                                 double sigmaDepth) const;
 
-        struct ReprojectionOnlyResidual {
+        /**
+         * @returns parameter blocks of observation residual in the order of its cost function
+         */
+        std::vector<double *> getParameterBlocksOfObservation(int poseIndex, int observation);
 
-            template<typename T>
-            bool operator()(const T *const point,
-                            const T *const poseTranslationWorldToCamera,
-                            const T *const poseOrientationWorldToCamera,
-                            T *residuals) const {
+        /** Choose anchor observation of each point and compute inverse depth of current point estimation */
+        void initializeInverseDepths();
 
-                Sophus::Vector<T, 3> pointInLocalCameraCoordinates =
-                        getPointLocalCameraSystemCoordinates<T>(point,
-                                                                poseTranslationWorldToCamera,
-                                                                poseOrientationWorldToCamera);
+        /** Write x, y, z of points computed from optimized inverse depths and anchor poses */
+        void updatePointsFromInverseDepths();
 
-                Sophus::Vector<T, 2> pointInImageCoordinatesNormalized =
-                        camera.projectUsingIntrinsics<T>(pointInLocalCameraCoordinates);
+        ceres::Solver::Options getSolverOptions(int numberOfPoses,
+                                                int numberOfPoints,
+                                                int numberOfObservations,
+                                                int numberOfThreads) const;
 
+        /** Optimize all poses and points as one ceres problem,
+         *      outlier observations are removed from the same problem between warm-started rounds
+         *
+         * @returns true if ceres solution is usable
+         */
+        bool optimizeSingleProblem(int indexFixed, double sigmaReproj, double sigmaDepth);
 
-                Eigen::Map<const Sophus::SO3<T>> orientationWorldToCamera(poseOrientationWorldToCamera);
-                Eigen::Map<const Sophus::Vector<T, 3>> translationWorldToCamera(poseTranslationWorldToCamera);
-                Eigen::Map<const Sophus::Vector<T, 3>> point3d(point);
+        /** Split poses into clusters by METIS partitioning of covisibility graph and optimize clusters in parallel,
+         *      points observed from several clusters are reconciled by consensus ADMM iterations
+         *
+         *      Only the cluster containing indexFixed has a constant pose. Other clusters are held in place
+         *      by consensus priors on their shared points, so their drift is bounded by the remaining
+         *      disagreement of shared points (max primal residual reported in solver info).
+         *
+         * @returns true if all ceres solutions are usable
+         */
+        bool optimizePartitioned(int indexFixed, double sigmaReproj, double sigmaDepth);
 
-                T &computedX = pointInImageCoordinatesNormalized[0];
-                T &computedY = pointInImageCoordinatesNormalized[1];
+        bool usePartitionedOptimization() const;
 
-                T resX = T(observedX) - computedX;
-                T resY = T(observedY) - computedY;
+        Sophus::SE3d getSE3TransformationMatrixByPoseNumber(int poseNumber) const;
 
-                residuals[0] = resX / T(deviationDividerReproj);
-                residuals[1] = resY / T(deviationDividerReproj);
+        Eigen::Vector3d getPointVector3dByPointGlobalIndex(int pointGlobalIndex) const;
 
-                return true;
-            }
+        Eigen::Vector4d getPointVector4dByPointGlobalIndex(int pointGlobalIndex) const;
 
-            double observedX;
-            double observedY;
-            double scaleKeyPoint;
+    public:
+        int getMaxNumberIterations() const;
 
-            double deviationDividerReproj;
+        int getMaxNumberThreads() const;
 
-            double deviationEstimationNormalizedReproj;
-            double medianResidualReproj;
-            double medianResidualDepth;
+        void setMaxNumberIterations(int iterationsNumber);
 
-            const CameraRGBD &camera;
+        void setMaxNumberThreads(int numberOfThreads);
 
-            static ceres::CostFunction *Create(double newObservedX,
-                                               double newObservedY,
-                                               double scale,
-                                               const CameraRGBD &camera,
-                                               double estNormalizedReproj,
-                                               double devDividerReproj,
-                                               double medianResReproj);
+        /** Disable automatic solver selection by problem size (see LinearSolverSelector)
+         *
+         * @param linearSolverTypeToSet ceres linear solver used for all following optimizations
+         * @param preconditionerTypeToSet preconditioner used by iterative solver
+         */
+        void setLinearSolver(const ceres::LinearSolverType &linearSolverTypeToSet,
+                             const ceres::PreconditionerType &preconditionerTypeToSet = ceres::JACOBI);
 
-            ReprojectionOnlyResidual(double newObservedX,
-                                     double newObservedY,
-                                     double scale,
-                                     const CameraRGBD &cameraRgbd,
-                                     double devNormalizedEstReproj,
-                                     double devDividerReproj,
-                                     double medianResReproj);
+        /** Enable automatic solver selection by problem size, it is enabled by default */
+        void setLinearSolverSelectionBySize();
 
-        };
+        /** Partitioned optimization is used only if number of poses exceeds cluster size,
+         *      it performs a single robust solve per cluster and consensus iteration without outlier rejection rounds.
+         *      Only the cluster containing the fixed pose has a constant pose, gauge of other clusters
+         *      is defined by consensus priors on points shared with neighbouring clusters,
+         *      so each cluster is assumed to share points with the rest of the graph
+         *
+         * @param maxPosesPerClusterToSet maximum number of poses in one cluster of partitioned bundle adjustment,
+         *      0 disables partitioning
+         * @param maxIterationsConsensusToSet maximum number of consensus iterations between clusters
+         */
+        void setPartitioning(int maxPosesPerClusterToSet, int maxIterationsConsensusToSet = 20);
 
-    public:
-        int getMaxNumberIterations() const;
+        /**
+         * @param maxRoundsToSet maximum number of solves, observations with big errors are removed after each one,
+         *      1 disables outlier rejection, ignored by partitioned optimization (see setPartitioning)
+         * @param thresholdToSet observation is an outlier if norm of its reprojection residual
+         *      or absolute value of depth residual divided by expected deviation exceeds this value
+         */
+        void setOutlierRejection(int maxRoundsToSet, double thresholdToSet = 3.0);
 
-        int getMaxNumberThreads() const;
+        /**
+         * @param useInverseDepthToSet true if each landmark should be optimized as one inverse depth value
+         *      along the ray of its first observation, partitioned optimization always uses x, y, z
+         */
+        void setInverseDepthParameterization(bool useInverseDepthToSet);
 
-        void setMaxNumberIterations(int iterationsNumber);
+        /**
+         * @returns number of ceres iterations of the last optimization summed over outlier rejection rounds,
+         *      number of consensus iterations if optimization was partitioned
+         */
+        int getNumberOfIterations() const;
 
-        void setMaxNumberThreads(int numberOfThreads);
+        /**
+         * @returns pairs {pose index, point index} of observations removed between outlier rejection rounds
+         *      of the last optimization, empty if outlier rejection is disabled
+         */
+        const std::vector<std::pair<int, int>> &getOutlierObservations() const;
 
     };
 }
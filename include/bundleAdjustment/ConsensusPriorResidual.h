@@ -0,0 +1,42 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#ifndef GDR_CONSENSUSPRIORRESIDUAL_H
+#define GDR_CONSENSUSPRIORRESIDUAL_H
+
+#include <ceres/ceres.h>
+
+namespace gdr {
+
+    /** Proximal term of consensus ADMM iteration for a 3D parameter block:
+     *      (x - target) / deviation
+     *
+     *      Target is read through a pointer on each evaluation, so the same residual block
+     *      is reused while consensus value and dual variable are updated between solves.
+     */
+    class ConsensusPriorResidual : public ceres::SizedCostFunction<3, 3> {
+
+        const double *target;
+        double deviation;
+
+    public:
+
+        /**
+         * @param targetToSet pointer to 3 values x should agree with, should outlive the residual
+         * @param deviationToSet inverse square root of ADMM penalty parameter
+         */
+        ConsensusPriorResidual(const double *targetToSet,
+                               double deviationToSet);
+
+        bool Evaluate(double const *const *parameters,
+                      double *residuals,
+                      double **jacobians) const override;
+
+        static ceres::CostFunction *Create(const double *target,
+                                           double deviation);
+    };
+}
+
+#endif
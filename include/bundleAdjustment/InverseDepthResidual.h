@@ -0,0 +1,79 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#ifndef GDR_INVERSEDEPTHRESIDUAL_H
+#define GDR_INVERSEDEPTHRESIDUAL_H
+
+#include <ceres/ceres.h>
+
+#include "cameraModel/CameraRGBD.h"
+
+namespace gdr {
+
+    /** Reprojection and depth residuals of one keypoint observation of an inverse depth landmark
+     *      with analytic Jacobians, residuals are the same as in ReprojectionDepthResidual.
+     *
+     *      Landmark lies on the ray of its anchor keypoint: point in anchor camera coordinates is
+     *      ((x_anchor - cx_anchor) / fx_anchor, (y_anchor - cy_anchor) / fy_anchor, 1) / inverseDepth.
+     *      Parameter blocks are inverse depth (1 value), anchor world to camera translation (tx, ty, tz)
+     *      and orientation (qx, qy, qz, qw), observing world to camera translation and orientation.
+     *      Observing pose should differ from anchor pose, see AnchorInverseDepthResidual.
+     */
+    class InverseDepthResidual : public ceres::SizedCostFunction<3, 1, 3, 4, 3, 4> {
+
+        Eigen::Vector3d rayAnchor;
+
+        double observedX;
+        double observedY;
+        double observedDepth;
+
+        double fx;
+        double fy;
+        double cx;
+        double cy;
+
+        double deviationReprojection;
+        double deviationDepth;
+
+    public:
+
+        /**
+         * @param anchorXToSet anchor keypoint x coordinate in pixels
+         * @param anchorYToSet anchor keypoint y coordinate in pixels
+         * @param anchorCamera intrinsics of anchor camera
+         * @param observedXToSet observed keypoint x coordinate in pixels
+         * @param observedYToSet observed keypoint y coordinate in pixels
+         * @param observedDepthToSet observed keypoint depth in meters
+         * @param camera intrinsics of observing camera
+         * @param deviationReprojectionToSet expected standard deviation of reprojection error in pixels
+         * @param deviationDepthToSet expected standard deviation of depth error in meters
+         */
+        InverseDepthResidual(double anchorXToSet,
+                             double anchorYToSet,
+                             const CameraRGBD &anchorCamera,
+                             double observedXToSet,
+                             double observedYToSet,
+                             double observedDepthToSet,
+                             const CameraRGBD &camera,
+                             double deviationReprojectionToSet,
+                             double deviationDepthToSet);
+
+        bool Evaluate(double const *const *parameters,
+                      double *residuals,
+                      double **jacobians) const override;
+
+        static ceres::CostFunction *Create(double anchorX,
+                                           double anchorY,
+                                           const CameraRGBD &anchorCamera,
+                                           double observedX,
+                                           double observedY,
+                                           double observedDepth,
+                                           const CameraRGBD &camera,
+                                           double deviationReprojection,
+                                           double deviationDepth);
+    };
+}
+
+#endif
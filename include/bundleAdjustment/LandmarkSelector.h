@@ -0,0 +1,74 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#ifndef GDR_LANDMARKSELECTOR_H
+#define GDR_LANDMARKSELECTOR_H
+
+#include <vector>
+#include <unordered_map>
+
+#include "parametrization/SE3.h"
+#include "parametrization/Point3d.h"
+#include "cameraModel/CameraRGBD.h"
+#include "keyPoints/KeyPointInfo.h"
+
+namespace gdr {
+
+    /** Chooses a subset of landmarks for bundle adjustment so its cost does not depend on texture density:
+     *      each pose requests a bounded number of landmarks, points with long tracks and small depth are preferred,
+     *      and landmarks of each pose are spread over cells of the image grid first
+     */
+    class LandmarkSelector {
+
+    public:
+        LandmarkSelector() = delete;
+
+        /**
+         * @param keyPointInfoByPose for each pose maps from observed point index to keypoint parameters
+         * @param numberOfPoints number of points, point indices are in [0, numberOfPoints)
+         * @param maxLandmarksPerPose number of landmarks requested by each pose,
+         *      pose can observe more landmarks requested by other poses
+         * @param imageWidth width of images in pixels
+         * @param imageHeight height of images in pixels
+         * @param cellsX number of grid cells along image width
+         * @param cellsY number of grid cells along image height
+         *
+         * @returns increasing indices of selected points
+         */
+        static std::vector<int> selectLandmarks(
+                const std::vector<std::unordered_map<int, KeyPointInfo>> &keyPointInfoByPose,
+                int numberOfPoints,
+                int maxLandmarksPerPose,
+                int imageWidth = 640,
+                int imageHeight = 480,
+                int cellsX = 8,
+                int cellsY = 6);
+
+        /**
+         * @param keyPointInfoByPose for each pose maps from observed point index to keypoint parameters
+         * @param selectedPoints increasing indices of selected points
+         *
+         * @returns keypoint maps where i-th selected point has index i, other observations are dropped
+         */
+        static std::vector<std::unordered_map<int, KeyPointInfo>> getKeyPointInfoOfSelectedLandmarks(
+                const std::vector<std::unordered_map<int, KeyPointInfo>> &keyPointInfoByPose,
+                const std::vector<int> &selectedPoints);
+
+        /** Compute coordinates of points as mean of their observations back-projected from refined poses
+         *
+         * @param points all points, only points from pointIndicesToUpdate are changed
+         * @param pointIndicesToUpdate indices of points to be recomputed
+         * @param posesCameraToWorld refined poses and camera intrinsics
+         * @param keyPointInfoByPose for each pose maps from observed point index to keypoint parameters
+         */
+        static void retriangulateLandmarks(
+                std::vector<Point3d> &points,
+                const std::vector<int> &pointIndicesToUpdate,
+                const std::vector<std::pair<SE3, CameraRGBD>> &posesCameraToWorld,
+                const std::vector<std::unordered_map<int, KeyPointInfo>> &keyPointInfoByPose);
+    };
+}
+
+#endif
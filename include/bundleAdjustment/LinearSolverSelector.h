@@ -0,0 +1,58 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#ifndef GDR_LINEARSOLVERSELECTOR_H
+#define GDR_LINEARSOLVERSELECTOR_H
+
+#include <utility>
+
+#include <ceres/ceres.h>
+
+namespace gdr {
+
+    /** Chooses ceres linear solver for bundle adjustment by the size of reduced camera system:
+     *      tiny problems or problems where almost every pair of poses shares points use DENSE_SCHUR,
+     *      medium problems use SPARSE_SCHUR,
+     *      large problems use ITERATIVE_SCHUR with CLUSTER_JACOBI preconditioner if visibility is sparse
+     *      and SCHUR_JACOBI otherwise
+     */
+    class LinearSolverSelector {
+
+    public:
+        static constexpr int maxPosesDenseSchur = 60;
+        static constexpr int maxPosesDenseSchurDenseVisibility = 250;
+        static constexpr int maxPosesSparseSchur = 1500;
+
+        // ratio of observations to (number of poses * number of points)
+        static constexpr double minVisibilityDensityDense = 0.2;
+        static constexpr double maxVisibilityDensityClusterJacobi = 0.05;
+
+        LinearSolverSelector() = delete;
+
+        /**
+         * @param numberOfPoses number of poses being optimized
+         * @param numberOfPoints number of points being optimized
+         * @param numberOfObservations number of point observations (residual blocks)
+         * @param isClusterPreconditionerAvailable is true if ceres was built with SuiteSparse
+         *      which is needed for CLUSTER_JACOBI
+         *
+         * @returns linear solver and preconditioner types
+         */
+        static std::pair<ceres::LinearSolverType, ceres::PreconditionerType>
+        getLinearSolverAndPreconditioner(int numberOfPoses,
+                                         int numberOfPoints,
+                                         int numberOfObservations,
+                                         bool isClusterPreconditionerAvailable);
+
+        /**
+         * @returns ratio of observations to (number of poses * number of points)
+         */
+        static double getVisibilityDensity(int numberOfPoses,
+                                           int numberOfPoints,
+                                           int numberOfObservations);
+    };
+}
+
+#endif
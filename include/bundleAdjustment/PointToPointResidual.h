@@ -0,0 +1,49 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#ifndef GDR_POINTTOPOINTRESIDUAL_H
+#define GDR_POINTTOPOINTRESIDUAL_H
+
+#include <Eigen/Eigen>
+#include <sophus/so3.hpp>
+#include <ceres/ceres.h>
+
+namespace gdr {
+
+    /** Difference of world coordinates of one 3D-3D correspondence between two frames with analytic Jacobians:
+     *      ((R_from * p_from + t_from) - (R_to * p_to + t_to)) / deviation
+     *
+     *      Parameter blocks are camera to world translation (tx, ty, tz) and orientation (qx, qy, qz, qw)
+     *      of the first frame and then of the second one.
+     */
+    class PointToPointResidual : public ceres::SizedCostFunction<3, 3, 4, 3, 4> {
+
+        Eigen::Vector3d pointFrom;
+        Eigen::Vector3d pointTo;
+
+        double deviation;
+
+    public:
+
+        /**
+         * @param pointFromToSet point in camera coordinates of the first frame
+         * @param pointToToSet the same point in camera coordinates of the second frame
+         * @param deviationToSet expected standard deviation of each coordinate of the difference in meters
+         */
+        PointToPointResidual(const Eigen::Vector3d &pointFromToSet,
+                             const Eigen::Vector3d &pointToToSet,
+                             double deviationToSet);
+
+        bool Evaluate(double const *const *parameters,
+                      double *residuals,
+                      double **jacobians) const override;
+
+        static ceres::CostFunction *Create(const Eigen::Vector3d &pointFrom,
+                                           const Eigen::Vector3d &pointTo,
+                                           double deviation);
+    };
+}
+
+#endif
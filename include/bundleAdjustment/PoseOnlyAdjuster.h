@@ -0,0 +1,89 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#ifndef GDR_POSEONLYADJUSTER_H
+#define GDR_POSEONLYADJUSTER_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <thread>
+
+#include "BundleAdjuster.h"
+#include "keyPoints/KeyPointInfo.h"
+#include "keyPoints/KeyPointMatches.h"
+#include "cameraModel/CameraRGBD.h"
+#include "parametrization/SE3.h"
+#include "parametrization/Point3d.h"
+
+namespace gdr {
+
+    /** Structure-less refinement of poses: only poses are optimized,
+     *      residuals are differences of world coordinates of back-projected 3D-3D inlier correspondences
+     *      weighted by depth and reprojection noise models of cameras.
+     *
+     *      Points are not optimized and are recomputed from refined poses after optimization.
+     */
+    class PoseOnlyAdjuster : public BundleAdjuster {
+
+        static const int dimPose = 3;
+        static const int dimOrientation = 4;
+
+        static constexpr double factor = 1.4826;
+
+        // normal equations of size 6N x 6N are factorized densely for small number of poses
+        static constexpr int maxPosesDenseNormalCholesky = 60;
+
+        int maxNumberTreadsCeres = static_cast<int>(std::thread::hardware_concurrency());
+        int iterations = 50;
+
+        // inlier matches of connected component with local pose indices, observations of points are used if not set
+        const KeyPointMatches *inlierCorrespondences = nullptr;
+
+        // tx, ty, tz of each camera to world pose
+        std::vector<double> translationsCameraToWorld;
+
+        // qx, qy, qz, qw of each camera to world orientation
+        std::vector<double> orientationsCameraToWorldQxyzw;
+
+        std::vector<Point3d> pointsOptimized;
+
+        std::string solverInfo;
+        int numberOfCorrespondences = 0;
+
+    public:
+
+        std::vector<SE3> optimizePointsAndPoses(const std::vector<Point3d> &points,
+                                                const std::vector<std::pair<SE3, CameraRGBD>> &posesCameraToWorld,
+                                                const std::vector<std::unordered_map<int, KeyPointInfo>> &keyPointInfo,
+                                                int indexFixed,
+                                                bool &success) override;
+
+        /**
+         * @returns points recomputed as mean of their observations back-projected from refined poses
+         */
+        std::vector<Point3d> getOptimizedPoints() const override;
+
+        std::string getSolverInfo() const override;
+
+        /**
+         * @param inlierCorrespondencesToSet inlier keypoint matches between poses of optimized component,
+         *      should outlive the adjuster, if nullptr or empty each point observation
+         *      is matched with the next observation of the same point
+         */
+        void setInlierCorrespondences(const KeyPointMatches *inlierCorrespondencesToSet);
+
+        /**
+         * @returns number of 3D-3D correspondences used by the last optimization
+         */
+        int getNumberOfCorrespondences() const;
+
+        void setMaxNumberIterations(int iterationsNumber);
+
+        void setMaxNumberThreads(int numberOfThreads);
+    };
+}
+
+#endif
@@ -0,0 +1,68 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#ifndef GDR_REPROJECTIONDEPTHRESIDUAL_H
+#define GDR_REPROJECTIONDEPTHRESIDUAL_H
+
+#include <ceres/ceres.h>
+
+#include "cameraModel/CameraRGBD.h"
+
+namespace gdr {
+
+    /** Reprojection and depth residuals of one keypoint observation with analytic Jacobians:
+     *      ((x_observed - x_computed) / deviationReprojection,
+     *       (y_observed - y_computed) / deviationReprojection,
+     *       (depth_observed - depth_computed) / deviationDepth)
+     *
+     *      Parameter blocks are point in world coordinates (x, y, z),
+     *      world to camera translation (tx, ty, tz) and orientation (qx, qy, qz, qw).
+     *      Camera coordinates of point are computed once and shared by all three residuals.
+     */
+    class ReprojectionDepthResidual : public ceres::SizedCostFunction<3, 3, 3, 4> {
+
+        double observedX;
+        double observedY;
+        double observedDepth;
+
+        double fx;
+        double fy;
+        double cx;
+        double cy;
+
+        double deviationReprojection;
+        double deviationDepth;
+
+    public:
+
+        /**
+         * @param observedXToSet observed keypoint x coordinate in pixels
+         * @param observedYToSet observed keypoint y coordinate in pixels
+         * @param observedDepthToSet observed keypoint depth in meters
+         * @param camera intrinsics of observing camera
+         * @param deviationReprojectionToSet expected standard deviation of reprojection error in pixels
+         * @param deviationDepthToSet expected standard deviation of depth error in meters
+         */
+        ReprojectionDepthResidual(double observedXToSet,
+                                  double observedYToSet,
+                                  double observedDepthToSet,
+                                  const CameraRGBD &camera,
+                                  double deviationReprojectionToSet,
+                                  double deviationDepthToSet);
+
+        bool Evaluate(double const *const *parameters,
+                      double *residuals,
+                      double **jacobians) const override;
+
+        static ceres::CostFunction *Create(double observedX,
+                                           double observedY,
+                                           double observedDepth,
+                                           const CameraRGBD &camera,
+                                           double deviationReprojection,
+                                           double deviationDepth);
+    };
+}
+
+#endif
@@ -8,9 +8,31 @@
 
 #include <functional>
 #include <cmath>
+#include <type_traits>
 
 namespace gdr {
 
+    /** Noise model policies used to instantiate per-observation kernels at compile time,
+     *      so the deviation estimation is inlined instead of being called through std::function
+     */
+    struct NoiseModelReprojectionLinearInScale {
+        static double getDeviation(double scale, double linearParameterNoiseModelReprojection) {
+            return linearParameterNoiseModelReprojection * scale;
+        }
+    };
+
+    struct NoiseModelDepthQuadratic {
+        static double getDeviation(double depth, double quadraticParameterNoiseModelDepth) {
+            return quadraticParameterNoiseModelDepth * depth * depth;
+        }
+    };
+
+    /** Fallback policy: deviation is computed by std::function stored in MeasurementErrorDeviationEstimators,
+     *      should be used if any camera has custom noise models
+     */
+    struct NoiseModelFunction {
+    };
+
     class MeasurementErrorDeviationEstimators {
 
 
@@ -19,15 +41,18 @@ namespace gdr {
 
         std::function<double(double, double)> dividerReprojectionError =
                 [](double scale, double linearParameterNoiseModelReprojection) {
-                    return linearParameterNoiseModelReprojection * scale;
+                    return NoiseModelReprojectionLinearInScale::getDeviation(scale,
+                                                                             linearParameterNoiseModelReprojection);
                 };
 
         std::function<double(double, double)> dividerDepthError =
                 [](double depth, double quadraticParameterNoiseModelDepth) {
-                    double squaredDepth = std::pow(depth, 2.0);
-                    return quadraticParameterNoiseModelDepth * squaredDepth;
+                    return NoiseModelDepthQuadratic::getDeviation(depth, quadraticParameterNoiseModelDepth);
                 };
 
+        /** true if dividers are NoiseModelReprojectionLinearInScale and NoiseModelDepthQuadratic */
+        bool defaultNoiseModels = true;
+
     public:
         MeasurementErrorDeviationEstimators() = default;
 
@@ -46,6 +71,40 @@ namespace gdr {
         void setParameterNoiseModelDepth(double paramDepth);
 
         double getParameterNoiseModelDepth() const;
+
+        /**
+         * @returns true if estimators were not constructed from custom std::function models,
+         *      so kernels can be instantiated with NoiseModelReprojectionLinearInScale and NoiseModelDepthQuadratic
+         */
+        bool hasDefaultNoiseModels() const;
+
+        /**
+         * @tparam NoiseModelReprojection policy with static getDeviation(scale, parameter) or NoiseModelFunction
+         * @param scale scale of observed keypoint
+         * @returns expected deviation of reprojection error in pixels
+         */
+        template<class NoiseModelReprojection = NoiseModelFunction>
+        double getDeviationReprojection(double scale) const {
+            if constexpr (std::is_same_v<NoiseModelReprojection, NoiseModelFunction>) {
+                return dividerReprojectionError(scale, defaultLinearParameterNoiseModelReprojectionBA);
+            } else {
+                return NoiseModelReprojection::getDeviation(scale, defaultLinearParameterNoiseModelReprojectionBA);
+            }
+        }
+
+        /**
+         * @tparam NoiseModelDepth policy with static getDeviation(depth, parameter) or NoiseModelFunction
+         * @param depth observed depth in meters
+         * @returns expected deviation of depth error in meters
+         */
+        template<class NoiseModelDepth = NoiseModelFunction>
+        double getDeviationDepth(double depth) const {
+            if constexpr (std::is_same_v<NoiseModelDepth, NoiseModelFunction>) {
+                return dividerDepthError(depth, defaultQuadraticParameterNoiseModelDepth);
+            } else {
+                return NoiseModelDepth::getDeviation(depth, defaultQuadraticParameterNoiseModelDepth);
+            }
+        }
     };
 }
 
@@ -10,6 +10,9 @@
 #include <memory>
 
 #include "absolutePoseEstimation/rotationAveraging/RotationMeasurement.h"
+#include "absolutePoseEstimation/rotationAveraging/RotationAverager.h"
+#include "absolutePoseEstimation/rotationAveraging/RotationRobustOptimizerCreator.h"
+#include "bundleAdjustment/BundleAdjusterCreator.h"
 
 #include "poseGraph/ConnectedComponent.h"
 
@@ -19,15 +22,19 @@ namespace gdr {
 
 
     public:
+        std::chrono::high_resolution_clock::time_point timeStartEdgeFiltering;
         std::chrono::high_resolution_clock::time_point timeStartRotationAveraging;
         std::chrono::high_resolution_clock::time_point timeStartRobustRotationOptimization;
         std::chrono::high_resolution_clock::time_point timeStartTranslationAveraging;
+        std::chrono::high_resolution_clock::time_point timeStartPoseGraphOptimization;
         std::chrono::high_resolution_clock::time_point timeStartBundleAdjustment;
 
 
+        std::chrono::high_resolution_clock::time_point timeEndEdgeFiltering;
         std::chrono::high_resolution_clock::time_point timeEndRotationAveraging;
         std::chrono::high_resolution_clock::time_point timeEndRobustRotationOptimization;
         std::chrono::high_resolution_clock::time_point timeEndTranslationAveraging;
+        std::chrono::high_resolution_clock::time_point timeEndPoseGraphOptimization;
         std::chrono::high_resolution_clock::time_point timeEndBundleAdjustment;
 
     private:
@@ -37,10 +44,50 @@ namespace gdr {
         std::unique_ptr<PointClassifier> pointMatcher;
         std::unique_ptr<CloudProjector> cloudProjector;
 
-        std::string pathRelativePosesFile = "relativePosesG2o.txt";
+        /** relative rotations are dumped to this file in g2o format only if it is not empty */
+        std::string pathRelativePosesFile;
+
+        RotationAverager::RotationAveragingType rotationAveragingType =
+                RotationAverager::RotationAveragingType::SHONAN;
+
+        /** number of concurrent Shonan runs from different initializations */
+        int numberOfShonanStarts = 1;
+
+        RotationRobustOptimizerCreator::RobustParameterType rotationRobustOptimizerType =
+                RotationRobustOptimizerCreator::RobustParameterType::DEFAULT;
+
+        /** rotation and translation averaging is done cluster-wise if number of poses exceeds this value,
+         *      0 disables hierarchical averaging */
+        int maxPosesPerClusterHierarchical = 0;
+
+        BundleAdjusterCreator::BundleAdjustmentType bundleAdjustmentType =
+                BundleAdjusterCreator::BundleAdjustmentType::USE_DEPTH_INFO;
+
+        /** bundle adjustment is partitioned into clusters optimized in parallel if number of poses exceeds this value,
+         *      0 disables partitioning */
+        int maxPosesPerClusterBundleAdjustment = 0;
+
+        /** number of bundle adjustment solves with outlier observations removed between them */
+        int maxRoundsOutlierRejectionBundleAdjustment = 1;
+
+        /** number of landmarks requested by each pose for bundle adjustment, 0 disables landmark selection */
+        int maxLandmarksPerPoseBundleAdjustment = 0;
+        bool retriangulateUnselectedLandmarks = true;
+        int numberOfLandmarksBeforeSelection = 0;
+        int numberOfLandmarksSelected = 0;
+
+        int numberOfEdgesBeforeFiltering = 0;
+        int numberOfEdgesRemovedByFiltering = 0;
+
+        std::string poseGraphOptimizationSolverInfo;
+        std::string bundleAdjustmentSolverInfo;
 
         void computePointClasses();
 
+        bool useHierarchicalAveraging() const;
+
+        std::vector<int> getClusterByPose() const;
+
     public:
 
         std::string getPathRelativePoseFile() const;
@@ -54,6 +101,41 @@ namespace gdr {
 
         void setRelativePosesFilePath(const std::string &relativePosesPathToSet);
 
+        void setRotationAveragingType(const RotationAverager::RotationAveragingType &rotationAveragingTypeToSet);
+
+        void setNumberOfShonanStarts(int numberOfShonanStartsToSet);
+
+        /**
+         * @param maxPosesPerClusterToSet maximum number of poses in one cluster of hierarchical averaging,
+         *      0 disables hierarchical averaging
+         */
+        void setHierarchicalAveraging(int maxPosesPerClusterToSet);
+
+        /**
+         * @param maxPosesPerClusterToSet maximum number of poses in one cluster of partitioned bundle adjustment,
+         *      0 disables partitioning
+         */
+        void setPartitionedBundleAdjustment(int maxPosesPerClusterToSet);
+
+        /**
+         * @param maxRoundsToSet number of bundle adjustment solves reusing the same problem,
+         *      outlier observations are removed between them, 1 disables outlier rejection
+         */
+        void setBundleAdjustmentOutlierRejection(int maxRoundsToSet);
+
+        /**
+         * @param maxLandmarksPerPoseToSet number of landmarks requested by each pose for bundle adjustment,
+         *      0 disables selection and all points are optimized
+         * @param retriangulateUnselectedToSet if true points not used by bundle adjustment are recomputed
+         *      from refined poses, otherwise they keep coordinates computed before bundle adjustment
+         */
+        void setLandmarkSelection(int maxLandmarksPerPoseToSet, bool retriangulateUnselectedToSet = true);
+
+        void setRotationRobustOptimizerType(
+                const RotationRobustOptimizerCreator::RobustParameterType &rotationRobustOptimizerTypeToSet);
+
+        void setBundleAdjustmentType(const BundleAdjusterCreator::BundleAdjustmentType &bundleAdjustmentTypeToSet);
+
         int getNumberOfPoses() const;
 
         std::set<int> initialIndices() const;
@@ -62,12 +144,29 @@ namespace gdr {
 
         std::vector<double> getPosesTimestamps() const;
 
+        /**
+         * Removes relative poses inconsistent with triangle cycles of pose graph,
+         *      should be called before rotation averaging, is not called by default
+         *      because it changes the set of measurements used for averaging
+         * @returns number of removed undirected edges
+         */
+        int filterInconsistentRelativePoses();
+
         std::vector<SO3> performRotationAveraging();
 
         std::vector<SO3> performRotationRobustOptimization();
 
         std::vector<Eigen::Vector3d> performTranslationAveraging();
 
+        /**
+         * Refines rotations and translations jointly over relative pose measurements without landmarks,
+         *      should be called after translation averaging, can be used instead of bundle adjustment
+         * @param updatePoses if false poses of the component are not changed,
+         *      so bundle adjustment can be benchmarked from the same translation averaging poses
+         * @returns optimized camera to world poses
+         */
+        std::vector<SE3> performPoseGraphOptimization(bool updatePoses = true);
+
         std::vector<SE3> performBundleAdjustmentUsingDepth();
 
         std::vector<SE3> getPosesSE3() const;
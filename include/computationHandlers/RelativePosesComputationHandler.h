@@ -10,8 +10,10 @@
 
 #include "poseGraph/graphAlgorithms/GraphTraverser.h"
 #include "poseGraph/CorrespondenceGraph.h"
+#include "parametrization/RelativePoseQuality.h"
 
 #include "relativePoseEstimators/InlierCounter.h"
+#include "relativePoseRefinement/RefinerRelativePoseCreator.h"
 
 #include "datasetDescriber/DatasetDescriber.h"
 
@@ -37,6 +39,12 @@ namespace gdr {
         mutable std::mutex timeMutex;
         mutable volatile double timeCountSecondsTotalICP = 0.0;
 
+        /** Refinement outcome counters guarded by timeMutex, LoRANSAC pose is kept
+         *      if refiner did not converge or refined pose has fewer inliers */
+        mutable int numberOfRefinementsConverged = 0;
+        mutable int numberOfRefinementsNotConverged = 0;
+        mutable int numberOfPairsKeptLoRANSAC = 0;
+
     private:
         int deviceCudaICP = 0;
 
@@ -75,13 +83,15 @@ namespace gdr {
          * @param vertexFrom is a vertex number relative transformation from is computed
          * @param vertexInList is a vertex number in vertexFrom's adjacency list (transformation "destination" vertex)
          * @param transformation is relative SE3 transformation between poses
+         * @param inlierErrors[out] reprojection errors of inlier matches
          *
          * @returns information about matched keypoints
          */
         KeyPointMatches
         findInlierPointCorrespondences(int vertexFrom,
                                        int vertexInList,
-                                       const SE3 &transformation) const;
+                                       const SE3 &transformation,
+                                       std::vector<double> &inlierErrors) const;
 
         /** Refine relative pose estimation with ICP-like dense clouds alignment
          * @param[in] vertexToBeTransformed pose which is transformed by SE3 transformation
@@ -92,7 +102,7 @@ namespace gdr {
          *      also stores refined estimation
          * @param[out] refinementSuccess true if refinement was successful
          *
-         * @returns 0 if refinement was successful
+         * @returns 0 if refinement was successful and 1 otherwise, in that case estimation should not be used
          */
         int refineRelativePose(const VertexPose &vertexToBeTransformed,
                                const VertexPose &vertexDestination,
@@ -106,6 +116,7 @@ namespace gdr {
          * @param keyPointMatches[out] contains information about inlier matches between keypoints,
          *      each vector is size 2 and i={0,1}-th element contains information about point from image:
          *      {observing pose vertexIndex, keypoint index in pose's keypoint list, information about keypoint itself}
+         * @param relativePoseQuality[out] inlier statistics of estimated transformation
          * @param success[out] is true if estimation was successful
          * @param showMatchesOnImages[in] is true if keypoint matches should be visualized
          *
@@ -115,6 +126,7 @@ namespace gdr {
         getTransformationRtMatrixTwoImages(int vertexFromDestOrigin,
                                            int vertexInListToBeTransformedCanBeComputed,
                                            KeyPointMatches &keyPointMatches,
+                                           RelativePoseQuality &relativePoseQuality,
                                            bool &success,
                                            bool showMatchesOnImages = false) const;
 
@@ -178,6 +190,12 @@ namespace gdr {
 
         void setDeviceCudaICP(int deviceCudaIcpToSet);
 
+        /**
+         * @param refinerType dense relative pose refinement method: ICP on CUDA device
+         *      or joint photometric-geometric RGB-D alignment on CPU
+         */
+        void setRefinerType(const RefinerRelativePoseCreator::RefinerType &refinerType);
+
         std::stringstream getTimeBenchmarkInfo() const;
     };
 }
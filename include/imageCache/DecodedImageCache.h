@@ -0,0 +1,140 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#ifndef GDR_DECODEDIMAGECACHE_H
+#define GDR_DECODEDIMAGECACHE_H
+
+#include <string>
+#include <list>
+#include <mutex>
+#include <future>
+#include <unordered_map>
+#include <ostream>
+#include <memory>
+#include <vector>
+
+#include <opencv2/core/mat.hpp>
+
+#include "readerDataset/readerPacked/PackedDatasetReader.h"
+
+namespace gdr {
+
+    struct DecodedImageCacheStatistics {
+        long long hits = 0;
+        long long misses = 0;
+        long long evictions = 0;
+
+        double secondsDecoding = 0.0;
+        double secondsDecodingSaved = 0.0;
+
+        friend std::ostream &operator<<(std::ostream &os, const DecodedImageCacheStatistics &statistics);
+    };
+
+    /** Process-wide cache of decoded images shared by all pipeline stages,
+     *      each image file is decoded at most once unless it was evicted because of the memory budget.
+     *      Entries are keyed by path and decoded image type: grayscale images are converted from the cached
+     *      colour image, so the same file is not decoded again for grayscale and colour requests.
+     *      Images which could not be read are not cached and are decoded again on the next request.
+     *      Returned cv::Mat objects share the cached buffer and must be treated as read-only.
+     */
+    class DecodedImageCache {
+
+    public:
+        enum class ImageType {
+            COLOR,
+            GRAYSCALE,
+            DEPTH
+        };
+
+    private:
+        struct CacheEntry {
+            std::shared_future<cv::Mat> imageDecoded;
+            size_t sizeBytes = 0;
+            double secondsDecoding = 0.0;
+            bool isReady = false;
+            std::list<std::string>::iterator positionRecentlyUsed;
+        };
+
+        mutable std::mutex cacheMutex;
+
+        size_t memoryBudgetBytes = static_cast<size_t>(1) << 30;
+        size_t memoryUsedBytes = 0;
+
+        std::unordered_map<std::string, CacheEntry> entriesByKey;
+
+        /** Keys sorted from most to least recently used */
+        std::list<std::string> keysRecentlyUsed;
+
+        /** Pinned keys are not evicted, images may be pinned before they are decoded */
+        std::unordered_map<std::string, int> pinCountersByKey;
+
+        DecodedImageCacheStatistics statistics;
+
+        std::vector<std::shared_ptr<const PackedDatasetReader>> packedDatasets;
+
+        DecodedImageCache() = default;
+
+        /** @returns key of the decoded image, grayscale requests share key with colour ones */
+        static std::string getKey(const std::string &pathToImage, const ImageType &imageType);
+
+        /**
+         * @param imageType colour or depth, grayscale images are not decoded directly
+         * @param packedDatasetsToSearch containers whose virtual paths are resolved without file system access
+         */
+        static cv::Mat decodeImage(const std::string &pathToImage,
+                                   const ImageType &imageType,
+                                   const std::vector<std::shared_ptr<const PackedDatasetReader>> &packedDatasetsToSearch);
+
+        /** Remove least recently used ready and not pinned entries until memory budget is satisfied,
+         *      should be called with locked cacheMutex */
+        void evictIfNeeded();
+
+        /** @param imageType colour or depth */
+        cv::Mat getImageDecoded(const std::string &pathToImage, const ImageType &imageType);
+
+    public:
+
+        DecodedImageCache(const DecodedImageCache &) = delete;
+
+        DecodedImageCache &operator=(const DecodedImageCache &) = delete;
+
+        static DecodedImageCache &getInstance();
+
+        /**
+         * @param pathToImage path to the image file
+         * @param imageType defines how the image is decoded: 8-bit BGR, 8-bit grayscale or raw 16-bit depth
+         *
+         * @returns decoded image sharing memory with cached one, empty if the image could not be read,
+         *      grayscale image is converted from cached colour image on each call
+         */
+        cv::Mat getImage(const std::string &pathToImage, const ImageType &imageType);
+
+        /** Keep image in cache regardless of memory budget until it is unpinned,
+         *      image is not decoded by this call and may be pinned before it is requested.
+         *      Each call should be paired with unpin with the same arguments.
+         */
+        void pin(const std::string &pathToImage, const ImageType &imageType);
+
+        void unpin(const std::string &pathToImage, const ImageType &imageType);
+
+        /** Images with virtual paths of the container are read from it instead of image files */
+        void addPackedDataset(const std::shared_ptr<const PackedDatasetReader> &packedDataset);
+
+        /** Least recently used images are evicted at once if the new budget is exceeded,
+         *      pinned images count towards the budget but are never evicted */
+        void setMemoryBudgetBytes(size_t memoryBudgetBytesToSet);
+
+        size_t getMemoryBudgetBytes() const;
+
+        size_t getMemoryUsedBytes() const;
+
+        DecodedImageCacheStatistics getStatistics() const;
+
+        /** Remove all not pinned images and reset statistics */
+        void clear();
+    };
+}
+
+#endif
@@ -0,0 +1,79 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#ifndef GDR_IMAGEPREFETCHER_H
+#define GDR_IMAGEPREFETCHER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/core/mat.hpp>
+
+#include "imageCache/DecodedImageCache.h"
+
+namespace gdr {
+
+    /** Decodes images on separate I/O threads in dataset order and hands them to consumers
+     *      through a bounded queue, so consumers do not wait for disk reads and decoding
+     */
+    class ImagePrefetcher {
+
+        std::vector<std::string> pathsToImages;
+        DecodedImageCache::ImageType imageType;
+
+        std::mutex queueMutex;
+        std::condition_variable queueHasImage;
+        std::condition_variable queueHasSpace;
+
+        /** Bounded by maxNumberOfImagesPrefetched, guarded by queueMutex together with stopRequested */
+        std::deque<std::pair<int, cv::Mat>> imagesDecoded;
+        size_t maxNumberOfImagesPrefetched;
+        bool stopRequested = false;
+
+        std::atomic_int nextImageToDecode{0};
+        std::atomic_int nextImageToConsume{0};
+
+        std::vector<std::thread> threadsIO;
+
+        void decodeImages();
+
+    public:
+
+        /**
+         * @param pathsToImages paths to images in the order they should be decoded
+         * @param imageType defines how images are decoded
+         * @param numberOfThreadsIO number of threads reading and decoding images
+         * @param maxNumberOfImagesPrefetched capacity of decoded images queue
+         */
+        ImagePrefetcher(const std::vector<std::string> &pathsToImages,
+                        const DecodedImageCache::ImageType &imageType,
+                        int numberOfThreadsIO = 2,
+                        int maxNumberOfImagesPrefetched = 16);
+
+        ImagePrefetcher(const ImagePrefetcher &) = delete;
+
+        ImagePrefetcher &operator=(const ImagePrefetcher &) = delete;
+
+        /**
+         * Wait for the next decoded image, can be called concurrently
+         * @param image[out] decoded image, must be treated as read-only
+         * @param imageIndex[out] index of the image in initial paths list
+         *
+         * @returns false if all images have already been handed out
+         */
+        bool getNextImage(cv::Mat &image, int &imageIndex);
+
+        /** Wakes I/O threads waiting for free space in the queue and joins them,
+         *      images which were not consumed are dropped */
+        ~ImagePrefetcher();
+    };
+}
+
+#endif
@@ -21,6 +21,8 @@
 #include "FeatureDetectorMatcher.h"
 #include "keyPointDetectionAndMatching/ImageRetriever.h"
 
+#include "imageCache/ImagePrefetcher.h"
+
 namespace gdr {
 
     using imageDescriptor = std::pair<std::vector<KeyPoint2DAndDepth>, std::vector<float>>;
@@ -36,8 +38,17 @@ namespace gdr {
         PrintDebug whatToPrint = PrintDebug::NOTHING;
         int maxSift = 4096;
 
+        int numberOfThreadsPrefetchingImages = 2;
+        int maxNumberOfImagesPrefetched = 16;
+
     public:
 
+        /**
+         * @param numberOfThreads number of threads reading and decoding images for detection
+         * @param maxNumberOfImages maximum number of decoded images waiting for detection
+         */
+        void setImagePrefetchingParameters(int numberOfThreads, int maxNumberOfImages);
+
         std::vector<std::pair<std::vector<KeyPoint2DAndDepth>, std::vector<float>>>
         getKeypoints2DDescriptorsAllImages(const std::vector<std::string> &pathsToImages,
                                            const std::vector<int> &numOfDevicesForDetectors) override;
@@ -74,7 +85,7 @@ namespace gdr {
 
         static void
         getKeypointsDescriptorsOneImage(SiftGPU *detectorSift,
-                                        tbb::concurrent_queue<std::pair<std::string, int>> &pathsToImagesAndImageIndices,
+                                        ImagePrefetcher &imagePrefetcher,
                                         std::vector<std::pair<std::vector<SiftGPU::SiftKeypoint>, std::vector<float>>> &keyPointsAndDescriptorsByIndex,
                                         std::mutex &output,
                                         bool normalizeRootL1 = true);
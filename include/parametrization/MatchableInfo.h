@@ -11,18 +11,21 @@
 
 #include "keyPoints/KeyPoint2DAndDepth.h"
 #include "cameraModel/CameraRGBD.h"
+#include "poseGraph/VertexPose.h"
 
 namespace gdr {
 
+    /** Lightweight non-owning view of pose information needed for relative pose refinement,
+     *      referenced objects must outlive the view, so constructors taking temporaries are deleted */
     class MatchableInfo {
 
         int imagePixelHeight = 480;
         int imagePixelWidght = 640;
 
-        std::string pathImageRGB;
-        CameraRGBD cameraRGB;
-        std::string pathImageD;
-        std::vector<KeyPoint2DAndDepth> keyPoints2D;
+        const std::string *pathImageRGB = nullptr;
+        const CameraRGBD *cameraRGB = nullptr;
+        const std::string *pathImageD = nullptr;
+        const std::vector<KeyPoint2DAndDepth> *keyPoints2D = nullptr;
 
     public:
 
@@ -31,13 +34,32 @@ namespace gdr {
                       const std::vector<KeyPoint2DAndDepth> &keyPoints2D,
                       const CameraRGBD &cameraRGB);
 
-        MatchableInfo() = default;
+        /**
+         * @param vertexPose pose whose paths, keypoints and camera are referenced without copying
+         */
+        explicit MatchableInfo(const VertexPose &vertexPose);
+
+        MatchableInfo(std::string &&, const std::string &,
+                      const std::vector<KeyPoint2DAndDepth> &, const CameraRGBD &) = delete;
+
+        MatchableInfo(const std::string &, std::string &&,
+                      const std::vector<KeyPoint2DAndDepth> &, const CameraRGBD &) = delete;
+
+        MatchableInfo(const std::string &, const std::string &,
+                      std::vector<KeyPoint2DAndDepth> &&, const CameraRGBD &) = delete;
+
+        MatchableInfo(const std::string &, const std::string &,
+                      const std::vector<KeyPoint2DAndDepth> &, CameraRGBD &&) = delete;
+
+        explicit MatchableInfo(VertexPose &&) = delete;
+
+        MatchableInfo() = delete;
 
         const std::string &getPathImageRGB() const;
 
         const std::string &getPathImageD() const;
 
-        const std::vector<KeyPoint2DAndDepth> getKeyPoints2D() const;
+        const std::vector<KeyPoint2DAndDepth> &getKeyPoints2D() const;
 
         const CameraRGBD &getCameraRGB() const;
 
@@ -0,0 +1,54 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#ifndef GDR_RELATIVEPOSEQUALITY_H
+#define GDR_RELATIVEPOSEQUALITY_H
+
+namespace gdr {
+
+    /** Statistics of pairwise relative pose estimation used to weight measurements in global averaging */
+    class RelativePoseQuality {
+
+        int numberOfInliers = 0;
+        double inlierErrorSpread = 0.0;
+        bool refinedByICP = false;
+
+    public:
+
+        /** Quality of measurement without known statistics, all such measurements have unit weight */
+        RelativePoseQuality() = default;
+
+        /**
+         * @param numberOfInliersToSet number of inlier keypoint matches supporting relative pose
+         * @param inlierErrorSpreadToSet root mean square error of inliers,
+         *      in pixels or meters depending on RANSAC inlier metric
+         * @param refinedByICPToSet true if relative pose was refined by dense ICP
+         */
+        RelativePoseQuality(int numberOfInliersToSet,
+                            double inlierErrorSpreadToSet,
+                            bool refinedByICPToSet);
+
+        int getNumberOfInliers() const;
+
+        double getInlierErrorSpread() const;
+
+        bool isRefinedByICP() const;
+
+        /** @returns true if statistics were computed for this measurement */
+        bool isKnown() const;
+
+        /**
+         * Weight is inversely proportional to standard deviation of translation estimated from inliers
+         *
+         * @param minInlierErrorSpread lower bound of error spread to avoid infinite weights
+         * @param weightFactorICP weight multiplier for poses refined by ICP
+         * @returns relative weight of translation measurement, 1 if statistics are not known
+         */
+        double getTranslationWeight(double minInlierErrorSpread = 1e-3,
+                                    double weightFactorICP = 2.0) const;
+    };
+}
+
+#endif
@@ -10,6 +10,7 @@
 #include <sophus/se3.hpp>
 
 #include "poseGraph/VertexPose.h"
+#include "parametrization/RelativePoseQuality.h"
 
 namespace gdr {
 
@@ -20,12 +21,15 @@ namespace gdr {
 
         SE3 relativePose;
 
+        RelativePoseQuality quality;
+
     public:
         EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 
         RelativeSE3(int indexFromDestinationToSet,
                     int indexToToBeTransformedToSet,
-                    const SE3 &se3);
+                    const SE3 &se3,
+                    const RelativePoseQuality &qualityToSet = RelativePoseQuality());
 
         int getIndexTo() const;
 
@@ -39,6 +43,9 @@ namespace gdr {
 
         const SE3 &getRelativePose() const;
 
+        /** @returns statistics of pairwise estimation of this relative pose */
+        const RelativePoseQuality &getQuality() const;
+
     };
 }
 #endif
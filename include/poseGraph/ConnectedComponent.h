@@ -19,6 +19,7 @@
 #include "sparsePointCloud/CloudProjector.h"
 
 #include "keyPoints/KeyPointMatches.h"
+#include <set>
 #include <vector>
 
 namespace gdr {
@@ -57,6 +58,12 @@ namespace gdr {
 
         const std::vector<RelativeSE3> &getConnectionsFromVertex(int vertexNumber) const;
 
+        /**
+         * Removes relative poses in both directions and inlier keypoint matches between given poses
+         * @param posePairsToRemove pairs of pose indices {indexFrom, indexTo}, indexFrom < indexTo
+         */
+        void removeRelativePoses(const std::set<std::pair<int, int>> &posePairsToRemove);
+
         const std::vector<VertexPose> &getVertices() const;
 
         const VertexPose &getVertex(int vertexNumber) const;
@@ -81,9 +81,9 @@ namespace gdr {
 
         double getTimestamp() const;
 
-        std::string getPathRGBImage() const;
+        const std::string &getPathRGBImage() const;
 
-        std::string getPathDImage() const;
+        const std::string &getPathDImage() const;
 
         std::string getFilenameRGBImage() const;
 
@@ -0,0 +1,49 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#ifndef GDR_CYCLECONSISTENCYFILTER_H
+#define GDR_CYCLECONSISTENCYFILTER_H
+
+#include <vector>
+
+#include "parametrization/SE3.h"
+
+namespace gdr {
+
+    /** Finds outlier relative poses by composing them along triangle cycles of pose graph.
+     *      Composition of relative poses along a cycle is identity for exact measurements,
+     *      so an edge is inconsistent if most of the cycles through it have big rotation or translation error.
+     */
+    class CycleConsistencyFilter {
+
+    public:
+        CycleConsistencyFilter() = delete;
+
+        /**
+         * @param numberOfPoses number of vertices in pose graph
+         * @param edges pairs {indexFrom, indexTo} of connected poses, indexFrom < indexTo,
+         *      each undirected edge is listed once
+         * @param relativePoses relative pose T_from^{-1} * T_to for each edge
+         * @param maxRotationErrorDegrees cycle is inconsistent if its rotation angle exceeds this value
+         * @param maxTranslationErrorRelative cycle is inconsistent if norm of its translation exceeds
+         *      this value multiplied by median norm of relative translations, so the threshold does not depend
+         *      on scene scale, translation is not checked if the value is not positive
+         * @param maxCyclesPerEdge max number of cycles checked for each edge, cycles are sampled uniformly
+         * @param maxInconsistentCyclesRatio edge is removed if ratio of its inconsistent cycles exceeds this value
+         *
+         * @returns increasing indices of edges to be removed, edges without cycles are always kept
+         *      and removal never splits connected pose graph into several components
+         */
+        static std::vector<int> getInconsistentEdges(int numberOfPoses,
+                                                     const std::vector<std::pair<int, int>> &edges,
+                                                     const std::vector<SE3> &relativePoses,
+                                                     double maxRotationErrorDegrees = 5.0,
+                                                     double maxTranslationErrorRelative = 0.1,
+                                                     int maxCyclesPerEdge = 20,
+                                                     double maxInconsistentCyclesRatio = 0.5);
+    };
+}
+
+#endif
@@ -0,0 +1,75 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#ifndef GDR_PACKEDDATASETFORMAT_H
+#define GDR_PACKEDDATASETFORMAT_H
+
+#include <cstdint>
+
+namespace gdr {
+
+    /** Layout of packed dataset container file:
+     *      header | frame data blobs (each 64-byte aligned) | frame index | ground truth poses | filenames
+     *  All offsets are in bytes from the beginning of the file, values are stored in native byte order.
+     */
+
+    constexpr char packedDatasetMagic[8] = {'G', 'D', 'R', 'P', 'A', 'C', 'K', '1'};
+    constexpr uint32_t packedDatasetVersion = 1;
+    constexpr uint64_t packedDatasetAlignmentBytes = 64;
+
+    enum class PackedFrameEncoding : uint32_t {
+        /** BGR 8-bit colour and 16-bit depth pixels stored row by row without padding */
+        RAW = 0,
+        /** original PNG files stored as is */
+        PNG = 1
+    };
+
+    struct PackedDatasetHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t frameEncoding;
+
+        uint32_t numberOfFrames;
+        uint32_t numberOfGroundTruthPoses;
+        uint32_t imageWidth;
+        uint32_t imageHeight;
+
+        double fx;
+        double fy;
+        double cx;
+        double cy;
+        double depthPixelDivider;
+
+        uint64_t offsetFrameIndex;
+        uint64_t offsetGroundTruth;
+        uint64_t offsetFilenames;
+        uint64_t sizeFilenames;
+    };
+
+    struct PackedFrameIndexEntry {
+        double timestampRgb;
+        double timestampDepth;
+
+        uint64_t offsetRgb;
+        uint64_t sizeRgb;
+        uint64_t offsetDepth;
+        uint64_t sizeDepth;
+
+        /** offsets are relative to the beginning of filenames section */
+        uint64_t offsetFilenameRgb;
+        uint64_t offsetFilenameDepth;
+        uint32_t lengthFilenameRgb;
+        uint32_t lengthFilenameDepth;
+    };
+
+    struct PackedGroundTruthEntry {
+        double timestamp;
+        double translation[3];
+        /** quaternion in qx, qy, qz, qw order as in TUM groundtruth.txt */
+        double orientation[4];
+    };
+}
+
+#endif
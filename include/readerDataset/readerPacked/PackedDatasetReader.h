@@ -0,0 +1,101 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#ifndef GDR_PACKEDDATASETREADER_H
+#define GDR_PACKEDDATASETREADER_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include <opencv2/core/mat.hpp>
+
+#include "readerDataset/readerPacked/PackedDatasetFormat.h"
+
+#include "datasetDescriber/DatasetStructure.h"
+#include "cameraModel/CameraRGBD.h"
+#include "parametrization/PoseFullInfo.h"
+
+namespace gdr {
+
+    /** Memory-mapped read-only access to packed dataset container.
+     *      Frames are addressed by index or by virtual paths [container path]/rgb/[filename]
+     *      and [container path]/depth/[filename] returned in dataset structure
+     */
+    class PackedDatasetReader {
+
+        std::string pathToContainer;
+
+        int fileDescriptor = -1;
+        const char *mappedData = nullptr;
+        size_t mappedSizeBytes = 0;
+
+        const PackedDatasetHeader *header = nullptr;
+        const PackedFrameIndexEntry *frameIndex = nullptr;
+        const PackedGroundTruthEntry *groundTruth = nullptr;
+        const char *filenames = nullptr;
+
+        std::unordered_map<std::string, int> frameIndexByPathRgb;
+        std::unordered_map<std::string, int> frameIndexByPathDepth;
+
+        bool validateAndMapSections();
+
+        std::string getFilenameRgb(int frameIndex) const;
+
+        std::string getFilenameDepth(int frameIndex) const;
+
+        void unmap();
+
+    public:
+
+        explicit PackedDatasetReader(const std::string &pathToContainer);
+
+        PackedDatasetReader(const PackedDatasetReader &) = delete;
+
+        PackedDatasetReader &operator=(const PackedDatasetReader &) = delete;
+
+        ~PackedDatasetReader();
+
+        /** @returns true if container was mapped and has valid structure,
+         *      for raw encoding sizes of all images must also match image resolution */
+        bool isOpened() const;
+
+        const std::string &getPathToContainer() const;
+
+        int getNumberOfFrames() const;
+
+        PackedFrameEncoding getFrameEncoding() const;
+
+        CameraRGBD getCamera() const;
+
+        /** @returns virtual paths to RGB and D images and their timestamps */
+        DatasetStructure getDatasetStructure() const;
+
+        std::vector<PoseFullInfo> getGroundTruthPoses() const;
+
+        /**
+         * @param frameIndex index of frame in container
+         * @returns BGR 8-bit image, for raw encoding it references mapped memory and must be treated as read-only
+         */
+        cv::Mat getImageRGB(int frameIndex) const;
+
+        /**
+         * @param frameIndex index of frame in container
+         * @returns 16-bit depth image, for raw encoding it references mapped memory and must be treated as read-only
+         */
+        cv::Mat getImageDepth(int frameIndex) const;
+
+        /**
+         * @param pathToImage virtual path of image
+         * @param isDepth[out] true if path corresponds to depth image
+         * @param frameIndex[out] frame index
+         *
+         * @returns true if path belongs to this container
+         */
+        bool findFrameByPath(const std::string &pathToImage, bool &isDepth, int &frameIndex) const;
+    };
+}
+
+#endif
@@ -0,0 +1,59 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#ifndef GDR_PACKEDDATASETWRITER_H
+#define GDR_PACKEDDATASETWRITER_H
+
+#include <string>
+#include <vector>
+
+#include "readerDataset/readerPacked/PackedDatasetFormat.h"
+
+#include "datasetDescriber/DatasetStructure.h"
+#include "cameraModel/CameraRGBD.h"
+#include "parametrization/PoseFullInfo.h"
+
+namespace gdr {
+
+    /** Converts datasets stored as separate image files to a single packed container file */
+    class PackedDatasetWriter {
+
+    public:
+        PackedDatasetWriter() = delete;
+
+        /**
+         * @param datasetStructure paths to associated RGB and D images and their timestamps
+         * @param camera intrinsics stored in container
+         * @param groundTruthPoses poses stored in container, can be empty
+         * @param pathToContainer path to output container file
+         * @param frameEncoding defines if images are stored decoded or as original PNG files
+         *
+         * @returns true if container was successfully written
+         */
+        static bool writeContainer(const DatasetStructure &datasetStructure,
+                                   const CameraRGBD &camera,
+                                   const std::vector<PoseFullInfo> &groundTruthPoses,
+                                   const std::string &pathToContainer,
+                                   const PackedFrameEncoding &frameEncoding = PackedFrameEncoding::PNG);
+
+        /**
+         * @param pathToDataset path to TUM-format dataset with rgb and depth directories
+         *      and optional groundtruth.txt file
+         * @param assocShortFilename association file name, can be empty
+         * @param camera intrinsics stored in container
+         * @param pathToContainer path to output container file
+         * @param frameEncoding defines if images are stored decoded or as original PNG files
+         *
+         * @returns true if container was successfully written
+         */
+        static bool convertTUM(const std::string &pathToDataset,
+                               const std::string &assocShortFilename,
+                               const CameraRGBD &camera,
+                               const std::string &pathToContainer,
+                               const PackedFrameEncoding &frameEncoding = PackedFrameEncoding::PNG);
+    };
+}
+
+#endif
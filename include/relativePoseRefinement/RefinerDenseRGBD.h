@@ -0,0 +1,126 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#ifndef GDR_REFINERDENSERGBD_H
+#define GDR_REFINERDENSERGBD_H
+
+#include <vector>
+
+#include <opencv2/core/mat.hpp>
+
+#include "RefinerRelativePose.h"
+
+namespace gdr {
+
+    /** Dense RGB-D odometry on CPU: coarse-to-fine Gauss-Newton minimization of joint
+     *      photometric (intensity) and geometric (depth) residuals over image pyramids.
+     *      Residuals are computed in parallel over pixel rows and accumulated with vectorized Eigen products.
+     */
+    class RefinerDenseRGBD : public RefinerRelativePose {
+
+        /** Single pyramid level of one frame with precomputed image gradients and scaled intrinsics */
+        struct PyramidLevel {
+            cv::Mat intensity;
+            cv::Mat intensityGradX;
+            cv::Mat intensityGradY;
+
+            cv::Mat depth;
+            cv::Mat depthGradX;
+            cv::Mat depthGradY;
+
+            double fx = 0;
+            double fy = 0;
+            double cx = 0;
+            double cy = 0;
+        };
+
+        /** Gauss-Newton normal equations H * dx = -b for 6-dimensional se3 increment */
+        struct NormalEquations {
+            Eigen::Matrix<double, 6, 6> hessian = Eigen::Matrix<double, 6, 6>::Zero();
+            Eigen::Matrix<double, 6, 1> gradient = Eigen::Matrix<double, 6, 1>::Zero();
+            double weightedSquaredError = 0;
+            int numberOfPixelsUsed = 0;
+
+            NormalEquations &operator+=(const NormalEquations &other);
+        };
+
+        /** Number of iterations for each pyramid level, 0-th level is the finest one */
+        std::vector<int> iterationsByPyramidLevel = {4, 6, 10};
+
+        double sigmaIntensity = 0.03;
+        double weightGeometric = 1.0;
+        double maxDepthDifferenceMeters = 0.1;
+        double minSigmaDepthMeters = 0.005;
+        double minRatioOfPixelsUsed = 0.05;
+        double thresholdIncrementNorm = 1e-6;
+        double huberThreshold = 1.345;
+
+        int rowsPerTask = 8;
+
+        /**
+         * @param poseInfo contains paths to colour and depth images
+         * @param intensity[out] grayscale image with values in [0, 1]
+         * @param depth[out] depth image in meters, zero means unknown depth
+         *
+         * @returns true if both images were read successfully
+         */
+        static bool readIntensityAndDepth(const MatchableInfo &poseInfo,
+                                          cv::Mat &intensity,
+                                          cv::Mat &depth);
+
+        static std::vector<PyramidLevel> buildPyramid(const cv::Mat &intensity,
+                                                      const cv::Mat &depth,
+                                                      const CameraRGBD &camera,
+                                                      int numberOfLevels);
+
+        /** Downsample depth image twice by averaging known depth values of 2x2 blocks */
+        static cv::Mat downsampleDepth(const cv::Mat &depth);
+
+        /** Central differences computed only where both neighbours have known depth */
+        static void computeDepthGradients(const cv::Mat &depth,
+                                          cv::Mat &gradX,
+                                          cv::Mat &gradY);
+
+        double getHuberWeight(double normalizedResidual) const;
+
+        /**
+         * @param levelToBeTransformed pyramid level of pose transformed by relative pose
+         * @param levelDestination pyramid level of destination pose
+         * @param transformation current relative pose estimation
+         * @param parameterNoiseModelDepth quadratic depth noise model parameter
+         *
+         * @returns normal equations accumulated over all pixels with valid residuals
+         */
+        NormalEquations computeNormalEquations(const PyramidLevel &levelToBeTransformed,
+                                               const PyramidLevel &levelDestination,
+                                               const Sophus::SE3d &transformation,
+                                               double parameterNoiseModelDepth) const;
+
+    public:
+
+        RefinerDenseRGBD() = default;
+
+        /**
+         * @param iterationsByLevel number of Gauss-Newton iterations for each pyramid level,
+         *      0-th element corresponds to the finest level
+         */
+        void setIterationsByPyramidLevel(const std::vector<int> &iterationsByLevel);
+
+        /**
+         * @param sigmaIntensityToSet expected deviation of intensity residual, intensities are in [0, 1]
+         * @param weightGeometricToSet relative weight of depth residuals compared to photometric ones
+         */
+        void setResidualWeights(double sigmaIntensityToSet, double weightGeometricToSet);
+
+        bool refineRelativePose(const MatchableInfo &poseToBeTransformed,
+                                const MatchableInfo &poseDestination,
+                                const KeyPointMatches &keyPointMatches,
+                                SE3 &initTransformationSE3,
+                                double &durationSeconds,
+                                int deviceIndex) override;
+    };
+}
+
+#endif
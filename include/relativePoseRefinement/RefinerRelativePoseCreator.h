@@ -19,7 +19,8 @@ namespace gdr {
         RefinerRelativePoseCreator() = delete;
 
         enum class RefinerType {
-            ICPCUDA
+            ICPCUDA,
+            DENSE_RGBD_CPU
         };
 
         static std::unique_ptr<RefinerRelativePose> getRefiner(const RefinerType &refinerType);
@@ -23,9 +23,16 @@ namespace gdr {
 
     class CloudProjectorStl : public CloudProjector {
 
+        /**
+         * @tparam NoiseModelReprojection noise model policy of all cameras, NoiseModelFunction for custom models
+         * @tparam NoiseModelDepth noise model policy of all cameras, NoiseModelFunction for custom models
+         */
+        template<class NoiseModelReprojection, class NoiseModelDepth>
         std::vector<int> getPoseNumbersOfInlierObservations(int indexPoint,
                                                             const Eigen::Vector3d &pointCoordinatesGuess) const;
 
+        bool hasDefaultNoiseModels() const;
+
     public:
 
         void setCameraPoses(const std::vector<ProjectableInfo> &cameraPoses) override;
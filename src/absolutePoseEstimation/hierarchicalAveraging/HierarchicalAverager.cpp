@@ -0,0 +1,288 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#include <algorithm>
+#include <cassert>
+
+#include <tbb/parallel_for.h>
+
+#include "absolutePoseEstimation/hierarchicalAveraging/HierarchicalAverager.h"
+#include "absolutePoseEstimation/hierarchicalAveraging/PoseGraphPartitioner.h"
+#include "absolutePoseEstimation/rotationAveraging/RotationRobustOptimizerL1IRLS.h"
+#include "absolutePoseEstimation/translationAveraging/TranslationAverager.h"
+
+namespace gdr {
+
+    /** @returns index of each pose inside its cluster */
+    std::vector<int> getLocalIndicesHierarchical(const std::vector<std::vector<int>> &posesByCluster,
+                                                 int numberOfPoses) {
+        std::vector<int> localIndexByPose(numberOfPoses, -1);
+
+        for (const auto &posesOfCluster: posesByCluster) {
+            for (int localIndex = 0; localIndex < posesOfCluster.size(); ++localIndex) {
+                localIndexByPose[posesOfCluster[localIndex]] = localIndex;
+            }
+        }
+
+        return localIndexByPose;
+    }
+
+    std::vector<SO3> HierarchicalAverager::averageRotations(
+            const std::vector<RotationMeasurement> &relativeRotations,
+            int indexPoseFixed,
+            const std::vector<int> &clusterByPose,
+            const RotationAverager::RotationAveragingType &averagingTypeInsideCluster) {
+
+        int numberOfPoses = static_cast<int>(clusterByPose.size());
+        assert(indexPoseFixed >= 0 && indexPoseFixed < numberOfPoses);
+
+        std::vector<std::vector<int>> posesByCluster = PoseGraphPartitioner::getPosesByCluster(clusterByPose);
+        std::vector<int> localIndexByPose = getLocalIndicesHierarchical(posesByCluster, numberOfPoses);
+        int numberOfClusters = static_cast<int>(posesByCluster.size());
+
+        // local pose indices preserve order so that indexFrom < indexTo holds inside clusters
+        std::vector<std::vector<RotationMeasurement>> relativeRotationsByCluster(numberOfClusters);
+        std::vector<const RotationMeasurement *> relativeRotationsBetweenClusters;
+
+        for (const auto &relativeRotation: relativeRotations) {
+            int indexFrom = relativeRotation.getIndexFromDestination();
+            int indexTo = relativeRotation.getIndexToToBeTransformed();
+
+            if (indexFrom >= indexTo) {
+                continue;
+            }
+
+            if (clusterByPose[indexFrom] == clusterByPose[indexTo]) {
+                relativeRotationsByCluster[clusterByPose[indexFrom]].emplace_back(
+                        RotationMeasurement(relativeRotation.getRotationSO3(),
+                                            localIndexByPose[indexFrom],
+                                            localIndexByPose[indexTo],
+                                            relativeRotation.getWeight()));
+            } else {
+                relativeRotationsBetweenClusters.emplace_back(&relativeRotation);
+            }
+        }
+
+        std::vector<std::vector<SO3>> rotationsInsideClusters(numberOfClusters);
+
+        tbb::parallel_for(0, numberOfClusters, [&](int cluster) {
+            if (posesByCluster[cluster].size() == 1) {
+                rotationsInsideClusters[cluster] = {SO3(Eigen::Matrix3d::Identity())};
+            } else {
+                rotationsInsideClusters[cluster] = RotationAverager::averageRotations(
+                        relativeRotationsByCluster[cluster], 0, averagingTypeInsideCluster);
+            }
+            assert(rotationsInsideClusters[cluster].size() == posesByCluster[cluster].size());
+        });
+
+        // absolute rotation is R_i = G_c * R_i^c where G_c is unknown rotation of cluster c,
+        // so R_to = R_from * R_relative gives G_from^-1 * G_to = R_from^c * R_relative * (R_to^c)^-1
+        std::vector<RotationMeasurement> relativeRotationsClusters;
+
+        for (const auto *relativeRotation: relativeRotationsBetweenClusters) {
+            int indexFrom = relativeRotation->getIndexFromDestination();
+            int indexTo = relativeRotation->getIndexToToBeTransformed();
+            int clusterFrom = clusterByPose[indexFrom];
+            int clusterTo = clusterByPose[indexTo];
+
+            SO3 relativeRotationClusters = rotationsInsideClusters[clusterFrom][localIndexByPose[indexFrom]]
+                                           * relativeRotation->getRotationSO3()
+                                           * rotationsInsideClusters[clusterTo][localIndexByPose[indexTo]].inverse();
+
+            if (clusterFrom < clusterTo) {
+                relativeRotationsClusters.emplace_back(
+                        RotationMeasurement(relativeRotationClusters, clusterFrom, clusterTo,
+                                            relativeRotation->getWeight()));
+            } else {
+                relativeRotationsClusters.emplace_back(
+                        RotationMeasurement(relativeRotationClusters.inverse(), clusterTo, clusterFrom,
+                                            relativeRotation->getWeight()));
+            }
+        }
+
+        int clusterFixed = clusterByPose[indexPoseFixed];
+        std::vector<SO3> rotationsClusters = {SO3(Eigen::Matrix3d::Identity())};
+
+        if (numberOfClusters > 1) {
+            rotationsClusters = RotationAverager::chordalAveraging(relativeRotationsClusters, clusterFixed);
+
+            RotationRobustOptimizerL1IRLS optimizerClusters;
+            rotationsClusters = optimizerClusters.getOptimizedOrientation(rotationsClusters,
+                                                                          relativeRotationsClusters,
+                                                                          clusterFixed);
+        }
+        assert(rotationsClusters.size() == numberOfClusters);
+
+        std::vector<SO3> absoluteRotations(numberOfPoses);
+
+        for (int pose = 0; pose < numberOfPoses; ++pose) {
+            absoluteRotations[pose] = rotationsClusters[clusterByPose[pose]]
+                                      * rotationsInsideClusters[clusterByPose[pose]][localIndexByPose[pose]];
+        }
+
+        SO3 rotationFixedInversed = absoluteRotations[indexPoseFixed].inverse();
+
+        for (auto &rotation: absoluteRotations) {
+            rotation = rotationFixedInversed * rotation;
+        }
+
+        return absoluteRotations;
+    }
+
+    std::vector<Eigen::Vector3d> HierarchicalAverager::averageTranslations(
+            const std::vector<TranslationMeasurement> &relativeTranslations,
+            const std::vector<SE3> &absolutePoses,
+            int indexPoseFixed,
+            const std::vector<int> &clusterByPose,
+            int numberOfIterationsIRLS) {
+
+        int numberOfPoses = static_cast<int>(clusterByPose.size());
+        assert(absolutePoses.size() == numberOfPoses);
+        assert(indexPoseFixed >= 0 && indexPoseFixed < numberOfPoses);
+
+        std::vector<std::vector<int>> posesByCluster = PoseGraphPartitioner::getPosesByCluster(clusterByPose);
+        std::vector<int> localIndexByPose = getLocalIndicesHierarchical(posesByCluster, numberOfPoses);
+        int numberOfClusters = static_cast<int>(posesByCluster.size());
+
+        std::vector<std::vector<TranslationMeasurement>> relativeTranslationsByCluster(numberOfClusters);
+        std::vector<const TranslationMeasurement *> relativeTranslationsBetweenClusters;
+
+        for (const auto &relativeTranslation: relativeTranslations) {
+            int indexFrom = relativeTranslation.getIndexFromToBeTransformed();
+            int indexTo = relativeTranslation.getIndexToDestination();
+            assert(indexFrom < indexTo);
+
+            if (clusterByPose[indexFrom] == clusterByPose[indexTo]) {
+                relativeTranslationsByCluster[clusterByPose[indexFrom]].emplace_back(
+                        TranslationMeasurement(relativeTranslation.getTranslation(),
+                                               localIndexByPose[indexFrom],
+                                               localIndexByPose[indexTo],
+                                               relativeTranslation.getQuality()));
+            } else {
+                relativeTranslationsBetweenClusters.emplace_back(&relativeTranslation);
+            }
+        }
+
+        std::vector<std::vector<Eigen::Vector3d>> translationsInsideClusters(numberOfClusters);
+
+        tbb::parallel_for(0, numberOfClusters, [&](int cluster) {
+            const auto &posesOfCluster = posesByCluster[cluster];
+
+            if (posesOfCluster.size() == 1) {
+                translationsInsideClusters[cluster] = {Eigen::Vector3d::Zero()};
+                return;
+            }
+
+            std::vector<SE3> absolutePosesCluster;
+            absolutePosesCluster.reserve(posesOfCluster.size());
+
+            for (int pose: posesOfCluster) {
+                absolutePosesCluster.emplace_back(absolutePoses[pose]);
+            }
+
+            const auto &relativeTranslationsCluster = relativeTranslationsByCluster[cluster];
+            Vectors3d translationsL2 = TranslationAverager::recoverTranslations(relativeTranslationsCluster,
+                                                                                absolutePosesCluster,
+                                                                                0);
+            bool successIRLS = true;
+            translationsInsideClusters[cluster] = TranslationAverager::recoverTranslationsIRLS(
+                    relativeTranslationsCluster,
+                    absolutePosesCluster,
+                    translationsL2,
+                    0,
+                    successIRLS,
+                    numberOfIterationsIRLS).toVectorOfVectors();
+        });
+
+        // absolute translation is t_i = t_i^c + o_c where o_c is unknown offset of cluster c,
+        // relation t_to - t_from = R_from * t_relative gives o_from - o_to = -R_from * t_relative - t_from^c + t_to^c
+        int clusterFixed = clusterByPose[indexPoseFixed];
+        std::vector<Eigen::Vector3d> offsetsClusters(numberOfClusters, Eigen::Vector3d::Zero());
+
+        auto getColumnCluster = [clusterFixed](int cluster) {
+            return (cluster < clusterFixed) ? cluster : (cluster - 1);
+        };
+
+        std::vector<Eigen::Vector3d> differencesOffsets;
+        differencesOffsets.reserve(relativeTranslationsBetweenClusters.size());
+
+        for (const auto *relativeTranslation: relativeTranslationsBetweenClusters) {
+            int indexFrom = relativeTranslation->getIndexFromToBeTransformed();
+            int indexTo = relativeTranslation->getIndexToDestination();
+
+            differencesOffsets.emplace_back(
+                    -(absolutePoses[indexFrom].getSO3().matrix() * relativeTranslation->getTranslation())
+                    - translationsInsideClusters[clusterByPose[indexFrom]][localIndexByPose[indexFrom]]
+                    + translationsInsideClusters[clusterByPose[indexTo]][localIndexByPose[indexTo]]);
+        }
+
+        std::vector<double> weights(relativeTranslationsBetweenClusters.size(), 1.0);
+        double epsilonResidual = 1e-6;
+
+        for (int iteration = 0; numberOfClusters > 1 && iteration <= numberOfIterationsIRLS; ++iteration) {
+
+            // system matrix is (L x I3) where L is weighted laplacian of cluster graph
+            Eigen::MatrixXd laplacian = Eigen::MatrixXd::Zero(numberOfClusters - 1, numberOfClusters - 1);
+            Eigen::MatrixXd rightHandSide = Eigen::MatrixXd::Zero(numberOfClusters - 1, 3);
+
+            for (int measurementIndex = 0; measurementIndex < differencesOffsets.size(); ++measurementIndex) {
+                const auto *relativeTranslation = relativeTranslationsBetweenClusters[measurementIndex];
+                int clusterFrom = clusterByPose[relativeTranslation->getIndexFromToBeTransformed()];
+                int clusterTo = clusterByPose[relativeTranslation->getIndexToDestination()];
+                double weight = weights[measurementIndex];
+                const Eigen::Vector3d &difference = differencesOffsets[measurementIndex];
+
+                if (clusterFrom != clusterFixed) {
+                    int column = getColumnCluster(clusterFrom);
+                    laplacian(column, column) += weight;
+                    rightHandSide.row(column) += weight * difference.transpose();
+                }
+                if (clusterTo != clusterFixed) {
+                    int column = getColumnCluster(clusterTo);
+                    laplacian(column, column) += weight;
+                    rightHandSide.row(column) -= weight * difference.transpose();
+                }
+                if (clusterFrom != clusterFixed && clusterTo != clusterFixed) {
+                    laplacian(getColumnCluster(clusterFrom), getColumnCluster(clusterTo)) -= weight;
+                    laplacian(getColumnCluster(clusterTo), getColumnCluster(clusterFrom)) -= weight;
+                }
+            }
+
+            Eigen::MatrixXd solution = laplacian.ldlt().solve(rightHandSide);
+
+            for (int cluster = 0; cluster < numberOfClusters; ++cluster) {
+                if (cluster != clusterFixed) {
+                    offsetsClusters[cluster] = solution.row(getColumnCluster(cluster)).transpose();
+                }
+            }
+
+            // L1 weights for the next iteration
+            for (int measurementIndex = 0; measurementIndex < differencesOffsets.size(); ++measurementIndex) {
+                const auto *relativeTranslation = relativeTranslationsBetweenClusters[measurementIndex];
+                int clusterFrom = clusterByPose[relativeTranslation->getIndexFromToBeTransformed()];
+                int clusterTo = clusterByPose[relativeTranslation->getIndexToDestination()];
+
+                double residual = (offsetsClusters[clusterFrom] - offsetsClusters[clusterTo]
+                                   - differencesOffsets[measurementIndex]).norm();
+                weights[measurementIndex] = 1.0 / std::max(residual, epsilonResidual);
+            }
+        }
+
+        std::vector<Eigen::Vector3d> absoluteTranslations(numberOfPoses);
+
+        for (int pose = 0; pose < numberOfPoses; ++pose) {
+            absoluteTranslations[pose] = translationsInsideClusters[clusterByPose[pose]][localIndexByPose[pose]]
+                                         + offsetsClusters[clusterByPose[pose]];
+        }
+
+        Eigen::Vector3d translationFixed = absoluteTranslations[indexPoseFixed];
+
+        for (auto &translation: absoluteTranslations) {
+            translation -= translationFixed;
+        }
+
+        return absoluteTranslations;
+    }
+}
@@ -0,0 +1,144 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <map>
+
+#include <metis.h>
+
+#include "absolutePoseEstimation/hierarchicalAveraging/PoseGraphPartitioner.h"
+
+namespace gdr {
+
+    /** Split each METIS part into connected components and renumber clusters consecutively */
+    std::vector<int> splitPartsToConnectedClusters(const std::vector<int> &partByPose,
+                                                   const std::vector<std::vector<int>> &adjacentPoses) {
+
+        int numberOfPoses = static_cast<int>(partByPose.size());
+        std::vector<int> clusterByPose(numberOfPoses, -1);
+        int numberOfClusters = 0;
+
+        for (int poseStart = 0; poseStart < numberOfPoses; ++poseStart) {
+            if (clusterByPose[poseStart] >= 0) {
+                continue;
+            }
+
+            std::vector<int> posesToVisit = {poseStart};
+            clusterByPose[poseStart] = numberOfClusters;
+
+            while (!posesToVisit.empty()) {
+                int pose = posesToVisit.back();
+                posesToVisit.pop_back();
+
+                for (int adjacentPose: adjacentPoses[pose]) {
+                    if (clusterByPose[adjacentPose] < 0 && partByPose[adjacentPose] == partByPose[poseStart]) {
+                        clusterByPose[adjacentPose] = numberOfClusters;
+                        posesToVisit.push_back(adjacentPose);
+                    }
+                }
+            }
+
+            ++numberOfClusters;
+        }
+
+        return clusterByPose;
+    }
+
+    std::vector<int> PoseGraphPartitioner::partition(int numberOfPoses,
+                                                     const std::vector<std::pair<int, int>> &edges,
+                                                     const std::vector<int> &edgeWeights,
+                                                     int maxPosesPerCluster) {
+
+        assert(maxPosesPerCluster > 0);
+        assert(edgeWeights.empty() || edgeWeights.size() == edges.size());
+
+        // METIS requires symmetric adjacency without self loops and duplicates
+        std::vector<std::map<int, int>> weightByAdjacentPose(numberOfPoses);
+
+        for (int edgeIndex = 0; edgeIndex < edges.size(); ++edgeIndex) {
+            int poseFirst = edges[edgeIndex].first;
+            int poseSecond = edges[edgeIndex].second;
+            assert(poseFirst >= 0 && poseFirst < numberOfPoses);
+            assert(poseSecond >= 0 && poseSecond < numberOfPoses);
+
+            if (poseFirst == poseSecond) {
+                continue;
+            }
+
+            int weight = edgeWeights.empty() ? 1 : std::max(1, edgeWeights[edgeIndex]);
+            weightByAdjacentPose[poseFirst][poseSecond] += weight;
+            weightByAdjacentPose[poseSecond][poseFirst] += weight;
+        }
+
+        std::vector<std::vector<int>> adjacentPoses(numberOfPoses);
+        std::vector<idx_t> adjacencyOffsets = {0};
+        std::vector<idx_t> adjacency;
+        std::vector<idx_t> adjacencyWeights;
+
+        for (int pose = 0; pose < numberOfPoses; ++pose) {
+            for (const auto &adjacentPoseAndWeight: weightByAdjacentPose[pose]) {
+                adjacentPoses[pose].push_back(adjacentPoseAndWeight.first);
+                adjacency.push_back(adjacentPoseAndWeight.first);
+                adjacencyWeights.push_back(adjacentPoseAndWeight.second);
+            }
+            adjacencyOffsets.push_back(static_cast<idx_t>(adjacency.size()));
+        }
+
+        idx_t numberOfParts = (numberOfPoses + maxPosesPerCluster - 1) / maxPosesPerCluster;
+        std::vector<int> partByPose(numberOfPoses, 0);
+
+        if (numberOfParts > 1 && !adjacency.empty()) {
+            idx_t numberOfVertices = numberOfPoses;
+            idx_t numberOfBalancingConstraints = 1;
+            idx_t edgeCut = 0;
+            std::vector<idx_t> partByPoseMetis(numberOfPoses, 0);
+
+            idx_t options[METIS_NOPTIONS];
+            METIS_SetDefaultOptions(options);
+            options[METIS_OPTION_CONTIG] = 1;
+            options[METIS_OPTION_SEED] = 42;
+
+            int status = METIS_PartGraphKway(&numberOfVertices,
+                                             &numberOfBalancingConstraints,
+                                             adjacencyOffsets.data(),
+                                             adjacency.data(),
+                                             nullptr,
+                                             nullptr,
+                                             adjacencyWeights.data(),
+                                             &numberOfParts,
+                                             nullptr,
+                                             nullptr,
+                                             options,
+                                             &edgeCut,
+                                             partByPoseMetis.data());
+
+            if (status == METIS_OK) {
+                std::copy(partByPoseMetis.begin(), partByPoseMetis.end(), partByPose.begin());
+            } else {
+                std::cout << "METIS partitioning failed with status " << status
+                          << ", pose graph is not partitioned" << std::endl;
+            }
+        }
+
+        return splitPartsToConnectedClusters(partByPose, adjacentPoses);
+    }
+
+    std::vector<std::vector<int>> PoseGraphPartitioner::getPosesByCluster(const std::vector<int> &clusterByPose) {
+
+        int numberOfClusters = clusterByPose.empty() ?
+                               0 :
+                               (*std::max_element(clusterByPose.begin(), clusterByPose.end()) + 1);
+        std::vector<std::vector<int>> posesByCluster(numberOfClusters);
+
+        for (int pose = 0; pose < clusterByPose.size(); ++pose) {
+            assert(clusterByPose[pose] >= 0);
+            posesByCluster[clusterByPose[pose]].push_back(pose);
+        }
+
+        return posesByCluster;
+    }
+}
@@ -0,0 +1,168 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#include <cassert>
+#include <cmath>
+#include <memory>
+#include <sstream>
+
+#include "absolutePoseEstimation/poseGraphOptimization/PoseGraphOptimizer.h"
+#include "absolutePoseEstimation/poseGraphOptimization/RelativePoseError.h"
+#include "statistics/RobustEstimators.h"
+
+namespace gdr {
+
+    std::vector<SE3> PoseGraphOptimizer::getOptimizedPoses(const std::vector<SE3> &posesCameraToWorld,
+                                                           const std::vector<RelativeSE3> &relativePoses,
+                                                           int indexFixed,
+                                                           bool &success) {
+        int numberOfPoses = static_cast<int>(posesCameraToWorld.size());
+        assert(indexFixed >= 0 && indexFixed < numberOfPoses);
+
+        int dimTranslation = 3;
+        int dimOrientation = 4;
+
+        std::vector<double> translations;
+        std::vector<double> orientations;
+        translations.reserve(dimTranslation * numberOfPoses);
+        orientations.reserve(dimOrientation * numberOfPoses);
+
+        for (const auto &pose: posesCameraToWorld) {
+            Eigen::Vector3d translation = pose.getTranslation();
+            Eigen::Quaterniond orientation = pose.getRotationQuatd().normalized();
+
+            translations.insert(translations.end(), translation.data(), translation.data() + dimTranslation);
+            orientations.insert(orientations.end(),
+                                orientation.coeffs().data(), orientation.coeffs().data() + dimOrientation);
+        }
+
+        // median statistics of measurements with known quality
+        std::vector<double> numbersOfInliers;
+        std::vector<double> translationWeights;
+
+        for (const auto &relativePose: relativePoses) {
+            const auto &quality = relativePose.getQuality();
+
+            if (quality.isKnown()) {
+                numbersOfInliers.emplace_back(std::max(1, quality.getNumberOfInliers()));
+                translationWeights.emplace_back(quality.getTranslationWeight());
+            }
+        }
+
+        double medianNumberOfInliers = numbersOfInliers.empty() ?
+                                       1.0 : RobustEstimators::getQuantile(numbersOfInliers);
+        double medianTranslationWeight = translationWeights.empty() ?
+                                         1.0 : RobustEstimators::getQuantile(translationWeights);
+
+        // residuals are whitened, so all measurements share the same robust loss
+        std::unique_ptr<ceres::LossFunction> lossFunction = std::make_unique<ceres::CauchyLoss>(1.0);
+
+        ceres::Problem::Options problemOptions;
+        problemOptions.loss_function_ownership = ceres::DO_NOT_TAKE_OWNERSHIP;
+
+        ceres::Problem problem(problemOptions);
+        ceres::LocalParameterization *quaternionLocalParameterization =
+                new ceres::EigenQuaternionParameterization;
+
+        for (const auto &relativePose: relativePoses) {
+            int indexFrom = relativePose.getIndexFrom();
+            int indexTo = relativePose.getIndexTo();
+            assert(indexFrom >= 0 && indexFrom < numberOfPoses);
+            assert(indexTo >= 0 && indexTo < numberOfPoses);
+            assert(indexFrom != indexTo);
+
+            const auto &quality = relativePose.getQuality();
+
+            // information of measurement grows linearly with number of inliers supporting it
+            double weightInliers = 1.0;
+            double weightTranslationSpread = 1.0;
+
+            if (quality.isKnown()) {
+                weightInliers = std::sqrt(std::max(1, quality.getNumberOfInliers()) / medianNumberOfInliers);
+                weightTranslationSpread = quality.getTranslationWeight() / medianTranslationWeight;
+            }
+
+            problem.AddResidualBlock(RelativePoseError::Create(relativePose.getRelativePose(),
+                                                               weightInliers / deviationRotation,
+                                                               weightInliers * weightTranslationSpread
+                                                               / deviationTranslation),
+                                     lossFunction.get(),
+                                     {&translations[dimTranslation * indexFrom],
+                                      &orientations[dimOrientation * indexFrom],
+                                      &translations[dimTranslation * indexTo],
+                                      &orientations[dimOrientation * indexTo]});
+        }
+
+        for (int poseIndex = 0; poseIndex < numberOfPoses; ++poseIndex) {
+            double *orientation = &orientations[dimOrientation * poseIndex];
+
+            if (problem.HasParameterBlock(orientation)) {
+                problem.SetParameterization(orientation, quaternionLocalParameterization);
+            }
+        }
+
+        if (problem.HasParameterBlock(&translations[dimTranslation * indexFixed])) {
+            problem.SetParameterBlockConstant(&translations[dimTranslation * indexFixed]);
+            problem.SetParameterBlockConstant(&orientations[dimOrientation * indexFixed]);
+        }
+
+        ceres::Solver::Options options;
+        options.linear_solver_type = linearSolverType;
+        options.minimizer_progress_to_stdout = false;
+        options.max_num_iterations = iterations;
+        options.num_threads = std::max(1, numberOfThreads);
+
+        ceres::Solver::Summary summary;
+        ceres::Solve(options, &problem, &summary);
+
+        success = summary.IsSolutionUsable();
+
+        std::vector<SE3> posesOptimized;
+        posesOptimized.reserve(numberOfPoses);
+
+        for (int poseIndex = 0; poseIndex < numberOfPoses; ++poseIndex) {
+            Eigen::Map<const Eigen::Vector3d> translation(&translations[dimTranslation * poseIndex]);
+            Eigen::Quaterniond orientation(&orientations[dimOrientation * poseIndex]);
+
+            posesOptimized.emplace_back(SE3(orientation.normalized(), translation));
+        }
+
+        std::stringstream solverInfoStream;
+        solverInfoStream << ceres::LinearSolverTypeToString(summary.linear_solver_type_used)
+                         << ", poses " << numberOfPoses
+                         << ", relative poses " << relativePoses.size()
+                         << ", iterations " << summary.num_successful_steps + summary.num_unsuccessful_steps
+                         << ", solve time " << summary.total_time_in_seconds << " s";
+        solverInfo = solverInfoStream.str();
+
+        return posesOptimized;
+    }
+
+    std::string PoseGraphOptimizer::getSolverInfo() const {
+        return solverInfo;
+    }
+
+    void PoseGraphOptimizer::setDeviations(double deviationRotationToSet,
+                                           double deviationTranslationToSet) {
+        assert(deviationRotationToSet > 0);
+        assert(deviationTranslationToSet > 0);
+        deviationRotation = deviationRotationToSet;
+        deviationTranslation = deviationTranslationToSet;
+    }
+
+    void PoseGraphOptimizer::setNumberOfThreads(int numberOfThreadsToSet) {
+        assert(numberOfThreadsToSet > 0);
+        numberOfThreads = numberOfThreadsToSet;
+    }
+
+    void PoseGraphOptimizer::setMaxNumberIterations(int iterationsNumber) {
+        assert(iterationsNumber > 0);
+        iterations = iterationsNumber;
+    }
+
+    void PoseGraphOptimizer::setLinearSolver(const ceres::LinearSolverType &linearSolverTypeToSet) {
+        linearSolverType = linearSolverTypeToSet;
+    }
+}
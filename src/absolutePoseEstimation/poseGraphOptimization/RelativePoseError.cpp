@@ -0,0 +1,29 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#include <cassert>
+
+#include "absolutePoseEstimation/poseGraphOptimization/RelativePoseError.h"
+
+namespace gdr {
+
+    RelativePoseError::RelativePoseError(const SE3 &relativePoseToSet,
+                                         double weightRotationToSet,
+                                         double weightTranslationToSet) :
+            relativePose(relativePoseToSet),
+            weightRotation(weightRotationToSet),
+            weightTranslation(weightTranslationToSet) {
+
+        assert(weightRotation > 0);
+        assert(weightTranslation > 0);
+    }
+
+    ceres::CostFunction *RelativePoseError::Create(const SE3 &relativePose,
+                                                   double weightRotation,
+                                                   double weightTranslation) {
+        return (new ceres::AutoDiffCostFunction<RelativePoseError, 6, 3, 4, 3, 4>(
+                new RelativePoseError(relativePose, weightRotation, weightTranslation)));
+    }
+}
@@ -0,0 +1,88 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#include <cmath>
+
+#include "absolutePoseEstimation/rotationAveraging/RelativeRotationErrorAnalytic.h"
+
+namespace gdr {
+
+    /** @returns inverse of left Jacobian of SO3 at rotation vector */
+    Eigen::Matrix3d getLeftJacobianInverseSO3(const Eigen::Vector3d &rotationVector) {
+
+        double angle = rotationVector.norm();
+        Eigen::Matrix3d skew = Sophus::SO3d::hat(rotationVector);
+
+        double coefficientSkewSquared = 1.0 / 12.0;
+
+        if (angle > 1e-6) {
+            coefficientSkewSquared = (1.0 - angle * std::sin(angle) / (2.0 * (1.0 - std::cos(angle))))
+                                     / (angle * angle);
+        }
+
+        return Eigen::Matrix3d::Identity() - 0.5 * skew + coefficientSkewSquared * skew * skew;
+    }
+
+    /** @returns transposed Jacobian of ceres::EigenQuaternionParameterization,
+     *      its columns are orthonormal for unit quaternion */
+    Eigen::Matrix<double, 3, 4> getQuaternionPlusJacobianTransposed(const Eigen::Quaterniond &quaternion) {
+
+        Eigen::Matrix<double, 4, 3> plusJacobian;
+        plusJacobian.block<3, 3>(0, 0) = quaternion.w() * Eigen::Matrix3d::Identity()
+                                         - Sophus::SO3d::hat(quaternion.vec());
+        plusJacobian.block<1, 3>(3, 0) = -quaternion.vec().transpose();
+
+        return plusJacobian.transpose();
+    }
+
+    RelativeRotationErrorAnalytic::RelativeRotationErrorAnalytic(const SO3 &relativeRotationToSet) :
+            relativeRotationMeasured(relativeRotationToSet.getUnitQuaternion()) {}
+
+    bool RelativeRotationErrorAnalytic::Evaluate(double const *const *parameters,
+                                                 double *residuals,
+                                                 double **jacobians) const {
+
+        Eigen::Map<const Eigen::Quaterniond> qFromRaw(parameters[0]);
+        Eigen::Map<const Eigen::Quaterniond> qToRaw(parameters[1]);
+
+        Eigen::Quaterniond qFrom = qFromRaw.normalized();
+        Eigen::Quaterniond qTo = qToRaw.normalized();
+
+        // E = R_measured * R_to^-1 * R_from
+        Eigen::Quaterniond measuredToInverse = relativeRotationMeasured * qTo.conjugate();
+        Eigen::Quaterniond error = (measuredToInverse * qFrom).normalized();
+
+        Eigen::Vector3d logError = Sophus::SO3d(error).log();
+
+        Eigen::Map<Eigen::Vector3d> residualsM(residuals);
+        residualsM = 2.0 * logError;
+
+        if (!jacobians) {
+            return true;
+        }
+
+        // left perturbation R_from <- exp(phi) R_from gives E <- exp(R_measured * R_to^-1 * phi) E
+        // and left perturbation of R_to gives the same with opposite sign,
+        // ceres quaternion increment delta corresponds to phi = 2 * delta
+        Eigen::Matrix3d jacobianTangentFrom = 4.0 * getLeftJacobianInverseSO3(logError)
+                                              * measuredToInverse.toRotationMatrix();
+
+        if (jacobians[0]) {
+            Eigen::Map<Eigen::Matrix<double, 3, 4, Eigen::RowMajor>> jacobianFrom(jacobians[0]);
+            jacobianFrom = jacobianTangentFrom * getQuaternionPlusJacobianTransposed(qFrom);
+        }
+
+        if (jacobians[1]) {
+            Eigen::Map<Eigen::Matrix<double, 3, 4, Eigen::RowMajor>> jacobianTo(jacobians[1]);
+            jacobianTo = -jacobianTangentFrom * getQuaternionPlusJacobianTransposed(qTo);
+        }
+
+        return true;
+    }
+
+    ceres::CostFunction *RelativeRotationErrorAnalytic::Create(const SO3 &relativeRotationToSet) {
+        return new RelativeRotationErrorAnalytic(relativeRotationToSet);
+    }
+}
@@ -5,46 +5,203 @@
 
 #include "absolutePoseEstimation/rotationAveraging/RotationAverager.h"
 #include "absolutePoseEstimation/rotationAveraging/RelativePosesG2oFormat.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <queue>
 #include <random>
 #include <fstream>
+#include <limits>
+#include <thread>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/partitioner.h>
+#include <tbb/task_arena.h>
 
 #include <gtsam/sfm/ShonanAveraging.h>
+#include <gtsam/slam/BetweenFactor.h>
 #include <gtsam/slam/InitializePose.h>
-#include <gtsam/slam/dataset.h>
+
+#include "parametrization/Vectors3d.h"
 
 namespace gdr {
 
+    /** Same information as in the EDGE_SE3:QUAT lines of RelativePosesG2oFormat */
+    constexpr double informationRelativeRotationShonan = 10000.0;
+
+    int getNumberOfPosesRotationAveraging(const std::vector<RotationMeasurement> &relativeRotations) {
+
+        int maxIndex = -1;
+
+        for (const auto &relativeRotation: relativeRotations) {
+            if (relativeRotation.getIndexFromDestination() < relativeRotation.getIndexToToBeTransformed()) {
+                maxIndex = std::max(maxIndex, relativeRotation.getIndexToToBeTransformed());
+            }
+        }
+
+        return maxIndex + 1;
+    }
+
     std::vector<SO3> RotationAverager::shanonAveraging(
             const std::vector<RotationMeasurement> &relativeRotations,
             int indexPoseFixed,
             const std::string &pathToRelativeRotationsOut,
-            int maxDimension) {
+            int maxDimension,
+            const std::vector<SO3> &initialRotations,
+            int numberOfStarts,
+            std::vector<ShonanStartStatus> *statusByStart) {
+
+        if (!pathToRelativeRotationsOut.empty()) {
+            std::ofstream outRelRotations(pathToRelativeRotationsOut);
+            outRelRotations << RelativePosesG2oFormat(relativeRotations);
+        }
+
+        assert(!relativeRotations.empty());
+
+        auto noiseRotation = gtsam::noiseModel::Isotropic::Sigma(3, 1.0 / std::sqrt(informationRelativeRotationShonan));
+        auto noisePose = gtsam::noiseModel::Diagonal::Precisions(
+                gtsam::Vector6::Constant(informationRelativeRotationShonan));
+
+        gtsam::ShonanAveraging3::Measurements measurements;
+        gtsam::NonlinearFactorGraph inputGraph;
+
+        int maxIndex = -1;
 
+        for (const auto &relativeRotation: relativeRotations) {
+            int indexFromDestination = relativeRotation.getIndexFromDestination();
+            int indexToToBeTransformed = relativeRotation.getIndexToToBeTransformed();
 
-        std::ofstream outRelRotations(pathToRelativeRotationsOut);
-        outRelRotations << RelativePosesG2oFormat(relativeRotations);
+            if (indexFromDestination >= indexToToBeTransformed) {
+                continue;
+            }
+
+            assert(indexFromDestination >= 0);
+            maxIndex = std::max(maxIndex, indexToToBeTransformed);
+
+            gtsam::Rot3 rotation(relativeRotation.getRotationSO3().getUnitQuaternion());
+
+            measurements.emplace_back(gtsam::BinaryMeasurement<gtsam::Rot3>(
+                    indexFromDestination, indexToToBeTransformed, rotation, noiseRotation));
+            inputGraph.emplace_shared<gtsam::BetweenFactor<gtsam::Pose3>>(
+                    indexFromDestination, indexToToBeTransformed,
+                    gtsam::Pose3(rotation, gtsam::Point3(0, 0, 0)), noisePose);
+        }
+
+        assert(maxIndex > 0);
 
         std::vector<SO3> absoluteRotationsSO3;
 
+        int numberOfStartsToRun = std::max(1, numberOfStarts);
         int seed = 42;
-        std::mt19937 rng(seed);
 
-        gtsam::NonlinearFactorGraph::shared_ptr inputGraph;
-        gtsam::Values::shared_ptr posesInFile;
-        gtsam::Values poses;
-        {
+        gtsam::ShonanAveragingParameters3 parameters;
+
+        std::vector<gtsam::Values> rotationsByStart(numberOfStartsToRun);
+        std::vector<double> costByStart(numberOfStartsToRun, std::numeric_limits<double>::infinity());
+        // runs which are not finished keep cancelled status and their solutions are not used
+        std::vector<ShonanStartStatus> statusOfStarts(numberOfStartsToRun, ShonanStartStatus::CANCELLED);
+        std::atomic<bool> certifiedSolutionFound(false);
+
+        // the same steps as in ShonanAveraging::run with early exit when other start is already certified
+        auto runShonanFromStart = [&](int startIndex) {
+
+            gtsam::ShonanAveraging3 shonan(measurements, parameters);
+            gtsam::Values initial;
+
+            if (startIndex == 0 && !initialRotations.empty()) {
+                assert(initialRotations.size() == maxIndex + 1);
+
+                for (int poseIndex = 0; poseIndex < initialRotations.size(); ++poseIndex) {
+                    initial.insert(poseIndex, gtsam::Rot3(initialRotations[poseIndex].getRotationSophus().matrix()));
+                }
+            } else {
+                std::mt19937 rng(seed + startIndex);
+                initial = shonan.initializeRandomly(rng);
+            }
+
+            int minDimension = 3;
+            gtsam::Values initialSOp = gtsam::ShonanAveraging3::LiftTo<gtsam::Rot3>(minDimension, initial);
 
-            gtsam::ShonanAveraging3 shonan(pathToRelativeRotationsOut);
-            auto initial = shonan.initializeRandomly(rng);
+            for (int dimension = minDimension; dimension <= maxDimension; ++dimension) {
 
-            auto result = shonan.run(initial, 3, maxDimension);
+                if (certifiedSolutionFound.load()) {
+                    return;
+                }
 
-            boost::tie(inputGraph, posesInFile) = gtsam::load3D(pathToRelativeRotationsOut);
+                gtsam::Values SOp = shonan.tryOptimizingAt(dimension, initialSOp);
+                gtsam::Vector minEigenVector;
+                double minEigenValue = shonan.computeMinEigenValue(SOp, &minEigenVector);
+                bool isCertified = minEigenValue > parameters.getOptimalityThreshold();
+
+                if (isCertified || dimension == maxDimension) {
+                    rotationsByStart[startIndex] = shonan.roundSolution(SOp);
+                    costByStart[startIndex] = shonan.cost(rotationsByStart[startIndex]);
+                    statusOfStarts[startIndex] = isCertified ? ShonanStartStatus::CERTIFIED
+                                                             : ShonanStartStatus::NOT_CERTIFIED;
+
+                    if (isCertified) {
+                        certifiedSolutionFound.store(true);
+                    }
+                    return;
+                }
+
+                initialSOp = shonan.initializeWithDescent(dimension + 1, SOp, minEigenVector, minEigenValue);
+            }
+        };
+
+        tbb::task_group_context contextStarts;
+        tbb::task_arena arenaStarts(std::min(numberOfStartsToRun,
+                                             std::max(1, static_cast<int>(std::thread::hardware_concurrency()))));
+
+        arenaStarts.execute([&]() {
+            // each start is a separate task
+            tbb::parallel_for(tbb::blocked_range<int>(0, numberOfStartsToRun, 1),
+                              [&](const tbb::blocked_range<int> &startIndices) {
+                                  for (int startIndex = startIndices.begin();
+                                       startIndex != startIndices.end(); ++startIndex) {
+                                      runShonanFromStart(startIndex);
+
+                                      if (statusOfStarts[startIndex] == ShonanStartStatus::CERTIFIED) {
+                                          contextStarts.cancel_group_execution();
+                                      }
+                                  }
+                              },
+                              tbb::simple_partitioner(),
+                              contextStarts);
+        });
+
+        if (statusByStart) {
+            *statusByStart = statusOfStarts;
+        }
+
+        int bestStart = -1;
+
+        for (int startIndex = 0; startIndex < numberOfStartsToRun; ++startIndex) {
+            if (statusOfStarts[startIndex] == ShonanStartStatus::CANCELLED) {
+                continue;
+            }
+
+            bool isCertified = statusOfStarts[startIndex] == ShonanStartStatus::CERTIFIED;
+            bool isBestCertified = bestStart >= 0 && statusOfStarts[bestStart] == ShonanStartStatus::CERTIFIED;
+
+            if (bestStart < 0
+                || (isCertified && !isBestCertified)
+                || (isCertified == isBestCertified && costByStart[startIndex] < costByStart[bestStart])) {
+                bestStart = startIndex;
+            }
+        }
+
+        assert(bestStart >= 0);
+
+        gtsam::Values poses;
+        {
             auto priorModel = gtsam::noiseModel::Unit::Create(6);
-            inputGraph->addPrior(0, posesInFile->at<gtsam::Pose3>(0), priorModel);
+            inputGraph.addPrior(0, gtsam::Pose3(), priorModel);
 
-            auto poseGraph = gtsam::initialize::buildPoseGraph<gtsam::Pose3>(*inputGraph);
-            poses = gtsam::initialize::computePoses<gtsam::Pose3>(result.first, &poseGraph);
+            auto poseGraph = gtsam::initialize::buildPoseGraph<gtsam::Pose3>(inputGraph);
+            poses = gtsam::initialize::computePoses<gtsam::Pose3>(rotationsByStart[bestStart], &poseGraph);
         }
 
         for (const auto key_value : poses) {
@@ -67,4 +224,213 @@ namespace gdr {
 
         return absoluteRotationsSO3;
     }
-}
\ No newline at end of file
+
+    std::vector<SO3> RotationAverager::spanningTreeInitialization(
+            const std::vector<RotationMeasurement> &relativeRotations,
+            int indexPoseFixed) {
+
+        int numberOfPoses = getNumberOfPosesRotationAveraging(relativeRotations);
+        assert(indexPoseFixed >= 0 && indexPoseFixed < numberOfPoses);
+
+        // edge index and pose index on the other side of edge
+        std::vector<std::vector<std::pair<int, int>>> edgesByPose(numberOfPoses);
+
+        for (int edgeIndex = 0; edgeIndex < relativeRotations.size(); ++edgeIndex) {
+            int indexFrom = relativeRotations[edgeIndex].getIndexFromDestination();
+            int indexTo = relativeRotations[edgeIndex].getIndexToToBeTransformed();
+
+            if (indexFrom >= indexTo) {
+                continue;
+            }
+
+            edgesByPose[indexFrom].emplace_back(std::make_pair(edgeIndex, indexTo));
+            edgesByPose[indexTo].emplace_back(std::make_pair(edgeIndex, indexFrom));
+        }
+
+        std::vector<SO3> absoluteRotations(numberOfPoses);
+        std::vector<bool> poseIsVisited(numberOfPoses, false);
+
+        // Prim's algorithm: edge weight, edge index and pose index the edge is traversed from
+        using weightAndEdgeFromPose = std::pair<double, std::pair<int, int>>;
+        std::priority_queue<weightAndEdgeFromPose> edgesToTraverse;
+
+        auto visitPose = [&](int poseIndex) {
+            poseIsVisited[poseIndex] = true;
+
+            for (const auto &edgeAndNeighbour: edgesByPose[poseIndex]) {
+                if (!poseIsVisited[edgeAndNeighbour.second]) {
+                    edgesToTraverse.push({relativeRotations[edgeAndNeighbour.first].getWeight(),
+                                          {edgeAndNeighbour.first, poseIndex}});
+                }
+            }
+        };
+
+        absoluteRotations[indexPoseFixed] = SO3(Eigen::Matrix3d::Identity());
+        visitPose(indexPoseFixed);
+
+        while (!edgesToTraverse.empty()) {
+            auto edgeToTraverse = edgesToTraverse.top();
+            edgesToTraverse.pop();
+
+            const auto &relativeRotation = relativeRotations[edgeToTraverse.second.first];
+            int poseIndexKnown = edgeToTraverse.second.second;
+            bool isForwardDirection = (poseIndexKnown == relativeRotation.getIndexFromDestination());
+            int poseIndexNew = isForwardDirection ?
+                               relativeRotation.getIndexToToBeTransformed() :
+                               relativeRotation.getIndexFromDestination();
+
+            if (poseIsVisited[poseIndexNew]) {
+                continue;
+            }
+
+            // R_to = R_from * R_relative
+            absoluteRotations[poseIndexNew] = isForwardDirection ?
+                                              absoluteRotations[poseIndexKnown] * relativeRotation.getRotationSO3() :
+                                              absoluteRotations[poseIndexKnown] *
+                                              relativeRotation.getRotationSO3().inverse();
+            visitPose(poseIndexNew);
+        }
+
+        assert(std::all_of(poseIsVisited.begin(), poseIsVisited.end(), [](bool isVisited) { return isVisited; }));
+
+        return absoluteRotations;
+    }
+
+    std::vector<SO3> RotationAverager::chordalAveraging(
+            const std::vector<RotationMeasurement> &relativeRotations,
+            int indexPoseFixed) {
+
+        int numberOfPoses = getNumberOfPosesRotationAveraging(relativeRotations);
+        assert(indexPoseFixed >= 0 && indexPoseFixed < numberOfPoses);
+
+        std::vector<SO3> rotationsSpanningTree = spanningTreeInitialization(relativeRotations, indexPoseFixed);
+
+        auto getColumnPoseIndex = [indexPoseFixed](int poseIndex) {
+            assert(poseIndex != indexPoseFixed);
+            return 3 * ((poseIndex < indexPoseFixed) ? poseIndex : (poseIndex - 1));
+        };
+
+        // relation R_from * R_relative = R_to is linear in rows of rotation matrices
+        // and it is the same for each of three rows, so there are 3 independent right hand sides:
+        // R_relative^T * row_from^T - row_to^T = 0
+        std::vector<Tripletd> coefficients;
+        std::vector<Eigen::Matrix3d> rightHandSides;
+
+        for (const auto &relativeRotation: relativeRotations) {
+            int indexFrom = relativeRotation.getIndexFromDestination();
+            int indexTo = relativeRotation.getIndexToToBeTransformed();
+
+            if (indexFrom >= indexTo) {
+                continue;
+            }
+
+            int row = 3 * static_cast<int>(rightHandSides.size());
+            double weightSqrt = std::sqrt(relativeRotation.getWeight());
+            Eigen::Matrix3d relativeTransposed =
+                    weightSqrt * relativeRotation.getRotationSO3().getRotationSophus().matrix().transpose();
+            Eigen::Matrix3d rightHandSide = Eigen::Matrix3d::Zero();
+
+            if (indexFrom != indexPoseFixed) {
+                int column = getColumnPoseIndex(indexFrom);
+                for (int i = 0; i < 3; ++i) {
+                    for (int j = 0; j < 3; ++j) {
+                        coefficients.emplace_back(Tripletd(row + i, column + j, relativeTransposed(i, j)));
+                    }
+                }
+            } else {
+                rightHandSide -= relativeTransposed;
+            }
+
+            if (indexTo != indexPoseFixed) {
+                int column = getColumnPoseIndex(indexTo);
+                for (int i = 0; i < 3; ++i) {
+                    coefficients.emplace_back(Tripletd(row + i, column + i, -weightSqrt));
+                }
+            } else {
+                rightHandSide += weightSqrt * Eigen::Matrix3d::Identity();
+            }
+
+            rightHandSides.emplace_back(rightHandSide);
+        }
+
+        int numberOfUnknowns = 3 * (numberOfPoses - 1);
+        SparseMatrixd systemMatrix(3 * rightHandSides.size(), numberOfUnknowns);
+        systemMatrix.setFromTriplets(coefficients.begin(), coefficients.end());
+
+        Eigen::MatrixXd b(3 * rightHandSides.size(), 3);
+        for (int measurementIndex = 0; measurementIndex < rightHandSides.size(); ++measurementIndex) {
+            b.block<3, 3>(3 * measurementIndex, 0) = rightHandSides[measurementIndex];
+        }
+
+        Eigen::MatrixXd guess(numberOfUnknowns, 3);
+        for (int poseIndex = 0; poseIndex < numberOfPoses; ++poseIndex) {
+            if (poseIndex != indexPoseFixed) {
+                guess.block<3, 3>(getColumnPoseIndex(poseIndex), 0) =
+                        rotationsSpanningTree[poseIndex].getRotationSophus().matrix().transpose();
+            }
+        }
+
+        SparseMatrixd normalMatrix = SparseMatrixd(systemMatrix.transpose()) * systemMatrix;
+        Eigen::MatrixXd normalRightHandSide = systemMatrix.transpose() * b;
+
+        Eigen::ConjugateGradient<SparseMatrixd, Eigen::Lower | Eigen::Upper> solverCG;
+        solverCG.compute(normalMatrix);
+        Eigen::MatrixXd solution = solverCG.solveWithGuess(normalRightHandSide, guess);
+
+        if (solverCG.info() != Eigen::Success) {
+            Eigen::SimplicialLDLT<SparseMatrixd> solverLDLT(normalMatrix);
+
+            if (solverLDLT.info() != Eigen::Success) {
+                return rotationsSpanningTree;
+            }
+            solution = solverLDLT.solve(normalRightHandSide);
+        }
+
+        std::vector<SO3> absoluteRotations(numberOfPoses);
+
+        for (int poseIndex = 0; poseIndex < numberOfPoses; ++poseIndex) {
+            if (poseIndex == indexPoseFixed) {
+                absoluteRotations[poseIndex] = SO3(Eigen::Matrix3d::Identity());
+            } else {
+                // projection to the closest rotation matrix
+                Eigen::Matrix3d rotationRelaxed = solution.block<3, 3>(getColumnPoseIndex(poseIndex), 0).transpose();
+                absoluteRotations[poseIndex] = SO3(rotationRelaxed);
+            }
+        }
+
+        return absoluteRotations;
+    }
+
+    std::vector<SO3> RotationAverager::averageRotations(
+            const std::vector<RotationMeasurement> &relativeRotations,
+            int indexPoseFixed,
+            const RotationAveragingType &averagingType,
+            const std::string &pathToRelativeRotationsOut,
+            int numberOfShonanStarts) {
+
+        if (averagingType == RotationAveragingType::CHORDAL) {
+            if (!pathToRelativeRotationsOut.empty()) {
+                std::ofstream outRelRotations(pathToRelativeRotationsOut);
+                outRelRotations << RelativePosesG2oFormat(relativeRotations);
+            }
+
+            return chordalAveraging(relativeRotations, indexPoseFixed);
+        }
+
+        if (averagingType == RotationAveragingType::CHORDAL_SHONAN) {
+            return shanonAveraging(relativeRotations,
+                                   indexPoseFixed,
+                                   pathToRelativeRotationsOut,
+                                   10,
+                                   chordalAveraging(relativeRotations, indexPoseFixed),
+                                   numberOfShonanStarts);
+        }
+
+        return shanonAveraging(relativeRotations,
+                               indexPoseFixed,
+                               pathToRelativeRotationsOut,
+                               10,
+                               std::vector<SO3>(),
+                               numberOfShonanStarts);
+    }
+}
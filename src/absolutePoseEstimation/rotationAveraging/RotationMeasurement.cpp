@@ -9,9 +9,11 @@ namespace gdr {
 
     RotationMeasurement::RotationMeasurement(const SO3 &relativeRotationToSet,
                                              int newIndexFrom,
-                                             int newIndexTo) : relativeRotationQuat(relativeRotationToSet),
-                                                               indexFromDestination(newIndexFrom),
-                                                               indexToToBeTransformed(newIndexTo) {}
+                                             int newIndexTo,
+                                             double weightToSet) : relativeRotationQuat(relativeRotationToSet),
+                                                                   indexFromDestination(newIndexFrom),
+                                                                   indexToToBeTransformed(newIndexTo),
+                                                                   weight(weightToSet) {}
 
 
     const SO3 &RotationMeasurement::getRotationSO3() const {
@@ -26,4 +28,8 @@ namespace gdr {
     int RotationMeasurement::getIndexToToBeTransformed() const {
         return indexToToBeTransformed;
     }
+
+    double RotationMeasurement::getWeight() const {
+        return weight;
+    }
 }
\ No newline at end of file
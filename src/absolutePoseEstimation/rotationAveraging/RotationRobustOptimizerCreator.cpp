@@ -5,6 +5,7 @@
 
 #include "absolutePoseEstimation/rotationAveraging/RotationRobustOptimizerCreator.h"
 #include "absolutePoseEstimation/rotationAveraging/RotationRobustOptimizerLogSO3.h"
+#include "absolutePoseEstimation/rotationAveraging/RotationRobustOptimizerL1IRLS.h"
 
 namespace gdr {
 
@@ -13,8 +14,10 @@ namespace gdr {
 
         if (robustParameterType == RobustParameterType::DEFAULT) {
 
+        } else if (robustParameterType == RobustParameterType::L1_IRLS) {
+            return std::make_unique<RotationRobustOptimizerL1IRLS>();
         } else {
-            std::cout << "only default ceres optimization is available at the moment" << std::endl;
+            std::cout << "only default ceres and L1-IRLS optimization are available at the moment" << std::endl;
         }
 
         return std::make_unique<RotationRobustOptimizerLogSO3>();
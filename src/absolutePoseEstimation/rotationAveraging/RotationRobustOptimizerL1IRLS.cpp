@@ -0,0 +1,156 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#include <cassert>
+
+#include "absolutePoseEstimation/rotationAveraging/RotationRobustOptimizerL1IRLS.h"
+
+#include "parametrization/Vectors3d.h"
+
+namespace gdr {
+
+    void RotationRobustOptimizerL1IRLS::setNumberOfIterations(int numberOfIterationsL1ToSet,
+                                                              int numberOfIterationsIRLSToSet) {
+        assert(numberOfIterationsL1ToSet >= 0 && numberOfIterationsIRLSToSet >= 0);
+
+        numberOfIterationsL1 = numberOfIterationsL1ToSet;
+        numberOfIterationsIRLS = numberOfIterationsIRLSToSet;
+    }
+
+    void RotationRobustOptimizerL1IRLS::setSigmaGemanMcClure(double sigmaGemanMcClureToSet) {
+        assert(sigmaGemanMcClureToSet > 0);
+
+        sigmaGemanMcClure = sigmaGemanMcClureToSet;
+    }
+
+    std::vector<Eigen::Vector3d> RotationRobustOptimizerL1IRLS::computeIncrements(
+            const std::vector<SO3> &orientations,
+            const std::vector<RotationMeasurement> &relativeRotations,
+            int indexFixed,
+            bool useL1Weights) const {
+
+        int numberOfPoses = static_cast<int>(orientations.size());
+
+        auto getColumnPoseIndex = [indexFixed](int poseIndex) {
+            return (poseIndex < indexFixed) ? poseIndex : (poseIndex - 1);
+        };
+
+        // system matrix is (L x I3) where L is weighted graph laplacian,
+        // so it is enough to solve scalar system with 3 right hand sides
+        std::vector<Tripletd> coefficients;
+        Eigen::MatrixXd rightHandSide = Eigen::MatrixXd::Zero(numberOfPoses - 1, 3);
+
+        for (const auto &relativeRotation: relativeRotations) {
+            int indexFrom = relativeRotation.getIndexFromDestination();
+            int indexTo = relativeRotation.getIndexToToBeTransformed();
+
+            if (indexFrom == indexTo) {
+                continue;
+            }
+
+            Eigen::Vector3d residual = (orientations[indexTo]
+                                        * relativeRotation.getRotationSO3().inverse()
+                                        * orientations[indexFrom].inverse()).getLog();
+            double residualNorm = residual.norm();
+
+            double weightRobust = 0;
+            if (useL1Weights) {
+                weightRobust = 1.0 / std::max(residualNorm, epsilonResidualL1);
+            } else {
+                double sigmaSquared = sigmaGemanMcClure * sigmaGemanMcClure;
+                double denominator = sigmaSquared + residualNorm * residualNorm;
+                weightRobust = sigmaSquared / (denominator * denominator);
+            }
+            double weight = weightRobust * relativeRotation.getWeight();
+
+            // residual equation: w_from - w_to = residual
+            if (indexFrom != indexFixed) {
+                int column = getColumnPoseIndex(indexFrom);
+                coefficients.emplace_back(Tripletd(column, column, weight));
+                rightHandSide.row(column) += weight * residual.transpose();
+            }
+            if (indexTo != indexFixed) {
+                int column = getColumnPoseIndex(indexTo);
+                coefficients.emplace_back(Tripletd(column, column, weight));
+                rightHandSide.row(column) -= weight * residual.transpose();
+            }
+            if (indexFrom != indexFixed && indexTo != indexFixed) {
+                coefficients.emplace_back(Tripletd(getColumnPoseIndex(indexFrom), getColumnPoseIndex(indexTo),
+                                                   -weight));
+                coefficients.emplace_back(Tripletd(getColumnPoseIndex(indexTo), getColumnPoseIndex(indexFrom),
+                                                   -weight));
+            }
+        }
+
+        SparseMatrixd laplacian(numberOfPoses - 1, numberOfPoses - 1);
+        laplacian.setFromTriplets(coefficients.begin(), coefficients.end());
+
+        Eigen::ConjugateGradient<SparseMatrixd, Eigen::Lower | Eigen::Upper> solverCG;
+        solverCG.compute(laplacian);
+        Eigen::MatrixXd solution = solverCG.solve(rightHandSide);
+
+        std::vector<Eigen::Vector3d> increments(numberOfPoses, Eigen::Vector3d::Zero());
+
+        if (solverCG.info() != Eigen::Success) {
+            return increments;
+        }
+
+        for (int poseIndex = 0; poseIndex < numberOfPoses; ++poseIndex) {
+            if (poseIndex != indexFixed) {
+                increments[poseIndex] = solution.row(getColumnPoseIndex(poseIndex)).transpose();
+            }
+        }
+
+        return increments;
+    }
+
+    std::vector<SO3> RotationRobustOptimizerL1IRLS::getOptimizedOrientation(
+            const std::vector<SO3> &orientationsToSet,
+            const std::vector<RotationMeasurement> &pairWiseRotationsToSet,
+            int indexFixed) {
+
+        assert(indexFixed >= 0 && indexFixed < orientationsToSet.size());
+
+        std::vector<SO3> orientations = orientationsToSet;
+
+        if (orientations.size() < 2) {
+            return orientations;
+        }
+
+        for (const auto &relativeRotation: pairWiseRotationsToSet) {
+            assert(relativeRotation.getIndexFromDestination() >= 0
+                   && relativeRotation.getIndexFromDestination() < orientations.size());
+            assert(relativeRotation.getIndexToToBeTransformed() >= 0
+                   && relativeRotation.getIndexToToBeTransformed() < orientations.size());
+        }
+
+        int totalIterations = numberOfIterationsL1 + numberOfIterationsIRLS;
+
+        for (int iteration = 0; iteration < totalIterations; ++iteration) {
+
+            bool useL1Weights = iteration < numberOfIterationsL1;
+            std::vector<Eigen::Vector3d> increments = computeIncrements(orientations,
+                                                                        pairWiseRotationsToSet,
+                                                                        indexFixed,
+                                                                        useL1Weights);
+            double sumIncrementNorms = 0;
+
+            for (int poseIndex = 0; poseIndex < orientations.size(); ++poseIndex) {
+                orientations[poseIndex] = SO3(Sophus::SO3d::exp(increments[poseIndex])) * orientations[poseIndex];
+                sumIncrementNorms += increments[poseIndex].norm();
+            }
+
+            if (sumIncrementNorms / orientations.size() < thresholdUpdateConvergence) {
+                if (useL1Weights) {
+                    iteration = numberOfIterationsL1 - 1;
+                } else {
+                    break;
+                }
+            }
+        }
+
+        return orientations;
+    }
+}
@@ -9,6 +9,21 @@
 
 namespace gdr {
 
+    void RotationRobustOptimizerLogSO3::setUseAnalyticJacobians(bool useAnalyticJacobiansToSet) {
+        useAnalyticJacobians = useAnalyticJacobiansToSet;
+    }
+
+    void RotationRobustOptimizerLogSO3::setNumberOfThreads(int numberOfThreadsToSet) {
+        assert(numberOfThreadsToSet > 0);
+        numberOfThreads = numberOfThreadsToSet;
+    }
+
+    void RotationRobustOptimizerLogSO3::setLinearSolver(const ceres::LinearSolverType &linearSolverTypeToSet,
+                                                        const ceres::PreconditionerType &preconditionerTypeToSet) {
+        linearSolverType = linearSolverTypeToSet;
+        preconditionerType = preconditionerTypeToSet;
+    }
+
     std::vector<SO3> RotationRobustOptimizerLogSO3::getOptimizedOrientation(const std::vector<SO3> &orientationsToSet,
                                                                             const std::vector<RotationMeasurement> &pairWiseRotationsToSet,
                                                                             int indexFixed) {
@@ -31,7 +46,11 @@ namespace gdr {
         for (const auto &relativeRotObservation: relativeRotations) {
 
             assert(result[relativeRotObservation.getIndexToToBeTransformed()].size() == dim);
-            ceres::CostFunction *cost_function = RelativeRotationError::Create(relativeRotObservation.getRotationSO3());
+            ceres::CostFunction *cost_function = useAnalyticJacobians ?
+                                                 RelativeRotationErrorAnalytic::Create(
+                                                         relativeRotObservation.getRotationSO3()) :
+                                                 RelativeRotationError::Create(
+                                                         relativeRotObservation.getRotationSO3());
 
             int indexFrom = relativeRotObservation.getIndexFromDestination();
             int indexTo = relativeRotObservation.getIndexToToBeTransformed();
@@ -54,7 +73,9 @@ namespace gdr {
 
 
         ceres::Solver::Options options;
-        options.linear_solver_type = ceres::SPARSE_NORMAL_CHOLESKY;
+        options.linear_solver_type = linearSolverType;
+        options.preconditioner_type = preconditionerType;
+        options.num_threads = std::max(1, numberOfThreads);
         options.minimizer_progress_to_stdout = false;
         ceres::Solver::Summary summary;
         ceres::Solve(options, &problem, &summary);
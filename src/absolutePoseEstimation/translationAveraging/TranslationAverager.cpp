@@ -3,10 +3,13 @@
 // Licensed under the MIT license. See LICENSE file in the project root for details.
 //
 
+#include <cassert>
 #include <iostream>
 #include <sophus/se3.hpp>
 
 #include "absolutePoseEstimation/translationAveraging/TranslationAverager.h"
+#include "absolutePoseEstimation/translationAveraging/TranslationSolverSparseCholesky.h"
+#include "absolutePoseEstimation/translationAveraging/TranslationSolverBlockJacobiPCG.h"
 #include "parametrization/Vectors3d.h"
 
 namespace gdr {
@@ -112,22 +115,91 @@ namespace gdr {
         return Vectors3d(solutionL2);
     }
 
+    std::unique_ptr<TranslationNormalEquationsSolver> TranslationAverager::getNormalEquationsSolver(
+            const std::vector<TranslationMeasurement> &relativeTranslations,
+            int numberOfPoses,
+            int indexPoseFixed,
+            const TranslationSolverType &solverType) {
+
+        if (solverType == TranslationSolverType::BLOCK_JACOBI_PCG) {
+            return std::make_unique<TranslationSolverBlockJacobiPCG>(relativeTranslations,
+                                                                     numberOfPoses,
+                                                                     indexPoseFixed);
+        }
+
+        assert(solverType == TranslationSolverType::SPARSE_CHOLESKY);
+
+        return std::make_unique<TranslationSolverSparseCholesky>(relativeTranslations,
+                                                                 numberOfPoses,
+                                                                 indexPoseFixed);
+    }
+
+    std::vector<double> TranslationAverager::getMeasurementWeights(
+            const std::vector<TranslationMeasurement> &relativeTranslations) {
+
+        std::vector<double> measurementWeights;
+        measurementWeights.reserve(relativeTranslations.size());
+
+        double sumWeightsKnown = 0;
+        int numberOfWeightsKnown = 0;
+
+        for (const auto &relativeTranslation: relativeTranslations) {
+            const auto &quality = relativeTranslation.getQuality();
+            measurementWeights.emplace_back(quality.getTranslationWeight());
+
+            if (quality.isKnown()) {
+                sumWeightsKnown += measurementWeights.back();
+                ++numberOfWeightsKnown;
+            }
+        }
+
+        // known weights are scaled to mean 1 to be comparable with measurements without statistics
+        if (numberOfWeightsKnown > 0) {
+            double meanWeightKnown = sumWeightsKnown / numberOfWeightsKnown;
+
+            for (int i = 0; i < relativeTranslations.size(); ++i) {
+                if (relativeTranslations[i].getQuality().isKnown()) {
+                    measurementWeights[i] /= meanWeightKnown;
+                }
+            }
+        }
+
+        return measurementWeights;
+    }
+
+    std::vector<double> TranslationAverager::getWeightsRaw(const std::vector<double> &residualNorms,
+                                                           const std::vector<double> &measurementWeights,
+                                                           double epsilonWeightMin) {
+        assert(residualNorms.size() == measurementWeights.size());
+
+        std::vector<double> weights;
+        weights.reserve(residualNorms.size());
+
+        for (int i = 0; i < residualNorms.size(); ++i) {
+            //square the residual
+            weights.emplace_back(measurementWeights[i] / std::max(pow(residualNorms[i], 2), epsilonWeightMin));
+        }
+
+        return weights;
+    }
+
     SparseMatrixd
-    TranslationAverager::getWeightMatrixRaw(const std::vector<double> &weights,
+    TranslationAverager::getWeightMatrixRaw(const std::vector<double> &residualNorms,
+                                            const std::vector<double> &measurementWeights,
                                             double epsilonWeightMin) {
 
         int dim = 3;
-        SparseMatrixd weightDiagonalMatrix(dim * weights.size(), dim * weights.size());
+        SparseMatrixd weightDiagonalMatrix(dim * residualNorms.size(), dim * residualNorms.size());
         std::vector<Tripletd> coefficients;
-        coefficients.reserve(dim * weights.size());
+        coefficients.reserve(dim * residualNorms.size());
 
-        for (int i = 0; i < weights.size(); ++i) {
+        std::vector<double> weightsRaw = getWeightsRaw(residualNorms, measurementWeights, epsilonWeightMin);
+
+        for (int i = 0; i < residualNorms.size(); ++i) {
             for (int toDim = 0; toDim < dim; ++toDim) {
 
                 int newRowColumnNumber = dim * i + toDim;
-                //square the residual
-                double newWeight = 1.0 / std::max(pow(weights[i], 2), epsilonWeightMin);
-                coefficients.emplace_back(Tripletd(newRowColumnNumber, newRowColumnNumber, newWeight));
+                coefficients.emplace_back(Tripletd(newRowColumnNumber, newRowColumnNumber, weightsRaw[i]));
             }
         }
         weightDiagonalMatrix.setFromTriplets(coefficients.begin(), coefficients.end());
@@ -140,6 +212,7 @@ namespace gdr {
                               const Vectors3d &b,
                               SparseMatrixd &weightDiagonalMatrix,
                               const Vectors3d &translationsGuess,
+                              const std::vector<double> &measurementWeights,
                               bool &success,
                               int numOfIterations,
                               double epsilonIRLS) {
@@ -174,7 +247,55 @@ namespace gdr {
                 std::numeric_limits<double>::epsilon()) {
                 return bestSolutionAbsoluteTranslations;
             }
-            weightDiagonalMatrix = getWeightMatrixRaw(residuals.getVectorOfNorms(), epsilonIRLS);
+            weightDiagonalMatrix = getWeightMatrixRaw(residuals.getVectorOfNorms(), measurementWeights, epsilonIRLS);
+
+            std::swap(prevResiduals, residuals);
+        }
+
+        return bestSolutionAbsoluteTranslations;
+    }
+
+    Vectors3d
+    TranslationAverager::IRLSNormalEquations(const SparseMatrixd &systemMatrix,
+                                             const Vectors3d &b,
+                                             TranslationNormalEquationsSolver &normalEquationsSolver,
+                                             const Vectors3d &translationsGuess,
+                                             const std::vector<double> &measurementWeights,
+                                             bool &success,
+                                             int numOfIterations,
+                                             double epsilonIRLS) {
+
+        success = false;
+
+        Vectors3d bestSolutionAbsoluteTranslations(translationsGuess);
+        Vectors3d prevResiduals = b - (SparseMatrixClass(systemMatrix) * translationsGuess);
+
+        // the first solve uses measurement weights only as in IRLS so both solvers share iteration schedule
+        std::vector<double> weights = getWeightsRaw(std::vector<double>(measurementWeights.size(), 1.0),
+                                                    measurementWeights,
+                                                    epsilonIRLS);
+
+        for (int iteration = 0; iteration < numOfIterations; ++iteration) {
+
+            Vectors3d currentSolutionAbsoluteTranslations;
+
+            if (!normalEquationsSolver.solve(weights,
+                                             b,
+                                             bestSolutionAbsoluteTranslations,
+                                             currentSolutionAbsoluteTranslations)) {
+                return bestSolutionAbsoluteTranslations;
+            }
+
+            success = true;
+            std::swap(bestSolutionAbsoluteTranslations, currentSolutionAbsoluteTranslations);
+
+            Vectors3d residuals = b - (SparseMatrixClass(systemMatrix) * bestSolutionAbsoluteTranslations);
+
+            if ((residuals.getVectorRaw() - prevResiduals.getVectorRaw()).norm() <
+                std::numeric_limits<double>::epsilon()) {
+                return bestSolutionAbsoluteTranslations;
+            }
+            weights = getWeightsRaw(residuals.getVectorOfNorms(), measurementWeights, epsilonIRLS);
 
             std::swap(prevResiduals, residuals);
         }
@@ -202,7 +323,10 @@ namespace gdr {
             relativePoseFromTo = relativePoseFromTo.inverse();
 
             relativeTranslationsInversed.emplace_back(
-                    TranslationMeasurement(relativePoseFromTo.translation(), indexFrom, indexTo));
+                    TranslationMeasurement(relativePoseFromTo.translation(),
+                                           indexFrom,
+                                           indexTo,
+                                           relativeTranslation.getQuality()));
         }
 
         return relativeTranslationsInversed;
@@ -216,7 +340,8 @@ namespace gdr {
                                                  int indexPoseFixed,
                                                  bool &successIRLS,
                                                  int numOfIterations,
-                                                 double epsilonWeightIRLS) {
+                                                 double epsilonWeightIRLS,
+                                                 const TranslationSolverType &solverType) {
 
         std::vector<TranslationMeasurement> relativeTranslationsInversed =
                 getInversedTranslationMeasurements(relativeTranslations,
@@ -230,17 +355,38 @@ namespace gdr {
                                            absolutePoses);
 
         successIRLS = true;
-        std::vector<double> weightsId(b.getSize(), 1.0);
+        auto vectorsExcludingFixedRaw = absoluteTranslations.getCopyWithoutVector(indexPoseFixed);
+        std::vector<double> measurementWeights = getMeasurementWeights(relativeTranslationsInversed);
+
+        if (solverType != TranslationSolverType::LEAST_SQUARES_CG) {
+            auto normalEquationsSolver = getNormalEquationsSolver(relativeTranslationsInversed,
+                                                                  static_cast<int>(absolutePoses.size()),
+                                                                  indexPoseFixed,
+                                                                  solverType);
+
+            return IRLSNormalEquations(systemMatrix,
+                                       b,
+                                       *normalEquationsSolver,
+                                       vectorsExcludingFixedRaw,
+                                       measurementWeights,
+                                       successIRLS,
+                                       numOfIterations,
+                                       epsilonWeightIRLS)
+                    .getCopyWithInsertedVector(indexPoseFixed,
+                                               Eigen::Vector3d(0, 0, 0));
+        }
 
-        SparseMatrixd weightMatrixSparse = getWeightMatrixRaw(weightsId,
-                                                              epsilonWeightIRLS);
+        std::vector<double> residualsId(b.getSize(), 1.0);
 
-        auto vectorsExcludingFixedRaw = absoluteTranslations.getCopyWithoutVector(indexPoseFixed);
+        SparseMatrixd weightMatrixSparse = getWeightMatrixRaw(residualsId,
+                                                              measurementWeights,
+                                                              epsilonWeightIRLS);
 
         auto solutionsWithoutPoseFixed = IRLS(systemMatrix,
                                               b,
                                               weightMatrixSparse,
                                               vectorsExcludingFixedRaw,
+                                              measurementWeights,
                                               successIRLS,
                                               numOfIterations,
                                               epsilonWeightIRLS);
@@ -253,7 +399,8 @@ namespace gdr {
     Vectors3d
     TranslationAverager::recoverTranslations(const std::vector<TranslationMeasurement> &relativeTranslations,
                                              const std::vector<SE3> &absolutePoses,
-                                             int indexPoseFixed) {
+                                             int indexPoseFixed,
+                                             const TranslationSolverType &solverType) {
 
         std::vector<TranslationMeasurement> relativeTranslationsInversed =
                 getInversedTranslationMeasurements(relativeTranslations,
@@ -265,13 +412,31 @@ namespace gdr {
 
         Vectors3d b = constructColumnTermB(relativeTranslationsInversed, absolutePoses);
         bool success = true;
-        std::vector<double> weightsId(b.getSize(), 1.0);
 
-        // weight 1e-6 is not used here because each weight is zero
+        // initial solution is weighted by quality of pairwise estimations
+        std::vector<double> measurementWeights = getMeasurementWeights(relativeTranslationsInversed);
+
+        if (solverType != TranslationSolverType::LEAST_SQUARES_CG) {
+            auto normalEquationsSolver = getNormalEquationsSolver(relativeTranslationsInversed,
+                                                                  static_cast<int>(absolutePoses.size()),
+                                                                  indexPoseFixed,
+                                                                  solverType);
+            Vectors3d solutionWithoutFixedPose;
+            success = normalEquationsSolver->solve(measurementWeights, b, Vectors3d(), solutionWithoutFixedPose);
+
+            if (success) {
+                return solutionWithoutFixedPose.getCopyWithInsertedVector(indexPoseFixed,
+                                                                          Eigen::Vector3d(0, 0, 0));
+            }
+        }
+
+        // weight 1e-6 is not used here because each residual is one
+        std::vector<double> residualsId(b.getSize(), 1.0);
         auto solutionWithoutFixedPose = findLeastSquaresSolution(systemMatrix,
                                                                  b,
                                                                  success,
-                                                                 getWeightMatrixRaw(weightsId,
+                                                                 getWeightMatrixRaw(residualsId,
+                                                                                    measurementWeights,
                                                                                     1e-6));
 
         return solutionWithoutFixedPose.getCopyWithInsertedVector(indexPoseFixed,
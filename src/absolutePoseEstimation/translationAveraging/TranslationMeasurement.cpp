@@ -8,9 +8,12 @@
 namespace gdr {
 
     TranslationMeasurement::TranslationMeasurement(const Eigen::Vector3d &newTranslation3d, int newIndexFrom,
-                                                   int newIndexTo) : translation3d(newTranslation3d),
-                                                                     indexFrom(newIndexFrom),
-                                                                     indexTo(newIndexTo) {}
+                                                   int newIndexTo,
+                                                   const RelativePoseQuality &newQuality) :
+            translation3d(newTranslation3d),
+            indexFrom(newIndexFrom),
+            indexTo(newIndexTo),
+            quality(newQuality) {}
 
     const Eigen::Vector3d &TranslationMeasurement::getTranslation() const {
         return translation3d;
@@ -24,5 +27,9 @@ namespace gdr {
     int TranslationMeasurement::getIndexToDestination() const {
         return indexTo;
     }
+
+    const RelativePoseQuality &TranslationMeasurement::getQuality() const {
+        return quality;
+    }
 }
 
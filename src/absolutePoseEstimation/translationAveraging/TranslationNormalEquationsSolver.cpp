@@ -0,0 +1,16 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#include "absolutePoseEstimation/translationAveraging/TranslationNormalEquationsSolver.h"
+
+namespace gdr {
+
+    int TranslationNormalEquationsSolver::getReducedIndex(int poseIndex, int indexPoseFixed) {
+        if (poseIndex == indexPoseFixed) {
+            return -1;
+        }
+        return (poseIndex < indexPoseFixed) ? poseIndex : (poseIndex - 1);
+    }
+}
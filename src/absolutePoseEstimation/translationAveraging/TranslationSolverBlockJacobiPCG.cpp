@@ -0,0 +1,214 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#include <cassert>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include "absolutePoseEstimation/translationAveraging/TranslationSolverBlockJacobiPCG.h"
+
+namespace gdr {
+
+    TranslationSolverBlockJacobiPCG::TranslationSolverBlockJacobiPCG(
+            const std::vector<TranslationMeasurement> &relativeTranslations,
+            int numberOfPosesToSet,
+            int indexPoseFixedToSet,
+            int maxNumberOfIterationsToSet,
+            double toleranceToSet) :
+            numberOfPoses(numberOfPosesToSet),
+            indexPoseFixed(indexPoseFixedToSet),
+            maxNumberOfIterations(maxNumberOfIterationsToSet),
+            tolerance(toleranceToSet) {
+
+        assert(indexPoseFixed >= 0 && indexPoseFixed < numberOfPoses);
+        assert(maxNumberOfIterations > 0);
+
+        int matrixSize = numberOfPoses - 1;
+        std::vector<int> numberOfIncidentMeasurements(matrixSize, 0);
+
+        reducedIndicesFromTo.reserve(relativeTranslations.size());
+
+        for (const auto &relativeT: relativeTranslations) {
+            int indexFrom = getReducedIndex(relativeT.getIndexFromToBeTransformed(), indexPoseFixed);
+            int indexTo = getReducedIndex(relativeT.getIndexToDestination(), indexPoseFixed);
+
+            assert(indexFrom < matrixSize && indexTo < matrixSize);
+            reducedIndicesFromTo.emplace_back(std::make_pair(indexFrom, indexTo));
+
+            for (int poseIndex: {indexFrom, indexTo}) {
+                if (poseIndex >= 0) {
+                    ++numberOfIncidentMeasurements[poseIndex];
+                }
+            }
+        }
+
+        incidentMeasurementsStarts.assign(matrixSize + 1, 0);
+        for (int i = 0; i < matrixSize; ++i) {
+            incidentMeasurementsStarts[i + 1] = incidentMeasurementsStarts[i] + numberOfIncidentMeasurements[i];
+        }
+
+        incidentMeasurements.resize(incidentMeasurementsStarts.back());
+        std::vector<int> positionToInsert(incidentMeasurementsStarts.begin(), incidentMeasurementsStarts.end() - 1);
+
+        for (int measurementIndex = 0; measurementIndex < reducedIndicesFromTo.size(); ++measurementIndex) {
+            for (int poseIndex: {reducedIndicesFromTo[measurementIndex].first,
+                                 reducedIndicesFromTo[measurementIndex].second}) {
+                if (poseIndex >= 0) {
+                    incidentMeasurements[positionToInsert[poseIndex]++] = measurementIndex;
+                }
+            }
+        }
+    }
+
+    void TranslationSolverBlockJacobiPCG::computeLaplacianProduct(const MatrixX3d &x, MatrixX3d &result) const {
+
+        result.resize(x.rows(), 3);
+
+        tbb::parallel_for(tbb::blocked_range<int>(0, static_cast<int>(x.rows())),
+                          [&](const tbb::blocked_range<int> &range) {
+                              for (int poseIndex = range.begin(); poseIndex < range.end(); ++poseIndex) {
+                                  Eigen::RowVector3d sum = Eigen::RowVector3d::Zero();
+
+                                  for (int position = incidentMeasurementsStarts[poseIndex];
+                                       position < incidentMeasurementsStarts[poseIndex + 1]; ++position) {
+                                      int measurementIndex = incidentMeasurements[position];
+                                      const auto &indicesFromTo = reducedIndicesFromTo[measurementIndex];
+                                      int poseIndexOther = (indicesFromTo.first == poseIndex) ?
+                                                           indicesFromTo.second : indicesFromTo.first;
+
+                                      Eigen::RowVector3d difference = x.row(poseIndex);
+                                      if (poseIndexOther >= 0) {
+                                          difference -= x.row(poseIndexOther);
+                                      }
+                                      sum += weightsSquared[measurementIndex] * difference;
+                                  }
+
+                                  result.row(poseIndex) = sum;
+                              }
+                          });
+    }
+
+    void TranslationSolverBlockJacobiPCG::computeRightHandSide(const Vectors3d &b, MatrixX3d &result) const {
+
+        const Eigen::VectorXd &bRaw = b.getVectorRaw();
+        result.resize(numberOfPoses - 1, 3);
+
+        tbb::parallel_for(tbb::blocked_range<int>(0, numberOfPoses - 1),
+                          [&](const tbb::blocked_range<int> &range) {
+                              for (int poseIndex = range.begin(); poseIndex < range.end(); ++poseIndex) {
+                                  Eigen::RowVector3d sum = Eigen::RowVector3d::Zero();
+
+                                  for (int position = incidentMeasurementsStarts[poseIndex];
+                                       position < incidentMeasurementsStarts[poseIndex + 1]; ++position) {
+                                      int measurementIndex = incidentMeasurements[position];
+                                      double sign = (reducedIndicesFromTo[measurementIndex].first == poseIndex) ?
+                                                    1.0 : -1.0;
+
+                                      sum += sign * weightsSquared[measurementIndex]
+                                             * bRaw.segment<3>(3 * measurementIndex).transpose();
+                                  }
+
+                                  result.row(poseIndex) = sum;
+                              }
+                          });
+    }
+
+    bool TranslationSolverBlockJacobiPCG::solve(const std::vector<double> &weights,
+                                                const Vectors3d &b,
+                                                const Vectors3d &initialGuess,
+                                                Vectors3d &solution) {
+
+        assert(weights.size() == reducedIndicesFromTo.size());
+        assert(b.getSize() == reducedIndicesFromTo.size());
+
+        int matrixSize = numberOfPoses - 1;
+
+        weightsSquared.resize(weights.size());
+        for (int i = 0; i < weights.size(); ++i) {
+            weightsSquared[i] = weights[i] * weights[i];
+        }
+
+        diagonalInversed.setZero(matrixSize);
+        for (int i = 0; i < reducedIndicesFromTo.size(); ++i) {
+            for (int poseIndex: {reducedIndicesFromTo[i].first, reducedIndicesFromTo[i].second}) {
+                if (poseIndex >= 0) {
+                    diagonalInversed[poseIndex] += weightsSquared[i];
+                }
+            }
+        }
+        for (int i = 0; i < matrixSize; ++i) {
+            diagonalInversed[i] = (diagonalInversed[i] > 0) ? (1.0 / diagonalInversed[i]) : 0.0;
+        }
+
+        MatrixX3d rightHandSide;
+        computeRightHandSide(b, rightHandSide);
+
+        MatrixX3d x = MatrixX3d::Zero(matrixSize, 3);
+        if (initialGuess.getSize() > 0) {
+            assert(initialGuess.getSize() == matrixSize);
+            x = Eigen::Map<const MatrixX3d>(initialGuess.getVectorRaw().data(), matrixSize, 3);
+        }
+
+        MatrixX3d laplacianProduct;
+        computeLaplacianProduct(x, laplacianProduct);
+
+        MatrixX3d residual = rightHandSide - laplacianProduct;
+        MatrixX3d preconditioned = diagonalInversed.asDiagonal() * residual;
+        MatrixX3d direction = preconditioned;
+
+        Eigen::Array3d residualDotPreconditioned = (residual.array() * preconditioned.array()).colwise().sum();
+        Eigen::Array3d thresholds = tolerance * rightHandSide.colwise().norm().array();
+
+        numberOfIterationsLastSolve = 0;
+        bool converged = false;
+
+        for (; numberOfIterationsLastSolve < maxNumberOfIterations; ++numberOfIterationsLastSolve) {
+
+            Eigen::Array3d residualNorms = residual.colwise().norm().array();
+            converged = (residualNorms <= thresholds).all();
+
+            if (converged) {
+                break;
+            }
+
+            computeLaplacianProduct(direction, laplacianProduct);
+            Eigen::Array3d curvatures = (direction.array() * laplacianProduct.array()).colwise().sum();
+
+            // converged coordinates are not updated anymore
+            Eigen::Array3d stepSizes = Eigen::Array3d::Zero();
+            for (int coordinate = 0; coordinate < 3; ++coordinate) {
+                if (residualNorms[coordinate] > thresholds[coordinate] && curvatures[coordinate] > 0) {
+                    stepSizes[coordinate] = residualDotPreconditioned[coordinate] / curvatures[coordinate];
+                }
+            }
+
+            x += direction * stepSizes.matrix().asDiagonal();
+            residual -= laplacianProduct * stepSizes.matrix().asDiagonal();
+            preconditioned = diagonalInversed.asDiagonal() * residual;
+
+            Eigen::Array3d residualDotPreconditionedNew =
+                    (residual.array() * preconditioned.array()).colwise().sum();
+            Eigen::Array3d directionCoefficients = Eigen::Array3d::Zero();
+            for (int coordinate = 0; coordinate < 3; ++coordinate) {
+                if (residualDotPreconditioned[coordinate] > 0) {
+                    directionCoefficients[coordinate] =
+                            residualDotPreconditionedNew[coordinate] / residualDotPreconditioned[coordinate];
+                }
+            }
+
+            direction = preconditioned + direction * directionCoefficients.matrix().asDiagonal();
+            residualDotPreconditioned = residualDotPreconditionedNew;
+        }
+
+        solution = Vectors3d(Eigen::VectorXd(Eigen::Map<const Eigen::VectorXd>(x.data(), 3 * matrixSize)));
+
+        return converged && x.allFinite();
+    }
+
+    int TranslationSolverBlockJacobiPCG::getNumberOfIterationsLastSolve() const {
+        return numberOfIterationsLastSolve;
+    }
+}
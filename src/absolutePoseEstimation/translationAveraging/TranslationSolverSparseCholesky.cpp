@@ -0,0 +1,137 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#include <cassert>
+
+#include "absolutePoseEstimation/translationAveraging/TranslationSolverSparseCholesky.h"
+
+namespace gdr {
+
+    TranslationSolverSparseCholesky::TranslationSolverSparseCholesky(
+            const std::vector<TranslationMeasurement> &relativeTranslations,
+            int numberOfPosesToSet,
+            int indexPoseFixedToSet) :
+            numberOfPoses(numberOfPosesToSet),
+            indexPoseFixed(indexPoseFixedToSet) {
+
+        assert(indexPoseFixed >= 0 && indexPoseFixed < numberOfPoses);
+
+        int matrixSize = numberOfPoses - 1;
+        std::vector<Tripletd> coefficients;
+        coefficients.reserve(4 * relativeTranslations.size() + matrixSize);
+
+        // diagonal is always present so that isolated poses do not produce missing pivots
+        for (int i = 0; i < matrixSize; ++i) {
+            coefficients.emplace_back(Tripletd(i, i, 0.0));
+        }
+
+        reducedIndicesFromTo.reserve(relativeTranslations.size());
+
+        for (const auto &relativeT: relativeTranslations) {
+            int indexFrom = getReducedIndex(relativeT.getIndexFromToBeTransformed(), indexPoseFixed);
+            int indexTo = getReducedIndex(relativeT.getIndexToDestination(), indexPoseFixed);
+
+            assert(indexFrom < matrixSize && indexTo < matrixSize);
+            reducedIndicesFromTo.emplace_back(std::make_pair(indexFrom, indexTo));
+
+            if (indexFrom >= 0 && indexTo >= 0) {
+                coefficients.emplace_back(Tripletd(indexFrom, indexTo, 0.0));
+                coefficients.emplace_back(Tripletd(indexTo, indexFrom, 0.0));
+            }
+        }
+
+        laplacian.resize(matrixSize, matrixSize);
+        laplacian.setFromTriplets(coefficients.begin(), coefficients.end());
+        laplacian.makeCompressed();
+
+        auto getValueIndex = [this](int row, int col) {
+            if (row < 0 || col < 0) {
+                return -1;
+            }
+            const int *innerIndices = laplacian.innerIndexPtr();
+            const int *outerStarts = laplacian.outerIndexPtr();
+
+            const int *found = std::lower_bound(innerIndices + outerStarts[col],
+                                                innerIndices + outerStarts[col + 1],
+                                                row);
+            assert(found != innerIndices + outerStarts[col + 1] && *found == row);
+
+            return static_cast<int>(found - innerIndices);
+        };
+
+        valueIndicesByMeasurement.reserve(reducedIndicesFromTo.size());
+
+        for (const auto &indicesFromTo: reducedIndicesFromTo) {
+            int indexFrom = indicesFromTo.first;
+            int indexTo = indicesFromTo.second;
+
+            valueIndicesByMeasurement.push_back({getValueIndex(indexFrom, indexFrom),
+                                                 getValueIndex(indexTo, indexTo),
+                                                 getValueIndex(indexFrom, indexTo),
+                                                 getValueIndex(indexTo, indexFrom)});
+        }
+
+        choleskySolver.analyzePattern(laplacian);
+    }
+
+    bool TranslationSolverSparseCholesky::solve(const std::vector<double> &weights,
+                                                const Vectors3d &b,
+                                                const Vectors3d &initialGuess,
+                                                Vectors3d &solution) {
+
+        assert(weights.size() == valueIndicesByMeasurement.size());
+        assert(b.getSize() == valueIndicesByMeasurement.size());
+
+        int matrixSize = numberOfPoses - 1;
+        double *values = laplacian.valuePtr();
+        std::fill(values, values + laplacian.nonZeros(), 0.0);
+
+        const Eigen::VectorXd &bRaw = b.getVectorRaw();
+        Eigen::Matrix<double, Eigen::Dynamic, 3> rightHandSide =
+                Eigen::Matrix<double, Eigen::Dynamic, 3>::Zero(matrixSize, 3);
+
+        for (int i = 0; i < valueIndicesByMeasurement.size(); ++i) {
+            double weightSquared = weights[i] * weights[i];
+            const auto &valueIndices = valueIndicesByMeasurement[i];
+            int indexFrom = reducedIndicesFromTo[i].first;
+            int indexTo = reducedIndicesFromTo[i].second;
+
+            Eigen::RowVector3d weightedB = weightSquared * bRaw.segment<3>(3 * i).transpose();
+
+            if (indexFrom >= 0) {
+                values[valueIndices[0]] += weightSquared;
+                rightHandSide.row(indexFrom) += weightedB;
+            }
+            if (indexTo >= 0) {
+                values[valueIndices[1]] += weightSquared;
+                rightHandSide.row(indexTo) -= weightedB;
+            }
+            if (indexFrom >= 0 && indexTo >= 0) {
+                values[valueIndices[2]] -= weightSquared;
+                values[valueIndices[3]] -= weightSquared;
+            }
+        }
+
+        choleskySolver.factorize(laplacian);
+
+        if (choleskySolver.info() != Eigen::Success) {
+            return false;
+        }
+
+        Eigen::Matrix<double, Eigen::Dynamic, 3> solutionByCoordinate = choleskySolver.solve(rightHandSide);
+
+        if (choleskySolver.info() != Eigen::Success) {
+            return false;
+        }
+
+        Eigen::VectorXd solutionRaw(3 * matrixSize);
+        for (int i = 0; i < matrixSize; ++i) {
+            solutionRaw.segment<3>(3 * i) = solutionByCoordinate.row(i).transpose();
+        }
+        solution = Vectors3d(solutionRaw);
+
+        return true;
+    }
+}
@@ -0,0 +1,51 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#include <sophus/so3.hpp>
+
+#include "bundleAdjustment/AnalyticJacobians.h"
+
+namespace gdr {
+
+    Eigen::Vector3d AnalyticJacobians::rotate(const Eigen::Quaterniond &orientation, const Eigen::Vector3d &point) {
+        Eigen::Vector3d u = orientation.vec();
+        Eigen::Vector3d uCrossPoint = u.cross(point);
+
+        return point + 2.0 * orientation.w() * uCrossPoint + 2.0 * u.cross(uCrossPoint);
+    }
+
+    Eigen::Matrix3d AnalyticJacobians::getRotatedPointByPoint(const Eigen::Quaterniond &orientation) {
+        Eigen::Matrix3d skewU = Sophus::SO3d::hat(orientation.vec());
+
+        return Eigen::Matrix3d::Identity() + 2.0 * orientation.w() * skewU + 2.0 * skewU * skewU;
+    }
+
+    Eigen::Matrix<double, 3, 4> AnalyticJacobians::getRotatedPointByOrientation(const Eigen::Quaterniond &orientation,
+                                                                                const Eigen::Vector3d &point) {
+        Eigen::Vector3d u = orientation.vec();
+
+        Eigen::Matrix<double, 3, 4> rotatedPointByOrientation;
+        rotatedPointByOrientation.leftCols<3>() = -2.0 * orientation.w() * Sophus::SO3d::hat(point)
+                                                  + 2.0 * (u * point.transpose()
+                                                           + u.dot(point) * Eigen::Matrix3d::Identity()
+                                                           - 2.0 * point * u.transpose());
+        rotatedPointByOrientation.col(3) = 2.0 * u.cross(point);
+
+        return rotatedPointByOrientation;
+    }
+
+    Eigen::Matrix3d AnalyticJacobians::getProjectionDepthByPointCamera(const Eigen::Vector3d &pointCamera,
+                                                                       double fx,
+                                                                       double fy) {
+        double depthInversed = 1.0 / pointCamera[2];
+
+        Eigen::Matrix3d projectionDepthByPointCamera;
+        projectionDepthByPointCamera << fx * depthInversed, 0.0, -fx * pointCamera[0] * depthInversed * depthInversed,
+                0.0, fy * depthInversed, -fy * pointCamera[1] * depthInversed * depthInversed,
+                0.0, 0.0, 1.0;
+
+        return projectionDepthByPointCamera;
+    }
+}
@@ -0,0 +1,47 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#include <cassert>
+
+#include "bundleAdjustment/AnchorInverseDepthResidual.h"
+
+namespace gdr {
+
+    AnchorInverseDepthResidual::AnchorInverseDepthResidual(double observedDepthToSet,
+                                                           double deviationDepthToSet) :
+            observedDepth(observedDepthToSet),
+            deviationDepth(deviationDepthToSet) {
+
+        assert(deviationDepth > 0);
+    }
+
+    bool AnchorInverseDepthResidual::Evaluate(double const *const *parameters,
+                                              double *residuals,
+                                              double **jacobians) const {
+
+        double inverseDepth = parameters[0][0];
+
+        if (inverseDepth <= 0) {
+            return false;
+        }
+
+        residuals[0] = 0.0;
+        residuals[1] = 0.0;
+        residuals[2] = (observedDepth - 1.0 / inverseDepth) / deviationDepth;
+
+        if (jacobians && jacobians[0]) {
+            jacobians[0][0] = 0.0;
+            jacobians[0][1] = 0.0;
+            jacobians[0][2] = 1.0 / (inverseDepth * inverseDepth * deviationDepth);
+        }
+
+        return true;
+    }
+
+    ceres::CostFunction *AnchorInverseDepthResidual::Create(double observedDepth,
+                                                            double deviationDepth) {
+        return new AnchorInverseDepthResidual(observedDepth, deviationDepth);
+    }
+}
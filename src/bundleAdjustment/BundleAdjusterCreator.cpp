@@ -3,20 +3,48 @@
 // Licensed under the MIT license. See LICENSE file in the project root for details.
 //
 
+#include <iostream>
+
 #include "bundleAdjustment/BundleAdjusterCreator.h"
 #include "bundleAdjustment/BundleDepthAdjuster.h"
+#include "bundleAdjustment/PoseOnlyAdjuster.h"
 
 namespace gdr {
 
     std::unique_ptr<BundleAdjuster>
-    BundleAdjusterCreator::getBundleAdjuster(const BundleAdjusterCreator::BundleAdjustmentType &bundleAdjustmentType) {
+    BundleAdjusterCreator::getBundleAdjuster(const BundleAdjusterCreator::BundleAdjustmentType &bundleAdjustmentType,
+                                             int maxPosesPerClusterPartitioned,
+                                             int maxRoundsOutlierRejection,
+                                             const KeyPointMatches *inlierCorrespondences) {
+
+        if (bundleAdjustmentType == BundleAdjustmentType::POSES_ONLY_DEPTH_CORRESPONDENCES) {
+            if (maxPosesPerClusterPartitioned > 0 || maxRoundsOutlierRejection > 1) {
+                std::cout << "partitioning and outlier rejection rounds are not available "
+                             "for poses only refinement and are ignored" << std::endl;
+            }
+
+            auto poseOnlyAdjuster = std::make_unique<PoseOnlyAdjuster>();
+            poseOnlyAdjuster->setInlierCorrespondences(inlierCorrespondences);
+
+            return poseOnlyAdjuster;
+        }
 
-        if (bundleAdjustmentType == BundleAdjustmentType::USE_DEPTH_INFO) {
+        auto bundleDepthAdjuster = std::make_unique<BundleDepthAdjuster>();
 
-        } else {
+        if (bundleAdjustmentType == BundleAdjustmentType::USE_DEPTH_INFO_INVERSE_DEPTH_LANDMARKS) {
+            bundleDepthAdjuster->setInverseDepthParameterization(true);
+        } else if (bundleAdjustmentType != BundleAdjustmentType::USE_DEPTH_INFO) {
             std::cout << "only BA with depth info is implemented" << std::endl;
         }
 
-        return std::make_unique<BundleDepthAdjuster>();
+        if (maxPosesPerClusterPartitioned > 0 && maxRoundsOutlierRejection > 1) {
+            std::cout << "outlier rejection rounds are not available for partitioned bundle adjustment "
+                         "and are ignored if number of poses exceeds cluster size" << std::endl;
+        }
+
+        bundleDepthAdjuster->setPartitioning(maxPosesPerClusterPartitioned);
+        bundleDepthAdjuster->setOutlierRejection(maxRoundsOutlierRejection);
+
+        return bundleDepthAdjuster;
     }
 }
\ No newline at end of file
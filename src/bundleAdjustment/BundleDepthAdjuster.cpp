@@ -4,25 +4,58 @@
 //
 
 #include "bundleAdjustment/BundleDepthAdjuster.h"
+#include "bundleAdjustment/ReprojectionDepthResidual.h"
+#include "bundleAdjustment/InverseDepthResidual.h"
+#include "bundleAdjustment/AnchorInverseDepthResidual.h"
+#include "bundleAdjustment/LinearSolverSelector.h"
+#include "bundleAdjustment/ConsensusPriorResidual.h"
+#include "absolutePoseEstimation/hierarchicalAveraging/PoseGraphPartitioner.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <sstream>
 
 #include <ceres/ceres.h>
+#include <tbb/parallel_for.h>
 
 namespace gdr {
 
     std::pair<std::vector<double>, std::vector<double>>
     BundleDepthAdjuster::getNormalizedErrorsReprojectionAndDepth(bool performNormalizing) {
+
+        bool defaultNoiseModels = std::all_of(cameraModelByPoseNumber.begin(), cameraModelByPoseNumber.end(),
+                                              [](const CameraRGBD &camera) {
+                                                  return camera.getMeasurementErrorDeviationEstimators()
+                                                          .hasDefaultNoiseModels();
+                                              });
+
+        if (defaultNoiseModels) {
+            return getErrorsReprojectionAndDepth<NoiseModelReprojectionLinearInScale, NoiseModelDepthQuadratic>(
+                    performNormalizing);
+        }
+
+        return getErrorsReprojectionAndDepth<NoiseModelFunction, NoiseModelFunction>(performNormalizing);
+    }
+
+    template<class NoiseModelReprojection, class NoiseModelDepth>
+    std::pair<std::vector<double>, std::vector<double>>
+    BundleDepthAdjuster::getErrorsReprojectionAndDepth(bool performNormalizing) {
         std::vector<double> errorsReprojectionXY;
         std::vector<double> errorsDepth;
 
         double minScale = std::numeric_limits<double>::infinity();
         double maxScale = -1;
 
-        for (int currPose = 0; currPose < poseWorldToCameraTxTyTzByPoseNumber.size(); ++currPose) {
-            for (const auto &keyPointInfosByPose: keyPointInfoByPoseNumberAndPointNumber[currPose]) {
+        for (int currPose = 0; currPose < getNumberOfPoses(); ++currPose) {
 
-                int currPoint = keyPointInfosByPose.first;
-                const auto &camera = cameraModelByPoseNumber[currPose];
-                const auto poseTransformation = getSE3TransformationMatrixByPoseNumber(currPose);
+            const auto &camera = cameraModelByPoseNumber[currPose];
+            const auto poseTransformation = getSE3TransformationMatrixByPoseNumber(currPose);
+
+            for (int observation = observationStartsByPose[currPose];
+                 observation < observationStartsByPose[currPose + 1]; ++observation) {
+
+                int currPoint = observationPointIndices[observation];
                 const auto point3d = getPointVector3dByPointGlobalIndex(currPoint);
 
                 Sophus::Vector3d localCameraCoordinatesOfPoint = poseTransformation * point3d;
@@ -36,7 +69,7 @@ namespace gdr {
 
                 double computedDepth = localCameraCoordinatesOfPoint[2];
 
-                const auto &keyPointInfo = keyPointInfoByPoseNumberAndPointNumber[currPose][currPoint];
+                const auto &keyPointInfo = observationKeyPointInfos[observation];
 
                 minScale = std::min(minScale, keyPointInfo.getScale());
                 maxScale = std::max(maxScale, keyPointInfo.getScale());
@@ -49,10 +82,9 @@ namespace gdr {
 
                 Sophus::Vector2d errorReproj(errorX, errorY);
 
-                const auto &dividerReproj = camera.getMeasurementErrorDeviationEstimators().getDividerReprojectionEstimator();
-                double normalizedReprojError = errorReproj.lpNorm<2>() /
-                                               (dividerReproj)(keyPointInfo.getScale(),
-                                                               measurementEstimators.getParameterNoiseModelReprojection());
+                double normalizedReprojError =
+                        errorReproj.lpNorm<2>() /
+                        measurementEstimators.getDeviationReprojection<NoiseModelReprojection>(keyPointInfo.getScale());
 
                 double rawReprojError = errorReproj.lpNorm<2>();
                 double reprojErrorToUse = performNormalizing ? normalizedReprojError : rawReprojError;
@@ -60,10 +92,8 @@ namespace gdr {
                 errorsReprojectionXY.emplace_back(reprojErrorToUse);
 
                 double depthError = std::abs(computedDepth - keyPointInfo.getDepth());
-                const auto &dividerDepth = camera.getMeasurementErrorDeviationEstimators().getDividerDepthErrorEstimator();
-                double normalizedErrorDepth = depthError /
-                                              (dividerDepth)(keyPointInfo.getDepth(),
-                                                             measurementEstimators.getParameterNoiseModelDepth());
+                double normalizedErrorDepth =
+                        depthError / measurementEstimators.getDeviationDepth<NoiseModelDepth>(keyPointInfo.getDepth());
                 double depthErrorToUse = performNormalizing ? normalizedErrorDepth : depthError;
 
                 errorsDepth.emplace_back(depthErrorToUse);
@@ -79,13 +109,14 @@ namespace gdr {
     std::vector<Point3d> BundleDepthAdjuster::getOptimizedPoints() const {
         std::vector<Point3d> pointsOptimized;
 
-        for (int i = 0; i < pointsXYZbyIndex.size(); ++i) {
-            const auto &point = pointsXYZbyIndex[i];
-            assert(point.size() == 3);
+        pointsOptimized.reserve(getNumberOfPoints());
+
+        for (int i = 0; i < getNumberOfPoints(); ++i) {
+            const double *point = &pointsXYZ[dimPoint * i];
             pointsOptimized.emplace_back(Point3d(point[0], point[1], point[2], i));
         }
 
-        assert(pointsOptimized.size() == pointsXYZbyIndex.size());
+        assert(pointsOptimized.size() == getNumberOfPoints());
         return pointsOptimized;
     }
 
@@ -101,13 +132,15 @@ namespace gdr {
         double minScale = std::numeric_limits<double>::infinity();
         double maxScale = -1;
 
-        for (int currPose = 0; currPose < poseWorldToCameraTxTyTzByPoseNumber.size(); ++currPose) {
-            for (const auto &keyPointInfosByPose: keyPointInfoByPoseNumberAndPointNumber[currPose]) {
+        for (int currPose = 0; currPose < getNumberOfPoses(); ++currPose) {
+
+            const auto &camera = cameraModelByPoseNumber[currPose];
+            const auto poseTransformation = getSE3TransformationMatrixByPoseNumber(currPose);
 
-                int currPoint = keyPointInfosByPose.first;
-                const auto &camera = cameraModelByPoseNumber[currPose];
+            for (int observation = observationStartsByPose[currPose];
+                 observation < observationStartsByPose[currPose + 1]; ++observation) {
 
-                const auto poseTransformation = getSE3TransformationMatrixByPoseNumber(currPose);
+                int currPoint = observationPointIndices[observation];
                 const auto point3d = getPointVector3dByPointGlobalIndex(currPoint);
 
                 Eigen::Vector3d localCameraCoordinatesOfPoint = poseTransformation * point3d;
@@ -118,7 +151,7 @@ namespace gdr {
                 double computedY = imageCoordinatesNormalized[1];
                 double computedDepth = localCameraCoordinatesOfPoint[2];
 
-                const auto &keyPointInfo = keyPointInfoByPoseNumberAndPointNumber[currPose][currPoint];
+                const auto &keyPointInfo = observationKeyPointInfos[observation];
 
                 minScale = std::min(minScale, keyPointInfo.getScale());
                 maxScale = std::max(maxScale, keyPointInfo.getScale());
@@ -179,12 +212,8 @@ namespace gdr {
         double quantile90ErrorY = medians[4];
         double quantile90ErrorDepth = medians[5];
 
-        ceres::Problem problem;
-        ceres::LocalParameterization *quaternionLocalParameterization =
-                new ceres::EigenQuaternionParameterization;
-
-        assert(orientationWorldToCameraqxyzwByPoseNumber.size() == poseWorldToCameraTxTyTzByPoseNumber.size());
-        assert(!orientationWorldToCameraqxyzwByPoseNumber.empty());
+        assert(orientationsWorldToCameraQxyzw.size() == dimOrientation * getNumberOfPoses());
+        assert(getNumberOfPoses() > 0);
 
         std::pair<double, double> deviationEstimatorsSigmaReprojAndDepth = getSigmaReprojectionAndDepth();
         double sigmaReproj = deviationEstimatorsSigmaReprojAndDepth.first;
@@ -201,144 +230,703 @@ namespace gdr {
 
         assert(errors3DL2Raw.size() == errorsReprojDepthRaw.first.size());
 
-        for (int poseIndex = 0; poseIndex < poseWorldToCameraTxTyTzByPoseNumber.size(); ++poseIndex) {
+        if (usePartitionedOptimization()) {
+            success = optimizePartitioned(indexFixed, sigmaReproj, sigmaDepth);
+        } else {
+            success = optimizeSingleProblem(indexFixed, sigmaReproj, sigmaDepth);
+        }
 
-            auto &pose = poseWorldToCameraTxTyTzByPoseNumber[poseIndex];
-            auto &orientation = orientationWorldToCameraqxyzwByPoseNumber[poseIndex];
+        if (!success) {
+            // parameters can be changed by unusable solve, so initial poses and points are restored
+            setPosesAndPoints(points, posesCameraToWorld, keyPointInfos);
 
-            assert(poseIndex < keyPointInfoByPoseNumberAndPointNumber.size());
+            std::vector<SE3> posesInitial;
+            for (const auto &poseAndCamera: posesCameraToWorld) {
+                posesInitial.emplace_back(poseAndCamera.first);
+            }
 
-            for (const auto &indexAndKeyPointInfo: keyPointInfoByPoseNumberAndPointNumber[poseIndex]) {
-                int pointIndex = indexAndKeyPointInfo.first;
-                assert(pointIndex >= 0 && pointIndex < pointsXYZbyIndex.size());
+            return posesInitial;
+        }
 
-                auto &point = pointsXYZbyIndex[pointIndex];
-                const auto &keyPointInfo = indexAndKeyPointInfo.second;
+        std::pair<std::vector<double>, std::vector<double>> errorsReprojDepthRawAfter =
+                getNormalizedErrorsReprojectionAndDepth(false);
 
-                assert(keyPointInfo.isInitialized());
-                double widthAssert = 640;
-                double heightAssert = 480;
-                double observedX = keyPointInfo.getX();
-                double observedY = keyPointInfo.getY();
+        double medianErrorReprojRawAfter = RobustEstimators::getQuantile(errorsReprojDepthRawAfter.first);
+        double medianErrorDepthRawAfter = RobustEstimators::getQuantile(errorsReprojDepthRawAfter.second);
+        double medianErrorL2RawAfter = RobustEstimators::getQuantile(getL2Errors());
+
+        std::vector<double> mediansAfter = getMedianErrorsXYDepth();
+
+        double medianErrorXafter = mediansAfter[0];
+        double medianErrorYafter = mediansAfter[1];
+        double medianErrorDepthAfter = mediansAfter[2];
 
-                assert(observedX > 0 && observedX < widthAssert);
-                assert(observedY > 0 && observedY < heightAssert);
+        double quantile90ErrorXafter = mediansAfter[3];
+        double quantile90ErrorYafter = mediansAfter[4];
+        double quantile90ErrorDepthAfter = mediansAfter[5];
 
-                const auto &camera = cameraModelByPoseNumber[poseIndex];
+        std::vector<SE3> posesOptimized;
 
-                const auto &measurementEstimators = camera.getMeasurementErrorDeviationEstimators();
-                const auto &dividerReproj = measurementEstimators.getDividerReprojectionEstimator();
-
-                double deviationEstReprojByScale = (dividerReproj)(keyPointInfo.getScale(),
-                                                                   measurementEstimators.getParameterNoiseModelReprojection());
-
-
-                const auto &dividerDepth = measurementEstimators.getDividerDepthErrorEstimator();
-                double deviationEstDepthByDepth = (dividerDepth)(keyPointInfo.getDepth(),
-                                                                 measurementEstimators.getParameterNoiseModelDepth());
-
-                ceres::CostFunction *cost_function_depth =
-                        DepthOnlyResidual::Create(keyPointInfo.getDepth(),
-                                                  cameraModelByPoseNumber[poseIndex],
-                                                  sigmaDepth,
-                                                  deviationEstDepthByDepth,
-                                                  medianErrorDepthRaw);
-                ceres::CostFunction *cost_function_reproj =
-                        ReprojectionOnlyResidual::Create(observedX,
-                                                         observedY,
-                                                         keyPointInfo.getScale(),
-                                                         cameraModelByPoseNumber[poseIndex],
-                                                         sigmaReproj,
-                                                         deviationEstReprojByScale,
-                                                         medianErrorReprojRaw);
-                problem.AddResidualBlock(cost_function_reproj,
-                                         new ceres::CauchyLoss(sigmaReproj),
-                                         point.data(),
-                                         pose.data(),
-                                         orientation.data());
-
-                problem.AddResidualBlock(cost_function_depth,
-                                         new ceres::CauchyLoss(sigmaDepth),
-                                         point.data(),
-                                         pose.data(),
-                                         orientation.data());
-
-                problem.SetParameterization(orientation.data(), quaternionLocalParameterization);
+        assert(cameraModelByPoseNumber.size() == getNumberOfPoses());
+
+        for (int i = 0; i < getNumberOfPoses(); ++i) {
+            posesOptimized.emplace_back(SE3(getSE3TransformationMatrixByPoseNumber(i)).inverse());
+        }
+
+        return posesOptimized;
+    }
+
+    ceres::CostFunction *BundleDepthAdjuster::createReprojectionDepthCostFunction(int poseIndex,
+                                                                                  int observation,
+                                                                                  double sigmaReproj,
+                                                                                  double sigmaDepth) const {
+        const auto &keyPointInfo = observationKeyPointInfos[observation];
+
+        assert(keyPointInfo.isInitialized());
+        double widthAssert = 640;
+        double heightAssert = 480;
+        double observedX = keyPointInfo.getX();
+        double observedY = keyPointInfo.getY();
+
+        assert(observedX > 0 && observedX < widthAssert);
+        assert(observedY > 0 && observedY < heightAssert);
+
+        const auto &camera = cameraModelByPoseNumber[poseIndex];
+
+        const auto &measurementEstimators = camera.getMeasurementErrorDeviationEstimators();
+        const auto &dividerReproj = measurementEstimators.getDividerReprojectionEstimator();
+
+        double deviationEstReprojByScale = (dividerReproj)(keyPointInfo.getScale(),
+                                                           measurementEstimators.getParameterNoiseModelReprojection());
+
+
+        const auto &dividerDepth = measurementEstimators.getDividerDepthErrorEstimator();
+        double deviationEstDepthByDepth = (dividerDepth)(keyPointInfo.getDepth(),
+                                                         measurementEstimators.getParameterNoiseModelDepth());
+
+        if (!useInverseDepthParameterization) {
+            return ReprojectionDepthResidual::Create(observedX,
+                                                     observedY,
+                                                     keyPointInfo.getDepth(),
+                                                     camera,
+                                                     sigmaReproj * deviationEstReprojByScale,
+                                                     sigmaDepth * deviationEstDepthByDepth);
+        }
+
+        int pointIndex = observationPointIndices[observation];
+        int anchorPoseIndex = anchorPoseByPoint[pointIndex];
+
+        if (anchorPoseIndex == poseIndex) {
+            return AnchorInverseDepthResidual::Create(keyPointInfo.getDepth(),
+                                                      sigmaDepth * deviationEstDepthByDepth);
+        }
+
+        const auto &anchorKeyPointInfo = observationKeyPointInfos[anchorObservationByPoint[pointIndex]];
+
+        return InverseDepthResidual::Create(anchorKeyPointInfo.getX(),
+                                            anchorKeyPointInfo.getY(),
+                                            cameraModelByPoseNumber[anchorPoseIndex],
+                                            observedX,
+                                            observedY,
+                                            keyPointInfo.getDepth(),
+                                            camera,
+                                            sigmaReproj * deviationEstReprojByScale,
+                                            sigmaDepth * deviationEstDepthByDepth);
+    }
+
+    std::vector<double *> BundleDepthAdjuster::getParameterBlocksOfObservation(int poseIndex,
+                                                                              int observation) {
+        int pointIndex = observationPointIndices[observation];
+
+        if (!useInverseDepthParameterization) {
+            return {getPointData(pointIndex), getTranslationData(poseIndex), getOrientationData(poseIndex)};
+        }
+
+        int anchorPoseIndex = anchorPoseByPoint[pointIndex];
+
+        if (anchorPoseIndex == poseIndex) {
+            return {&inverseDepths[pointIndex]};
+        }
+
+        return {&inverseDepths[pointIndex],
+                getTranslationData(anchorPoseIndex), getOrientationData(anchorPoseIndex),
+                getTranslationData(poseIndex), getOrientationData(poseIndex)};
+    }
+
+    void BundleDepthAdjuster::initializeInverseDepths() {
+
+        int numberOfPoints = getNumberOfPoints();
+
+        anchorPoseByPoint.assign(numberOfPoints, -1);
+        anchorObservationByPoint.assign(numberOfPoints, -1);
+        inverseDepths.assign(numberOfPoints, 0.0);
+
+        // observations are sorted by pose, so the first visited observation of a point is made from its first pose
+        for (int poseIndex = 0; poseIndex < getNumberOfPoses(); ++poseIndex) {
+            for (int observation = observationStartsByPose[poseIndex];
+                 observation < observationStartsByPose[poseIndex + 1]; ++observation) {
+                int pointIndex = observationPointIndices[observation];
+
+                if (anchorPoseByPoint[pointIndex] < 0) {
+                    anchorPoseByPoint[pointIndex] = poseIndex;
+                    anchorObservationByPoint[pointIndex] = observation;
+                }
             }
         }
-        problem.SetParameterBlockConstant(poseWorldToCameraTxTyTzByPoseNumber[indexFixed].data());
-        problem.SetParameterBlockConstant(orientationWorldToCameraqxyzwByPoseNumber[indexFixed].data());
 
+        for (int pointIndex = 0; pointIndex < numberOfPoints; ++pointIndex) {
+            int anchorPoseIndex = anchorPoseByPoint[pointIndex];
+
+            if (anchorPoseIndex < 0) {
+                continue;
+            }
+
+            // depth of current point estimation along the anchor ray, measured depth is used if point is behind camera
+            double depth = (getSE3TransformationMatrixByPoseNumber(anchorPoseIndex)
+                            * getPointVector3dByPointGlobalIndex(pointIndex))[2];
+
+            if (depth <= 0) {
+                depth = observationKeyPointInfos[anchorObservationByPoint[pointIndex]].getDepth();
+            }
+            assert(depth > 0);
+
+            inverseDepths[pointIndex] = 1.0 / depth;
+        }
+    }
+
+    void BundleDepthAdjuster::updatePointsFromInverseDepths() {
+
+        for (int pointIndex = 0; pointIndex < getNumberOfPoints(); ++pointIndex) {
+            int anchorPoseIndex = anchorPoseByPoint[pointIndex];
+
+            if (anchorPoseIndex < 0) {
+                continue;
+            }
+
+            const auto &camera = cameraModelByPoseNumber[anchorPoseIndex];
+            const auto &anchorKeyPointInfo = observationKeyPointInfos[anchorObservationByPoint[pointIndex]];
+
+            Eigen::Vector3d pointAnchor = camera.getCoordinates3D(anchorKeyPointInfo.getX(),
+                                                                  anchorKeyPointInfo.getY(),
+                                                                  1.0 / inverseDepths[pointIndex]);
+            Eigen::Map<Eigen::Vector3d> point(getPointData(pointIndex));
+            point = getSE3TransformationMatrixByPoseNumber(anchorPoseIndex).inverse() * pointAnchor;
+        }
+    }
+
+    ceres::Solver::Options BundleDepthAdjuster::getSolverOptions(int numberOfPoses,
+                                                                 int numberOfPoints,
+                                                                 int numberOfObservations,
+                                                                 int numberOfThreads) const {
+        std::pair<ceres::LinearSolverType, ceres::PreconditionerType> solverAndPreconditioner =
+                {linearSolverType, preconditionerType};
+
+        if (selectLinearSolverBySize) {
+            solverAndPreconditioner = LinearSolverSelector::getLinearSolverAndPreconditioner(
+                    numberOfPoses,
+                    numberOfPoints,
+                    numberOfObservations,
+                    ceres::IsSparseLinearAlgebraLibraryTypeAvailable(ceres::SUITE_SPARSE));
+        }
 
         ceres::Solver::Options options;
-        options.linear_solver_type = ceres::SPARSE_SCHUR;
+        options.linear_solver_type = solverAndPreconditioner.first;
+        options.preconditioner_type = solverAndPreconditioner.second;
         options.minimizer_progress_to_stdout = false;
         options.max_num_iterations = getMaxNumberIterations();
-        options.num_threads = getMaxNumberThreads();
+        options.num_threads = std::max(1, numberOfThreads);
+
+        return options;
+    }
+
+    bool BundleDepthAdjuster::optimizeSingleProblem(int indexFixed,
+                                                    double sigmaReproj,
+                                                    double sigmaDepth) {
+
+        // residuals are divided by sigma, so all observations share the same stateless robust loss,
+        // it is owned here and outlives the problem
+        ceres::CauchyLoss lossFunction(1.0);
+
+        ceres::Problem::Options problemOptions;
+        problemOptions.loss_function_ownership = ceres::DO_NOT_TAKE_OWNERSHIP;
+        problemOptions.enable_fast_removal = (maxRoundsOutlierRejection > 1);
+
+        ceres::Problem problem(problemOptions);
+        ceres::LocalParameterization *quaternionLocalParameterization =
+                new ceres::EigenQuaternionParameterization;
+
+        int numberOfObservations = static_cast<int>(observationPointIndices.size());
 
+        if (useInverseDepthParameterization) {
+            initializeInverseDepths();
+        }
+
+        // cost functions are owned by the problem and are valid while their residual blocks are not removed
+        std::vector<ceres::ResidualBlockId> residualBlockByObservation(numberOfObservations);
+        std::vector<ceres::CostFunction *> costFunctionByObservation(numberOfObservations);
+
+        for (int poseIndex = 0; poseIndex < getNumberOfPoses(); ++poseIndex) {
+            for (int observation = observationStartsByPose[poseIndex];
+                 observation < observationStartsByPose[poseIndex + 1]; ++observation) {
+                int pointIndex = observationPointIndices[observation];
+                assert(pointIndex >= 0 && pointIndex < getNumberOfPoints());
+
+                costFunctionByObservation[observation] =
+                        createReprojectionDepthCostFunction(poseIndex, observation, sigmaReproj, sigmaDepth);
+                residualBlockByObservation[observation] =
+                        problem.AddResidualBlock(costFunctionByObservation[observation],
+                                                 &lossFunction,
+                                                 getParameterBlocksOfObservation(poseIndex, observation));
+            }
+        }
+
+        // with inverse depth landmarks orientation of a pose can be added only as anchor of observations
+        // of later poses, so parameterization is set after all residual blocks are added
+        for (int poseIndex = 0; poseIndex < getNumberOfPoses(); ++poseIndex) {
+            double *orientation = getOrientationData(poseIndex);
+
+            if (problem.HasParameterBlock(orientation)) {
+                problem.SetParameterization(orientation, quaternionLocalParameterization);
+            }
+        }
+        problem.SetParameterBlockConstant(getTranslationData(indexFixed));
+        problem.SetParameterBlockConstant(getOrientationData(indexFixed));
+
+        ceres::Solver::Options options = getSolverOptions(getNumberOfPoses(),
+                                                          getNumberOfPoints(),
+                                                          numberOfObservations,
+                                                          getMaxNumberThreads());
+
+        // each round is warm-started from parameters of the previous one,
+        // outlier residual blocks are removed from the same problem instead of rebuilding it
         ceres::Solver::Summary summary;
-        ceres::Solve(options, &problem, &summary);
+        int numberOfRounds = 0;
+        int numberOfIterations = 0;
+        int numberOfOutliersRemoved = 0;
+        double secondsSolving = 0;
+        std::vector<char> isObservationActive(numberOfObservations, true);
+        outlierObservationsLastOptimization.clear();
+
+        while (true) {
+            ceres::Solve(options, &problem, &summary);
+
+            ++numberOfRounds;
+            numberOfIterations += summary.num_successful_steps + summary.num_unsuccessful_steps;
+            secondsSolving += summary.total_time_in_seconds;
+
+            if (numberOfRounds >= maxRoundsOutlierRejection || !summary.IsSolutionUsable()) {
+                break;
+            }
 
-        assert(summary.IsSolutionUsable() && "ceres marked solution as unusable");
+            int numberOfOutliersRound = 0;
+
+            for (int poseIndex = 0; poseIndex < getNumberOfPoses(); ++poseIndex) {
+                for (int observation = observationStartsByPose[poseIndex];
+                     observation < observationStartsByPose[poseIndex + 1]; ++observation) {
+                    if (!isObservationActive[observation]) {
+                        continue;
+                    }
+
+                    std::vector<double *> parameterBlocks = getParameterBlocksOfObservation(poseIndex, observation);
+                    double residuals[3];
+                    costFunctionByObservation[observation]->Evaluate(parameterBlocks.data(), residuals, nullptr);
+
+                    // residuals are already divided by expected deviations
+                    bool isOutlier = std::sqrt(residuals[0] * residuals[0] + residuals[1] * residuals[1])
+                                     > thresholdOutlierRejection
+                                     || std::abs(residuals[2]) > thresholdOutlierRejection;
+
+                    if (isOutlier) {
+                        problem.RemoveResidualBlock(residualBlockByObservation[observation]);
+                        isObservationActive[observation] = false;
+                        outlierObservationsLastOptimization.emplace_back(
+                                std::make_pair(poseIndex, observationPointIndices[observation]));
+                        ++numberOfOutliersRound;
+                    }
+                }
+            }
 
-        std::pair<std::vector<double>, std::vector<double>> errorsReprojDepthRawAfter =
-                getNormalizedErrorsReprojectionAndDepth(false);
+            numberOfOutliersRemoved += numberOfOutliersRound;
 
-        double medianErrorReprojRawAfter = RobustEstimators::getQuantile(errorsReprojDepthRawAfter.first);
-        double medianErrorDepthRawAfter = RobustEstimators::getQuantile(errorsReprojDepthRawAfter.second);
-        double medianErrorL2RawAfter = RobustEstimators::getQuantile(getL2Errors());
+            if (numberOfOutliersRound == 0) {
+                break;
+            }
+        }
 
-        std::vector<double> mediansAfter = getMedianErrorsXYDepth();
+        if (useInverseDepthParameterization) {
+            updatePointsFromInverseDepths();
+        }
 
-        double medianErrorXafter = mediansAfter[0];
-        double medianErrorYafter = mediansAfter[1];
-        double medianErrorDepthAfter = mediansAfter[2];
+        {
+            std::stringstream solverInfoStream;
+            solverInfoStream << (selectLinearSolverBySize ? "auto " : "manual ")
+                             << ceres::LinearSolverTypeToString(summary.linear_solver_type_used);
+            if (summary.linear_solver_type_used == ceres::ITERATIVE_SCHUR) {
+                solverInfoStream << " + " << ceres::PreconditionerTypeToString(summary.preconditioner_type_used);
+            }
+            solverInfoStream << ", poses " << getNumberOfPoses()
+                             << ", points " << getNumberOfPoints()
+                             << (useInverseDepthParameterization ? " (inverse depth)" : "")
+                             << ", observations " << numberOfObservations
+                             << ", iterations " << numberOfIterations;
+            if (maxRoundsOutlierRejection > 1) {
+                solverInfoStream << ", rounds " << numberOfRounds
+                                 << ", outliers removed " << numberOfOutliersRemoved;
+            }
+            solverInfoStream << ", solve time " << secondsSolving << " s";
+            solverInfo = solverInfoStream.str();
+        }
+        numberOfIterationsLastOptimization = numberOfIterations;
 
-        double quantile90ErrorXafter = mediansAfter[3];
-        double quantile90ErrorYafter = mediansAfter[4];
-        double quantile90ErrorDepthAfter = mediansAfter[5];
+        return summary.IsSolutionUsable();
+    }
 
-        std::vector<SE3> posesOptimized;
+    /** Poses and points of one cluster of partitioned bundle adjustment with ADMM state of its shared points */
+    struct ClusterBundleAdjustment {
+        std::vector<int> poseIndices;
+        std::vector<int> pointIndices;
+        int numberOfObservations = 0;
+
+        // local copies of parameters in the same layout as in BundleDepthAdjuster
+        std::vector<double> translations;
+        std::vector<double> orientations;
+        std::vector<double> pointsXYZ;
 
-        assert(cameraModelByPoseNumber.size() == poseWorldToCameraTxTyTzByPoseNumber.size());
+        // local indices of points shared with other clusters,
+        // scaled dual variable u and proximal target z - u of each shared point
+        std::vector<int> sharedPointLocalIndices;
+        std::vector<double> duals;
+        std::vector<double> targets;
 
-        for (int i = 0; i < poseWorldToCameraTxTyTzByPoseNumber.size(); ++i) {
+        std::unique_ptr<ceres::Problem> problem;
+        ceres::Solver::Summary summary;
+    };
 
-            Eigen::Quaterniond orientation(orientationWorldToCameraqxyzwByPoseNumber[i].data());
-            const auto &poseTranslationCameraIntr = poseWorldToCameraTxTyTzByPoseNumber[i];
+    bool BundleDepthAdjuster::optimizePartitioned(int indexFixed,
+                                                  double sigmaReproj,
+                                                  double sigmaDepth) {
+        int numberOfPoses = getNumberOfPoses();
+        int numberOfPoints = getNumberOfPoints();
 
-            std::vector<double> t = {poseTranslationCameraIntr[0], poseTranslationCameraIntr[1],
-                                     poseTranslationCameraIntr[2]};
-            Eigen::Vector3d translation(t.data());
-            Sophus::SE3d poseCurrent;
-            poseCurrent.setQuaternion(orientation);
-            poseCurrent.translation() = translation;
+        // poses observing each point in increasing order
+        std::vector<std::vector<int>> posesByPoint(numberOfPoints);
 
-            posesOptimized.emplace_back(SE3(poseCurrent).inverse());
+        for (int poseIndex = 0; poseIndex < numberOfPoses; ++poseIndex) {
+            for (int observation = observationStartsByPose[poseIndex];
+                 observation < observationStartsByPose[poseIndex + 1]; ++observation) {
+                posesByPoint[observationPointIndices[observation]].emplace_back(poseIndex);
+            }
         }
 
-        return posesOptimized;
+        // covisibility graph, each pose is connected only to a few next observers of a point
+        // so long tracks do not produce quadratic number of edges
+        std::vector<std::pair<int, int>> covisibilityEdges;
+
+        for (const auto &observingPoses: posesByPoint) {
+            for (int i = 0; i < observingPoses.size(); ++i) {
+                for (int j = i + 1; j < std::min(static_cast<int>(observingPoses.size()), i + 1 + covisibilityWindow);
+                     ++j) {
+                    covisibilityEdges.emplace_back(std::make_pair(observingPoses[i], observingPoses[j]));
+                }
+            }
+        }
+
+        std::vector<int> clusterByPose = PoseGraphPartitioner::partition(numberOfPoses,
+                                                                         covisibilityEdges,
+                                                                         {},
+                                                                         maxPosesPerClusterPartitioned);
+        std::vector<std::vector<int>> posesByCluster = PoseGraphPartitioner::getPosesByCluster(clusterByPose);
+        int numberOfClusters = static_cast<int>(posesByCluster.size());
+
+        if (numberOfClusters < 2) {
+            return optimizeSingleProblem(indexFixed, sigmaReproj, sigmaDepth);
+        }
+
+        std::vector<ClusterBundleAdjustment> clusters(numberOfClusters);
+        std::vector<int> localIndexByPose(numberOfPoses, -1);
+
+        for (int cluster = 0; cluster < numberOfClusters; ++cluster) {
+            auto &clusterBA = clusters[cluster];
+            clusterBA.poseIndices = posesByCluster[cluster];
+
+            for (int localPose = 0; localPose < clusterBA.poseIndices.size(); ++localPose) {
+                int poseIndex = clusterBA.poseIndices[localPose];
+                localIndexByPose[poseIndex] = localPose;
+
+                const double *translation = getTranslationData(poseIndex);
+                const double *orientation = getOrientationData(poseIndex);
+                clusterBA.translations.insert(clusterBA.translations.end(), translation, translation + dimPose);
+                clusterBA.orientations.insert(clusterBA.orientations.end(), orientation, orientation + dimOrientation);
+                clusterBA.numberOfObservations +=
+                        observationStartsByPose[poseIndex + 1] - observationStartsByPose[poseIndex];
+            }
+        }
+
+        // pairs {cluster, local point index} of each point, point is shared if it has several pairs
+        std::vector<std::vector<std::pair<int, int>>> clustersAndLocalIndicesByPoint(numberOfPoints);
+
+        for (int pointIndex = 0; pointIndex < numberOfPoints; ++pointIndex) {
+            auto &clustersOfPoint = clustersAndLocalIndicesByPoint[pointIndex];
+
+            for (int poseIndex: posesByPoint[pointIndex]) {
+                int cluster = clusterByPose[poseIndex];
+
+                if (std::find_if(clustersOfPoint.begin(), clustersOfPoint.end(),
+                                 [cluster](const std::pair<int, int> &clusterAndLocalIndex) {
+                                     return clusterAndLocalIndex.first == cluster;
+                                 }) != clustersOfPoint.end()) {
+                    continue;
+                }
+
+                auto &clusterBA = clusters[cluster];
+                clustersOfPoint.emplace_back(std::make_pair(cluster,
+                                                            static_cast<int>(clusterBA.pointIndices.size())));
+                clusterBA.pointIndices.emplace_back(pointIndex);
+
+                const double *point = getPointData(pointIndex);
+                clusterBA.pointsXYZ.insert(clusterBA.pointsXYZ.end(), point, point + dimPoint);
+            }
+
+            if (clustersOfPoint.size() > 1) {
+                for (const auto &clusterAndLocalIndex: clustersOfPoint) {
+                    auto &clusterBA = clusters[clusterAndLocalIndex.first];
+                    clusterBA.sharedPointLocalIndices.emplace_back(clusterAndLocalIndex.second);
+                    clusterBA.duals.insert(clusterBA.duals.end(), dimPoint, 0.0);
+
+                    const double *point = getPointData(pointIndex);
+                    clusterBA.targets.insert(clusterBA.targets.end(), point, point + dimPoint);
+                }
+            }
+        }
+
+        // local parameters are not reallocated after this point, so ceres can keep raw pointers to them,
+        // stateless robust loss is shared by all clusters solved in parallel
+        ceres::CauchyLoss lossFunction(1.0);
+
+        for (int cluster = 0; cluster < numberOfClusters; ++cluster) {
+            auto &clusterBA = clusters[cluster];
+
+            ceres::Problem::Options problemOptions;
+            problemOptions.loss_function_ownership = ceres::DO_NOT_TAKE_OWNERSHIP;
+            clusterBA.problem = std::make_unique<ceres::Problem>(problemOptions);
+            ceres::LocalParameterization *quaternionLocalParameterization =
+                    new ceres::EigenQuaternionParameterization;
+
+            for (int localPose = 0; localPose < clusterBA.poseIndices.size(); ++localPose) {
+                int poseIndex = clusterBA.poseIndices[localPose];
+
+                double *pose = &clusterBA.translations[dimPose * localPose];
+                double *orientation = &clusterBA.orientations[dimOrientation * localPose];
+
+                for (int observation = observationStartsByPose[poseIndex];
+                     observation < observationStartsByPose[poseIndex + 1]; ++observation) {
+                    const auto &clustersOfPoint = clustersAndLocalIndicesByPoint[observationPointIndices[observation]];
+                    auto foundCluster = std::find_if(clustersOfPoint.begin(), clustersOfPoint.end(),
+                                                     [cluster](const std::pair<int, int> &clusterAndLocalIndex) {
+                                                         return clusterAndLocalIndex.first == cluster;
+                                                     });
+                    assert(foundCluster != clustersOfPoint.end());
+
+                    clusterBA.problem->AddResidualBlock(
+                            createReprojectionDepthCostFunction(poseIndex, observation, sigmaReproj, sigmaDepth),
+                            &lossFunction,
+                            &clusterBA.pointsXYZ[dimPoint * foundCluster->second],
+                            pose,
+                            orientation);
+                }
+
+                if (clusterBA.problem->HasParameterBlock(orientation)) {
+                    clusterBA.problem->SetParameterization(orientation, quaternionLocalParameterization);
+
+                    // other clusters have no fixed pose: their gauge is defined only by consensus priors
+                    // on shared points, so they follow the cluster with fixed pose as ADMM converges
+                    if (poseIndex == indexFixed) {
+                        clusterBA.problem->SetParameterBlockConstant(pose);
+                        clusterBA.problem->SetParameterBlockConstant(orientation);
+                    }
+                }
+            }
+
+            for (int sharedPoint = 0; sharedPoint < clusterBA.sharedPointLocalIndices.size(); ++sharedPoint) {
+                int localPoint = clusterBA.sharedPointLocalIndices[sharedPoint];
+                clusterBA.problem->AddResidualBlock(
+                        ConsensusPriorResidual::Create(&clusterBA.targets[dimPoint * sharedPoint],
+                                                       deviationConsensus),
+                        nullptr,
+                        &clusterBA.pointsXYZ[dimPoint * localPoint]);
+            }
+        }
+
+        int numberOfThreadsPerCluster = std::max(1, getMaxNumberThreads() / numberOfClusters);
+        bool isSolutionUsable = true;
+        double maxPrimalResidual = std::numeric_limits<double>::infinity();
+        int iterationsConsensus = 0;
+
+        while (iterationsConsensus < maxIterationsConsensus) {
+            ++iterationsConsensus;
+
+            tbb::parallel_for(0, numberOfClusters, [&](int cluster) {
+                auto &clusterBA = clusters[cluster];
+                ceres::Solver::Options options = getSolverOptions(static_cast<int>(clusterBA.poseIndices.size()),
+                                                                  static_cast<int>(clusterBA.pointIndices.size()),
+                                                                  clusterBA.numberOfObservations,
+                                                                  numberOfThreadsPerCluster);
+                ceres::Solve(options, clusterBA.problem.get(), &clusterBA.summary);
+            });
+
+            for (const auto &clusterBA: clusters) {
+                isSolutionUsable &= clusterBA.summary.IsSolutionUsable();
+            }
+
+            // consensus (z) update is the average of x + u over clusters observing the point,
+            // then scaled duals are updated with primal residuals x - z
+            maxPrimalResidual = 0;
+            double maxDualResidual = 0;
+            std::vector<int> sharedPointsProcessedByCluster(numberOfClusters, 0);
+
+            for (int pointIndex = 0; pointIndex < numberOfPoints; ++pointIndex) {
+                const auto &clustersOfPoint = clustersAndLocalIndicesByPoint[pointIndex];
+
+                if (clustersOfPoint.size() < 2) {
+                    continue;
+                }
+
+                Eigen::Vector3d consensus = Eigen::Vector3d::Zero();
+
+                for (const auto &clusterAndLocalIndex: clustersOfPoint) {
+                    const auto &clusterBA = clusters[clusterAndLocalIndex.first];
+                    int sharedPoint = sharedPointsProcessedByCluster[clusterAndLocalIndex.first];
+                    consensus += Eigen::Vector3d(&clusterBA.pointsXYZ[dimPoint * clusterAndLocalIndex.second])
+                                 + Eigen::Vector3d(&clusterBA.duals[dimPoint * sharedPoint]);
+                }
+                consensus /= static_cast<double>(clustersOfPoint.size());
+
+                Eigen::Map<Eigen::Vector3d> consensusStored(getPointData(pointIndex));
+                maxDualResidual = std::max(maxDualResidual, (consensus - consensusStored).norm());
+                consensusStored = consensus;
+
+                for (const auto &clusterAndLocalIndex: clustersOfPoint) {
+                    auto &clusterBA = clusters[clusterAndLocalIndex.first];
+                    int sharedPoint = sharedPointsProcessedByCluster[clusterAndLocalIndex.first]++;
+
+                    Eigen::Map<const Eigen::Vector3d> pointLocal(&clusterBA.pointsXYZ[dimPoint * clusterAndLocalIndex.second]);
+                    Eigen::Map<Eigen::Vector3d> dual(&clusterBA.duals[dimPoint * sharedPoint]);
+                    Eigen::Map<Eigen::Vector3d> target(&clusterBA.targets[dimPoint * sharedPoint]);
+
+                    dual += pointLocal - consensus;
+                    target = consensus - dual;
+                    maxPrimalResidual = std::max(maxPrimalResidual, (pointLocal - consensus).norm());
+                }
+            }
+
+            if (maxPrimalResidual < toleranceConsensus && maxDualResidual < toleranceConsensus) {
+                break;
+            }
+        }
+
+        // each pose belongs to exactly one cluster, shared points already store consensus values
+        double secondsSolving = 0;
+
+        for (const auto &clusterBA: clusters) {
+            for (int localPose = 0; localPose < clusterBA.poseIndices.size(); ++localPose) {
+                int poseIndex = clusterBA.poseIndices[localPose];
+                std::copy_n(&clusterBA.translations[dimPose * localPose], dimPose, getTranslationData(poseIndex));
+                std::copy_n(&clusterBA.orientations[dimOrientation * localPose], dimOrientation,
+                            getOrientationData(poseIndex));
+            }
+            secondsSolving = std::max(secondsSolving, clusterBA.summary.total_time_in_seconds);
+        }
+
+        for (int pointIndex = 0; pointIndex < numberOfPoints; ++pointIndex) {
+            const auto &clustersOfPoint = clustersAndLocalIndicesByPoint[pointIndex];
+
+            if (clustersOfPoint.size() == 1) {
+                const auto &clusterBA = clusters[clustersOfPoint[0].first];
+                std::copy_n(&clusterBA.pointsXYZ[dimPoint * clustersOfPoint[0].second], dimPoint,
+                            getPointData(pointIndex));
+            }
+        }
+
+        {
+            std::stringstream solverInfoStream;
+            solverInfoStream << "partitioned into " << numberOfClusters << " clusters"
+                             << ", poses " << numberOfPoses
+                             << ", points " << numberOfPoints
+                             << ", observations " << observationPointIndices.size()
+                             << ", consensus iterations " << iterationsConsensus
+                             << ", max primal residual " << maxPrimalResidual
+                             << ", last cluster solve time " << secondsSolving << " s";
+            solverInfo = solverInfoStream.str();
+        }
+        numberOfIterationsLastOptimization = iterationsConsensus;
+
+        return isSolutionUsable;
+    }
+
+    void BundleDepthAdjuster::setOutlierRejection(int maxRoundsToSet,
+                                                  double thresholdToSet) {
+        assert(maxRoundsToSet > 0);
+        assert(thresholdToSet > 0);
+        maxRoundsOutlierRejection = maxRoundsToSet;
+        thresholdOutlierRejection = thresholdToSet;
+    }
+
+    void BundleDepthAdjuster::setInverseDepthParameterization(bool useInverseDepthToSet) {
+        useInverseDepthParameterization = useInverseDepthToSet;
+    }
+
+    bool BundleDepthAdjuster::usePartitionedOptimization() const {
+        return maxPosesPerClusterPartitioned > 0 && getNumberOfPoses() > maxPosesPerClusterPartitioned;
+    }
+
+    void BundleDepthAdjuster::setPartitioning(int maxPosesPerClusterToSet,
+                                              int maxIterationsConsensusToSet) {
+        assert(maxPosesPerClusterToSet >= 0);
+        assert(maxIterationsConsensusToSet > 0);
+        maxPosesPerClusterPartitioned = maxPosesPerClusterToSet;
+        maxIterationsConsensus = maxIterationsConsensusToSet;
+    }
+
+    int BundleDepthAdjuster::getNumberOfPoses() const {
+        return static_cast<int>(translationsWorldToCamera.size()) / dimPose;
+    }
+
+    int BundleDepthAdjuster::getNumberOfPoints() const {
+        return static_cast<int>(pointsXYZ.size()) / dimPoint;
+    }
+
+    double *BundleDepthAdjuster::getPointData(int pointIndex) {
+        assert(pointIndex >= 0 && pointIndex < getNumberOfPoints());
+        return &pointsXYZ[dimPoint * pointIndex];
+    }
+
+    double *BundleDepthAdjuster::getTranslationData(int poseIndex) {
+        assert(poseIndex >= 0 && poseIndex < getNumberOfPoses());
+        return &translationsWorldToCamera[dimPose * poseIndex];
+    }
+
+    double *BundleDepthAdjuster::getOrientationData(int poseIndex) {
+        assert(poseIndex >= 0 && poseIndex < getNumberOfPoses());
+        return &orientationsWorldToCameraQxyzw[dimOrientation * poseIndex];
     }
 
     Sophus::SE3d BundleDepthAdjuster::getSE3TransformationMatrixByPoseNumber(int poseNumber) const {
 
         Sophus::SE3d pose;
-        pose.setQuaternion(Eigen::Quaterniond(orientationWorldToCameraqxyzwByPoseNumber[poseNumber].data()));
-        pose.translation() = Eigen::Vector3d(poseWorldToCameraTxTyTzByPoseNumber[poseNumber].data());
+        pose.setQuaternion(Eigen::Quaterniond(&orientationsWorldToCameraQxyzw[dimOrientation * poseNumber]));
+        pose.translation() = Eigen::Vector3d(&translationsWorldToCamera[dimPose * poseNumber]);
 
         return pose;
     }
 
     Eigen::Vector3d BundleDepthAdjuster::getPointVector3dByPointGlobalIndex(int pointGlobalIndex) const {
-        return Eigen::Vector3d(pointsXYZbyIndex[pointGlobalIndex].data());
+        return Eigen::Vector3d(&pointsXYZ[dimPoint * pointGlobalIndex]);
     }
 
     Eigen::Vector4d BundleDepthAdjuster::getPointVector4dByPointGlobalIndex(int pointGlobalIndex) const {
         Eigen::Vector4d point4d;
         point4d.setOnes();
-        for (int i = 0; i < 3; ++i) {
-            point4d[i] = pointsXYZbyIndex[pointGlobalIndex][i];
-        }
+        point4d.head<3>() = getPointVector3dByPointGlobalIndex(pointGlobalIndex);
         return point4d;
     }
 
@@ -423,14 +1011,17 @@ namespace gdr {
     std::vector<double> BundleDepthAdjuster::getL2Errors() {
         std::vector<double> errorsL2;
 
-        for (int currPose = 0; currPose < poseWorldToCameraTxTyTzByPoseNumber.size(); ++currPose) {
-            for (const auto &keyPointInfosByPose: keyPointInfoByPoseNumberAndPointNumber[currPose]) {
+        for (int currPose = 0; currPose < getNumberOfPoses(); ++currPose) {
+
+            const auto &camera = cameraModelByPoseNumber[currPose];
+            const auto poseTransformation = getSE3TransformationMatrixByPoseNumber(currPose);
+
+            for (int observation = observationStartsByPose[currPose];
+                 observation < observationStartsByPose[currPose + 1]; ++observation) {
 
-                int currPoint = keyPointInfosByPose.first;
-                const auto &keyPointInfo = keyPointInfoByPoseNumberAndPointNumber[currPose][currPoint];
+                int currPoint = observationPointIndices[observation];
+                const auto &keyPointInfo = observationKeyPointInfos[observation];
 
-                const auto &camera = cameraModelByPoseNumber[currPose];
-                const auto poseTransformation = getSE3TransformationMatrixByPoseNumber(currPose);
                 const auto point3d = getPointVector3dByPointGlobalIndex(currPoint);
                 const auto observedPoint3d = camera.getCoordinates3D(keyPointInfo.getX(),
                                                                      keyPointInfo.getY(),
@@ -455,17 +1046,50 @@ namespace gdr {
         assert(keyPointInfo.size() == posesCameraToWorld.size());
         assert(!posesCameraToWorld.empty());
 
+        pointsXYZ.clear();
+        pointsXYZ.reserve(dimPoint * points.size());
+
         for (const auto &point: points) {
-            pointsXYZbyIndex.emplace_back(point.getVectorPointXYZ());
+            const auto &pointXYZ = point.getVectorPointXYZ();
+            assert(pointXYZ.size() == dimPoint);
+            pointsXYZ.insert(pointsXYZ.end(), pointXYZ.begin(), pointXYZ.end());
         }
 
+        observationStartsByPose.clear();
+        observationPointIndices.clear();
+        observationKeyPointInfos.clear();
+        observationStartsByPose.reserve(keyPointInfo.size() + 1);
+        observationStartsByPose.emplace_back(0);
+
         for (const auto &mapIntInfo: keyPointInfo) {
+            std::vector<std::pair<int, const KeyPointInfo *>> observationsOfPose;
+            observationsOfPose.reserve(mapIntInfo.size());
+
             for (const auto &pairIntInfo: mapIntInfo) {
+                assert(pairIntInfo.first >= 0 && pairIntInfo.first < points.size());
                 assert(pairIntInfo.second.getX() >= 0);
                 assert(pairIntInfo.second.getY() >= 0);
+                observationsOfPose.emplace_back(std::make_pair(pairIntInfo.first, &pairIntInfo.second));
             }
+
+            // points observed by one pose are stored in increasing order for sequential access
+            std::sort(observationsOfPose.begin(), observationsOfPose.end(),
+                      [](const auto &lhs, const auto &rhs) {
+                          return lhs.first < rhs.first;
+                      });
+
+            for (const auto &pointIndexAndInfo: observationsOfPose) {
+                observationPointIndices.emplace_back(pointIndexAndInfo.first);
+                observationKeyPointInfos.emplace_back(*pointIndexAndInfo.second);
+            }
+            observationStartsByPose.emplace_back(static_cast<int>(observationPointIndices.size()));
         }
-        keyPointInfoByPoseNumberAndPointNumber = keyPointInfo;
+
+        translationsWorldToCamera.clear();
+        orientationsWorldToCameraQxyzw.clear();
+        cameraModelByPoseNumber.clear();
+        translationsWorldToCamera.reserve(dimPose * posesCameraToWorld.size());
+        orientationsWorldToCameraQxyzw.reserve(dimOrientation * posesCameraToWorld.size());
 
         for (const auto &pose: posesCameraToWorld) {
 
@@ -476,20 +1100,21 @@ namespace gdr {
 
             const auto &translation = poseWorldToCamera.translation();
             const auto &rotationQuat = poseWorldToCamera.unit_quaternion();
-            const auto &cameraIntr = pose.second;
 
-            poseWorldToCameraTxTyTzByPoseNumber.push_back({translation[0], translation[1], translation[2]});
-            orientationWorldToCameraqxyzwByPoseNumber.push_back(
-                    {rotationQuat.x(), rotationQuat.y(), rotationQuat.z(), rotationQuat.w()});
+            translationsWorldToCamera.insert(translationsWorldToCamera.end(),
+                                             {translation[0], translation[1], translation[2]});
+            orientationsWorldToCameraQxyzw.insert(orientationsWorldToCameraQxyzw.end(),
+                                                  {rotationQuat.x(), rotationQuat.y(),
+                                                   rotationQuat.z(), rotationQuat.w()});
 
             cameraModelByPoseNumber.emplace_back(pose.second);
-            assert(poseWorldToCameraTxTyTzByPoseNumber[poseWorldToCameraTxTyTzByPoseNumber.size() - 1].size() ==
-                   dimPose);
         }
 
-        assert(pointsXYZbyIndex.size() == points.size());
-        assert(keyPointInfo.size() == keyPointInfoByPoseNumberAndPointNumber.size());
-        assert(posesCameraToWorld.size() == poseWorldToCameraTxTyTzByPoseNumber.size());
+        assert(getNumberOfPoints() == points.size());
+        assert(observationStartsByPose.size() == keyPointInfo.size() + 1);
+        assert(observationKeyPointInfos.size() == observationPointIndices.size());
+        assert(getNumberOfPoses() == posesCameraToWorld.size());
+        assert(orientationsWorldToCameraQxyzw.size() == dimOrientation * getNumberOfPoses());
     }
 
     int BundleDepthAdjuster::getMaxNumberIterations() const {
@@ -509,60 +1134,26 @@ namespace gdr {
         maxNumberTreadsCeres = maxNumberThreadsToUse;
     }
 
-    ceres::CostFunction *
-    BundleDepthAdjuster::DepthOnlyResidual::Create(double newObservedDepth,
-                                                   const CameraRGBD &camera,
-                                                   double estNormalizedDepth,
-                                                   double devDividerDepth,
-                                                   double medianResDepth) {
-
-        return (new ceres::AutoDiffCostFunction<DepthOnlyResidual, 1, dimPoint, dimPose, dimOrientation>(
-                new DepthOnlyResidual(newObservedDepth,
-                                      camera,
-                                      estNormalizedDepth,
-                                      devDividerDepth,
-                                      medianResDepth)));
-    }
-
-    ceres::CostFunction *BundleDepthAdjuster::ReprojectionOnlyResidual::Create(double newObservedX,
-                                                                               double newObservedY,
-                                                                               double scale,
-                                                                               const CameraRGBD &camera,
-                                                                               double estNormalizedReproj,
-                                                                               double devDividerReproj,
-                                                                               double medianResReproj) {
-
-        return (new ceres::AutoDiffCostFunction<ReprojectionOnlyResidual, 2, dimPoint, dimPose, dimOrientation>(
-                new ReprojectionOnlyResidual(newObservedX, newObservedY,
-                                             scale, camera,
-                                             estNormalizedReproj,
-                                             devDividerReproj,
-                                             medianResReproj)));
-    }
-
-    BundleDepthAdjuster::ReprojectionOnlyResidual::ReprojectionOnlyResidual(double newObservedX,
-                                                                            double newObservedY,
-                                                                            double scale,
-                                                                            const CameraRGBD &cameraRgbd,
-                                                                            double devNormalizedEstReproj,
-                                                                            double devDividerReproj,
-                                                                            double medianResReproj)
-            : observedX(newObservedX),
-              observedY(newObservedY),
-              scaleKeyPoint(scale),
-              camera(cameraRgbd),
-              deviationEstimationNormalizedReproj(devNormalizedEstReproj),
-              deviationDividerReproj(devDividerReproj),
-              medianResidualReproj(medianResReproj) {}
-
-    BundleDepthAdjuster::DepthOnlyResidual::DepthOnlyResidual(double newObservedDepth,
-                                                              const CameraRGBD &cameraRgbd,
-                                                              double devNormalizedEstDepth,
-                                                              double devDividerDepth,
-                                                              double medianResDepth)
-            : observedDepth(newObservedDepth),
-              camera(cameraRgbd),
-              deviationEstimationNormalizedDepth(devNormalizedEstDepth),
-              deviationDividerDepth(devDividerDepth),
-              medianResidualDepth(medianResDepth) {}
+    void BundleDepthAdjuster::setLinearSolver(const ceres::LinearSolverType &linearSolverTypeToSet,
+                                              const ceres::PreconditionerType &preconditionerTypeToSet) {
+        selectLinearSolverBySize = false;
+        linearSolverType = linearSolverTypeToSet;
+        preconditionerType = preconditionerTypeToSet;
+    }
+
+    void BundleDepthAdjuster::setLinearSolverSelectionBySize() {
+        selectLinearSolverBySize = true;
+    }
+
+    std::string BundleDepthAdjuster::getSolverInfo() const {
+        return solverInfo;
+    }
+
+    int BundleDepthAdjuster::getNumberOfIterations() const {
+        return numberOfIterationsLastOptimization;
+    }
+
+    const std::vector<std::pair<int, int>> &BundleDepthAdjuster::getOutlierObservations() const {
+        return outlierObservationsLastOptimization;
+    }
 }
@@ -0,0 +1,43 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#include <cassert>
+
+#include "bundleAdjustment/ConsensusPriorResidual.h"
+
+namespace gdr {
+
+    ConsensusPriorResidual::ConsensusPriorResidual(const double *targetToSet,
+                                                   double deviationToSet) :
+            target(targetToSet),
+            deviation(deviationToSet) {
+
+        assert(target);
+        assert(deviation > 0);
+    }
+
+    bool ConsensusPriorResidual::Evaluate(double const *const *parameters,
+                                          double *residuals,
+                                          double **jacobians) const {
+
+        for (int i = 0; i < 3; ++i) {
+            residuals[i] = (parameters[0][i] - target[i]) / deviation;
+        }
+
+        if (jacobians && jacobians[0]) {
+            // row-major 3x3 diagonal matrix
+            for (int i = 0; i < 9; ++i) {
+                jacobians[0][i] = (i % 4 == 0) ? 1.0 / deviation : 0.0;
+            }
+        }
+
+        return true;
+    }
+
+    ceres::CostFunction *ConsensusPriorResidual::Create(const double *target,
+                                                        double deviation) {
+        return new ConsensusPriorResidual(target, deviation);
+    }
+}
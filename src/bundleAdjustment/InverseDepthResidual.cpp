@@ -0,0 +1,129 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#include <cassert>
+
+#include "bundleAdjustment/InverseDepthResidual.h"
+#include "bundleAdjustment/AnalyticJacobians.h"
+
+namespace gdr {
+
+    InverseDepthResidual::InverseDepthResidual(double anchorXToSet,
+                                               double anchorYToSet,
+                                               const CameraRGBD &anchorCamera,
+                                               double observedXToSet,
+                                               double observedYToSet,
+                                               double observedDepthToSet,
+                                               const CameraRGBD &camera,
+                                               double deviationReprojectionToSet,
+                                               double deviationDepthToSet) :
+            rayAnchor((anchorXToSet - anchorCamera.getCx()) / anchorCamera.getFx(),
+                      (anchorYToSet - anchorCamera.getCy()) / anchorCamera.getFy(),
+                      1.0),
+            observedX(observedXToSet),
+            observedY(observedYToSet),
+            observedDepth(observedDepthToSet),
+            fx(camera.getFx()),
+            fy(camera.getFy()),
+            cx(camera.getCx()),
+            cy(camera.getCy()),
+            deviationReprojection(deviationReprojectionToSet),
+            deviationDepth(deviationDepthToSet) {
+
+        assert(deviationReprojection > 0);
+        assert(deviationDepth > 0);
+    }
+
+    bool InverseDepthResidual::Evaluate(double const *const *parameters,
+                                        double *residuals,
+                                        double **jacobians) const {
+
+        double inverseDepth = parameters[0][0];
+
+        if (inverseDepth <= 0) {
+            return false;
+        }
+
+        Eigen::Map<const Eigen::Vector3d> translationAnchor(parameters[1]);
+        Eigen::Quaterniond orientationAnchor(parameters[2]);
+        Eigen::Map<const Eigen::Vector3d> translation(parameters[3]);
+        Eigen::Quaterniond orientation(parameters[4]);
+
+        // anchor camera to world rotation uses conjugate quaternion (-u, w)
+        Eigen::Vector3d pointAnchorShifted = rayAnchor / inverseDepth - translationAnchor;
+        Eigen::Quaterniond orientationAnchorInversed = orientationAnchor.conjugate();
+        Eigen::Vector3d point = AnalyticJacobians::rotate(orientationAnchorInversed, pointAnchorShifted);
+        Eigen::Vector3d pointCamera = AnalyticJacobians::rotate(orientation, point) + translation;
+
+        double depthInversed = 1.0 / pointCamera[2];
+        double computedX = fx * pointCamera[0] * depthInversed + cx;
+        double computedY = fy * pointCamera[1] * depthInversed + cy;
+
+        residuals[0] = (observedX - computedX) / deviationReprojection;
+        residuals[1] = (observedY - computedY) / deviationReprojection;
+        residuals[2] = (observedDepth - pointCamera[2]) / deviationDepth;
+
+        if (!jacobians) {
+            return true;
+        }
+
+        Eigen::Matrix3d residualByPointCamera = AnalyticJacobians::getProjectionDepthByPointCamera(pointCamera, fx, fy);
+        residualByPointCamera.topRows<2>() /= -deviationReprojection;
+        residualByPointCamera.row(2) /= -deviationDepth;
+
+        // derivatives with respect to point in world coordinates and to point in anchor camera coordinates
+        Eigen::Matrix3d residualByPoint = residualByPointCamera * AnalyticJacobians::getRotatedPointByPoint(orientation);
+        Eigen::Matrix3d residualByPointAnchor =
+                residualByPoint * AnalyticJacobians::getRotatedPointByPoint(orientationAnchorInversed);
+
+        if (jacobians[0]) {
+            Eigen::Map<Eigen::Vector3d> jacobianInverseDepth(jacobians[0]);
+            jacobianInverseDepth = residualByPointAnchor * (-rayAnchor / (inverseDepth * inverseDepth));
+        }
+
+        if (jacobians[1]) {
+            Eigen::Map<Eigen::Matrix<double, 3, 3, Eigen::RowMajor>> jacobianTranslationAnchor(jacobians[1]);
+            jacobianTranslationAnchor = -residualByPointAnchor;
+        }
+
+        if (jacobians[2]) {
+            // vector part of the conjugate quaternion changes sign
+            Eigen::Matrix<double, 3, 4> pointByOrientationAnchor =
+                    AnalyticJacobians::getRotatedPointByOrientation(orientationAnchorInversed, pointAnchorShifted);
+            pointByOrientationAnchor.leftCols<3>() *= -1.0;
+
+            Eigen::Map<Eigen::Matrix<double, 3, 4, Eigen::RowMajor>> jacobianOrientationAnchor(jacobians[2]);
+            jacobianOrientationAnchor = residualByPoint * pointByOrientationAnchor;
+        }
+
+        if (jacobians[3]) {
+            Eigen::Map<Eigen::Matrix<double, 3, 3, Eigen::RowMajor>> jacobianTranslation(jacobians[3]);
+            jacobianTranslation = residualByPointCamera;
+        }
+
+        if (jacobians[4]) {
+            Eigen::Map<Eigen::Matrix<double, 3, 4, Eigen::RowMajor>> jacobianOrientation(jacobians[4]);
+            jacobianOrientation = residualByPointCamera * AnalyticJacobians::getRotatedPointByOrientation(orientation,
+                                                                                                          point);
+        }
+
+        return true;
+    }
+
+    ceres::CostFunction *InverseDepthResidual::Create(double anchorX,
+                                                      double anchorY,
+                                                      const CameraRGBD &anchorCamera,
+                                                      double observedX,
+                                                      double observedY,
+                                                      double observedDepth,
+                                                      const CameraRGBD &camera,
+                                                      double deviationReprojection,
+                                                      double deviationDepth) {
+        return new InverseDepthResidual(anchorX, anchorY, anchorCamera,
+                                        observedX, observedY, observedDepth,
+                                        camera,
+                                        deviationReprojection, deviationDepth);
+    }
+}
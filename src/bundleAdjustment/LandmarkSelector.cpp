@@ -0,0 +1,176 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+
+#include "bundleAdjustment/LandmarkSelector.h"
+
+namespace gdr {
+
+    std::vector<int> LandmarkSelector::selectLandmarks(
+            const std::vector<std::unordered_map<int, KeyPointInfo>> &keyPointInfoByPose,
+            int numberOfPoints,
+            int maxLandmarksPerPose,
+            int imageWidth,
+            int imageHeight,
+            int cellsX,
+            int cellsY) {
+
+        assert(maxLandmarksPerPose > 0);
+        assert(imageWidth > 0 && imageHeight > 0);
+        assert(cellsX > 0 && cellsY > 0);
+
+        int numberOfPoses = static_cast<int>(keyPointInfoByPose.size());
+        int numberOfCells = cellsX * cellsY;
+        int maxLandmarksPerCell = std::max(1, maxLandmarksPerPose / numberOfCells);
+
+        // pairs {pose, grid cell} of each point observation
+        std::vector<std::vector<std::pair<int, int>>> posesAndCellsByPoint(numberOfPoints);
+
+        // long tracks and small depth (depth noise grows quadratically) are preferred
+        std::vector<double> scoreByPoint(numberOfPoints, 0.0);
+
+        for (int poseIndex = 0; poseIndex < numberOfPoses; ++poseIndex) {
+            for (const auto &pointIndexAndInfo: keyPointInfoByPose[poseIndex]) {
+                int pointIndex = pointIndexAndInfo.first;
+                const auto &keyPointInfo = pointIndexAndInfo.second;
+                assert(pointIndex >= 0 && pointIndex < numberOfPoints);
+
+                int cellX = std::clamp(static_cast<int>(keyPointInfo.getX() * cellsX / imageWidth), 0, cellsX - 1);
+                int cellY = std::clamp(static_cast<int>(keyPointInfo.getY() * cellsY / imageHeight), 0, cellsY - 1);
+                posesAndCellsByPoint[pointIndex].emplace_back(std::make_pair(poseIndex, cellY * cellsX + cellX));
+
+                double depth = keyPointInfo.getDepth();
+                scoreByPoint[pointIndex] += 1.0 / (1.0 + depth * depth);
+            }
+        }
+
+        std::vector<int> pointsByScore(numberOfPoints);
+        std::iota(pointsByScore.begin(), pointsByScore.end(), 0);
+        std::stable_sort(pointsByScore.begin(), pointsByScore.end(),
+                         [&scoreByPoint](int lhs, int rhs) {
+                             return scoreByPoint[lhs] > scoreByPoint[rhs];
+                         });
+
+        std::vector<int> landmarksByPose(numberOfPoses, 0);
+        std::vector<int> landmarksByPoseAndCell(numberOfPoses * numberOfCells, 0);
+        std::vector<char> isSelected(numberOfPoints, false);
+
+        auto selectPoint = [&](int pointIndex) {
+            isSelected[pointIndex] = true;
+            for (const auto &poseAndCell: posesAndCellsByPoint[pointIndex]) {
+                ++landmarksByPose[poseAndCell.first];
+                ++landmarksByPoseAndCell[poseAndCell.first * numberOfCells + poseAndCell.second];
+            }
+        };
+
+        // the first pass spreads landmarks of each pose over the image and is bounded by cell quotas only,
+        // so landmarks selected for neighbouring poses do not exhaust the budget before sparse cells are reached,
+        // the second one fills the remaining budget of poses with the best points left
+        for (int pointIndex: pointsByScore) {
+            for (const auto &poseAndCell: posesAndCellsByPoint[pointIndex]) {
+                if (landmarksByPoseAndCell[poseAndCell.first * numberOfCells + poseAndCell.second]
+                    < maxLandmarksPerCell) {
+                    selectPoint(pointIndex);
+                    break;
+                }
+            }
+        }
+
+        for (int pointIndex: pointsByScore) {
+            if (isSelected[pointIndex]) {
+                continue;
+            }
+            for (const auto &poseAndCell: posesAndCellsByPoint[pointIndex]) {
+                if (landmarksByPose[poseAndCell.first] < maxLandmarksPerPose) {
+                    selectPoint(pointIndex);
+                    break;
+                }
+            }
+        }
+
+        std::vector<int> selectedPoints;
+        for (int pointIndex = 0; pointIndex < numberOfPoints; ++pointIndex) {
+            if (isSelected[pointIndex]) {
+                selectedPoints.emplace_back(pointIndex);
+            }
+        }
+
+        return selectedPoints;
+    }
+
+    std::vector<std::unordered_map<int, KeyPointInfo>> LandmarkSelector::getKeyPointInfoOfSelectedLandmarks(
+            const std::vector<std::unordered_map<int, KeyPointInfo>> &keyPointInfoByPose,
+            const std::vector<int> &selectedPoints) {
+
+        std::unordered_map<int, int> selectedIndexByPoint;
+        selectedIndexByPoint.reserve(selectedPoints.size());
+
+        for (int selectedIndex = 0; selectedIndex < selectedPoints.size(); ++selectedIndex) {
+            selectedIndexByPoint[selectedPoints[selectedIndex]] = selectedIndex;
+        }
+
+        std::vector<std::unordered_map<int, KeyPointInfo>> keyPointInfoOfSelected(keyPointInfoByPose.size());
+
+        for (int poseIndex = 0; poseIndex < keyPointInfoByPose.size(); ++poseIndex) {
+            for (const auto &pointIndexAndInfo: keyPointInfoByPose[poseIndex]) {
+                auto foundSelected = selectedIndexByPoint.find(pointIndexAndInfo.first);
+
+                if (foundSelected != selectedIndexByPoint.end()) {
+                    keyPointInfoOfSelected[poseIndex][foundSelected->second] = pointIndexAndInfo.second;
+                }
+            }
+        }
+
+        return keyPointInfoOfSelected;
+    }
+
+    void LandmarkSelector::retriangulateLandmarks(
+            std::vector<Point3d> &points,
+            const std::vector<int> &pointIndicesToUpdate,
+            const std::vector<std::pair<SE3, CameraRGBD>> &posesCameraToWorld,
+            const std::vector<std::unordered_map<int, KeyPointInfo>> &keyPointInfoByPose) {
+
+        assert(posesCameraToWorld.size() == keyPointInfoByPose.size());
+
+        std::vector<Eigen::Vector3d> sumCoordinatesByPoint(points.size(), Eigen::Vector3d::Zero());
+        std::vector<int> numberOfObservationsByPoint(points.size(), 0);
+        std::vector<char> isToUpdate(points.size(), false);
+
+        for (int pointIndex: pointIndicesToUpdate) {
+            assert(pointIndex >= 0 && pointIndex < points.size());
+            isToUpdate[pointIndex] = true;
+        }
+
+        for (int poseIndex = 0; poseIndex < posesCameraToWorld.size(); ++poseIndex) {
+            const auto &pose = posesCameraToWorld[poseIndex].first;
+            const auto &camera = posesCameraToWorld[poseIndex].second;
+
+            for (const auto &pointIndexAndInfo: keyPointInfoByPose[poseIndex]) {
+                int pointIndex = pointIndexAndInfo.first;
+
+                if (!isToUpdate[pointIndex]) {
+                    continue;
+                }
+
+                const auto &keyPointInfo = pointIndexAndInfo.second;
+                Eigen::Vector3d localCoordinates = camera.getCoordinates3D(keyPointInfo.getX(),
+                                                                           keyPointInfo.getY(),
+                                                                           keyPointInfo.getDepth());
+                sumCoordinatesByPoint[pointIndex] += pose.getSE3() * localCoordinates;
+                ++numberOfObservationsByPoint[pointIndex];
+            }
+        }
+
+        for (int pointIndex: pointIndicesToUpdate) {
+            if (numberOfObservationsByPoint[pointIndex] > 0) {
+                points[pointIndex].setEigenVector3dPointXYZ(
+                        sumCoordinatesByPoint[pointIndex] / numberOfObservationsByPoint[pointIndex]);
+            }
+        }
+    }
+}
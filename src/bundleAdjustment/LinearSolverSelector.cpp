@@ -0,0 +1,55 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#include <cassert>
+
+#include "bundleAdjustment/LinearSolverSelector.h"
+
+namespace gdr {
+
+    double LinearSolverSelector::getVisibilityDensity(int numberOfPoses,
+                                                      int numberOfPoints,
+                                                      int numberOfObservations) {
+        if (numberOfPoses <= 0 || numberOfPoints <= 0) {
+            return 0.0;
+        }
+
+        return static_cast<double>(numberOfObservations)
+               / (static_cast<double>(numberOfPoses) * static_cast<double>(numberOfPoints));
+    }
+
+    std::pair<ceres::LinearSolverType, ceres::PreconditionerType>
+    LinearSolverSelector::getLinearSolverAndPreconditioner(int numberOfPoses,
+                                                           int numberOfPoints,
+                                                           int numberOfObservations,
+                                                           bool isClusterPreconditionerAvailable) {
+        assert(numberOfPoses >= 0);
+        assert(numberOfPoints >= 0);
+        assert(numberOfObservations >= 0);
+
+        double visibilityDensity = getVisibilityDensity(numberOfPoses, numberOfPoints, numberOfObservations);
+
+        // reduced camera system of size 6N x 6N is factorized densely
+        if (numberOfPoses <= maxPosesDenseSchur) {
+            return {ceres::DENSE_SCHUR, ceres::JACOBI};
+        }
+
+        // almost every pair of poses shares points, so reduced camera system has no sparsity to exploit
+        if (numberOfPoses <= maxPosesDenseSchurDenseVisibility && visibilityDensity >= minVisibilityDensityDense) {
+            return {ceres::DENSE_SCHUR, ceres::JACOBI};
+        }
+
+        if (numberOfPoses <= maxPosesSparseSchur) {
+            return {ceres::SPARSE_SCHUR, ceres::JACOBI};
+        }
+
+        // factorization fill-in grows too fast, reduced camera system is solved by preconditioned CG
+        if (isClusterPreconditionerAvailable && visibilityDensity <= maxVisibilityDensityClusterJacobi) {
+            return {ceres::ITERATIVE_SCHUR, ceres::CLUSTER_JACOBI};
+        }
+
+        return {ceres::ITERATIVE_SCHUR, ceres::SCHUR_JACOBI};
+    }
+}
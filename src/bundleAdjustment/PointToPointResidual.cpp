@@ -0,0 +1,70 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#include <cassert>
+
+#include "bundleAdjustment/PointToPointResidual.h"
+#include "bundleAdjustment/AnalyticJacobians.h"
+
+namespace gdr {
+
+    PointToPointResidual::PointToPointResidual(const Eigen::Vector3d &pointFromToSet,
+                                               const Eigen::Vector3d &pointToToSet,
+                                               double deviationToSet) :
+            pointFrom(pointFromToSet),
+            pointTo(pointToToSet),
+            deviation(deviationToSet) {
+
+        assert(deviation > 0);
+    }
+
+    bool PointToPointResidual::Evaluate(double const *const *parameters,
+                                        double *residuals,
+                                        double **jacobians) const {
+
+        Eigen::Map<const Eigen::Vector3d> translationFrom(parameters[0]);
+        Eigen::Quaterniond orientationFrom(parameters[1]);
+        Eigen::Map<const Eigen::Vector3d> translationTo(parameters[2]);
+        Eigen::Quaterniond orientationTo(parameters[3]);
+
+        Eigen::Map<Eigen::Vector3d> residualsVector(residuals);
+        residualsVector = ((AnalyticJacobians::rotate(orientationFrom, pointFrom) + translationFrom)
+                           - (AnalyticJacobians::rotate(orientationTo, pointTo) + translationTo)) / deviation;
+
+        if (!jacobians) {
+            return true;
+        }
+
+        if (jacobians[0]) {
+            Eigen::Map<Eigen::Matrix<double, 3, 3, Eigen::RowMajor>> jacobianTranslationFrom(jacobians[0]);
+            jacobianTranslationFrom = Eigen::Matrix3d::Identity() / deviation;
+        }
+
+        if (jacobians[1]) {
+            Eigen::Map<Eigen::Matrix<double, 3, 4, Eigen::RowMajor>> jacobianOrientationFrom(jacobians[1]);
+            jacobianOrientationFrom = AnalyticJacobians::getRotatedPointByOrientation(orientationFrom, pointFrom)
+                                      / deviation;
+        }
+
+        if (jacobians[2]) {
+            Eigen::Map<Eigen::Matrix<double, 3, 3, Eigen::RowMajor>> jacobianTranslationTo(jacobians[2]);
+            jacobianTranslationTo = -Eigen::Matrix3d::Identity() / deviation;
+        }
+
+        if (jacobians[3]) {
+            Eigen::Map<Eigen::Matrix<double, 3, 4, Eigen::RowMajor>> jacobianOrientationTo(jacobians[3]);
+            jacobianOrientationTo = -AnalyticJacobians::getRotatedPointByOrientation(orientationTo, pointTo)
+                                    / deviation;
+        }
+
+        return true;
+    }
+
+    ceres::CostFunction *PointToPointResidual::Create(const Eigen::Vector3d &pointFrom,
+                                                      const Eigen::Vector3d &pointTo,
+                                                      double deviation) {
+        return new PointToPointResidual(pointFrom, pointTo, deviation);
+    }
+}
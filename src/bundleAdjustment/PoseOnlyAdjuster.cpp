@@ -0,0 +1,284 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <memory>
+#include <numeric>
+#include <sstream>
+
+#include <ceres/ceres.h>
+
+#include "bundleAdjustment/PoseOnlyAdjuster.h"
+#include "bundleAdjustment/PointToPointResidual.h"
+#include "bundleAdjustment/LandmarkSelector.h"
+#include "statistics/RobustEstimators.h"
+
+namespace gdr {
+
+    /** One 3D-3D correspondence between two frames, points are in camera coordinates */
+    struct PointCorrespondence {
+        int poseFrom = -1;
+        int poseTo = -1;
+        Eigen::Vector3d pointFrom;
+        Eigen::Vector3d pointTo;
+
+        // expected standard deviation of each coordinate of world points difference in meters
+        double deviation = 1.0;
+    };
+
+    /**
+     * @returns variance of back-projected keypoint: depth noise along the ray
+     *      and reprojection noise scaled by depth in two orthogonal directions
+     */
+    static double getBackProjectionVariance(const KeyPointInfo &keyPointInfo,
+                                            const CameraRGBD &camera) {
+        const auto &measurementEstimators = camera.getMeasurementErrorDeviationEstimators();
+
+        double deviationDepth = measurementEstimators.getDividerDepthErrorEstimator()(
+                keyPointInfo.getDepth(),
+                measurementEstimators.getParameterNoiseModelDepth());
+        double deviationReprojection = measurementEstimators.getDividerReprojectionEstimator()(
+                keyPointInfo.getScale(),
+                measurementEstimators.getParameterNoiseModelReprojection());
+        double deviationLateral = keyPointInfo.getDepth() * deviationReprojection
+                                  / (0.5 * (camera.getFx() + camera.getFy()));
+
+        return deviationDepth * deviationDepth + 2.0 * deviationLateral * deviationLateral;
+    }
+
+    static bool addPointCorrespondence(std::vector<PointCorrespondence> &correspondences,
+                                       int poseFrom,
+                                       const KeyPointInfo &keyPointInfoFrom,
+                                       int poseTo,
+                                       const KeyPointInfo &keyPointInfoTo,
+                                       const std::vector<std::pair<SE3, CameraRGBD>> &posesCameraToWorld) {
+        if (poseFrom == poseTo || keyPointInfoFrom.getDepth() <= 0 || keyPointInfoTo.getDepth() <= 0) {
+            return false;
+        }
+
+        const auto &cameraFrom = posesCameraToWorld[poseFrom].second;
+        const auto &cameraTo = posesCameraToWorld[poseTo].second;
+
+        PointCorrespondence correspondence;
+        correspondence.poseFrom = poseFrom;
+        correspondence.poseTo = poseTo;
+        correspondence.pointFrom = cameraFrom.getCoordinates3D(keyPointInfoFrom.getX(),
+                                                               keyPointInfoFrom.getY(),
+                                                               keyPointInfoFrom.getDepth());
+        correspondence.pointTo = cameraTo.getCoordinates3D(keyPointInfoTo.getX(),
+                                                           keyPointInfoTo.getY(),
+                                                           keyPointInfoTo.getDepth());
+
+        // isotropic approximation of covariance of the difference
+        correspondence.deviation = std::sqrt((getBackProjectionVariance(keyPointInfoFrom, cameraFrom)
+                                              + getBackProjectionVariance(keyPointInfoTo, cameraTo)) / 3.0);
+
+        if (!(correspondence.deviation > 0)) {
+            return false;
+        }
+
+        correspondences.emplace_back(correspondence);
+
+        return true;
+    }
+
+    std::vector<SE3> PoseOnlyAdjuster::optimizePointsAndPoses(
+            const std::vector<Point3d> &points,
+            const std::vector<std::pair<SE3, CameraRGBD>> &posesCameraToWorld,
+            const std::vector<std::unordered_map<int, KeyPointInfo>> &keyPointInfo,
+            int indexFixed,
+            bool &success) {
+
+        int numberOfPoses = static_cast<int>(posesCameraToWorld.size());
+        assert(numberOfPoses > 0);
+        assert(keyPointInfo.size() == numberOfPoses);
+        assert(indexFixed >= 0 && indexFixed < numberOfPoses);
+
+        translationsCameraToWorld.clear();
+        orientationsCameraToWorldQxyzw.clear();
+
+        for (const auto &poseAndCamera: posesCameraToWorld) {
+            Eigen::Vector3d translation = poseAndCamera.first.getTranslation();
+            Eigen::Quaterniond orientation = poseAndCamera.first.getRotationQuatd().normalized();
+
+            translationsCameraToWorld.insert(translationsCameraToWorld.end(),
+                                             translation.data(), translation.data() + dimPose);
+            orientationsCameraToWorldQxyzw.insert(orientationsCameraToWorldQxyzw.end(),
+                                                  orientation.coeffs().data(),
+                                                  orientation.coeffs().data() + dimOrientation);
+        }
+
+        std::vector<PointCorrespondence> correspondences;
+
+        if (inlierCorrespondences && !inlierCorrespondences->empty()) {
+            correspondences.reserve(inlierCorrespondences->size());
+
+            for (const auto &match: *inlierCorrespondences) {
+                int poseFrom = match.first.first.first;
+                int poseTo = match.second.first.first;
+                assert(poseFrom >= 0 && poseFrom < numberOfPoses);
+                assert(poseTo >= 0 && poseTo < numberOfPoses);
+
+                addPointCorrespondence(correspondences,
+                                       poseFrom, match.first.second,
+                                       poseTo, match.second.second,
+                                       posesCameraToWorld);
+            }
+        } else {
+
+            // observations of each point in increasing pose order are chained
+            std::vector<std::vector<int>> posesByPoint(points.size());
+
+            for (int poseIndex = 0; poseIndex < numberOfPoses; ++poseIndex) {
+                for (const auto &pointIndexAndInfo: keyPointInfo[poseIndex]) {
+                    assert(pointIndexAndInfo.first >= 0 && pointIndexAndInfo.first < points.size());
+                    posesByPoint[pointIndexAndInfo.first].emplace_back(poseIndex);
+                }
+            }
+
+            for (int pointIndex = 0; pointIndex < posesByPoint.size(); ++pointIndex) {
+                const auto &observingPoses = posesByPoint[pointIndex];
+
+                for (int i = 0; i + 1 < observingPoses.size(); ++i) {
+                    int poseFrom = observingPoses[i];
+                    int poseTo = observingPoses[i + 1];
+
+                    addPointCorrespondence(correspondences,
+                                           poseFrom, keyPointInfo[poseFrom].at(pointIndex),
+                                           poseTo, keyPointInfo[poseTo].at(pointIndex),
+                                           posesCameraToWorld);
+                }
+            }
+        }
+
+        // deviations of the noise model are rescaled by robust estimation of whitened residuals
+        // with initial poses, so robust loss threshold does not depend on noise model parameters
+        std::vector<double> whitenedErrors;
+        whitenedErrors.reserve(3 * correspondences.size());
+
+        for (const auto &correspondence: correspondences) {
+            const auto &poseFrom = posesCameraToWorld[correspondence.poseFrom].first.getSE3();
+            const auto &poseTo = posesCameraToWorld[correspondence.poseTo].first.getSE3();
+            Eigen::Vector3d difference = (poseFrom * correspondence.pointFrom - poseTo * correspondence.pointTo)
+                                         / correspondence.deviation;
+
+            for (int i = 0; i < 3; ++i) {
+                whitenedErrors.emplace_back(std::abs(difference[i]));
+            }
+        }
+
+        double scaleDeviation = whitenedErrors.empty() ? 1.0 : factor * RobustEstimators::getQuantile(whitenedErrors);
+        if (!(scaleDeviation > 0)) {
+            scaleDeviation = 1.0;
+        }
+
+        std::unique_ptr<ceres::LossFunction> lossFunction = std::make_unique<ceres::CauchyLoss>(1.0);
+
+        ceres::Problem::Options problemOptions;
+        problemOptions.loss_function_ownership = ceres::DO_NOT_TAKE_OWNERSHIP;
+
+        ceres::Problem problem(problemOptions);
+        ceres::LocalParameterization *quaternionLocalParameterization =
+                new ceres::EigenQuaternionParameterization;
+
+        for (const auto &correspondence: correspondences) {
+            problem.AddResidualBlock(PointToPointResidual::Create(correspondence.pointFrom,
+                                                                  correspondence.pointTo,
+                                                                  scaleDeviation * correspondence.deviation),
+                                     lossFunction.get(),
+                                     {&translationsCameraToWorld[dimPose * correspondence.poseFrom],
+                                      &orientationsCameraToWorldQxyzw[dimOrientation * correspondence.poseFrom],
+                                      &translationsCameraToWorld[dimPose * correspondence.poseTo],
+                                      &orientationsCameraToWorldQxyzw[dimOrientation * correspondence.poseTo]});
+        }
+
+        for (int poseIndex = 0; poseIndex < numberOfPoses; ++poseIndex) {
+            double *orientation = &orientationsCameraToWorldQxyzw[dimOrientation * poseIndex];
+
+            if (problem.HasParameterBlock(orientation)) {
+                problem.SetParameterization(orientation, quaternionLocalParameterization);
+            }
+        }
+
+        if (problem.HasParameterBlock(&translationsCameraToWorld[dimPose * indexFixed])) {
+            problem.SetParameterBlockConstant(&translationsCameraToWorld[dimPose * indexFixed]);
+            problem.SetParameterBlockConstant(&orientationsCameraToWorldQxyzw[dimOrientation * indexFixed]);
+        }
+
+        ceres::Solver::Options options;
+        options.linear_solver_type = (numberOfPoses <= maxPosesDenseNormalCholesky) ?
+                                     ceres::DENSE_NORMAL_CHOLESKY : ceres::SPARSE_NORMAL_CHOLESKY;
+        options.minimizer_progress_to_stdout = false;
+        options.max_num_iterations = iterations;
+        options.num_threads = std::max(1, maxNumberTreadsCeres);
+
+        ceres::Solver::Summary summary;
+        ceres::Solve(options, &problem, &summary);
+
+        success = summary.IsSolutionUsable();
+
+        std::vector<std::pair<SE3, CameraRGBD>> posesOptimizedAndCameras;
+        std::vector<SE3> posesOptimized;
+
+        for (int poseIndex = 0; poseIndex < numberOfPoses; ++poseIndex) {
+            Eigen::Map<const Eigen::Vector3d> translation(&translationsCameraToWorld[dimPose * poseIndex]);
+            Eigen::Quaterniond orientation(&orientationsCameraToWorldQxyzw[dimOrientation * poseIndex]);
+
+            posesOptimized.emplace_back(SE3(orientation.normalized(), translation));
+            posesOptimizedAndCameras.emplace_back(std::make_pair(posesOptimized.back(),
+                                                                 posesCameraToWorld[poseIndex].second));
+        }
+
+        std::vector<int> allPointIndices(points.size());
+        std::iota(allPointIndices.begin(), allPointIndices.end(), 0);
+
+        pointsOptimized = points;
+        LandmarkSelector::retriangulateLandmarks(pointsOptimized,
+                                                 allPointIndices,
+                                                 posesOptimizedAndCameras,
+                                                 keyPointInfo);
+
+        std::stringstream solverInfoStream;
+        solverInfoStream << "pose only " << ceres::LinearSolverTypeToString(summary.linear_solver_type_used)
+                         << ", poses " << numberOfPoses
+                         << ", correspondences " << correspondences.size()
+                         << (inlierCorrespondences && !inlierCorrespondences->empty() ? " (inlier matches)"
+                                                                                      : " (point tracks)")
+                         << ", iterations " << summary.num_successful_steps + summary.num_unsuccessful_steps
+                         << ", solve time " << summary.total_time_in_seconds << " s";
+        solverInfo = solverInfoStream.str();
+        numberOfCorrespondences = static_cast<int>(correspondences.size());
+
+        return posesOptimized;
+    }
+
+    std::vector<Point3d> PoseOnlyAdjuster::getOptimizedPoints() const {
+        return pointsOptimized;
+    }
+
+    std::string PoseOnlyAdjuster::getSolverInfo() const {
+        return solverInfo;
+    }
+
+    int PoseOnlyAdjuster::getNumberOfCorrespondences() const {
+        return numberOfCorrespondences;
+    }
+
+    void PoseOnlyAdjuster::setInlierCorrespondences(const KeyPointMatches *inlierCorrespondencesToSet) {
+        inlierCorrespondences = inlierCorrespondencesToSet;
+    }
+
+    void PoseOnlyAdjuster::setMaxNumberIterations(int iterationsNumber) {
+        assert(iterationsNumber > 0);
+        iterations = iterationsNumber;
+    }
+
+    void PoseOnlyAdjuster::setMaxNumberThreads(int numberOfThreads) {
+        assert(numberOfThreads > 0);
+        maxNumberTreadsCeres = numberOfThreads;
+    }
+}
@@ -0,0 +1,88 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#include <cassert>
+
+#include "bundleAdjustment/ReprojectionDepthResidual.h"
+#include "bundleAdjustment/AnalyticJacobians.h"
+
+namespace gdr {
+
+    ReprojectionDepthResidual::ReprojectionDepthResidual(double observedXToSet,
+                                                         double observedYToSet,
+                                                         double observedDepthToSet,
+                                                         const CameraRGBD &camera,
+                                                         double deviationReprojectionToSet,
+                                                         double deviationDepthToSet) :
+            observedX(observedXToSet),
+            observedY(observedYToSet),
+            observedDepth(observedDepthToSet),
+            fx(camera.getFx()),
+            fy(camera.getFy()),
+            cx(camera.getCx()),
+            cy(camera.getCy()),
+            deviationReprojection(deviationReprojectionToSet),
+            deviationDepth(deviationDepthToSet) {
+
+        assert(deviationReprojection > 0);
+        assert(deviationDepth > 0);
+    }
+
+    bool ReprojectionDepthResidual::Evaluate(double const *const *parameters,
+                                             double *residuals,
+                                             double **jacobians) const {
+
+        Eigen::Map<const Eigen::Vector3d> point(parameters[0]);
+        Eigen::Map<const Eigen::Vector3d> translation(parameters[1]);
+        Eigen::Quaterniond orientation(parameters[2]);
+
+        Eigen::Vector3d pointCamera = AnalyticJacobians::rotate(orientation, point) + translation;
+
+        double depthInversed = 1.0 / pointCamera[2];
+        double computedX = fx * pointCamera[0] * depthInversed + cx;
+        double computedY = fy * pointCamera[1] * depthInversed + cy;
+
+        residuals[0] = (observedX - computedX) / deviationReprojection;
+        residuals[1] = (observedY - computedY) / deviationReprojection;
+        residuals[2] = (observedDepth - pointCamera[2]) / deviationDepth;
+
+        if (!jacobians) {
+            return true;
+        }
+
+        Eigen::Matrix3d residualByPointCamera = AnalyticJacobians::getProjectionDepthByPointCamera(pointCamera, fx, fy);
+        residualByPointCamera.topRows<2>() /= -deviationReprojection;
+        residualByPointCamera.row(2) /= -deviationDepth;
+
+        if (jacobians[0]) {
+            Eigen::Map<Eigen::Matrix<double, 3, 3, Eigen::RowMajor>> jacobianPoint(jacobians[0]);
+            jacobianPoint = residualByPointCamera * AnalyticJacobians::getRotatedPointByPoint(orientation);
+        }
+
+        if (jacobians[1]) {
+            Eigen::Map<Eigen::Matrix<double, 3, 3, Eigen::RowMajor>> jacobianTranslation(jacobians[1]);
+            jacobianTranslation = residualByPointCamera;
+        }
+
+        if (jacobians[2]) {
+            Eigen::Map<Eigen::Matrix<double, 3, 4, Eigen::RowMajor>> jacobianOrientation(jacobians[2]);
+            jacobianOrientation = residualByPointCamera * AnalyticJacobians::getRotatedPointByOrientation(orientation,
+                                                                                                          point);
+        }
+
+        return true;
+    }
+
+    ceres::CostFunction *ReprojectionDepthResidual::Create(double observedX,
+                                                           double observedY,
+                                                           double observedDepth,
+                                                           const CameraRGBD &camera,
+                                                           double deviationReprojection,
+                                                           double deviationDepth) {
+        return new ReprojectionDepthResidual(observedX, observedY, observedDepth,
+                                             camera,
+                                             deviationReprojection, deviationDepth);
+    }
+}
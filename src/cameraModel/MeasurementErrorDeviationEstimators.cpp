@@ -11,7 +11,8 @@ namespace gdr {
             const std::function<double(double, double)> &dividerReprojectionErrorEstimator,
             const std::function<double(double, double)> &dividerDepthErrorEstimator) :
             dividerReprojectionError(dividerReprojectionErrorEstimator),
-            dividerDepthError(dividerDepthErrorEstimator) {}
+            dividerDepthError(dividerDepthErrorEstimator),
+            defaultNoiseModels(false) {}
 
     const std::function<double(double, double)> &
     MeasurementErrorDeviationEstimators::getDividerDepthErrorEstimator() const {
@@ -38,4 +39,8 @@ namespace gdr {
     double MeasurementErrorDeviationEstimators::getParameterNoiseModelDepth() const {
         return defaultQuadraticParameterNoiseModelDepth;
     }
+
+    bool MeasurementErrorDeviationEstimators::hasDefaultNoiseModels() const {
+        return defaultNoiseModels;
+    }
 }
\ No newline at end of file
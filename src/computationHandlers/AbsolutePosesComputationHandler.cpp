@@ -3,15 +3,24 @@
 // Licensed under the MIT license. See LICENSE file in the project root for details.
 //
 
+#include <map>
+#include <set>
+
 #include <boost/filesystem.hpp>
 #include "absolutePoseEstimation/rotationAveraging/RotationAverager.h"
 #include "absolutePoseEstimation/rotationAveraging/RotationRobustOptimizerCreator.h"
 #include "absolutePoseEstimation/translationAveraging/TranslationMeasurement.h"
 #include "absolutePoseEstimation/rotationAveraging/RotationMeasurement.h"
 #include "absolutePoseEstimation/translationAveraging/TranslationAverager.h"
+#include "absolutePoseEstimation/hierarchicalAveraging/HierarchicalAverager.h"
+#include "absolutePoseEstimation/hierarchicalAveraging/PoseGraphPartitioner.h"
+#include "absolutePoseEstimation/poseGraphOptimization/PoseGraphOptimizer.h"
+
+#include "poseGraph/graphAlgorithms/CycleConsistencyFilter.h"
 
 #include "bundleAdjustment/BundleAdjuster.h"
 #include "bundleAdjustment/BundleAdjusterCreator.h"
+#include "bundleAdjustment/LandmarkSelector.h"
 
 #include "sparsePointCloud/CloudProjectorCreator.h"
 #include "sparsePointCloud/PointClassifierCreator.h"
@@ -96,6 +105,17 @@ namespace gdr {
 
         std::vector<RotationMeasurement> relativeRotationsToReturn;
 
+        // measurement weight is based on the number of inlier keypoint matches between images
+        std::map<std::pair<int, int>, int> numberOfInliersByPosePair;
+
+        for (const auto &inlierMatch: connectedComponent->getInlierObservedPoints()) {
+            int poseIndexFirst = inlierMatch.first.first.first;
+            int poseIndexSecond = inlierMatch.second.first.first;
+
+            ++numberOfInliersByPosePair[std::make_pair(std::min(poseIndexFirst, poseIndexSecond),
+                                                       std::max(poseIndexFirst, poseIndexSecond))];
+        }
+
         for (int indexFromDest = 0; indexFromDest < getPoseGraph().size(); ++indexFromDest) {
             for (const auto &relativePose: getPoseGraph().getRelativePosesFrom(indexFromDest)) {
 
@@ -103,8 +123,14 @@ namespace gdr {
 
                 assert(indexFromDest == relativePose.getIndexFrom());
 
+                auto foundInliers = numberOfInliersByPosePair.find(
+                        std::make_pair(std::min(indexFromDest, indexToToBeTransformed),
+                                       std::max(indexFromDest, indexToToBeTransformed)));
+                int numberOfInliers = (foundInliers == numberOfInliersByPosePair.end()) ? 0 : foundInliers->second;
+
                 relativeRotationsToReturn.emplace_back(RotationMeasurement(
-                        relativePose.getRelativeRotation(), indexFromDest, indexToToBeTransformed
+                        relativePose.getRelativeRotation(), indexFromDest, indexToToBeTransformed,
+                        1.0 + numberOfInliers
                 ));
             }
         }
@@ -112,13 +138,61 @@ namespace gdr {
         return relativeRotationsToReturn;
     }
 
+    int AbsolutePosesComputationHandler::filterInconsistentRelativePoses() {
+
+        std::vector<std::pair<int, int>> edges;
+        std::vector<SE3> relativePoses;
+
+        for (int indexFrom = 0; indexFrom < getNumberOfPoses(); ++indexFrom) {
+            for (const auto &knownRelativePose: connectedComponent->getConnectionsFromVertex(indexFrom)) {
+                assert(indexFrom == knownRelativePose.getIndexFrom());
+
+                if (knownRelativePose.getIndexFrom() < knownRelativePose.getIndexTo()) {
+                    edges.emplace_back(std::make_pair(knownRelativePose.getIndexFrom(),
+                                                      knownRelativePose.getIndexTo()));
+                    relativePoses.emplace_back(knownRelativePose.getRelativePose());
+                }
+            }
+        }
+
+        timeStartEdgeFiltering = timerGetClockTimeNow();
+
+        std::vector<int> edgesToRemove = CycleConsistencyFilter::getInconsistentEdges(getNumberOfPoses(),
+                                                                                      edges,
+                                                                                      relativePoses);
+        std::set<std::pair<int, int>> posePairsToRemove;
+        for (int edgeIndex: edgesToRemove) {
+            posePairsToRemove.insert(edges[edgeIndex]);
+        }
+        connectedComponent->removeRelativePoses(posePairsToRemove);
+
+        timeEndEdgeFiltering = timerGetClockTimeNow();
+
+        numberOfEdgesBeforeFiltering = static_cast<int>(edges.size());
+        numberOfEdgesRemovedByFiltering = static_cast<int>(edgesToRemove.size());
+
+        return numberOfEdgesRemovedByFiltering;
+    }
+
     std::vector<SO3> AbsolutePosesComputationHandler::performRotationAveraging() {
 
         timeStartRotationAveraging = timerGetClockTimeNow();
-        std::vector<SO3> absoluteRotations = RotationAverager::shanonAveraging(
-                getRelativeRotationsVector(),
-                getIndexFixedPose(),
-                getPathRelativePoseFile());
+        std::vector<SO3> absoluteRotations;
+
+        if (useHierarchicalAveraging()) {
+            absoluteRotations = HierarchicalAverager::averageRotations(
+                    getRelativeRotationsVector(),
+                    getIndexFixedPose(),
+                    getClusterByPose(),
+                    rotationAveragingType);
+        } else {
+            absoluteRotations = RotationAverager::averageRotations(
+                    getRelativeRotationsVector(),
+                    getIndexFixedPose(),
+                    rotationAveragingType,
+                    getPathRelativePoseFile(),
+                    numberOfShonanStarts);
+        }
 
         for (int i = 0; i < getNumberOfPoses(); ++i) {
             connectedComponent->setRotation(i, SO3(absoluteRotations[i].getRotationSophus()));
@@ -158,8 +232,7 @@ namespace gdr {
 
         timeStartRobustRotationOptimization = timerGetClockTimeNow();
         std::unique_ptr<RotationRobustOptimizer> rotationOptimizer =
-                RotationRobustOptimizerCreator::getRefiner(
-                        RotationRobustOptimizerCreator::RobustParameterType::DEFAULT);
+                RotationRobustOptimizerCreator::getRefiner(rotationRobustOptimizerType);
 
         std::vector<SO3> optimizedPosesRobust =
                 rotationOptimizer->getOptimizedOrientation(shonanOptimizedAbsolutePoses,
@@ -191,13 +264,32 @@ namespace gdr {
                     relativeTranslations.emplace_back(
                             TranslationMeasurement(knownRelativePose.getRelativeTranslation(),
                                                    knownRelativePose.getIndexFrom(),
-                                                   knownRelativePose.getIndexTo()));
+                                                   knownRelativePose.getIndexTo(),
+                                                   knownRelativePose.getQuality()));
                 }
             }
         }
 
         timeStartTranslationAveraging = timerGetClockTimeNow();
 
+        if (useHierarchicalAveraging()) {
+            std::vector<Eigen::Vector3d> hierarchicalTranslations = HierarchicalAverager::averageTranslations(
+                    relativeTranslations,
+                    absolutePoses,
+                    indexFixedToZero,
+                    getClusterByPose());
+
+            timeEndTranslationAveraging = timerGetClockTimeNow();
+
+            assert(getNumberOfPoses() == hierarchicalTranslations.size());
+
+            for (int i = 0; i < getNumberOfPoses(); ++i) {
+                connectedComponent->setTranslation(i, hierarchicalTranslations[i]);
+            }
+
+            return hierarchicalTranslations;
+        }
+
         std::vector<Eigen::Vector3d> optimizedAbsoluteTranslationsIRLS = TranslationAverager::recoverTranslations(
                 relativeTranslations,
                 absolutePoses,
@@ -228,6 +320,49 @@ namespace gdr {
         return optimizedAbsoluteTranslationsIRLS;
     }
 
+    std::vector<SE3> AbsolutePosesComputationHandler::performPoseGraphOptimization(bool updatePoses) {
+
+        std::vector<RelativeSE3> relativePoses;
+        std::vector<SE3> absolutePoses = connectedComponent->getPoses();
+        int indexFixed = connectedComponent->getPoseIndexWithMaxConnectivity();
+
+        for (int indexFrom = 0; indexFrom < getNumberOfPoses(); ++indexFrom) {
+            for (const auto &knownRelativePose: connectedComponent->getConnectionsFromVertex(indexFrom)) {
+                assert(indexFrom == knownRelativePose.getIndexFrom());
+
+                if (knownRelativePose.getIndexFrom() < knownRelativePose.getIndexTo()) {
+                    relativePoses.emplace_back(knownRelativePose);
+                }
+            }
+        }
+
+        timeStartPoseGraphOptimization = timerGetClockTimeNow();
+
+        PoseGraphOptimizer poseGraphOptimizer;
+        bool successPoseGraphOptimization = true;
+        std::vector<SE3> posesOptimized = poseGraphOptimizer.getOptimizedPoses(absolutePoses,
+                                                                               relativePoses,
+                                                                               indexFixed,
+                                                                               successPoseGraphOptimization);
+
+        timeEndPoseGraphOptimization = timerGetClockTimeNow();
+        poseGraphOptimizationSolverInfo = poseGraphOptimizer.getSolverInfo();
+
+        assert(posesOptimized.size() == getNumberOfPoses());
+
+        if (!successPoseGraphOptimization) {
+            return absolutePoses;
+        }
+
+        if (updatePoses) {
+            for (int i = 0; i < getNumberOfPoses(); ++i) {
+                connectedComponent->setPoseSE3(i, posesOptimized[i]);
+            }
+        }
+
+        return posesOptimized;
+    }
+
     std::vector<SE3> AbsolutePosesComputationHandler::performBundleAdjustmentUsingDepth() {
         int maxNumberOfPointsToShow = -1;
         computePointClasses();
@@ -256,17 +391,86 @@ namespace gdr {
 
         timeStartBundleAdjustment = timerGetClockTimeNow();
 
+        std::vector<std::unordered_map<int, KeyPointInfo>> keyPointInfoByPose =
+                cloudProjector->getKeyPointInfoByPoseNumberAndPointClass();
+        std::vector<Point3d> pointsToOptimize = observedPoints;
+        std::vector<std::unordered_map<int, KeyPointInfo>> keyPointInfoToOptimize = keyPointInfoByPose;
+        std::vector<int> selectedLandmarks;
+
+        numberOfLandmarksBeforeSelection = static_cast<int>(observedPoints.size());
+        numberOfLandmarksSelected = numberOfLandmarksBeforeSelection;
+
+        if (maxLandmarksPerPoseBundleAdjustment > 0) {
+            selectedLandmarks = LandmarkSelector::selectLandmarks(keyPointInfoByPose,
+                                                                  static_cast<int>(observedPoints.size()),
+                                                                  maxLandmarksPerPoseBundleAdjustment);
+            numberOfLandmarksSelected = static_cast<int>(selectedLandmarks.size());
+
+            pointsToOptimize.clear();
+            for (int selectedIndex = 0; selectedIndex < selectedLandmarks.size(); ++selectedIndex) {
+                pointsToOptimize.emplace_back(Point3d(
+                        observedPoints[selectedLandmarks[selectedIndex]].getEigenVector3dPointXYZ(),
+                        selectedIndex));
+            }
+            keyPointInfoToOptimize = LandmarkSelector::getKeyPointInfoOfSelectedLandmarks(keyPointInfoByPose,
+                                                                                          selectedLandmarks);
+        }
+
         std::unique_ptr<BundleAdjuster> bundleAdjuster =
-                BundleAdjusterCreator::getBundleAdjuster(BundleAdjusterCreator::BundleAdjustmentType::USE_DEPTH_INFO);
+                BundleAdjusterCreator::getBundleAdjuster(bundleAdjustmentType,
+                                                         maxPosesPerClusterBundleAdjustment,
+                                                         maxRoundsOutlierRejectionBundleAdjustment,
+                                                         &connectedComponent->getInlierObservedPoints());
 
         bool isUsableBA = true;
-        std::vector<SE3> posesOptimized = bundleAdjuster->optimizePointsAndPoses(observedPoints,
+        std::vector<SE3> posesOptimized = bundleAdjuster->optimizePointsAndPoses(pointsToOptimize,
                                                                                  posesAndCameraParams,
-                                                                                 cloudProjector->getKeyPointInfoByPoseNumberAndPointClass(),
+                                                                                 keyPointInfoToOptimize,
                                                                                  indexFixedToZero,
                                                                                  isUsableBA);
 
+        if (!isUsableBA) {
+            timeEndBundleAdjustment = timerGetClockTimeNow();
+            bundleAdjustmentSolverInfo = bundleAdjuster->getSolverInfo() + ", solution is not usable";
+
+            return connectedComponent->getPoses();
+        }
+
+        std::vector<Point3d> pointsOptimized = bundleAdjuster->getOptimizedPoints();
+
+        if (maxLandmarksPerPoseBundleAdjustment > 0) {
+            assert(pointsOptimized.size() == selectedLandmarks.size());
+
+            std::vector<Point3d> pointsOptimizedAll = observedPoints;
+            std::vector<int> unselectedLandmarks;
+
+            for (int pointIndex = 0, selectedIndex = 0; pointIndex < pointsOptimizedAll.size(); ++pointIndex) {
+                if (selectedIndex < selectedLandmarks.size() && selectedLandmarks[selectedIndex] == pointIndex) {
+                    pointsOptimizedAll[pointIndex].setEigenVector3dPointXYZ(
+                            pointsOptimized[selectedIndex].getEigenVector3dPointXYZ());
+                    ++selectedIndex;
+                } else {
+                    unselectedLandmarks.emplace_back(pointIndex);
+                }
+            }
+
+            if (retriangulateUnselectedLandmarks) {
+                std::vector<std::pair<SE3, CameraRGBD>> posesOptimizedAndCameraParams;
+                for (int i = 0; i < posesOptimized.size(); ++i) {
+                    posesOptimizedAndCameraParams.emplace_back(std::make_pair(posesOptimized[i],
+                                                                              posesAndCameraParams[i].second));
+                }
+                LandmarkSelector::retriangulateLandmarks(pointsOptimizedAll,
+                                                         unselectedLandmarks,
+                                                         posesOptimizedAndCameraParams,
+                                                         keyPointInfoByPose);
+            }
+
+            pointsOptimized = pointsOptimizedAll;
+        }
+
         timeEndBundleAdjustment = timerGetClockTimeNow();
+        bundleAdjustmentSolverInfo = bundleAdjuster->getSolverInfo();
 
         assert(posesOptimized.size() == getNumberOfPoses());
 
@@ -277,7 +481,7 @@ namespace gdr {
         std::vector<double> errorsAfter;
 
         cloudProjector->setPoses(connectedComponent->getPoses());
-        cloudProjector->setPoints(bundleAdjuster->getOptimizedPoints());
+        cloudProjector->setPoints(pointsOptimized);
 
         if (saveDebugImages) {
             auto shownResidualsAfter = cloudProjector->showPointsReprojectionError(observedPoints,
@@ -410,26 +614,110 @@ namespace gdr {
         pathRelativePosesFile = pathRelPoses;
     }
 
+    void AbsolutePosesComputationHandler::setRotationAveragingType(
+            const RotationAverager::RotationAveragingType &rotationAveragingTypeToSet) {
+        rotationAveragingType = rotationAveragingTypeToSet;
+    }
+
+    void AbsolutePosesComputationHandler::setNumberOfShonanStarts(int numberOfShonanStartsToSet) {
+        assert(numberOfShonanStartsToSet > 0);
+        numberOfShonanStarts = numberOfShonanStartsToSet;
+    }
+
+    void AbsolutePosesComputationHandler::setHierarchicalAveraging(int maxPosesPerClusterToSet) {
+        assert(maxPosesPerClusterToSet >= 0);
+        maxPosesPerClusterHierarchical = maxPosesPerClusterToSet;
+    }
+
+    void AbsolutePosesComputationHandler::setPartitionedBundleAdjustment(int maxPosesPerClusterToSet) {
+        assert(maxPosesPerClusterToSet >= 0);
+        maxPosesPerClusterBundleAdjustment = maxPosesPerClusterToSet;
+    }
+
+    void AbsolutePosesComputationHandler::setBundleAdjustmentOutlierRejection(int maxRoundsToSet) {
+        assert(maxRoundsToSet > 0);
+        maxRoundsOutlierRejectionBundleAdjustment = maxRoundsToSet;
+    }
+
+    void AbsolutePosesComputationHandler::setBundleAdjustmentType(
+            const BundleAdjusterCreator::BundleAdjustmentType &bundleAdjustmentTypeToSet) {
+        bundleAdjustmentType = bundleAdjustmentTypeToSet;
+    }
+
+    void AbsolutePosesComputationHandler::setLandmarkSelection(int maxLandmarksPerPoseToSet,
+                                                               bool retriangulateUnselectedToSet) {
+        assert(maxLandmarksPerPoseToSet >= 0);
+        maxLandmarksPerPoseBundleAdjustment = maxLandmarksPerPoseToSet;
+        retriangulateUnselectedLandmarks = retriangulateUnselectedToSet;
+    }
+
+    bool AbsolutePosesComputationHandler::useHierarchicalAveraging() const {
+        return maxPosesPerClusterHierarchical > 0 && getNumberOfPoses() > maxPosesPerClusterHierarchical;
+    }
+
+    std::vector<int> AbsolutePosesComputationHandler::getClusterByPose() const {
+
+        std::vector<std::pair<int, int>> edges;
+        std::vector<int> edgeWeights;
+
+        for (const auto &relativeRotation: getRelativeRotationsVector()) {
+            edges.emplace_back(std::make_pair(relativeRotation.getIndexFromDestination(),
+                                              relativeRotation.getIndexToToBeTransformed()));
+            edgeWeights.emplace_back(static_cast<int>(relativeRotation.getWeight()));
+        }
+
+        return PoseGraphPartitioner::partition(getNumberOfPoses(),
+                                               edges,
+                                               edgeWeights,
+                                               maxPosesPerClusterHierarchical);
+    }
+
+    void AbsolutePosesComputationHandler::setRotationRobustOptimizerType(
+            const RotationRobustOptimizerCreator::RobustParameterType &rotationRobustOptimizerTypeToSet) {
+        rotationRobustOptimizerType = rotationRobustOptimizerTypeToSet;
+    }
+
     std::string AbsolutePosesComputationHandler::getPathRelativePoseFile() const {
         return pathRelativePosesFile;
     }
 
     std::stringstream AbsolutePosesComputationHandler::printTimeBenchmarkInfo() const {
+        std::chrono::duration<double> timeEdgeFiltering = std::chrono::duration_cast<std::chrono::duration<double>>(
+                timeEndEdgeFiltering - timeStartEdgeFiltering);
         std::chrono::duration<double> timeRotationAveraging = std::chrono::duration_cast<std::chrono::duration<double>>(
                 timeEndRotationAveraging - timeStartRotationAveraging);
         std::chrono::duration<double> timeRotationRobust = std::chrono::duration_cast<std::chrono::duration<double>>(
                 timeEndRobustRotationOptimization - timeStartRobustRotationOptimization);
         std::chrono::duration<double> timeTranslationAveraging = std::chrono::duration_cast<std::chrono::duration<double>>(
                 timeEndTranslationAveraging - timeStartTranslationAveraging);
+        std::chrono::duration<double> timePoseGraphOptimization = std::chrono::duration_cast<std::chrono::duration<double>>(
+                timeEndPoseGraphOptimization - timeStartPoseGraphOptimization);
         std::chrono::duration<double> timeBundleAdjustment = std::chrono::duration_cast<std::chrono::duration<double>>(
                 timeEndBundleAdjustment - timeStartBundleAdjustment);
 
         std::stringstream benchmarkTimeInfo;
 
+        if (numberOfEdgesBeforeFiltering > 0) {
+            benchmarkTimeInfo << "          Edge Filtering: " << timeEdgeFiltering.count()
+                              << " (removed " << numberOfEdgesRemovedByFiltering << " of "
+                              << numberOfEdgesBeforeFiltering << " edges)" << std::endl;
+        }
         benchmarkTimeInfo << "          Rotation Averaging: " << timeRotationAveraging.count() << std::endl;
         benchmarkTimeInfo << "          Robust Rotation Optimization: " << timeRotationRobust.count() << std::endl;
         benchmarkTimeInfo << "          Translation Averaging: " << timeTranslationAveraging.count() << std::endl;
-        benchmarkTimeInfo << "          Bundle Adjustment: " << timeBundleAdjustment.count() << std::endl;
+        if (!poseGraphOptimizationSolverInfo.empty()) {
+            benchmarkTimeInfo << "          Pose Graph Optimization: " << timePoseGraphOptimization.count()
+                              << " (" << poseGraphOptimizationSolverInfo << ")" << std::endl;
+        }
+        benchmarkTimeInfo << "          Bundle Adjustment: " << timeBundleAdjustment.count();
+        if (!bundleAdjustmentSolverInfo.empty()) {
+            benchmarkTimeInfo << " (" << bundleAdjustmentSolverInfo << ")";
+        }
+        if (numberOfLandmarksSelected < numberOfLandmarksBeforeSelection) {
+            benchmarkTimeInfo << " (landmarks " << numberOfLandmarksSelected << " of "
+                              << numberOfLandmarksBeforeSelection << ")";
+        }
+        benchmarkTimeInfo << std::endl;
 
         return benchmarkTimeInfo;
     }
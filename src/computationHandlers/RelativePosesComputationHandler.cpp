@@ -3,6 +3,7 @@
 // Licensed under the MIT license. See LICENSE file in the project root for details.
 //
 
+#include <cmath>
 #include <mutex>
 #include "boost/filesystem.hpp"
 
@@ -17,6 +18,7 @@
 #include "keyPointDetectionAndMatching/FeatureDetectorMatcherCreator.h"
 #include "relativePoseEstimators/EstimatorRelativePoseRobustCreator.h"
 #include "relativePoseRefinement/RefinerRelativePoseCreator.h"
+#include "imageCache/DecodedImageCache.h"
 
 #include "computationHandlers/RelativePosesComputationHandler.h"
 #include "computationHandlers/TimerClockNow.h"
@@ -210,9 +212,11 @@ namespace gdr {
                                                            frameFromDestination.getIndex());
                                                     bool success = true;
                                                     KeyPointMatches inlierKeyPointMatches;
+                                                    RelativePoseQuality relativePoseQuality;
                                                     auto cameraMotion = getTransformationRtMatrixTwoImages(i,
                                                                                                            j,
                                                                                                            inlierKeyPointMatches,
+                                                                                                           relativePoseQuality,
                                                                                                            success);
 
                                                     if (success) {
@@ -227,13 +231,15 @@ namespace gdr {
                                                                 std::move(RelativeSE3(
                                                                         frameFromDestination.getIndex(),
                                                                         frameToToBeTransformed.getIndex(),
-                                                                        cameraMotion
+                                                                        cameraMotion,
+                                                                        relativePoseQuality
                                                                 )));
                                                         transformationMatricesConcurrent[frameToToBeTransformed.getIndex()].emplace_back(
                                                                 std::move(RelativeSE3(
                                                                         frameToToBeTransformed.getIndex(),
                                                                         frameFromDestination.getIndex(),
-                                                                        cameraMotion.inverse())));
+                                                                        cameraMotion.inverse(),
+                                                                        relativePoseQuality)));
                                                     }
                                                 });
                           });
@@ -267,6 +273,7 @@ namespace gdr {
             int vertexFromDestDestination,
             int vertexInListToBeTransformedCanBeComputed,
             KeyPointMatches &keyPointMatches,
+            RelativePoseQuality &relativePoseQuality,
             bool &success,
             bool showMatchesOnImages) const {
 
@@ -352,36 +359,73 @@ namespace gdr {
             assert(inliersAgain.size() >= paramsRansac.getInlierNumber());
         }
 
+        std::vector<double> inlierErrorsLoRansac;
         auto inlierMatchesCorrespondingKeypointsLoRansac = findInlierPointCorrespondences(vertexFromDestDestination,
                                                                                           vertexInListToBeTransformedCanBeComputed,
-                                                                                          relativePoseLoRANSAC);
+                                                                                          relativePoseLoRANSAC,
+                                                                                          inlierErrorsLoRansac);
         assert(inliersAgain.size() == inlierMatchesCorrespondingKeypointsLoRansac.size());
         assert(inliersAgain.size() >= inlierCoeff * toBeTransformedPoints.cols());
 
         bool successRefine = true;
         SE3 refinedByICPRelativePose = relativePoseLoRANSAC;
-        refineRelativePose(vertices[vertexToBeTransformed],
-                           vertices[vertexFromDestDestination],
-                           keyPointMatches,
-                           refinedByICPRelativePose,
-                           successRefine);
+        int refinementStatus = refineRelativePose(vertices[vertexToBeTransformed],
+                                                  vertices[vertexFromDestDestination],
+                                                  keyPointMatches,
+                                                  refinedByICPRelativePose,
+                                                  successRefine);
+
+        if (refinementStatus != 0) {
+            // refiner did not converge and its estimate may be partially updated -- keep LoRANSAC result
+            refinedByICPRelativePose = relativePoseLoRANSAC;
+        }
 
+        std::vector<double> inlierErrorsAfterRefinement;
         auto inlierMatchesCorrespondingKeypointsAfterRefinement =
                 findInlierPointCorrespondences(vertexFromDestDestination,
                                                vertexInListToBeTransformedCanBeComputed,
-                                               refinedByICPRelativePose);
+                                               refinedByICPRelativePose,
+                                               inlierErrorsAfterRefinement);
 
         int ransacInliers = inliersAgain.size();
         int ICPinliers = inlierMatchesCorrespondingKeypointsAfterRefinement.size();
 
+        bool refinedByICP = false;
+
+        {
+            std::unique_lock<std::mutex> lockTime(timeMutex);
+
+            if (refinementStatus == 0) {
+                ++numberOfRefinementsConverged;
+            } else {
+                ++numberOfRefinementsNotConverged;
+            }
+
+            if (refinementStatus != 0 || ransacInliers > ICPinliers) {
+                ++numberOfPairsKeptLoRANSAC;
+            }
+        }
+
         if (ransacInliers > ICPinliers) {
             // ICP did not refine the relative pose -- return umeyama result
             cR_t_umeyama = relativePoseLoRANSAC;
         } else {
             cR_t_umeyama = refinedByICPRelativePose;
+            refinedByICP = successRefine;
             std::swap(inlierMatchesCorrespondingKeypointsAfterRefinement, inlierMatchesCorrespondingKeypointsLoRansac);
+            std::swap(inlierErrorsAfterRefinement, inlierErrorsLoRansac);
         }
 
+        double sumSquaredInlierErrors = 0;
+        for (double inlierError: inlierErrorsLoRansac) {
+            sumSquaredInlierErrors += inlierError * inlierError;
+        }
+        int numberOfInliers = static_cast<int>(inlierErrorsLoRansac.size());
+        relativePoseQuality = RelativePoseQuality(
+                numberOfInliers,
+                (numberOfInliers > 0) ? std::sqrt(sumSquaredInlierErrors / numberOfInliers) : 0.0,
+                refinedByICP);
+
 
         std::vector<std::pair<int, int>> matchesForVisualization;
         std::swap(keyPointMatches, inlierMatchesCorrespondingKeypointsLoRansac);
@@ -420,7 +464,8 @@ namespace gdr {
     KeyPointMatches
     RelativePosesComputationHandler::findInlierPointCorrespondences(int vertexFrom,
                                                                     int vertexInList,
-                                                                    const SE3 &transformation) const {
+                                                                    const SE3 &transformation,
+                                                                    std::vector<double> &inlierErrors) const {
 
         std::vector<std::pair<keyPointImageAndLocalPointIndexAndKeyPointInfo,
                 keyPointImageAndLocalPointIndexAndKeyPointInfo>> correspondencesBetweenTwoImages;
@@ -497,10 +542,14 @@ namespace gdr {
         assert(inlierCorrespondences.empty());
         assert(correspondencesBetweenTwoImages.size() == transformedPoints.cols());
 
+        inlierErrors.clear();
+        inlierErrors.reserve(reprojectionInlierErrors.size());
+
         for (const auto &inlierErrorAndIndex: reprojectionInlierErrors) {
             int inlierNumber = inlierErrorAndIndex.second;
             assert(inlierNumber >= 0 && inlierNumber < correspondencesBetweenTwoImages.size());
             inlierCorrespondences.emplace_back(correspondencesBetweenTwoImages[inlierNumber]);
+            inlierErrors.emplace_back(inlierErrorAndIndex.first);
         }
 
         assert(reprojectionInlierErrors.size() == inlierCorrespondences.size());
@@ -514,15 +563,15 @@ namespace gdr {
                                                             SE3 &initEstimationRelPos,
                                                             bool &refinementSuccess) const {
 
-        MatchableInfo poseToBeTransformed(vertexToBeTransformed.getPathRGBImage(),
-                                          vertexToBeTransformed.getPathDImage(),
-                                          vertexToBeTransformed.getKeyPoints2D(),
-                                          vertexToBeTransformed.getCamera());
+        MatchableInfo poseToBeTransformed(vertexToBeTransformed);
+        MatchableInfo poseDestination(vertexDestination);
 
-        MatchableInfo poseDestination(vertexDestination.getPathRGBImage(),
-                                      vertexDestination.getPathDImage(),
-                                      vertexDestination.getKeyPoints2D(),
-                                      vertexDestination.getCamera());
+        // images of the pair are not evicted by other threads while the refiner reads them
+        auto &decodedImageCache = DecodedImageCache::getInstance();
+        for (const auto &vertex: {&vertexToBeTransformed, &vertexDestination}) {
+            decodedImageCache.pin(vertex->getPathRGBImage(), DecodedImageCache::ImageType::COLOR);
+            decodedImageCache.pin(vertex->getPathDImage(), DecodedImageCache::ImageType::DEPTH);
+        }
 
         double durationICP = 0.0;
         refinementSuccess = relativePoseRefiner->refineRelativePose(poseToBeTransformed,
@@ -532,14 +581,17 @@ namespace gdr {
                                                                     durationICP,
                                                                     deviceCudaICP);
 
+        for (const auto &vertex: {&vertexToBeTransformed, &vertexDestination}) {
+            decodedImageCache.unpin(vertex->getPathRGBImage(), DecodedImageCache::ImageType::COLOR);
+            decodedImageCache.unpin(vertex->getPathDImage(), DecodedImageCache::ImageType::DEPTH);
+        }
+
         {
             std::unique_lock<std::mutex> lockTime(timeMutex);
             timeCountSecondsTotalICP += durationICP;
         }
 
-        assert(refinementSuccess);
-
-        return 0;
+        return refinementSuccess ? 0 : 1;
     }
 
     std::vector<std::vector<int>>
@@ -582,6 +634,10 @@ namespace gdr {
         deviceCudaICP = deviceCudaIcpToSet;
     }
 
+    void RelativePosesComputationHandler::setRefinerType(const RefinerRelativePoseCreator::RefinerType &refinerType) {
+        relativePoseRefiner = RefinerRelativePoseCreator::getRefiner(refinerType);
+    }
+
 
     std::stringstream RelativePosesComputationHandler::getTimeBenchmarkInfo() const {
 
@@ -602,6 +658,10 @@ namespace gdr {
         resultTimeInfo << "              umeyama: " << timeRelativePoseICP.count() - timeCountSecondsTotalICP
                        << std::endl;
         resultTimeInfo << "              ICP: " << timeCountSecondsTotalICP << std::endl;
+        resultTimeInfo << "          refinement converged: " << numberOfRefinementsConverged
+                       << ", not converged: " << numberOfRefinementsNotConverged
+                       << ", LoRANSAC poses kept: " << numberOfPairsKeptLoRANSAC << std::endl;
+        resultTimeInfo << DecodedImageCache::getInstance().getStatistics();
 
         return resultTimeInfo;
     }
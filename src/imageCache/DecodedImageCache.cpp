@@ -0,0 +1,260 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#include <algorithm>
+#include <cassert>
+
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "imageCache/DecodedImageCache.h"
+
+#include "computationHandlers/TimerClockNow.h"
+
+namespace gdr {
+
+    std::ostream &operator<<(std::ostream &os, const DecodedImageCacheStatistics &statistics) {
+        os << "          decoded image cache: hits " << statistics.hits
+           << ", misses " << statistics.misses
+           << ", evictions " << statistics.evictions << std::endl;
+        os << "              decoding: " << statistics.secondsDecoding << std::endl;
+        os << "              decoding saved: " << statistics.secondsDecodingSaved << std::endl;
+
+        return os;
+    }
+
+    DecodedImageCache &DecodedImageCache::getInstance() {
+        static DecodedImageCache decodedImageCache;
+
+        return decodedImageCache;
+    }
+
+    std::string DecodedImageCache::getKey(const std::string &pathToImage, const ImageType &imageType) {
+        ImageType imageTypeDecoded = (imageType == ImageType::DEPTH) ? ImageType::DEPTH : ImageType::COLOR;
+
+        return std::to_string(static_cast<int>(imageTypeDecoded)) + ":" + pathToImage;
+    }
+
+    cv::Mat DecodedImageCache::decodeImage(
+            const std::string &pathToImage,
+            const ImageType &imageType,
+            const std::vector<std::shared_ptr<const PackedDatasetReader>> &packedDatasetsToSearch) {
+
+        for (const auto &packedDataset: packedDatasetsToSearch) {
+            bool isDepth = false;
+            int frameIndex = -1;
+
+            if (!packedDataset->findFrameByPath(pathToImage, isDepth, frameIndex)) {
+                continue;
+            }
+
+            if (imageType == ImageType::DEPTH) {
+                return packedDataset->getImageDepth(frameIndex);
+            }
+
+            assert(imageType == ImageType::COLOR);
+            return packedDataset->getImageRGB(frameIndex);
+        }
+
+        if (imageType == ImageType::DEPTH) {
+            return cv::imread(pathToImage, cv::IMREAD_ANYDEPTH);
+        }
+
+        assert(imageType == ImageType::COLOR);
+        return cv::imread(pathToImage, cv::IMREAD_COLOR);
+    }
+
+    cv::Mat DecodedImageCache::getImage(const std::string &pathToImage, const ImageType &imageType) {
+
+        if (imageType != ImageType::GRAYSCALE) {
+            return getImageDecoded(pathToImage, imageType);
+        }
+
+        cv::Mat imageColor = getImageDecoded(pathToImage, ImageType::COLOR);
+
+        if (imageColor.empty()) {
+            return imageColor;
+        }
+
+        cv::Mat imageGrayscale;
+        cv::cvtColor(imageColor, imageGrayscale, cv::COLOR_BGR2GRAY);
+
+        return imageGrayscale;
+    }
+
+    cv::Mat DecodedImageCache::getImageDecoded(const std::string &pathToImage, const ImageType &imageType) {
+
+        assert(imageType != ImageType::GRAYSCALE);
+
+        std::string key = getKey(pathToImage, imageType);
+        std::promise<cv::Mat> promiseImageDecoded;
+        std::vector<std::shared_ptr<const PackedDatasetReader>> packedDatasetsToSearch;
+
+        {
+            std::unique_lock<std::mutex> lockCache(cacheMutex);
+            auto foundEntry = entriesByKey.find(key);
+
+            if (foundEntry != entriesByKey.end()) {
+                auto &entry = foundEntry->second;
+                keysRecentlyUsed.splice(keysRecentlyUsed.begin(), keysRecentlyUsed, entry.positionRecentlyUsed);
+                ++statistics.hits;
+
+                if (entry.isReady) {
+                    statistics.secondsDecodingSaved += entry.secondsDecoding;
+                    return entry.imageDecoded.get();
+                }
+
+                // image is being decoded by another thread
+                std::shared_future<cv::Mat> imageDecoded = entry.imageDecoded;
+                lockCache.unlock();
+                cv::Mat image = imageDecoded.get();
+                lockCache.lock();
+
+                auto foundEntryDecoded = entriesByKey.find(key);
+                if (foundEntryDecoded != entriesByKey.end()) {
+                    statistics.secondsDecodingSaved += foundEntryDecoded->second.secondsDecoding;
+                }
+
+                return image;
+            }
+
+            ++statistics.misses;
+            keysRecentlyUsed.push_front(key);
+            packedDatasetsToSearch = packedDatasets;
+
+            auto &entry = entriesByKey[key];
+            entry.imageDecoded = promiseImageDecoded.get_future().share();
+            entry.positionRecentlyUsed = keysRecentlyUsed.begin();
+        }
+
+        std::chrono::high_resolution_clock::time_point timeStartDecoding = timerGetClockTimeNow();
+        cv::Mat image = decodeImage(pathToImage, imageType, packedDatasetsToSearch);
+        std::chrono::high_resolution_clock::time_point timeEndDecoding = timerGetClockTimeNow();
+        double secondsDecoding = std::chrono::duration_cast<std::chrono::duration<double>>(
+                timeEndDecoding - timeStartDecoding).count();
+
+        promiseImageDecoded.set_value(image);
+
+        {
+            std::unique_lock<std::mutex> lockCache(cacheMutex);
+            auto foundEntry = entriesByKey.find(key);
+
+            // entries being decoded are never evicted
+            assert(foundEntry != entriesByKey.end());
+            auto &entry = foundEntry->second;
+            statistics.secondsDecoding += secondsDecoding;
+
+            // read failure may be transient: threads already waiting get empty image, later requests retry
+            if (image.empty()) {
+                keysRecentlyUsed.erase(entry.positionRecentlyUsed);
+                entriesByKey.erase(foundEntry);
+
+                return image;
+            }
+
+            entry.isReady = true;
+            entry.sizeBytes = image.total() * image.elemSize();
+            entry.secondsDecoding = secondsDecoding;
+
+            memoryUsedBytes += entry.sizeBytes;
+
+            evictIfNeeded();
+        }
+
+        return image;
+    }
+
+    void DecodedImageCache::evictIfNeeded() {
+
+        auto positionToCheck = keysRecentlyUsed.end();
+
+        while (memoryUsedBytes > memoryBudgetBytes && positionToCheck != keysRecentlyUsed.begin()) {
+            --positionToCheck;
+
+            auto foundEntry = entriesByKey.find(*positionToCheck);
+            assert(foundEntry != entriesByKey.end());
+            const auto &entry = foundEntry->second;
+
+            if (!entry.isReady || pinCountersByKey.count(*positionToCheck) > 0) {
+                continue;
+            }
+
+            assert(memoryUsedBytes >= entry.sizeBytes);
+            memoryUsedBytes -= entry.sizeBytes;
+            ++statistics.evictions;
+
+            entriesByKey.erase(foundEntry);
+            positionToCheck = keysRecentlyUsed.erase(positionToCheck);
+        }
+    }
+
+    void DecodedImageCache::pin(const std::string &pathToImage, const ImageType &imageType) {
+        std::unique_lock<std::mutex> lockCache(cacheMutex);
+        ++pinCountersByKey[getKey(pathToImage, imageType)];
+    }
+
+    void DecodedImageCache::unpin(const std::string &pathToImage, const ImageType &imageType) {
+        std::unique_lock<std::mutex> lockCache(cacheMutex);
+        auto foundPinCounter = pinCountersByKey.find(getKey(pathToImage, imageType));
+
+        assert(foundPinCounter != pinCountersByKey.end());
+        assert(foundPinCounter->second > 0);
+
+        if (--foundPinCounter->second == 0) {
+            pinCountersByKey.erase(foundPinCounter);
+            evictIfNeeded();
+        }
+    }
+
+    void DecodedImageCache::addPackedDataset(const std::shared_ptr<const PackedDatasetReader> &packedDataset) {
+        assert(packedDataset && packedDataset->isOpened());
+
+        std::unique_lock<std::mutex> lockCache(cacheMutex);
+        packedDatasets.emplace_back(packedDataset);
+    }
+
+    void DecodedImageCache::setMemoryBudgetBytes(size_t memoryBudgetBytesToSet) {
+        std::unique_lock<std::mutex> lockCache(cacheMutex);
+        memoryBudgetBytes = memoryBudgetBytesToSet;
+
+        evictIfNeeded();
+    }
+
+    size_t DecodedImageCache::getMemoryBudgetBytes() const {
+        std::unique_lock<std::mutex> lockCache(cacheMutex);
+        return memoryBudgetBytes;
+    }
+
+    size_t DecodedImageCache::getMemoryUsedBytes() const {
+        std::unique_lock<std::mutex> lockCache(cacheMutex);
+        return memoryUsedBytes;
+    }
+
+    DecodedImageCacheStatistics DecodedImageCache::getStatistics() const {
+        std::unique_lock<std::mutex> lockCache(cacheMutex);
+        return statistics;
+    }
+
+    void DecodedImageCache::clear() {
+        std::unique_lock<std::mutex> lockCache(cacheMutex);
+
+        for (auto position = keysRecentlyUsed.begin(); position != keysRecentlyUsed.end();) {
+            auto foundEntry = entriesByKey.find(*position);
+            assert(foundEntry != entriesByKey.end());
+            const auto &entry = foundEntry->second;
+
+            if (!entry.isReady || pinCountersByKey.count(*position) > 0) {
+                ++position;
+                continue;
+            }
+
+            memoryUsedBytes -= entry.sizeBytes;
+            entriesByKey.erase(foundEntry);
+            position = keysRecentlyUsed.erase(position);
+        }
+
+        statistics = DecodedImageCacheStatistics();
+    }
+}
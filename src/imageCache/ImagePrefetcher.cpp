@@ -0,0 +1,92 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#include <cassert>
+
+#include "imageCache/ImagePrefetcher.h"
+
+namespace gdr {
+
+    ImagePrefetcher::ImagePrefetcher(const std::vector<std::string> &pathsToImagesToSet,
+                                     const DecodedImageCache::ImageType &imageTypeToSet,
+                                     int numberOfThreadsIO,
+                                     int maxNumberOfImagesPrefetchedToSet) :
+            pathsToImages(pathsToImagesToSet),
+            imageType(imageTypeToSet),
+            maxNumberOfImagesPrefetched(maxNumberOfImagesPrefetchedToSet) {
+
+        assert(numberOfThreadsIO > 0);
+        assert(maxNumberOfImagesPrefetchedToSet > 0);
+
+        for (int i = 0; i < numberOfThreadsIO; ++i) {
+            threadsIO.emplace_back(&ImagePrefetcher::decodeImages, this);
+        }
+    }
+
+    void ImagePrefetcher::decodeImages() {
+
+        int numberOfImages = static_cast<int>(pathsToImages.size());
+
+        while (true) {
+            int imageIndex = nextImageToDecode.fetch_add(1);
+
+            if (imageIndex >= numberOfImages) {
+                break;
+            }
+
+            cv::Mat image = DecodedImageCache::getInstance().getImage(pathsToImages[imageIndex], imageType);
+
+            {
+                // blocks while the queue is full
+                std::unique_lock<std::mutex> lockQueue(queueMutex);
+                queueHasSpace.wait(lockQueue, [this]() {
+                    return stopRequested || imagesDecoded.size() < maxNumberOfImagesPrefetched;
+                });
+
+                if (stopRequested) {
+                    break;
+                }
+
+                imagesDecoded.emplace_back(imageIndex, image);
+            }
+            queueHasImage.notify_one();
+        }
+    }
+
+    bool ImagePrefetcher::getNextImage(cv::Mat &image, int &imageIndex) {
+
+        // each successful claim corresponds to exactly one pushed image
+        if (nextImageToConsume.fetch_add(1) >= static_cast<int>(pathsToImages.size())) {
+            return false;
+        }
+
+        {
+            std::unique_lock<std::mutex> lockQueue(queueMutex);
+            queueHasImage.wait(lockQueue, [this]() {
+                return !imagesDecoded.empty();
+            });
+
+            imageIndex = imagesDecoded.front().first;
+            image = imagesDecoded.front().second;
+            imagesDecoded.pop_front();
+        }
+        queueHasSpace.notify_one();
+
+        return true;
+    }
+
+    ImagePrefetcher::~ImagePrefetcher() {
+
+        {
+            std::unique_lock<std::mutex> lockQueue(queueMutex);
+            stopRequested = true;
+        }
+        queueHasSpace.notify_all();
+
+        for (auto &thread: threadsIO) {
+            thread.join();
+        }
+    }
+}
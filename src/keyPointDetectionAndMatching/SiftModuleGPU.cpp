@@ -3,14 +3,25 @@
 // Licensed under the MIT license. See LICENSE file in the project root for details.
 //
 
+#include <iostream>
 #include <thread>
 #include <mutex>
 
+#include <GL/gl.h>
+
 #include "keyPointDetectionAndMatching/KeyPointsAndDescriptors.h"
 #include "keyPointDetectionAndMatching/SiftModuleGPU.h"
 
 namespace gdr {
 
+    void SiftModuleGPU::setImagePrefetchingParameters(int numberOfThreads, int maxNumberOfImages) {
+        assert(numberOfThreads > 0);
+        assert(maxNumberOfImages > 0);
+
+        numberOfThreadsPrefetchingImages = numberOfThreads;
+        maxNumberOfImagesPrefetched = maxNumberOfImages;
+    }
+
     void SiftModuleGPU::siftParseParams(SiftGPU *sift, std::vector<char *> &siftGpuArgs) {
         sift->ParseParam(siftGpuArgs.size(), siftGpuArgs.data());
     }
@@ -50,10 +61,10 @@ namespace gdr {
         std::vector<std::pair<std::vector<SiftGPU::SiftKeypoint>, std::vector<float>>> keypointsAndDescriptorsAllImages(
                 pathsToImages.size());
 
-        tbb::concurrent_queue<std::pair<std::string, int>> pathsToImagesAndImageIndices;
-        for (int i = 0; i < keypointsAndDescriptorsAllImages.size(); ++i) {
-            pathsToImagesAndImageIndices.push({pathsToImages[i], i});
-        }
+        ImagePrefetcher imagePrefetcher(pathsToImages,
+                                        DecodedImageCache::ImageType::GRAYSCALE,
+                                        numberOfThreadsPrefetchingImages,
+                                        maxNumberOfImagesPrefetched);
 
         std::vector<std::thread> threads(numOfDevicesForDetection.size());
 
@@ -61,7 +72,7 @@ namespace gdr {
         for (int i = 0; i < numOfDevicesForDetection.size(); ++i) {
             threads[i] = std::thread(SiftModuleGPU::getKeypointsDescriptorsOneImage,
                                      detectorsSift[i].get(),
-                                     std::ref(pathsToImagesAndImageIndices),
+                                     std::ref(imagePrefetcher),
                                      std::ref(keypointsAndDescriptorsAllImages),
                                      std::ref(output),
                                      true);
@@ -76,17 +87,32 @@ namespace gdr {
 
     void
     SiftModuleGPU::getKeypointsDescriptorsOneImage(SiftGPU *detectorSift,
-                                                   tbb::concurrent_queue<std::pair<std::string, int>> &pathsToImagesAndImageIndices,
+                                                   ImagePrefetcher &imagePrefetcher,
                                                    std::vector<std::pair<std::vector<SiftGPU::SiftKeypoint>, std::vector<float>>> &keyPointsAndDescriptorsByIndex,
                                                    std::mutex &output,
                                                    bool normalizeRootL1) {
 
-        std::pair<std::string, int> pathToImageAndIndex;
+        cv::Mat imageGrayscale;
+        int imageIndex = -1;
 
-        while (pathsToImagesAndImageIndices.try_pop(pathToImageAndIndex)) {
-            const auto &pathToTheImage = pathToImageAndIndex.first;
+        while (imagePrefetcher.getNextImage(imageGrayscale, imageIndex)) {
+
+            assert(imageIndex >= 0 && imageIndex < keyPointsAndDescriptorsByIndex.size());
+
+            // frame without key points is kept so that indices of images do not change
+            if (imageGrayscale.empty() || imageGrayscale.type() != CV_8UC1) {
+                std::unique_lock<std::mutex> lockOutput(output);
+                std::cout << "could not read image " << imageIndex << ", no key points are detected" << std::endl;
+                keyPointsAndDescriptorsByIndex[imageIndex] = {};
+                continue;
+            }
+
+            if (!imageGrayscale.isContinuous()) {
+                imageGrayscale = imageGrayscale.clone();
+            }
 
-            detectorSift->RunSIFT(pathToTheImage.data());
+            detectorSift->RunSIFT(imageGrayscale.cols, imageGrayscale.rows, imageGrayscale.data,
+                                  GL_LUMINANCE, GL_UNSIGNED_BYTE);
             int num1 = detectorSift->GetFeatureNum();
             std::vector<float> descriptors1(128 * num1);
             std::vector<SiftGPU::SiftKeypoint> keys1(num1);
@@ -96,9 +122,7 @@ namespace gdr {
                 descriptors1 = normalizeDescriptorsL1Root(descriptors1);
             }
 
-            assert(pathToImageAndIndex.second >= 0 &&
-                   pathToImageAndIndex.second < keyPointsAndDescriptorsByIndex.size());
-            keyPointsAndDescriptorsByIndex[pathToImageAndIndex.second] = {keys1, descriptors1};
+            keyPointsAndDescriptorsByIndex[imageIndex] = {keys1, descriptors1};
         }
     }
 
@@ -7,6 +7,7 @@
 #include <opencv2/imgcodecs.hpp>
 
 #include "keyPoints/KeyPointsDepthDescriptor.h"
+#include "imageCache/DecodedImageCache.h"
 
 #include <vector>
 #include <cassert>
@@ -55,7 +56,8 @@ namespace gdr {
         std::vector<float> descriptorsKnownDepth;
         std::vector<double> depths;
 
-        cv::Mat depthImage = cv::imread(pathToDImage, cv::IMREAD_ANYDEPTH);
+        cv::Mat depthImage = DecodedImageCache::getInstance().getImage(pathToDImage,
+                                                                       DecodedImageCache::ImageType::DEPTH);
 
         for (int i = 0; i < keypoints.size(); ++i) {
             int posInDescriptorVector = 128 * i;
@@ -10,26 +10,36 @@ namespace gdr {
     MatchableInfo::MatchableInfo(const std::string &pathRGB,
                                  const std::string &pathD,
                                  const std::vector<KeyPoint2DAndDepth> &keyPoints2DToSet,
-                                 const CameraRGBD &cameraRGB) :
-            pathImageRGB(pathRGB),
-            pathImageD(pathD),
-            keyPoints2D(keyPoints2DToSet),
-            cameraRGB(cameraRGB) {}
+                                 const CameraRGBD &cameraRGBToSet) :
+            pathImageRGB(&pathRGB),
+            cameraRGB(&cameraRGBToSet),
+            pathImageD(&pathD),
+            keyPoints2D(&keyPoints2DToSet) {}
+
+    MatchableInfo::MatchableInfo(const VertexPose &vertexPose) :
+            MatchableInfo(vertexPose.getPathRGBImage(),
+                          vertexPose.getPathDImage(),
+                          vertexPose.getKeyPoints2D(),
+                          vertexPose.getCamera()) {}
 
     const std::string &MatchableInfo::getPathImageRGB() const {
-        return pathImageRGB;
+        assert(pathImageRGB);
+        return *pathImageRGB;
     }
 
     const std::string &MatchableInfo::getPathImageD() const {
-        return pathImageD;
+        assert(pathImageD);
+        return *pathImageD;
     }
 
-    const std::vector<KeyPoint2DAndDepth> MatchableInfo::getKeyPoints2D() const {
-        return keyPoints2D;
+    const std::vector<KeyPoint2DAndDepth> &MatchableInfo::getKeyPoints2D() const {
+        assert(keyPoints2D);
+        return *keyPoints2D;
     }
 
     const CameraRGBD &MatchableInfo::getCameraRGB() const {
-        return cameraRGB;
+        assert(cameraRGB);
+        return *cameraRGB;
     }
 
     int MatchableInfo::getImagePixelHeight() const {
@@ -47,6 +57,6 @@ namespace gdr {
     }
 
     double MatchableInfo::getDepthDivider() const {
-        return cameraRGB.getDepthPixelDivider();
+        return getCameraRGB().getDepthPixelDivider();
     }
 }
\ No newline at end of file
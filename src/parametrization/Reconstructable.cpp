@@ -4,6 +4,7 @@
 //
 
 #include "parametrization/Reconstructable.h"
+#include "imageCache/DecodedImageCache.h"
 
 #include "opencv2/opencv.hpp"
 
@@ -19,8 +20,9 @@ namespace gdr {
     std::vector<PointXYZRGBfloatUchar> Reconstructable::getPointCloudXYZRGB() const {
         double coeffDepth = getCamera().getDepthPixelDivider();
 
-        cv::Mat depthImage = cv::imread(getPathDImage(), cv::IMREAD_ANYDEPTH);
-        cv::Mat rgbImage = cv::imread(getPathRGBImage(), cv::IMREAD_ANYCOLOR);
+        auto &decodedImageCache = DecodedImageCache::getInstance();
+        cv::Mat depthImage = decodedImageCache.getImage(getPathDImage(), DecodedImageCache::ImageType::DEPTH);
+        cv::Mat rgbImage = decodedImageCache.getImage(getPathRGBImage(), DecodedImageCache::ImageType::COLOR);
         std::vector<PointXYZRGBfloatUchar> points;
 
         auto cameraToWorldSE3 = getAbsolutePose();
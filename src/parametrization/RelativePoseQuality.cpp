@@ -0,0 +1,54 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "parametrization/RelativePoseQuality.h"
+
+namespace gdr {
+
+    RelativePoseQuality::RelativePoseQuality(int numberOfInliersToSet,
+                                             double inlierErrorSpreadToSet,
+                                             bool refinedByICPToSet) :
+            numberOfInliers(numberOfInliersToSet),
+            inlierErrorSpread(inlierErrorSpreadToSet),
+            refinedByICP(refinedByICPToSet) {
+
+        assert(numberOfInliers >= 0);
+        assert(inlierErrorSpread >= 0);
+    }
+
+    int RelativePoseQuality::getNumberOfInliers() const {
+        return numberOfInliers;
+    }
+
+    double RelativePoseQuality::getInlierErrorSpread() const {
+        return inlierErrorSpread;
+    }
+
+    bool RelativePoseQuality::isRefinedByICP() const {
+        return refinedByICP;
+    }
+
+    bool RelativePoseQuality::isKnown() const {
+        return numberOfInliers > 0;
+    }
+
+    double RelativePoseQuality::getTranslationWeight(double minInlierErrorSpread,
+                                                     double weightFactorICP) const {
+        assert(minInlierErrorSpread > 0);
+
+        if (!isKnown()) {
+            return 1.0;
+        }
+
+        double weight = std::sqrt(static_cast<double>(numberOfInliers))
+                        / std::max(inlierErrorSpread, minInlierErrorSpread);
+
+        return refinedByICP ? (weightFactorICP * weight) : weight;
+    }
+}
@@ -31,10 +31,16 @@ namespace gdr {
         return relativePose;
     }
 
+    const RelativePoseQuality &RelativeSE3::getQuality() const {
+        return quality;
+    }
+
     RelativeSE3::RelativeSE3(int indexFromDestinationToSet,
                              int indexToToBeTransformedToSet,
-                             const SE3 &se3) :
+                             const SE3 &se3,
+                             const RelativePoseQuality &qualityToSet) :
             indexFromDestination(indexFromDestinationToSet),
             indexToToBeTransformed(indexToToBeTransformedToSet),
-            relativePose(se3) {}
+            relativePose(se3),
+            quality(qualityToSet) {}
 }
@@ -119,6 +119,35 @@ namespace gdr {
         return poseGraph.getRelativePosesFrom(vertexNumber);
     }
 
+    void ConnectedComponentPoseGraph::removeRelativePoses(const std::set<std::pair<int, int>> &posePairsToRemove) {
+
+        auto isRemoved = [&posePairsToRemove](int indexFirst, int indexSecond) {
+            return posePairsToRemove.find(std::make_pair(std::min(indexFirst, indexSecond),
+                                                         std::max(indexFirst, indexSecond)))
+                   != posePairsToRemove.end();
+        };
+
+        std::vector<std::vector<RelativeSE3>> relativePosesLeft(getNumberOfPoses());
+
+        for (int indexFrom = 0; indexFrom < getNumberOfPoses(); ++indexFrom) {
+            for (const auto &relativePose: getConnectionsFromVertex(indexFrom)) {
+                if (!isRemoved(relativePose.getIndexFrom(), relativePose.getIndexTo())) {
+                    relativePosesLeft[indexFrom].emplace_back(relativePose);
+                }
+            }
+        }
+        poseGraph.setRelativePoses(relativePosesLeft);
+
+        KeyPointMatches inlierPointCorrespondencesLeft;
+
+        for (const auto &inlierMatch: inlierPointCorrespondences) {
+            if (!isRemoved(inlierMatch.first.first.first, inlierMatch.second.first.first)) {
+                inlierPointCorrespondencesLeft.emplace_back(inlierMatch);
+            }
+        }
+        std::swap(inlierPointCorrespondences, inlierPointCorrespondencesLeft);
+    }
+
     bool ConnectedComponentPoseGraph::poseIndexIsValid(int poseIndex) const {
         bool isValid = poseIndex < poseGraph.size() && poseIndex >= 0;
 
@@ -21,7 +21,7 @@ namespace gdr {
         return depths;
     }
 
-    std::string VertexPose::getPathRGBImage() const {
+    const std::string &VertexPose::getPathRGBImage() const {
         return pathToRGBimage;
     }
 
@@ -31,7 +31,7 @@ namespace gdr {
         return path.filename().string();
     }
 
-    std::string VertexPose::getPathDImage() const {
+    const std::string &VertexPose::getPathDImage() const {
         return pathToDimage;
     }
 
@@ -0,0 +1,185 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <numeric>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include "poseGraph/graphAlgorithms/CycleConsistencyFilter.h"
+
+namespace gdr {
+
+    static int findRootDisjointSet(std::vector<int> &parentByPose, int poseIndex) {
+        while (parentByPose[poseIndex] != poseIndex) {
+            parentByPose[poseIndex] = parentByPose[parentByPose[poseIndex]];
+            poseIndex = parentByPose[poseIndex];
+        }
+        return poseIndex;
+    }
+
+    std::vector<int> CycleConsistencyFilter::getInconsistentEdges(int numberOfPoses,
+                                                                  const std::vector<std::pair<int, int>> &edges,
+                                                                  const std::vector<SE3> &relativePoses,
+                                                                  double maxRotationErrorDegrees,
+                                                                  double maxTranslationErrorRelative,
+                                                                  int maxCyclesPerEdge,
+                                                                  double maxInconsistentCyclesRatio) {
+        assert(edges.size() == relativePoses.size());
+        assert(maxCyclesPerEdge > 0);
+
+        // pairs {adjacent pose, edge index} sorted by adjacent pose
+        std::vector<std::vector<std::pair<int, int>>> adjacentPosesAndEdges(numberOfPoses);
+
+        for (int edgeIndex = 0; edgeIndex < edges.size(); ++edgeIndex) {
+            int indexFrom = edges[edgeIndex].first;
+            int indexTo = edges[edgeIndex].second;
+
+            assert(indexFrom >= 0 && indexFrom < indexTo && indexTo < numberOfPoses);
+            adjacentPosesAndEdges[indexFrom].emplace_back(std::make_pair(indexTo, edgeIndex));
+            adjacentPosesAndEdges[indexTo].emplace_back(std::make_pair(indexFrom, edgeIndex));
+        }
+
+        for (auto &adjacentPoses: adjacentPosesAndEdges) {
+            std::sort(adjacentPoses.begin(), adjacentPoses.end());
+        }
+
+        // relative pose T_from^{-1} * T_to of edge traversed from pose indexFrom
+        auto getRelativePoseFrom = [&](int edgeIndex, int indexFrom) {
+            return (edges[edgeIndex].first == indexFrom) ? relativePoses[edgeIndex]
+                                                          : relativePoses[edgeIndex].inverse();
+        };
+
+        double maxRotationErrorRadians = maxRotationErrorDegrees * M_PI / 180.0;
+        double maxTranslationError = 0;
+
+        if (maxTranslationErrorRelative > 0 && !relativePoses.empty()) {
+            std::vector<double> translationNorms;
+            translationNorms.reserve(relativePoses.size());
+
+            for (const auto &relativePose: relativePoses) {
+                translationNorms.emplace_back(relativePose.getTranslation().norm());
+            }
+
+            auto medianIterator = translationNorms.begin() + translationNorms.size() / 2;
+            std::nth_element(translationNorms.begin(), medianIterator, translationNorms.end());
+            maxTranslationError = maxTranslationErrorRelative * (*medianIterator);
+        }
+
+        std::vector<double> inconsistentCyclesRatios(edges.size(), 0.0);
+        std::vector<char> isFlagged(edges.size(), false);
+
+        // ratio is not changed if edge has no cycles without flagged edges
+        auto updateInconsistentCyclesRatio = [&](int edgeIndex) {
+            int indexFirst = edges[edgeIndex].first;
+            int indexSecond = edges[edgeIndex].second;
+
+            // pairs {edge indexSecond-indexThird, edge indexFirst-indexThird} of triangles
+            // are found as intersection of sorted adjacency lists
+            std::vector<std::pair<int, int>> edgesToThirdPose;
+            const auto &adjacentFirst = adjacentPosesAndEdges[indexFirst];
+            const auto &adjacentSecond = adjacentPosesAndEdges[indexSecond];
+
+            for (int i = 0, j = 0; i < adjacentFirst.size() && j < adjacentSecond.size();) {
+                if (adjacentFirst[i].first < adjacentSecond[j].first) {
+                    ++i;
+                } else if (adjacentSecond[j].first < adjacentFirst[i].first) {
+                    ++j;
+                } else {
+                    if (!isFlagged[adjacentSecond[j].second] && !isFlagged[adjacentFirst[i].second]) {
+                        edgesToThirdPose.emplace_back(std::make_pair(adjacentSecond[j].second,
+                                                                     adjacentFirst[i].second));
+                    }
+                    ++i;
+                    ++j;
+                }
+            }
+
+            int numberOfCycles = std::min(maxCyclesPerEdge, static_cast<int>(edgesToThirdPose.size()));
+            if (numberOfCycles == 0) {
+                return;
+            }
+
+            int numberOfInconsistentCycles = 0;
+            double stride = static_cast<double>(edgesToThirdPose.size()) / numberOfCycles;
+
+            for (int cycleNumber = 0; cycleNumber < numberOfCycles; ++cycleNumber) {
+                const auto &cycleEdges = edgesToThirdPose[static_cast<int>(cycleNumber * stride)];
+                int indexThird = (edges[cycleEdges.first].first == indexSecond) ?
+                                 edges[cycleEdges.first].second : edges[cycleEdges.first].first;
+
+                SE3 cycle = relativePoses[edgeIndex]
+                            * getRelativePoseFrom(cycleEdges.first, indexSecond)
+                            * getRelativePoseFrom(cycleEdges.second, indexThird);
+
+                bool isInconsistent = Eigen::AngleAxisd(cycle.getRotationQuatd()).angle() > maxRotationErrorRadians;
+
+                if (maxTranslationError > 0) {
+                    isInconsistent |= cycle.getTranslation().norm() > maxTranslationError;
+                }
+
+                if (isInconsistent) {
+                    ++numberOfInconsistentCycles;
+                }
+            }
+
+            inconsistentCyclesRatios[edgeIndex] = static_cast<double>(numberOfInconsistentCycles) / numberOfCycles;
+        };
+
+        // the second pass skips cycles through edges flagged by the first one,
+        // so inliers sharing triangles with outliers are not removed
+        for (int pass = 0; pass < 2; ++pass) {
+            tbb::parallel_for(tbb::blocked_range<int>(0, static_cast<int>(edges.size())),
+                              [&](const tbb::blocked_range<int> &range) {
+                                  for (int edgeIndex = range.begin(); edgeIndex < range.end(); ++edgeIndex) {
+                                      updateInconsistentCyclesRatio(edgeIndex);
+                                  }
+                              });
+
+            for (int edgeIndex = 0; edgeIndex < edges.size(); ++edgeIndex) {
+                isFlagged[edgeIndex] = inconsistentCyclesRatios[edgeIndex] > maxInconsistentCyclesRatio;
+            }
+        }
+
+        std::vector<int> edgesToRemove;
+        std::vector<int> parentByPose(numberOfPoses);
+        std::iota(parentByPose.begin(), parentByPose.end(), 0);
+
+        for (int edgeIndex = 0; edgeIndex < edges.size(); ++edgeIndex) {
+            if (isFlagged[edgeIndex]) {
+                edgesToRemove.emplace_back(edgeIndex);
+            } else {
+                parentByPose[findRootDisjointSet(parentByPose, edges[edgeIndex].first)] =
+                        findRootDisjointSet(parentByPose, edges[edgeIndex].second);
+            }
+        }
+
+        // the least inconsistent removed edges are restored if they are needed to keep graph connected
+        std::stable_sort(edgesToRemove.begin(), edgesToRemove.end(),
+                         [&inconsistentCyclesRatios](int lhs, int rhs) {
+                             return inconsistentCyclesRatios[lhs] < inconsistentCyclesRatios[rhs];
+                         });
+
+        std::vector<int> edgesRemoved;
+
+        for (int edgeIndex: edgesToRemove) {
+            int rootFrom = findRootDisjointSet(parentByPose, edges[edgeIndex].first);
+            int rootTo = findRootDisjointSet(parentByPose, edges[edgeIndex].second);
+
+            if (rootFrom != rootTo) {
+                parentByPose[rootFrom] = rootTo;
+            } else {
+                edgesRemoved.emplace_back(edgeIndex);
+            }
+        }
+
+        std::sort(edgesRemoved.begin(), edgesRemoved.end());
+
+        return edgesRemoved;
+    }
+}
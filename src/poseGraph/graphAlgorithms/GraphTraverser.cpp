@@ -86,7 +86,8 @@ namespace gdr {
                 const Sophus::SE3d &relativePoseSE3 = transformation.getRelativePoseSE3();
                 RelativeSE3 localRelativePoseSE3(localIndexFrom,
                                                  localIndexTo,
-                                                 transformation.getRelativePose());
+                                                 transformation.getRelativePose(),
+                                                 transformation.getQuality());
                 assert(componentNumberByPose[indexFrom] == componentNumberByPose[indexTo]);
                 assert(componentNumberByPose[indexFrom] == componentNumberIndexTo);
 
@@ -0,0 +1,271 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#include <cassert>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <opencv2/imgcodecs.hpp>
+
+#include "readerDataset/readerPacked/PackedDatasetReader.h"
+
+#include "directoryTraversing/DirectoryReader.h"
+
+namespace gdr {
+
+    PackedDatasetReader::PackedDatasetReader(const std::string &pathToContainerToSet) :
+            pathToContainer(pathToContainerToSet) {
+
+        fileDescriptor = open(pathToContainer.c_str(), O_RDONLY);
+
+        if (fileDescriptor < 0) {
+            return;
+        }
+
+        struct stat fileStatus{};
+        if (fstat(fileDescriptor, &fileStatus) != 0 || fileStatus.st_size < sizeof(PackedDatasetHeader)) {
+            unmap();
+            return;
+        }
+
+        mappedSizeBytes = static_cast<size_t>(fileStatus.st_size);
+        void *mapped = mmap(nullptr, mappedSizeBytes, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+
+        if (mapped == MAP_FAILED) {
+            mappedSizeBytes = 0;
+            unmap();
+            return;
+        }
+
+        mappedData = static_cast<const char *>(mapped);
+
+        if (!validateAndMapSections()) {
+            unmap();
+            return;
+        }
+
+        for (int frame = 0; frame < getNumberOfFrames(); ++frame) {
+            frameIndexByPathRgb[DirectoryReader::appendPathSuffix(
+                    DirectoryReader::appendPathSuffix(pathToContainer, "rgb"), getFilenameRgb(frame))] = frame;
+            frameIndexByPathDepth[DirectoryReader::appendPathSuffix(
+                    DirectoryReader::appendPathSuffix(pathToContainer, "depth"), getFilenameDepth(frame))] = frame;
+        }
+    }
+
+    bool PackedDatasetReader::validateAndMapSections() {
+
+        header = reinterpret_cast<const PackedDatasetHeader *>(mappedData);
+
+        if (std::memcmp(header->magic, packedDatasetMagic, sizeof(header->magic)) != 0
+            || header->version != packedDatasetVersion) {
+            return false;
+        }
+
+        bool isRaw = header->frameEncoding == static_cast<uint32_t>(PackedFrameEncoding::RAW);
+
+        if (!isRaw && header->frameEncoding != static_cast<uint32_t>(PackedFrameEncoding::PNG)) {
+            return false;
+        }
+
+        // offset + length is not computed because it may wrap around for corrupted files
+        auto rangeIsInside = [](uint64_t offset, uint64_t length, uint64_t sizeOfEnclosing) {
+            return offset <= sizeOfEnclosing && length <= sizeOfEnclosing - offset;
+        };
+        auto sectionIsInside = [this, &rangeIsInside](uint64_t offset, uint64_t size) {
+            return rangeIsInside(offset, size, mappedSizeBytes);
+        };
+
+        if (!sectionIsInside(header->offsetFrameIndex,
+                             static_cast<uint64_t>(header->numberOfFrames) * sizeof(PackedFrameIndexEntry))
+            || !sectionIsInside(header->offsetGroundTruth,
+                                static_cast<uint64_t>(header->numberOfGroundTruthPoses)
+                                * sizeof(PackedGroundTruthEntry))
+            || !sectionIsInside(header->offsetFilenames, header->sizeFilenames)) {
+            return false;
+        }
+
+        uint64_t numberOfPixels = static_cast<uint64_t>(header->imageWidth) * header->imageHeight;
+
+        frameIndex = reinterpret_cast<const PackedFrameIndexEntry *>(mappedData + header->offsetFrameIndex);
+        groundTruth = reinterpret_cast<const PackedGroundTruthEntry *>(mappedData + header->offsetGroundTruth);
+        filenames = mappedData + header->offsetFilenames;
+
+        for (int frame = 0; frame < header->numberOfFrames; ++frame) {
+            const auto &entry = frameIndex[frame];
+
+            if (!sectionIsInside(entry.offsetRgb, entry.sizeRgb)
+                || !sectionIsInside(entry.offsetDepth, entry.sizeDepth)
+                || !rangeIsInside(entry.offsetFilenameRgb, entry.lengthFilenameRgb, header->sizeFilenames)
+                || !rangeIsInside(entry.offsetFilenameDepth, entry.lengthFilenameDepth, header->sizeFilenames)) {
+                return false;
+            }
+
+            // raw images are wrapped without copying so their sizes must match image resolution,
+            // sizes are divided instead of multiplying number of pixels which may overflow
+            if (isRaw && (entry.sizeRgb % 3 != 0 || entry.sizeRgb / 3 != numberOfPixels
+                          || entry.sizeDepth % 2 != 0 || entry.sizeDepth / 2 != numberOfPixels)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void PackedDatasetReader::unmap() {
+
+        if (mappedData) {
+            munmap(const_cast<char *>(mappedData), mappedSizeBytes);
+        }
+        if (fileDescriptor >= 0) {
+            close(fileDescriptor);
+        }
+
+        fileDescriptor = -1;
+        mappedData = nullptr;
+        mappedSizeBytes = 0;
+        header = nullptr;
+        frameIndex = nullptr;
+        groundTruth = nullptr;
+        filenames = nullptr;
+    }
+
+    PackedDatasetReader::~PackedDatasetReader() {
+        unmap();
+    }
+
+    bool PackedDatasetReader::isOpened() const {
+        return header != nullptr;
+    }
+
+    const std::string &PackedDatasetReader::getPathToContainer() const {
+        return pathToContainer;
+    }
+
+    int PackedDatasetReader::getNumberOfFrames() const {
+        assert(isOpened());
+        return static_cast<int>(header->numberOfFrames);
+    }
+
+    PackedFrameEncoding PackedDatasetReader::getFrameEncoding() const {
+        assert(isOpened());
+        return static_cast<PackedFrameEncoding>(header->frameEncoding);
+    }
+
+    CameraRGBD PackedDatasetReader::getCamera() const {
+        assert(isOpened());
+
+        CameraRGBD camera(header->fx, header->cx, header->fy, header->cy);
+        camera.setDepthPixelDivider(header->depthPixelDivider);
+
+        return camera;
+    }
+
+    std::string PackedDatasetReader::getFilenameRgb(int frame) const {
+        const auto &entry = frameIndex[frame];
+        return std::string(filenames + entry.offsetFilenameRgb, entry.lengthFilenameRgb);
+    }
+
+    std::string PackedDatasetReader::getFilenameDepth(int frame) const {
+        const auto &entry = frameIndex[frame];
+        return std::string(filenames + entry.offsetFilenameDepth, entry.lengthFilenameDepth);
+    }
+
+    DatasetStructure PackedDatasetReader::getDatasetStructure() const {
+        assert(isOpened());
+
+        DatasetStructure datasetStructure;
+        std::string pathRgb = DirectoryReader::appendPathSuffix(pathToContainer, "rgb");
+        std::string pathDepth = DirectoryReader::appendPathSuffix(pathToContainer, "depth");
+
+        for (int frame = 0; frame < getNumberOfFrames(); ++frame) {
+            const auto &entry = frameIndex[frame];
+
+            datasetStructure.pathsImagesRgb.emplace_back(
+                    DirectoryReader::appendPathSuffix(pathRgb, getFilenameRgb(frame)));
+            datasetStructure.pathsImagesDepth.emplace_back(
+                    DirectoryReader::appendPathSuffix(pathDepth, getFilenameDepth(frame)));
+            datasetStructure.timestampsRgbDepth.emplace_back(std::make_pair(entry.timestampRgb,
+                                                                            entry.timestampDepth));
+        }
+
+        return datasetStructure;
+    }
+
+    std::vector<PoseFullInfo> PackedDatasetReader::getGroundTruthPoses() const {
+        assert(isOpened());
+
+        std::vector<PoseFullInfo> poses;
+        poses.reserve(header->numberOfGroundTruthPoses);
+
+        for (int poseIndex = 0; poseIndex < header->numberOfGroundTruthPoses; ++poseIndex) {
+            const auto &entry = groundTruth[poseIndex];
+
+            Eigen::Quaterniond orientation(entry.orientation[3],
+                                           entry.orientation[0],
+                                           entry.orientation[1],
+                                           entry.orientation[2]);
+            poses.emplace_back(PoseFullInfo(entry.timestamp,
+                                            orientation.normalized(),
+                                            Eigen::Vector3d(entry.translation[0],
+                                                            entry.translation[1],
+                                                            entry.translation[2])));
+        }
+
+        return poses;
+    }
+
+    cv::Mat PackedDatasetReader::getImageRGB(int frame) const {
+        assert(isOpened());
+        assert(frame >= 0 && frame < getNumberOfFrames());
+
+        const auto &entry = frameIndex[frame];
+        char *data = const_cast<char *>(mappedData + entry.offsetRgb);
+
+        if (getFrameEncoding() == PackedFrameEncoding::RAW) {
+            assert(entry.sizeRgb == 3ULL * header->imageWidth * header->imageHeight);
+            return cv::Mat(header->imageHeight, header->imageWidth, CV_8UC3, data);
+        }
+
+        return cv::imdecode(cv::Mat(1, static_cast<int>(entry.sizeRgb), CV_8UC1, data), cv::IMREAD_COLOR);
+    }
+
+    cv::Mat PackedDatasetReader::getImageDepth(int frame) const {
+        assert(isOpened());
+        assert(frame >= 0 && frame < getNumberOfFrames());
+
+        const auto &entry = frameIndex[frame];
+        char *data = const_cast<char *>(mappedData + entry.offsetDepth);
+
+        if (getFrameEncoding() == PackedFrameEncoding::RAW) {
+            assert(entry.sizeDepth == 2ULL * header->imageWidth * header->imageHeight);
+            return cv::Mat(header->imageHeight, header->imageWidth, CV_16UC1, data);
+        }
+
+        return cv::imdecode(cv::Mat(1, static_cast<int>(entry.sizeDepth), CV_8UC1, data), cv::IMREAD_ANYDEPTH);
+    }
+
+    bool PackedDatasetReader::findFrameByPath(const std::string &pathToImage, bool &isDepth, int &frame) const {
+
+        auto foundRgb = frameIndexByPathRgb.find(pathToImage);
+        if (foundRgb != frameIndexByPathRgb.end()) {
+            isDepth = false;
+            frame = foundRgb->second;
+            return true;
+        }
+
+        auto foundDepth = frameIndexByPathDepth.find(pathToImage);
+        if (foundDepth != frameIndexByPathDepth.end()) {
+            isDepth = true;
+            frame = foundDepth->second;
+            return true;
+        }
+
+        return false;
+    }
+}
@@ -0,0 +1,226 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#include <opencv2/imgcodecs.hpp>
+
+#include "boost/filesystem.hpp"
+
+#include "readerDataset/readerPacked/PackedDatasetWriter.h"
+#include "readerDataset/readerTUM/ReaderTum.h"
+
+#include "directoryTraversing/DirectoryReader.h"
+
+namespace gdr {
+
+    namespace fs = boost::filesystem;
+
+    bool readFileBytesPacked(const std::string &pathToFile, std::vector<char> &bytes) {
+        std::ifstream file(pathToFile, std::ios::binary);
+
+        if (!file.is_open()) {
+            return false;
+        }
+
+        bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+        return !bytes.empty();
+    }
+
+    bool readFrameBytesPacked(const std::string &pathToImage,
+                              bool isDepth,
+                              const PackedFrameEncoding &frameEncoding,
+                              std::vector<char> &bytes,
+                              int &width,
+                              int &height) {
+
+        if (frameEncoding == PackedFrameEncoding::PNG) {
+            return readFileBytesPacked(pathToImage, bytes);
+        }
+
+        cv::Mat image = cv::imread(pathToImage, isDepth ? cv::IMREAD_ANYDEPTH : cv::IMREAD_COLOR);
+
+        if (image.empty() || image.type() != (isDepth ? CV_16UC1 : CV_8UC3)) {
+            return false;
+        }
+        if (!image.isContinuous()) {
+            image = image.clone();
+        }
+
+        width = image.cols;
+        height = image.rows;
+
+        const char *imageData = reinterpret_cast<const char *>(image.data);
+        bytes.assign(imageData, imageData + image.total() * image.elemSize());
+
+        return true;
+    }
+
+    void writeAlignedPacked(std::ofstream &container, const char *data, uint64_t size) {
+        container.write(data, size);
+
+        uint64_t position = container.tellp();
+        uint64_t padding = (packedDatasetAlignmentBytes - position % packedDatasetAlignmentBytes)
+                           % packedDatasetAlignmentBytes;
+        std::vector<char> zeros(padding, 0);
+        container.write(zeros.data(), zeros.size());
+    }
+
+    bool PackedDatasetWriter::writeContainer(const DatasetStructure &datasetStructure,
+                                             const CameraRGBD &camera,
+                                             const std::vector<PoseFullInfo> &groundTruthPoses,
+                                             const std::string &pathToContainer,
+                                             const PackedFrameEncoding &frameEncoding) {
+
+        const auto &pathsRgb = datasetStructure.pathsImagesRgb;
+        const auto &pathsDepth = datasetStructure.pathsImagesDepth;
+        const auto &timestamps = datasetStructure.timestampsRgbDepth;
+
+        assert(pathsRgb.size() == pathsDepth.size());
+        assert(pathsRgb.size() == timestamps.size());
+
+        std::ofstream container(pathToContainer, std::ios::binary | std::ios::trunc);
+
+        if (!container.is_open()) {
+            return false;
+        }
+
+        PackedDatasetHeader header{};
+        std::memcpy(header.magic, packedDatasetMagic, sizeof(header.magic));
+        header.version = packedDatasetVersion;
+        header.frameEncoding = static_cast<uint32_t>(frameEncoding);
+        header.numberOfFrames = static_cast<uint32_t>(pathsRgb.size());
+        header.numberOfGroundTruthPoses = static_cast<uint32_t>(groundTruthPoses.size());
+        header.fx = camera.getFx();
+        header.fy = camera.getFy();
+        header.cx = camera.getCx();
+        header.cy = camera.getCy();
+        header.depthPixelDivider = camera.getDepthPixelDivider();
+
+        // header is rewritten when all offsets are known
+        writeAlignedPacked(container, reinterpret_cast<const char *>(&header), sizeof(header));
+
+        std::vector<PackedFrameIndexEntry> frameIndex(pathsRgb.size());
+        std::string filenames;
+
+        for (int frame = 0; frame < pathsRgb.size(); ++frame) {
+            auto &entry = frameIndex[frame];
+
+            entry.timestampRgb = timestamps[frame].first;
+            entry.timestampDepth = timestamps[frame].second;
+
+            std::vector<char> bytesRgb;
+            std::vector<char> bytesDepth;
+            int widthRgb = 0, heightRgb = 0;
+            int widthDepth = 0, heightDepth = 0;
+
+            if (!readFrameBytesPacked(pathsRgb[frame], false, frameEncoding, bytesRgb, widthRgb, heightRgb)
+                || !readFrameBytesPacked(pathsDepth[frame], true, frameEncoding, bytesDepth, widthDepth, heightDepth)) {
+                std::cout << "could not read frame " << frame << ": " << pathsRgb[frame]
+                          << ", " << pathsDepth[frame] << std::endl;
+                return false;
+            }
+
+            if (frameEncoding == PackedFrameEncoding::RAW) {
+                if (widthRgb != widthDepth || heightRgb != heightDepth) {
+                    return false;
+                }
+                if (frame == 0) {
+                    header.imageWidth = widthRgb;
+                    header.imageHeight = heightRgb;
+                } else if (header.imageWidth != widthRgb || header.imageHeight != heightRgb) {
+                    return false;
+                }
+            }
+
+            entry.offsetRgb = container.tellp();
+            entry.sizeRgb = bytesRgb.size();
+            writeAlignedPacked(container, bytesRgb.data(), bytesRgb.size());
+
+            entry.offsetDepth = container.tellp();
+            entry.sizeDepth = bytesDepth.size();
+            writeAlignedPacked(container, bytesDepth.data(), bytesDepth.size());
+
+            std::string filenameRgb = fs::path(pathsRgb[frame]).filename().string();
+            std::string filenameDepth = fs::path(pathsDepth[frame]).filename().string();
+
+            entry.offsetFilenameRgb = filenames.size();
+            entry.lengthFilenameRgb = filenameRgb.size();
+            filenames += filenameRgb;
+
+            entry.offsetFilenameDepth = filenames.size();
+            entry.lengthFilenameDepth = filenameDepth.size();
+            filenames += filenameDepth;
+        }
+
+        if (frameEncoding == PackedFrameEncoding::PNG && !pathsRgb.empty()) {
+            cv::Mat firstImage = cv::imread(pathsRgb[0], cv::IMREAD_UNCHANGED);
+            header.imageWidth = firstImage.cols;
+            header.imageHeight = firstImage.rows;
+        }
+
+        header.offsetFrameIndex = container.tellp();
+        writeAlignedPacked(container,
+                           reinterpret_cast<const char *>(frameIndex.data()),
+                           frameIndex.size() * sizeof(PackedFrameIndexEntry));
+
+        std::vector<PackedGroundTruthEntry> groundTruth;
+        groundTruth.reserve(groundTruthPoses.size());
+
+        for (const auto &pose: groundTruthPoses) {
+            PackedGroundTruthEntry entry{};
+            entry.timestamp = pose.getTimestamp();
+
+            Eigen::Vector3d translation = pose.getTranslation();
+            Eigen::Quaterniond orientation = pose.getOrientationQuat();
+
+            for (int i = 0; i < 3; ++i) {
+                entry.translation[i] = translation[i];
+            }
+            entry.orientation[0] = orientation.x();
+            entry.orientation[1] = orientation.y();
+            entry.orientation[2] = orientation.z();
+            entry.orientation[3] = orientation.w();
+
+            groundTruth.emplace_back(entry);
+        }
+
+        header.offsetGroundTruth = container.tellp();
+        writeAlignedPacked(container,
+                           reinterpret_cast<const char *>(groundTruth.data()),
+                           groundTruth.size() * sizeof(PackedGroundTruthEntry));
+
+        header.offsetFilenames = container.tellp();
+        header.sizeFilenames = filenames.size();
+        writeAlignedPacked(container, filenames.data(), filenames.size());
+
+        container.seekp(0);
+        container.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+        return container.good();
+    }
+
+    bool PackedDatasetWriter::convertTUM(const std::string &pathToDataset,
+                                         const std::string &assocShortFilename,
+                                         const CameraRGBD &camera,
+                                         const std::string &pathToContainer,
+                                         const PackedFrameEncoding &frameEncoding) {
+
+        DatasetStructure datasetStructure = ReaderTUM::getDatasetStructure(pathToDataset, assocShortFilename);
+
+        std::vector<PoseFullInfo> groundTruthPoses;
+        std::string pathToGroundTruth = DirectoryReader::appendPathSuffix(pathToDataset, "groundtruth.txt");
+
+        if (fs::exists(pathToGroundTruth)) {
+            groundTruthPoses = ReaderTUM::getPoseInfoTimeTranslationOrientation(pathToGroundTruth);
+        }
+
+        return writeContainer(datasetStructure, camera, groundTruthPoses, pathToContainer, frameEncoding);
+    }
+}
@@ -9,6 +9,8 @@
 
 #include "relativePoseRefinement/ICPCUDA.h"
 
+#include "imageCache/DecodedImageCache.h"
+
 #include "computationHandlers/TimerClockNow.h"
 
 namespace gdr {
@@ -19,22 +21,20 @@ namespace gdr {
                        int width,
                        int height) {
 
-        pangolin::TypedImage depthRawImage =
-                pangolin::LoadImage(filename, pangolin::ImageFileTypePng);
-
-        pangolin::Image<unsigned short> depthRaw16(
-                (unsigned short *) depthRawImage.ptr, depthRawImage.w, depthRawImage.h,
-                depthRawImage.w * sizeof(unsigned short));
+        cv::Mat depthRaw16 = DecodedImageCache::getInstance().getImage(filename,
+                                                                       DecodedImageCache::ImageType::DEPTH);
+        assert(depthRaw16.type() == CV_16UC1);
+        assert(depthRaw16.cols >= width && depthRaw16.rows >= height);
 
         int depthDividerMm = static_cast<int>(depthDivider) / 1000;
         for (int y = 0; y < height; ++y) {
+            const auto *rowDepthRaw16 = depthRaw16.ptr<unsigned short>(y);
+
             for (int x = 0; x < width; ++x) {
-                imageDepth.RowPtr(y)[x] = depthRaw16(x, y) / depthDividerMm;
+                imageDepth.RowPtr(y)[x] = rowDepthRaw16[x] / depthDividerMm;
             }
         }
 
-        depthRawImage.Dealloc();
-
         return 0;
     }
 
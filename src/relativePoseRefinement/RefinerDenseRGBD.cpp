@@ -0,0 +1,474 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#include <opencv2/imgproc.hpp>
+
+#include <tbb/parallel_reduce.h>
+#include <tbb/blocked_range.h>
+
+#include "relativePoseRefinement/RefinerDenseRGBD.h"
+
+#include "imageCache/DecodedImageCache.h"
+
+#include "computationHandlers/TimerClockNow.h"
+
+namespace gdr {
+
+    static double interpolateBilinearDense(const cv::Mat &image, double x, double y) {
+
+        int x0 = static_cast<int>(x);
+        int y0 = static_cast<int>(y);
+        double dx = x - x0;
+        double dy = y - y0;
+
+        const float *row0 = image.ptr<float>(y0);
+        const float *row1 = image.ptr<float>(y0 + 1);
+
+        return (1 - dy) * ((1 - dx) * row0[x0] + dx * row0[x0 + 1])
+               + dy * ((1 - dx) * row1[x0] + dx * row1[x0 + 1]);
+    }
+
+    static bool interpolateDepthBilinearDense(const cv::Mat &depth,
+                                              const cv::Mat &depthGradX,
+                                              const cv::Mat &depthGradY,
+                                              double x, double y,
+                                              double &depthInterpolated,
+                                              double &gradX,
+                                              double &gradY) {
+
+        int x0 = static_cast<int>(x);
+        int y0 = static_cast<int>(y);
+
+        const float *row0 = depth.ptr<float>(y0);
+        const float *row1 = depth.ptr<float>(y0 + 1);
+
+        if (row0[x0] <= 0 || row0[x0 + 1] <= 0 || row1[x0] <= 0 || row1[x0 + 1] <= 0) {
+            return false;
+        }
+
+        depthInterpolated = interpolateBilinearDense(depth, x, y);
+        gradX = interpolateBilinearDense(depthGradX, x, y);
+        gradY = interpolateBilinearDense(depthGradY, x, y);
+
+        return std::isfinite(gradX) && std::isfinite(gradY);
+    }
+
+    RefinerDenseRGBD::NormalEquations &RefinerDenseRGBD::NormalEquations::operator+=(const NormalEquations &other) {
+        hessian += other.hessian;
+        gradient += other.gradient;
+        weightedSquaredError += other.weightedSquaredError;
+        numberOfPixelsUsed += other.numberOfPixelsUsed;
+
+        return *this;
+    }
+
+    void RefinerDenseRGBD::setIterationsByPyramidLevel(const std::vector<int> &iterationsByLevel) {
+        assert(!iterationsByLevel.empty());
+        iterationsByPyramidLevel = iterationsByLevel;
+    }
+
+    void RefinerDenseRGBD::setResidualWeights(double sigmaIntensityToSet, double weightGeometricToSet) {
+        assert(sigmaIntensityToSet > 0);
+        assert(weightGeometricToSet >= 0);
+
+        sigmaIntensity = sigmaIntensityToSet;
+        weightGeometric = weightGeometricToSet;
+    }
+
+    bool RefinerDenseRGBD::readIntensityAndDepth(const MatchableInfo &poseInfo,
+                                                 cv::Mat &intensity,
+                                                 cv::Mat &depth) {
+
+        auto &decodedImageCache = DecodedImageCache::getInstance();
+        cv::Mat imageGray = decodedImageCache.getImage(poseInfo.getPathImageRGB(),
+                                                       DecodedImageCache::ImageType::GRAYSCALE);
+        cv::Mat imageDepth = decodedImageCache.getImage(poseInfo.getPathImageD(),
+                                                        DecodedImageCache::ImageType::DEPTH);
+
+        if (imageGray.empty() || imageDepth.empty() || imageGray.size() != imageDepth.size()) {
+            return false;
+        }
+
+        imageGray.convertTo(intensity, CV_32F, 1.0 / 255.0);
+        imageDepth.convertTo(depth, CV_32F, 1.0 / poseInfo.getDepthDivider());
+
+        return true;
+    }
+
+    cv::Mat RefinerDenseRGBD::downsampleDepth(const cv::Mat &depth) {
+
+        int heightDownsampled = (depth.rows + 1) / 2;
+        int widthDownsampled = (depth.cols + 1) / 2;
+        cv::Mat depthDownsampled(heightDownsampled, widthDownsampled, CV_32F);
+
+        for (int y = 0; y < heightDownsampled; ++y) {
+            for (int x = 0; x < widthDownsampled; ++x) {
+
+                double sumDepth = 0;
+                int knownDepthValues = 0;
+
+                for (int yBlock = 2 * y; yBlock < std::min(2 * y + 2, depth.rows); ++yBlock) {
+                    for (int xBlock = 2 * x; xBlock < std::min(2 * x + 2, depth.cols); ++xBlock) {
+                        float depthValue = depth.at<float>(yBlock, xBlock);
+
+                        if (depthValue > 0) {
+                            sumDepth += depthValue;
+                            ++knownDepthValues;
+                        }
+                    }
+                }
+
+                depthDownsampled.at<float>(y, x) =
+                        (knownDepthValues > 0) ? static_cast<float>(sumDepth / knownDepthValues) : 0.0f;
+            }
+        }
+
+        return depthDownsampled;
+    }
+
+    void RefinerDenseRGBD::computeDepthGradients(const cv::Mat &depth,
+                                                 cv::Mat &gradX,
+                                                 cv::Mat &gradY) {
+
+        const float unknownGradient = std::numeric_limits<float>::quiet_NaN();
+        gradX = cv::Mat(depth.size(), CV_32F, cv::Scalar(unknownGradient));
+        gradY = cv::Mat(depth.size(), CV_32F, cv::Scalar(unknownGradient));
+
+        for (int y = 1; y < depth.rows - 1; ++y) {
+            const float *rowPrev = depth.ptr<float>(y - 1);
+            const float *row = depth.ptr<float>(y);
+            const float *rowNext = depth.ptr<float>(y + 1);
+
+            float *rowGradX = gradX.ptr<float>(y);
+            float *rowGradY = gradY.ptr<float>(y);
+
+            for (int x = 1; x < depth.cols - 1; ++x) {
+                if (row[x] <= 0) {
+                    continue;
+                }
+                if (row[x - 1] > 0 && row[x + 1] > 0) {
+                    rowGradX[x] = 0.5f * (row[x + 1] - row[x - 1]);
+                }
+                if (rowPrev[x] > 0 && rowNext[x] > 0) {
+                    rowGradY[x] = 0.5f * (rowNext[x] - rowPrev[x]);
+                }
+            }
+        }
+    }
+
+    std::vector<RefinerDenseRGBD::PyramidLevel> RefinerDenseRGBD::buildPyramid(const cv::Mat &intensity,
+                                                                               const cv::Mat &depth,
+                                                                               const CameraRGBD &camera,
+                                                                               int numberOfLevels) {
+        assert(numberOfLevels > 0);
+        std::vector<PyramidLevel> pyramid(numberOfLevels);
+
+        for (int level = 0; level < numberOfLevels; ++level) {
+            auto &pyramidLevel = pyramid[level];
+
+            if (level == 0) {
+                pyramidLevel.intensity = intensity;
+                pyramidLevel.depth = depth;
+
+                pyramidLevel.fx = camera.getFx();
+                pyramidLevel.fy = camera.getFy();
+                pyramidLevel.cx = camera.getCx();
+                pyramidLevel.cy = camera.getCy();
+            } else {
+                const auto &levelFiner = pyramid[level - 1];
+
+                cv::pyrDown(levelFiner.intensity, pyramidLevel.intensity);
+                pyramidLevel.depth = downsampleDepth(levelFiner.depth);
+                assert(pyramidLevel.intensity.size() == pyramidLevel.depth.size());
+
+                pyramidLevel.fx = 0.5 * levelFiner.fx;
+                pyramidLevel.fy = 0.5 * levelFiner.fy;
+                pyramidLevel.cx = 0.5 * (levelFiner.cx + 0.5) - 0.5;
+                pyramidLevel.cy = 0.5 * (levelFiner.cy + 0.5) - 0.5;
+            }
+
+            cv::Sobel(pyramidLevel.intensity, pyramidLevel.intensityGradX, CV_32F, 1, 0, 3, 1.0 / 8.0);
+            cv::Sobel(pyramidLevel.intensity, pyramidLevel.intensityGradY, CV_32F, 0, 1, 3, 1.0 / 8.0);
+
+            computeDepthGradients(pyramidLevel.depth, pyramidLevel.depthGradX, pyramidLevel.depthGradY);
+        }
+
+        return pyramid;
+    }
+
+    double RefinerDenseRGBD::getHuberWeight(double normalizedResidual) const {
+        double absResidual = std::abs(normalizedResidual);
+
+        return (absResidual <= huberThreshold) ? 1.0 : huberThreshold / absResidual;
+    }
+
+    RefinerDenseRGBD::NormalEquations RefinerDenseRGBD::computeNormalEquations(
+            const PyramidLevel &levelToBeTransformed,
+            const PyramidLevel &levelDestination,
+            const Sophus::SE3d &transformation,
+            double parameterNoiseModelDepth) const {
+
+        const Eigen::Matrix3d rotation = transformation.rotationMatrix();
+        const Eigen::Vector3d translation = transformation.translation();
+
+        int height = levelToBeTransformed.depth.rows;
+        int width = levelToBeTransformed.depth.cols;
+        int heightDestination = levelDestination.depth.rows;
+        int widthDestination = levelDestination.depth.cols;
+
+        double fxDestination = levelDestination.fx;
+        double fyDestination = levelDestination.fy;
+        double cxDestination = levelDestination.cx;
+        double cyDestination = levelDestination.cy;
+
+        // each pixel contributes at most one photometric and one geometric residual
+        int maxNumberOfResidualsPerBlock = 2 * width * rowsPerTask;
+
+        // jacobian rows of a block of image rows are stored contiguously to accumulate J^T * W * J
+        // with a single product
+        auto accumulateBlock = [&](int rowBegin, int rowEnd,
+                                   Eigen::Matrix<double, Eigen::Dynamic, 6> &jacobians,
+                                   Eigen::VectorXd &residuals,
+                                   Eigen::VectorXd &weights,
+                                   NormalEquations &equations) {
+            int numberOfResiduals = 0;
+
+            for (int y = rowBegin; y < rowEnd; ++y) {
+
+                const float *rowDepth = levelToBeTransformed.depth.ptr<float>(y);
+                const float *rowIntensity = levelToBeTransformed.intensity.ptr<float>(y);
+
+                for (int x = 0; x < width; ++x) {
+
+                    double depth = rowDepth[x];
+                    if (depth <= 0) {
+                        continue;
+                    }
+
+                    Eigen::Vector3d point((x - levelToBeTransformed.cx) / levelToBeTransformed.fx * depth,
+                                          (y - levelToBeTransformed.cy) / levelToBeTransformed.fy * depth,
+                                          depth);
+                    Eigen::Vector3d pointTransformed = rotation * point + translation;
+
+                    double z = pointTransformed[2];
+                    if (z <= 0) {
+                        continue;
+                    }
+
+                    double xProjected = fxDestination * pointTransformed[0] / z + cxDestination;
+                    double yProjected = fyDestination * pointTransformed[1] / z + cyDestination;
+
+                    if (xProjected < 0 || yProjected < 0
+                        || xProjected >= widthDestination - 1 || yProjected >= heightDestination - 1) {
+                        continue;
+                    }
+
+                    double depthDestination = 0;
+                    double depthGradX = 0;
+                    double depthGradY = 0;
+                    bool depthKnown = interpolateDepthBilinearDense(levelDestination.depth,
+                                                                    levelDestination.depthGradX,
+                                                                    levelDestination.depthGradY,
+                                                                    xProjected, yProjected,
+                                                                    depthDestination,
+                                                                    depthGradX, depthGradY);
+                    double residualDepth = depthDestination - z;
+
+                    // point is occluded or belongs to another surface
+                    if (depthKnown && std::abs(residualDepth) > maxDepthDifferenceMeters) {
+                        continue;
+                    }
+
+                    Eigen::Matrix<double, 2, 3> jacobianProjection;
+                    jacobianProjection << fxDestination / z, 0, -fxDestination * pointTransformed[0] / (z * z),
+                            0, fyDestination / z, -fyDestination * pointTransformed[1] / (z * z);
+
+                    // derivative of exp(dx) * T * p by dx = (translation, rotation) at dx = 0
+                    Eigen::Matrix<double, 3, 6> jacobianPoint;
+                    jacobianPoint.leftCols<3>().setIdentity();
+                    jacobianPoint.rightCols<3>() = -Sophus::SO3d::hat(pointTransformed);
+
+                    Eigen::Matrix<double, 2, 6> jacobianPixel = jacobianProjection * jacobianPoint;
+
+                    double intensityDestination = interpolateBilinearDense(levelDestination.intensity,
+                                                                           xProjected, yProjected);
+                    double intensityGradX = interpolateBilinearDense(levelDestination.intensityGradX,
+                                                                     xProjected, yProjected);
+                    double intensityGradY = interpolateBilinearDense(levelDestination.intensityGradY,
+                                                                     xProjected, yProjected);
+                    double residualIntensity = intensityDestination - rowIntensity[x];
+
+                    jacobians.row(numberOfResiduals) = intensityGradX * jacobianPixel.row(0)
+                                                       + intensityGradY * jacobianPixel.row(1);
+                    residuals[numberOfResiduals] = residualIntensity;
+                    weights[numberOfResiduals] = getHuberWeight(residualIntensity / sigmaIntensity)
+                                                 / (sigmaIntensity * sigmaIntensity);
+                    ++numberOfResiduals;
+
+                    if (depthKnown && weightGeometric > 0) {
+                        double sigmaDepth = std::max(parameterNoiseModelDepth * z * z, minSigmaDepthMeters);
+
+                        jacobians.row(numberOfResiduals) = depthGradX * jacobianPixel.row(0)
+                                                           + depthGradY * jacobianPixel.row(1)
+                                                           - jacobianPoint.row(2);
+                        residuals[numberOfResiduals] = residualDepth;
+                        weights[numberOfResiduals] = weightGeometric
+                                                     * getHuberWeight(residualDepth / sigmaDepth)
+                                                     / (sigmaDepth * sigmaDepth);
+                        ++numberOfResiduals;
+                    }
+
+                    ++equations.numberOfPixelsUsed;
+                }
+            }
+
+            if (numberOfResiduals > 0) {
+                const auto jacobiansUsed = jacobians.topRows(numberOfResiduals);
+                Eigen::VectorXd weightedResiduals =
+                        weights.head(numberOfResiduals).cwiseProduct(residuals.head(numberOfResiduals));
+
+                equations.hessian.noalias() += jacobiansUsed.transpose()
+                                               * weights.head(numberOfResiduals).asDiagonal()
+                                               * jacobiansUsed;
+                equations.gradient.noalias() += jacobiansUsed.transpose() * weightedResiduals;
+                equations.weightedSquaredError += residuals.head(numberOfResiduals).dot(weightedResiduals);
+            }
+        };
+        using AccumulateBlock = decltype(accumulateBlock);
+
+        // buffers are allocated once per body, bodies are reused by TBB for many ranges
+        struct ReduceBody {
+            const AccumulateBlock &accumulateRows;
+            int rowsPerBlock;
+
+            Eigen::Matrix<double, Eigen::Dynamic, 6> jacobians;
+            Eigen::VectorXd residuals;
+            Eigen::VectorXd weights;
+            NormalEquations equations;
+
+            ReduceBody(const AccumulateBlock &accumulateRowsToSet,
+                       int rowsPerBlockToSet,
+                       int maxNumberOfResiduals) :
+                    accumulateRows(accumulateRowsToSet),
+                    rowsPerBlock(rowsPerBlockToSet),
+                    jacobians(maxNumberOfResiduals, 6),
+                    residuals(maxNumberOfResiduals),
+                    weights(maxNumberOfResiduals) {}
+
+            ReduceBody(ReduceBody &other, tbb::split) :
+                    ReduceBody(other.accumulateRows, other.rowsPerBlock, static_cast<int>(other.residuals.size())) {}
+
+            void operator()(const tbb::blocked_range<int> &rows) {
+                // auto partitioner may pass ranges longer than grain size
+                for (int rowBegin = rows.begin(); rowBegin < rows.end(); rowBegin += rowsPerBlock) {
+                    accumulateRows(rowBegin, std::min(rowBegin + rowsPerBlock, rows.end()),
+                                   jacobians, residuals, weights, equations);
+                }
+            }
+
+            void join(const ReduceBody &other) {
+                equations += other.equations;
+            }
+        };
+
+        ReduceBody reduceBody(accumulateBlock, rowsPerTask, maxNumberOfResidualsPerBlock);
+        tbb::parallel_reduce(tbb::blocked_range<int>(0, height, rowsPerTask), reduceBody);
+
+        return reduceBody.equations;
+    }
+
+    bool RefinerDenseRGBD::refineRelativePose(const MatchableInfo &poseToBeTransformed,
+                                              const MatchableInfo &poseDestination,
+                                              const KeyPointMatches &keyPointMatches,
+                                              SE3 &initTransformationSE3,
+                                              double &durationSeconds,
+                                              int deviceIndex) {
+
+        std::chrono::high_resolution_clock::time_point timeStartRefinement = timerGetClockTimeNow();
+
+        cv::Mat intensityToBeTransformed, depthToBeTransformed;
+        cv::Mat intensityDestination, depthDestination;
+
+        bool imagesRead = readIntensityAndDepth(poseToBeTransformed, intensityToBeTransformed, depthToBeTransformed)
+                          && readIntensityAndDepth(poseDestination, intensityDestination, depthDestination);
+
+        bool converged = imagesRead;
+
+        if (imagesRead) {
+            int numberOfLevels = static_cast<int>(iterationsByPyramidLevel.size());
+
+            std::vector<PyramidLevel> pyramidToBeTransformed = buildPyramid(intensityToBeTransformed,
+                                                                            depthToBeTransformed,
+                                                                            poseToBeTransformed.getCameraRGB(),
+                                                                            numberOfLevels);
+            std::vector<PyramidLevel> pyramidDestination = buildPyramid(intensityDestination,
+                                                                        depthDestination,
+                                                                        poseDestination.getCameraRGB(),
+                                                                        numberOfLevels);
+            double parameterNoiseModelDepth = poseDestination.getCameraRGB()
+                    .getMeasurementErrorDeviationEstimators().getParameterNoiseModelDepth();
+
+            Sophus::SE3d relativePose = initTransformationSE3.getSE3();
+
+            for (int level = numberOfLevels - 1; level >= 0 && converged; --level) {
+
+                const auto &levelToBeTransformed = pyramidToBeTransformed[level];
+                const auto &levelDestination = pyramidDestination[level];
+
+                int minPixelsUsed = static_cast<int>(minRatioOfPixelsUsed
+                                                     * levelToBeTransformed.depth.rows
+                                                     * levelToBeTransformed.depth.cols);
+                double previousMeanError = std::numeric_limits<double>::max();
+                Sophus::SE3d previousPose = relativePose;
+
+                for (int iteration = 0; iteration < iterationsByPyramidLevel[level]; ++iteration) {
+
+                    NormalEquations equations = computeNormalEquations(levelToBeTransformed,
+                                                                       levelDestination,
+                                                                       relativePose,
+                                                                       parameterNoiseModelDepth);
+
+                    if (equations.numberOfPixelsUsed < minPixelsUsed) {
+                        converged = false;
+                        break;
+                    }
+
+                    double meanError = equations.weightedSquaredError / equations.numberOfPixelsUsed;
+
+                    if (meanError > previousMeanError) {
+                        relativePose = previousPose;
+                        break;
+                    }
+
+                    previousMeanError = meanError;
+                    previousPose = relativePose;
+
+                    Eigen::Matrix<double, 6, 1> increment = equations.hessian.ldlt().solve(-equations.gradient);
+
+                    if (!increment.allFinite()) {
+                        converged = false;
+                        break;
+                    }
+
+                    relativePose = Sophus::SE3d::exp(increment) * relativePose;
+
+                    if (increment.norm() < thresholdIncrementNorm) {
+                        break;
+                    }
+                }
+            }
+
+            if (converged) {
+                initTransformationSE3 = SE3(relativePose);
+            }
+        }
+
+        std::chrono::high_resolution_clock::time_point timeEndRefinement = timerGetClockTimeNow();
+        durationSeconds = std::chrono::duration_cast<std::chrono::duration<double>>(
+                timeEndRefinement - timeStartRefinement).count();
+
+        return converged;
+    }
+}
@@ -5,6 +5,7 @@
 
 #include "relativePoseRefinement/RefinerRelativePoseCreator.h"
 #include "relativePoseRefinement/ICPCUDA.h"
+#include "relativePoseRefinement/RefinerDenseRGBD.h"
 
 namespace gdr {
 
@@ -13,8 +14,10 @@ namespace gdr {
 
         if (refinerType == RefinerType::ICPCUDA) {
 
+        } else if (refinerType == RefinerType::DENSE_RGBD_CPU) {
+            return std::make_unique<RefinerDenseRGBD>();
         } else {
-            std::cout << " only ICPCUDA version can be used right now" << std::endl;
+            std::cout << " only ICPCUDA and DENSE_RGBD_CPU versions can be used right now" << std::endl;
         }
 
         return std::make_unique<ICPCUDA>();
@@ -3,9 +3,12 @@
 // Licensed under the MIT license. See LICENSE file in the project root for details.
 //
 
+#include <algorithm>
+
 #include "boost/filesystem.hpp"
 
 #include "sparsePointCloud/CloudProjectorStl.h"
+#include "imageCache/DecodedImageCache.h"
 #include "keyPoints/KeyPoint2DAndDepth.h"
 
 
@@ -153,6 +156,17 @@ namespace gdr {
         int numberOfIterationsRansacPerPoint = 15;
         std::vector<Point3d> optimalPointCoordinates(indexedPoints);
 
+        bool defaultNoiseModels = hasDefaultNoiseModels();
+        auto getNumberOfInlierObservations = [this, defaultNoiseModels](int indexPoint,
+                                                                        const Eigen::Vector3d &pointGuess) {
+            if (defaultNoiseModels) {
+                return static_cast<int>(getPoseNumbersOfInlierObservations<NoiseModelReprojectionLinearInScale,
+                        NoiseModelDepthQuadratic>(indexPoint, pointGuess).size());
+            }
+            return static_cast<int>(getPoseNumbersOfInlierObservations<NoiseModelFunction,
+                    NoiseModelFunction>(indexPoint, pointGuess).size());
+        };
+
         for (int i = 0; i < computedCoordinatesByPointIndex.size(); ++i) {
 
             int numberOfInlierObservationsMax = 0;
@@ -175,9 +189,7 @@ namespace gdr {
 
                 if (iterationPointRansac == -1) {
 
-                    currentNumberOfInlierObservations =
-                            getPoseNumbersOfInlierObservations(i,
-                                                               pointGuessL2).size();
+                    currentNumberOfInlierObservations = getNumberOfInlierObservations(i, pointGuessL2);
 
                     if (currentNumberOfInlierObservations > numberOfInlierObservationsMax) {
                         //L2 solution is already set in optimalPointCoordinates, only need to update inlier counter
@@ -185,8 +197,7 @@ namespace gdr {
                     }
 
                 } else {
-                    currentNumberOfInlierObservations = getPoseNumbersOfInlierObservations(i,
-                                                                                           pointGuess).size();
+                    currentNumberOfInlierObservations = getNumberOfInlierObservations(i, pointGuess);
 
                     //counter being equal to 1 means point is probably an outlier, keep L2 solution
                     if (currentNumberOfInlierObservations > numberOfInlierObservationsMax
@@ -228,7 +239,9 @@ namespace gdr {
                 keyPointsRealAndComputedByImageIndex(getPoseNumber());
 
         for (int poseIndexComponent = 0; poseIndexComponent < getPoseNumber(); ++poseIndexComponent) {
-            cv::Mat imageNoKeyPoints = cv::imread(poses[poseIndexComponent].getPathRGB(), cv::IMREAD_COLOR);
+            cv::Mat imageNoKeyPoints = DecodedImageCache::getInstance().getImage(
+                    poses[poseIndexComponent].getPathRGB(),
+                    DecodedImageCache::ImageType::COLOR).clone();
             imagesToShowKeyPoints.emplace_back(imageNoKeyPoints);
         }
 
@@ -389,6 +402,14 @@ namespace gdr {
         keyPointInfoByPose = std::vector<std::unordered_map<int, KeyPointInfo>>(cameraPoses.size());
     }
 
+    bool CloudProjectorStl::hasDefaultNoiseModels() const {
+        return std::all_of(poses.begin(), poses.end(),
+                           [](const ProjectableInfo &pose) {
+                               return pose.getCamera().getMeasurementErrorDeviationEstimators().hasDefaultNoiseModels();
+                           });
+    }
+
+    template<class NoiseModelReprojection, class NoiseModelDepth>
     std::vector<int> CloudProjectorStl::getPoseNumbersOfInlierObservations(int indexPoint,
                                                                            const Eigen::Vector3d &pointCoordinatesGuess) const {
 
@@ -415,18 +436,14 @@ namespace gdr {
 
             const auto &measurementEstimators = cameraRgbd
                     .getMeasurementErrorDeviationEstimators();
-            double reprojectionParameter = measurementEstimators.getParameterNoiseModelReprojection();
-            double depthParameter = measurementEstimators.getParameterNoiseModelDepth();
-
-            double thresholdInlierReprojection = measurementEstimators
-                                                         .getDividerReprojectionEstimator()(
-                                                                 keyPointInfo.getScale(),
-                                                                 reprojectionParameter) * sigmaMultiplierReprojection;
-
-            double thresholdInlierDepth = measurementEstimators
-                                                  .getDividerDepthErrorEstimator()(
-                                                          keyPointInfo.getDepth(),
-                                                          depthParameter) * sigmaMultiplierDepth;
+
+            double thresholdInlierReprojection =
+                    measurementEstimators.getDeviationReprojection<NoiseModelReprojection>(keyPointInfo.getScale())
+                    * sigmaMultiplierReprojection;
+
+            double thresholdInlierDepth =
+                    measurementEstimators.getDeviationDepth<NoiseModelDepth>(keyPointInfo.getDepth())
+                    * sigmaMultiplierDepth;
 
             if (errorXyNorm < thresholdInlierReprojection &&
                 errorDepthNorm < thresholdInlierDepth) {
@@ -4,6 +4,7 @@
 //
 
 #include "visualization/2D/ImageDrawer.h"
+#include "imageCache/DecodedImageCache.h"
 
 #include <opencv2/opencv.hpp>
 
@@ -13,10 +14,12 @@ namespace gdr {
     int ImageDrawer::showKeyPointOnImage(const std::string &pathToRGBImage, const KeyPointInfo &keyPointInfo,
                                          int pointIndex, std::string pathToSave, std::string nameToSave) {
 
-        cv::Mat imageNoKeyPoint = cv::imread(pathToRGBImage, cv::IMREAD_COLOR);
+        cv::Mat imageNoKeyPoint = DecodedImageCache::getInstance().getImage(pathToRGBImage,
+                                                                            DecodedImageCache::ImageType::COLOR);
         cv::KeyPoint keyPointToShow(keyPointInfo.getX(), keyPointInfo.getY(), keyPointInfo.getScale());
 
-        cv::Mat imageWithKeyPoint = cv::imread(pathToRGBImage, cv::IMREAD_COLOR);
+        // cached image is shared and must not be drawn on
+        cv::Mat imageWithKeyPoint = imageNoKeyPoint.clone();
         cv::drawKeypoints(imageNoKeyPoint, {keyPointToShow}, imageWithKeyPoint);
 
         cv::imshow("Showing " + pathToRGBImage + " " + std::to_string(pointIndex), imageWithKeyPoint);
@@ -34,11 +37,13 @@ namespace gdr {
                                           std::string pathToSave,
                                           std::string nameToSave) {
 
-        cv::Mat imageNoKeyPoint = cv::imread(pathToRGBImage, cv::IMREAD_COLOR);
+        cv::Mat imageNoKeyPoint = DecodedImageCache::getInstance().getImage(pathToRGBImage,
+                                                                            DecodedImageCache::ImageType::COLOR);
         std::vector<cv::KeyPoint> keyPointsToShow;
 
 
-        cv::Mat imageWithKeyPoint = cv::imread(pathToRGBImage, cv::IMREAD_COLOR);
+        // cached image is shared and must not be drawn on
+        cv::Mat imageWithKeyPoint = imageNoKeyPoint.clone();
 
         for (const auto &pairedIndexAndInfo: keyPointInfos) {
             const auto &keyPointInfo = pairedIndexAndInfo.second;
@@ -95,14 +100,16 @@ namespace gdr {
                                                   std::string pathToSave) {
 
         // first image with keypoints
-        cv::Mat imageNoKeyPointFirst = cv::imread(pathToRGBImageFirst, cv::IMREAD_COLOR);
+        cv::Mat imageNoKeyPointFirst = DecodedImageCache::getInstance().getImage(
+                pathToRGBImageFirst, DecodedImageCache::ImageType::COLOR);
         std::vector<cv::KeyPoint> keyPointsToShowFirst;
         for (const auto &keyPointInfo: keyPointInfosFirstImage) {
             cv::KeyPoint keyPointToShow(keyPointInfo.getX(), keyPointInfo.getY(), keyPointInfo.getScale());
             keyPointsToShowFirst.emplace_back(keyPointToShow);
         }
         // second image and keypoints
-        cv::Mat imageNoKeyPointSecond = cv::imread(pathToRGBImageSecond, cv::IMREAD_COLOR);
+        cv::Mat imageNoKeyPointSecond = DecodedImageCache::getInstance().getImage(
+                pathToRGBImageSecond, DecodedImageCache::ImageType::COLOR);
         std::vector<cv::KeyPoint> keyPointsToShowSecond;
         for (const auto &keyPointInfo: keyPointInfosSecondImage) {
             cv::KeyPoint keyPointToShow(keyPointInfo.getX(), keyPointInfo.getY(), keyPointInfo.getScale());
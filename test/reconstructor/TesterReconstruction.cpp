@@ -6,6 +6,8 @@
 #include "directoryTraversing/DirectoryReader.h"
 #include "TesterReconstruction.h"
 
+#include "imageCache/DecodedImageCache.h"
+#include "readerDataset/readerPacked/PackedDatasetReader.h"
 #include "readerDataset/readerTUM/ReaderTum.h"
 #include "boost/filesystem.hpp"
 
@@ -25,9 +27,14 @@ namespace test {
             bool showVisualization3D,
             bool savePointCloudPly,
             const std::vector<int> &gpuDevices,
-            bool printFullReport) {
+            bool printFullReport,
+            bool benchmarkPoseGraphOptimization,
+            bool filterRelativePoses,
+            size_t imageCacheMemoryBudgetBytes,
+            const gdr::RefinerRelativePoseCreator::RefinerType &refinerType) {
 
         ErrorsOfTrajectoryEstimation errorsOfTrajectoryEstimation;
+        gdr::DecodedImageCache::getInstance().setMemoryBudgetBytes(imageCacheMemoryBudgetBytes);
 
 
         std::cout << "Running test on " << pathRelativeToData << std::endl;
@@ -36,8 +43,22 @@ namespace test {
         const fs::path datasetPath(pathRelativeToData);
         std::string shortDatasetName = datasetPath.filename().string();
 
-        gdr::DatasetStructure datasetStructure = gdr::ReaderTUM::getDatasetStructure(datasetPath.string(),
-                                                                                     assocFile);
+        gdr::DatasetStructure datasetStructure;
+        std::vector<gdr::PoseFullInfo> posesGroundTruthAll;
+
+        if (fs::is_regular_file(datasetPath)) {
+            // packed container: images are read from mapped file through the decoded image cache
+            auto packedDataset = std::make_shared<const gdr::PackedDatasetReader>(datasetPath.string());
+            assert(packedDataset->isOpened());
+
+            gdr::DecodedImageCache::getInstance().addPackedDataset(packedDataset);
+            datasetStructure = packedDataset->getDatasetStructure();
+            posesGroundTruthAll = packedDataset->getGroundTruthPoses();
+        } else {
+            datasetStructure = gdr::ReaderTUM::getDatasetStructure(datasetPath.string(), assocFile);
+            posesGroundTruthAll = gdr::ReaderTUM::getPoseInfoTimeTranslationOrientation(
+                    gdr::DirectoryReader::appendPathSuffix(pathRelativeToData, "groundtruth.txt"));
+        }
         std::vector<std::unique_ptr<gdr::AbsolutePosesComputationHandler>> connectedComponentsPoseGraph;
         int numberOfPosesInDataset = 0;
 
@@ -47,6 +68,7 @@ namespace test {
                     gdr::DatasetDescriber(datasetStructure,
                                           cameraDefault),
                     paramsRansac);
+            cgHandler.setRefinerType(refinerType);
 
             if (printToConsole) {
                 std::cout << "start computing relative poses" << std::endl;
@@ -76,6 +98,15 @@ namespace test {
         auto &biggestComponent = connectedComponentsPoseGraph[0];
         biggestComponent->setRelativePosesFilePath("relativeRotationsFile_0.txt");
 
+        if (filterRelativePoses) {
+            // filtered graph is averaged below, filtering time is reported in benchmark info of the component
+            int numberOfEdgesRemoved = biggestComponent->filterInconsistentRelativePoses();
+
+            if (printToConsole) {
+                std::cout << "removed " << numberOfEdgesRemoved << " inconsistent relative poses" << std::endl;
+            }
+        }
+
         const auto &poseFixed = biggestComponent->getVertices()[biggestComponent->getIndexFixedPose()];
 
         if (printToConsole) {
@@ -112,6 +143,38 @@ namespace test {
             posesIRLS << biggestComponent->getPosesForEvaluation();
         }
 
+        int indexFixedPose = biggestComponent->getIndexFixedPose();
+
+        std::vector<double> timestampsToFind = biggestComponent->getPosesTimestamps();
+
+        std::vector<gdr::PoseFullInfo> posesFullInfoPGO;
+
+        if (benchmarkPoseGraphOptimization) {
+            if (printToConsole) {
+                std::cout << "perform pose graph optimization" << std::endl;
+            }
+
+            // poses of the component are not updated: BA below starts from IRLS poses as without PGO
+            std::vector<gdr::SE3> poseGraphOptimizedPoses =
+                    biggestComponent->performPoseGraphOptimization(false);
+
+            for (int i = 0; i < poseGraphOptimizedPoses.size(); ++i) {
+                const auto &pose = poseGraphOptimizedPoses[i];
+                posesFullInfoPGO.emplace_back(gdr::PoseFullInfo(timestampsToFind[i], pose));
+            }
+
+            std::string outputNamePGO =
+                    gdr::DirectoryReader::appendPathSuffix(fullOutPath, outputShortFileNames.posesPGO);
+            std::ofstream posesPGO(outputNamePGO);
+
+            if (printToConsole) {
+                std::cout << "PGO poses written to: " << outputNamePGO << std::endl;
+            }
+
+            posesPGO << gdr::PosesForEvaluation(posesFullInfoPGO,
+                                                poseGraphOptimizedPoses[indexFixedPose].inverse());
+        }
+
         if (printToConsole) {
             std::cout << "perform Bundle Adjustment" << std::endl;
         }
@@ -132,14 +195,7 @@ namespace test {
             posesBA << biggestComponent->getPosesForEvaluation();
         }
 
-        std::string absolutePosesGroundTruth = gdr::DirectoryReader::appendPathSuffix(pathRelativeToData,
-                                                                                      "groundtruth.txt");
-        std::vector<gdr::PoseFullInfo> posesInfoFull = gdr::ReaderTUM::getPoseInfoTimeTranslationOrientation(
-                absolutePosesGroundTruth);
-
-        int indexFixedPose = biggestComponent->getIndexFixedPose();
-
-        std::vector<double> timestampsToFind = biggestComponent->getPosesTimestamps();
+        std::vector<gdr::PoseFullInfo> posesInfoFull = posesGroundTruthAll;
 
         //fill information needed for evaluation
         std::vector<gdr::PoseFullInfo> posesFullInfoIRLS;
@@ -158,6 +214,7 @@ namespace test {
         }
 
         assert(posesFullInfoBA.size() == posesFullInfoIRLS.size());
+        assert(!benchmarkPoseGraphOptimization || posesFullInfoPGO.size() == posesFullInfoIRLS.size());
         assert(!posesFullInfoIRLS.empty());
         assert(posesFullInfoIRLS.size() == timestampsToFind.size());
 
@@ -193,7 +250,7 @@ namespace test {
                     fixedPoseGroundTruth.inverse());
         }
 
-        gdr::Evaluator evaluator(absolutePosesGroundTruth);
+        gdr::Evaluator evaluator(posesGroundTruthAll);
 
 
         double meanErrorRotBA = 0;
@@ -240,6 +297,44 @@ namespace test {
                 std::cout << std::endl << std::endl;
             }
 
+            if (benchmarkPoseGraphOptimization) {
+                assert(!posesFullInfoPGO.empty());
+
+                {
+                    auto informationErrors = evaluator.evaluateTrajectory(posesFullInfoPGO,
+                                                                          biggestComponent->getIndexFixedPose(),
+                                                                          true);
+                    if (printFullReport) {
+                        std::cout << "========================PGO report[Umeyama ALIGNED]:========================="
+                                  << std::endl;
+                        std::cout << informationErrors << std::endl;
+                    }
+
+                    errorsOfTrajectoryEstimation.errorAlignedUmeyamaPGO = informationErrors;
+                }
+                if (printFullReport) {
+                    std::cout << "------------------------------------------------------------------------------------"
+                              << std::endl;
+                }
+
+                {
+                    auto informationErrors = evaluator.evaluateTrajectory(posesFullInfoPGO,
+                                                                          biggestComponent->getIndexFixedPose(),
+                                                                          false);
+                    if (printFullReport) {
+                        std::cout << "========================PGO report[Fixed Pose ALIGNED]:========================="
+                                  << std::endl;
+                        std::cout << informationErrors << std::endl;
+                    }
+
+                    errorsOfTrajectoryEstimation.errorPGO = informationErrors;
+                }
+
+                if (printFullReport) {
+                    std::cout << std::endl << std::endl;
+                }
+            }
+
             assert(!posesFullInfoIRLS.empty());
 
             {
@@ -25,13 +25,16 @@ namespace test {
     struct ErrorsOfTrajectoryEstimation {
         int numberOfPosesInDataset = 0;
         gdr::ErrorRotationTranslation errorIRLS;
+        gdr::ErrorRotationTranslation errorPGO;
         gdr::ErrorRotationTranslation errorBA;
         gdr::ErrorRotationTranslation errorAlignedUmeyamaIRLS;
+        gdr::ErrorRotationTranslation errorAlignedUmeyamaPGO;
         gdr::ErrorRotationTranslation errorAlignedUmeyamaBA;
     };
 
     struct OutputShortFileNames {
         std::string posesIRLS = "posesIRLS.txt";
+        std::string posesPGO = "posesPGO.txt";
         std::string posesBA = "posesBA.txt";
         std::string posesGroundTruth = "posesGT.txt";
     };
@@ -49,7 +52,12 @@ namespace test {
                 bool showVisualization3D = false,
                 bool savePointCloudPly = false,
                 const std::vector<int> &gpuDevices = {0},
-                bool printInfoReport = true);
+                bool printInfoReport = true,
+                bool benchmarkPoseGraphOptimization = false,
+                bool filterRelativePoses = false,
+                size_t imageCacheMemoryBudgetBytes = static_cast<size_t>(1) << 30,
+                const gdr::RefinerRelativePoseCreator::RefinerType &refinerType =
+                        gdr::RefinerRelativePoseCreator::RefinerType::ICPCUDA);
     };
 }
 
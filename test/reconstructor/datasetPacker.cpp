@@ -0,0 +1,53 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#include <iostream>
+#include "readerDataset/readerPacked/PackedDatasetWriter.h"
+
+int main(int argc, char* argv[]) {
+
+    std::cout << "input args format: [path Dataset] [pathOutContainer] [fx] [fy] [cx] [cy] [depthDivider], "
+    << "optionally: [assocShortFilename] [raw|png]" << std::endl;
+    std::cout << "your args is " << argc << std::endl;
+    assert(argc >= 8 && argc <= 10);
+
+    std::string pathDatasetRoot(argv[1]);
+    std::string pathOutContainer(argv[2]);
+
+    double fx = std::stod(std::string(argv[3]));
+    double fy = std::stod(std::string(argv[4]));
+    double cx = std::stod(std::string(argv[5]));
+    double cy = std::stod(std::string(argv[6]));
+    double depthDivider = std::stod(std::string(argv[7]));
+
+    std::string assocShortFilename;
+    gdr::PackedFrameEncoding frameEncoding = gdr::PackedFrameEncoding::PNG;
+
+    if (argc > 8) {
+        assocShortFilename = std::string(argv[8]);
+    }
+    if (argc > 9) {
+        std::string encoding(argv[9]);
+        assert(encoding == "raw" || encoding == "png");
+
+        if (encoding == "raw") {
+            frameEncoding = gdr::PackedFrameEncoding::RAW;
+        }
+    }
+
+    gdr::CameraRGBD camera(fx, cx, fy, cy);
+    camera.setDepthPixelDivider(depthDivider);
+
+    bool written = gdr::PackedDatasetWriter::convertTUM(pathDatasetRoot,
+                                                        assocShortFilename,
+                                                        camera,
+                                                        pathOutContainer,
+                                                        frameEncoding);
+
+    std::cout << (written ? "container written to " : "failed to write container ")
+              << pathOutContainer << std::endl;
+
+    return written ? 0 : 1;
+}
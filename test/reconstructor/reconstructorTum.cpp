@@ -9,9 +9,9 @@
 int main(int argc, char* argv[]) {
 
     std::cout << "input args format: [path Dataset] [pathOutPoses] [fx] [fy] [cx] [cy] [depthDivider], " <<
-                 "optionally: [fileOutIRLS] [fileOutBA] [fileOutGT] : [GPU index]" << std::endl;
+                 "optionally: [fileOutIRLS] [fileOutBA] [fileOutGT] : [GPU index] : [image cache budget MB] : [refiner icp|dense]" << std::endl;
     std::cout << "your args is " << argc << std::endl;
-    assert(argc == 8 || argc == 11 || argc == 12);
+    assert(argc == 8 || argc == 11 || argc == 12 || argc == 13 || argc == 14);
 
     std::string pathDatasetRoot(argv[1]);
     std::string pathOutPoses(argv[2]);
@@ -31,6 +31,27 @@ int main(int argc, char* argv[]) {
     }
     std::cout << "using " << gpuIndex << " gpu" << std::endl;
 
+    size_t imageCacheMemoryBudgetBytes = static_cast<size_t>(1) << 30;
+
+    if (argc >= 13) {
+        imageCacheMemoryBudgetBytes = std::stoull(std::string(argv[12])) << 20;
+    }
+    std::cout << "decoded image cache budget: " << (imageCacheMemoryBudgetBytes >> 20) << " MB" << std::endl;
+
+    auto refinerType = gdr::RefinerRelativePoseCreator::RefinerType::ICPCUDA;
+
+    if (argc >= 14) {
+        std::string refinerName(argv[13]);
+        assert(refinerName == "icp" || refinerName == "dense");
+
+        if (refinerName == "dense") {
+            refinerType = gdr::RefinerRelativePoseCreator::RefinerType::DENSE_RGBD_CPU;
+        }
+    }
+    std::cout << "relative pose refiner: "
+              << (refinerType == gdr::RefinerRelativePoseCreator::RefinerType::ICPCUDA ? "ICP CUDA" : "dense RGB-D CPU")
+              << std::endl;
+
     for (int i = 3; i < 7; ++i) {
         intrinsics.emplace_back(std::stod(std::string(argv[i])));
     }
@@ -80,6 +101,10 @@ int main(int argc, char* argv[]) {
                                                    false,
                                                    false,
                                                    {gpuIndex},
-                                                   true);
+                                                   true,
+                                                   false,
+                                                   false,
+                                                   imageCacheMemoryBudgetBytes,
+                                                   refinerType);
     return 0;
 }
\ No newline at end of file
@@ -7,8 +7,22 @@
 #include <gtest/gtest.h>
 #include <vector>
 #include <chrono>
+#include <memory>
+#include <random>
+#include <set>
+#include <thread>
+#include <tuple>
 
 #include "computationHandlers/RelativePosesComputationHandler.h"
+#include "bundleAdjustment/ReprojectionDepthResidual.h"
+#include "bundleAdjustment/InverseDepthResidual.h"
+#include "bundleAdjustment/AnchorInverseDepthResidual.h"
+#include "bundleAdjustment/PointToPointResidual.h"
+#include "bundleAdjustment/PoseOnlyAdjuster.h"
+#include "bundleAdjustment/BundleAdjusterCreator.h"
+#include "bundleAdjustment/LinearSolverSelector.h"
+#include "bundleAdjustment/BundleDepthAdjuster.h"
+#include "bundleAdjustment/LandmarkSelector.h"
 
 #include "poseGraph/PosesForEvaluation.h"
 #include "reconstructor/TesterReconstruction.h"
@@ -53,6 +67,878 @@ TEST(testBAOptimized, visualizationDesk98) {
 
 }
 
+/** Compare analytic jacobians of cost function with central differences
+ *
+ * @param costFunction cost function with analytic jacobians
+ * @param parameters values of all parameter blocks stored sequentially
+ * @param blockSizes sizes of parameter blocks in the order of cost function
+ */
+void checkJacobiansNumerically(const ceres::CostFunction &costFunction,
+                               const std::vector<double> &parameters,
+                               const std::vector<int> &blockSizes) {
+
+    int numberOfResiduals = costFunction.num_residuals();
+    std::vector<int> blockStarts = {0};
+    for (int blockSize: blockSizes) {
+        blockStarts.emplace_back(blockStarts.back() + blockSize);
+    }
+    ASSERT_EQ(blockStarts.back(), parameters.size());
+
+    auto getBlocks = [&blockSizes, &blockStarts](const std::vector<double> &parametersOfBlocks) {
+        std::vector<const double *> blocks;
+        for (int block = 0; block < blockSizes.size(); ++block) {
+            blocks.emplace_back(&parametersOfBlocks[blockStarts[block]]);
+        }
+        return blocks;
+    };
+
+    // jacobians are stored row-major with blockSizes[block] columns
+    std::vector<std::vector<double>> jacobians;
+    std::vector<double *> jacobiansRaw;
+    for (int blockSize: blockSizes) {
+        jacobians.emplace_back(std::vector<double>(numberOfResiduals * blockSize));
+        jacobiansRaw.emplace_back(jacobians.back().data());
+    }
+
+    Eigen::VectorXd residuals(numberOfResiduals);
+    ASSERT_TRUE(costFunction.Evaluate(getBlocks(parameters).data(), residuals.data(), jacobiansRaw.data()));
+
+    double step = 1e-6;
+
+    for (int block = 0; block < blockSizes.size(); ++block) {
+        Eigen::Map<Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>> jacobianAnalytic(
+                jacobiansRaw[block], numberOfResiduals, blockSizes[block]);
+
+        for (int coordinate = 0; coordinate < blockSizes[block]; ++coordinate) {
+            std::vector<double> parametersPlus = parameters;
+            std::vector<double> parametersMinus = parameters;
+            parametersPlus[blockStarts[block] + coordinate] += step;
+            parametersMinus[blockStarts[block] + coordinate] -= step;
+
+            Eigen::VectorXd residualsPlus(numberOfResiduals);
+            Eigen::VectorXd residualsMinus(numberOfResiduals);
+            ASSERT_TRUE(costFunction.Evaluate(getBlocks(parametersPlus).data(), residualsPlus.data(), nullptr));
+            ASSERT_TRUE(costFunction.Evaluate(getBlocks(parametersMinus).data(), residualsMinus.data(), nullptr));
+
+            Eigen::VectorXd columnNumeric = (residualsPlus - residualsMinus) / (2.0 * step);
+
+            ASSERT_LE((jacobianAnalytic.col(coordinate) - columnNumeric).norm(),
+                      1e-5 * (1.0 + columnNumeric.norm()))
+                                        << "block " << block << ", coordinate " << coordinate;
+        }
+    }
+}
+
+TEST(testBAOptimized, ReprojectionDepthResidualAnalyticJacobiansMatchNumeric) {
+
+    gdr::CameraRGBD kinectCamera(517.3, 318.6, 516.5, 255.3);
+
+    std::mt19937 randomNumberGenerator(3);
+    std::uniform_real_distribution<> uniform(-1.0, 1.0);
+
+    for (int iteration = 0; iteration < 100; ++iteration) {
+        std::unique_ptr<ceres::CostFunction> costFunction(gdr::ReprojectionDepthResidual::Create(
+                300.0, 200.0, 2.5, kinectCamera, 1.3, 0.02));
+
+        // point, translation and orientation (qx, qy, qz, qw) are stored sequentially
+        std::vector<double> parameters = {uniform(randomNumberGenerator), uniform(randomNumberGenerator),
+                                          3.0 + uniform(randomNumberGenerator),
+                                          0.1 * uniform(randomNumberGenerator), 0.1 * uniform(randomNumberGenerator),
+                                          0.1 * uniform(randomNumberGenerator)};
+        Eigen::Quaterniond orientation(gdr::SO3::getRandomUnitQuaternion());
+        orientation = Eigen::Quaterniond::Identity().slerp(0.1, orientation);
+        for (int i = 0; i < 4; ++i) {
+            parameters.emplace_back(orientation.coeffs()[i]);
+        }
+
+        ASSERT_NO_FATAL_FAILURE(checkJacobiansNumerically(*costFunction, parameters, {3, 3, 4}));
+    }
+}
+
+TEST(testBAOptimized, InverseDepthResidualAnalyticJacobiansMatchNumeric) {
+
+    gdr::CameraRGBD kinectCamera(517.3, 318.6, 516.5, 255.3);
+    gdr::CameraRGBD structureIoCamera(583, 320, 583, 240);
+
+    std::mt19937 randomNumberGenerator(4);
+    std::uniform_real_distribution<> uniform(-1.0, 1.0);
+
+    auto getRandomOrientation = [&]() {
+        Eigen::Quaterniond orientation(gdr::SO3::getRandomUnitQuaternion());
+        return Eigen::Quaterniond::Identity().slerp(0.1, orientation);
+    };
+
+    for (int iteration = 0; iteration < 100; ++iteration) {
+        std::unique_ptr<ceres::CostFunction> costFunction(gdr::InverseDepthResidual::Create(
+                250.0, 280.0, structureIoCamera,
+                300.0, 200.0, 2.5, kinectCamera, 1.3, 0.02));
+        std::unique_ptr<ceres::CostFunction> costFunctionAnchor(gdr::AnchorInverseDepthResidual::Create(
+                2.5, 0.02));
+
+        // inverse depth, anchor translation and orientation (qx, qy, qz, qw),
+        // observing translation and orientation are stored sequentially
+        std::vector<double> parameters = {1.0 / (3.0 + uniform(randomNumberGenerator))};
+        for (int pose = 0; pose < 2; ++pose) {
+            for (int i = 0; i < 3; ++i) {
+                parameters.emplace_back(0.1 * uniform(randomNumberGenerator));
+            }
+            Eigen::Quaterniond orientation = getRandomOrientation();
+            for (int i = 0; i < 4; ++i) {
+                parameters.emplace_back(orientation.coeffs()[i]);
+            }
+        }
+
+        ASSERT_NO_FATAL_FAILURE(checkJacobiansNumerically(*costFunction, parameters, {1, 3, 4, 3, 4}));
+        ASSERT_NO_FATAL_FAILURE(checkJacobiansNumerically(*costFunctionAnchor, {parameters[0]}, {1}));
+    }
+}
+
+TEST(testBAOptimized, PointToPointResidualAnalyticJacobiansMatchNumeric) {
+
+    std::mt19937 randomNumberGenerator(6);
+    std::uniform_real_distribution<> uniform(-1.0, 1.0);
+
+    for (int iteration = 0; iteration < 100; ++iteration) {
+        Eigen::Vector3d pointFrom(uniform(randomNumberGenerator), uniform(randomNumberGenerator),
+                                  3.0 + uniform(randomNumberGenerator));
+        Eigen::Vector3d pointTo(uniform(randomNumberGenerator), uniform(randomNumberGenerator),
+                                3.0 + uniform(randomNumberGenerator));
+        std::unique_ptr<ceres::CostFunction> costFunction(gdr::PointToPointResidual::Create(
+                pointFrom, pointTo, 0.03));
+
+        // translation and orientation (qx, qy, qz, qw) of both poses are stored sequentially
+        std::vector<double> parameters;
+        for (int pose = 0; pose < 2; ++pose) {
+            for (int i = 0; i < 3; ++i) {
+                parameters.emplace_back(uniform(randomNumberGenerator));
+            }
+            Eigen::Quaterniond orientation(gdr::SO3::getRandomUnitQuaternion());
+            for (int i = 0; i < 4; ++i) {
+                parameters.emplace_back(orientation.coeffs()[i]);
+            }
+        }
+
+        ASSERT_NO_FATAL_FAILURE(checkJacobiansNumerically(*costFunction, parameters, {3, 4, 3, 4}));
+    }
+}
+
+TEST(testBAOptimized, NoiseModelPoliciesMatchDefaultFunctions) {
+
+    gdr::MeasurementErrorDeviationEstimators estimatorsDefault;
+    ASSERT_TRUE(estimatorsDefault.hasDefaultNoiseModels());
+
+    const auto &dividerReprojection = estimatorsDefault.getDividerReprojectionEstimator();
+    const auto &dividerDepth = estimatorsDefault.getDividerDepthErrorEstimator();
+
+    for (double value = 0.25; value < 8.0; value += 0.25) {
+        double deviationReprojection = dividerReprojection(
+                value, estimatorsDefault.getParameterNoiseModelReprojection());
+        double deviationDepth = dividerDepth(value, estimatorsDefault.getParameterNoiseModelDepth());
+
+        ASSERT_DOUBLE_EQ(estimatorsDefault.getDeviationReprojection<gdr::NoiseModelReprojectionLinearInScale>(value),
+                         deviationReprojection);
+        ASSERT_DOUBLE_EQ(estimatorsDefault.getDeviationReprojection(value), deviationReprojection);
+        ASSERT_DOUBLE_EQ(estimatorsDefault.getDeviationDepth<gdr::NoiseModelDepthQuadratic>(value), deviationDepth);
+        ASSERT_DOUBLE_EQ(estimatorsDefault.getDeviationDepth(value), deviationDepth);
+    }
+
+    // custom models are evaluated through std::function fallback
+    gdr::MeasurementErrorDeviationEstimators estimatorsCustom(
+            [](double scale, double parameter) { return parameter * std::sqrt(scale); },
+            [](double depth, double parameter) { return parameter * depth; });
+    ASSERT_FALSE(estimatorsCustom.hasDefaultNoiseModels());
+
+    ASSERT_DOUBLE_EQ(estimatorsCustom.getDeviationReprojection(4.0),
+                     2.0 * estimatorsCustom.getParameterNoiseModelReprojection());
+    ASSERT_DOUBLE_EQ(estimatorsCustom.getDeviationDepth(2.0),
+                     2.0 * estimatorsCustom.getParameterNoiseModelDepth());
+}
+
+TEST(testBAOptimized, LinearSolverSelectedByProblemSize) {
+
+    using gdr::LinearSolverSelector;
+
+    // each pose observes 1000 points
+    auto getSelection = [](int numberOfPoses, int numberOfPoints, bool isClusterAvailable) {
+        return LinearSolverSelector::getLinearSolverAndPreconditioner(numberOfPoses, numberOfPoints,
+                                                                      1000 * numberOfPoses,
+                                                                      isClusterAvailable);
+    };
+
+    ASSERT_EQ(getSelection(30, 5000, true).first, ceres::DENSE_SCHUR);
+    ASSERT_EQ(getSelection(200, 3000, true).first, ceres::DENSE_SCHUR);
+    ASSERT_EQ(getSelection(200, 50000, true).first, ceres::SPARSE_SCHUR);
+    ASSERT_EQ(getSelection(1000, 100000, true).first, ceres::SPARSE_SCHUR);
+
+    auto largeSparseVisibility = getSelection(5000, 500000, true);
+    ASSERT_EQ(largeSparseVisibility.first, ceres::ITERATIVE_SCHUR);
+    ASSERT_EQ(largeSparseVisibility.second, ceres::CLUSTER_JACOBI);
+
+    auto largeNoSuiteSparse = getSelection(5000, 500000, false);
+    ASSERT_EQ(largeNoSuiteSparse.first, ceres::ITERATIVE_SCHUR);
+    ASSERT_EQ(largeNoSuiteSparse.second, ceres::SCHUR_JACOBI);
+
+    auto largeDenseVisibility = getSelection(5000, 10000, true);
+    ASSERT_EQ(largeDenseVisibility.first, ceres::ITERATIVE_SCHUR);
+    ASSERT_EQ(largeDenseVisibility.second, ceres::SCHUR_JACOBI);
+}
+
+/** Poses moving along a line and looking at a box of points, observations are exact,
+ *      all poses except the first one and all points are perturbed by up to 1 cm */
+struct SyntheticSceneBA {
+    std::vector<gdr::SE3> posesGroundTruth;
+    std::vector<std::pair<gdr::SE3, gdr::CameraRGBD>> posesPerturbed;
+    std::vector<gdr::Point3d> pointsPerturbed;
+    std::vector<std::unordered_map<int, gdr::KeyPointInfo>> keyPointInfos;
+};
+
+SyntheticSceneBA getSyntheticSceneBA(int numberOfPoses, int numberOfPoints, int seed, int indexUnperturbed = 0) {
+
+    gdr::CameraRGBD kinectCamera(517.3, 318.6, 516.5, 255.3);
+
+    std::mt19937 randomNumberGenerator(seed);
+    std::uniform_real_distribution<> uniform(-1.0, 1.0);
+
+    SyntheticSceneBA scene;
+
+    for (int poseIndex = 0; poseIndex < numberOfPoses; ++poseIndex) {
+        Eigen::Quaterniond orientation(Eigen::AngleAxisd(0.01 * poseIndex, Eigen::Vector3d::UnitY()));
+        scene.posesGroundTruth.emplace_back(gdr::SE3(orientation, Eigen::Vector3d(0.05 * poseIndex, 0.0, 0.0)));
+    }
+
+    std::vector<gdr::Point3d> pointsGroundTruth;
+    for (int pointIndex = 0; pointIndex < numberOfPoints; ++pointIndex) {
+        pointsGroundTruth.emplace_back(gdr::Point3d(1.0 + 2.5 * uniform(randomNumberGenerator),
+                                                    0.8 * uniform(randomNumberGenerator),
+                                                    3.0 + uniform(randomNumberGenerator),
+                                                    pointIndex));
+    }
+
+    scene.keyPointInfos.resize(numberOfPoses);
+
+    for (int poseIndex = 0; poseIndex < numberOfPoses; ++poseIndex) {
+        gdr::SE3 poseWorldToCamera = scene.posesGroundTruth[poseIndex].inverse();
+
+        for (int pointIndex = 0; pointIndex < numberOfPoints; ++pointIndex) {
+            Eigen::Vector3d pointCamera =
+                    poseWorldToCamera.getSE3() * pointsGroundTruth[pointIndex].getEigenVector3dPointXYZ();
+            Eigen::Vector2d projected = kinectCamera.projectUsingIntrinsics<double>(pointCamera);
+
+            if (projected[0] > 10 && projected[0] < 630 && projected[1] > 10 && projected[1] < 470) {
+                gdr::KeyPoint2DAndDepth keyPoint(projected[0], projected[1], 1.0, 0.0);
+                keyPoint.setDepth(pointCamera[2]);
+                scene.keyPointInfos[poseIndex][pointIndex] = gdr::KeyPointInfo(keyPoint, poseIndex);
+            }
+        }
+    }
+
+    for (int poseIndex = 0; poseIndex < numberOfPoses; ++poseIndex) {
+        const auto &pose = scene.posesGroundTruth[poseIndex];
+        Eigen::Vector3d translationNoise = (poseIndex == indexUnperturbed) ? Eigen::Vector3d::Zero() :
+                                           Eigen::Vector3d(0.01 * uniform(randomNumberGenerator),
+                                                           0.01 * uniform(randomNumberGenerator),
+                                                           0.01 * uniform(randomNumberGenerator));
+        scene.posesPerturbed.emplace_back(std::make_pair(gdr::SE3(pose.getRotationQuatd(),
+                                                                  pose.getTranslation() + translationNoise),
+                                                         kinectCamera));
+    }
+
+    for (const auto &point: pointsGroundTruth) {
+        Eigen::Vector3d pointNoise(0.01 * uniform(randomNumberGenerator),
+                                   0.01 * uniform(randomNumberGenerator),
+                                   0.01 * uniform(randomNumberGenerator));
+        scene.pointsPerturbed.emplace_back(gdr::Point3d(point.getEigenVector3dPointXYZ() + pointNoise,
+                                                        point.getIndex()));
+    }
+
+    return scene;
+}
+
+double getMeanTranslationError(const std::vector<gdr::SE3> &poses,
+                               const std::vector<gdr::SE3> &posesGroundTruth) {
+    assert(poses.size() == posesGroundTruth.size());
+    double sumError = 0;
+
+    for (int poseIndex = 0; poseIndex < poses.size(); ++poseIndex) {
+        sumError += (poses[poseIndex].getTranslation() - posesGroundTruth[poseIndex].getTranslation()).norm();
+    }
+
+    return sumError / poses.size();
+}
+
+std::vector<gdr::SE3> getPosesWithoutCameras(const std::vector<std::pair<gdr::SE3, gdr::CameraRGBD>> &poses) {
+    std::vector<gdr::SE3> posesSE3;
+    for (const auto &poseAndCamera: poses) {
+        posesSE3.emplace_back(poseAndCamera.first);
+    }
+    return posesSE3;
+}
+
+TEST(testBAOptimized, PartitionedBundleAdjustmentSynthetic40Poses) {
+
+    SyntheticSceneBA scene = getSyntheticSceneBA(40, 2000, 7);
+
+    gdr::BundleDepthAdjuster bundleAdjuster;
+    bundleAdjuster.setPartitioning(10);
+
+    bool success = false;
+    std::vector<gdr::SE3> posesOptimized = bundleAdjuster.optimizePointsAndPoses(scene.pointsPerturbed,
+                                                                                 scene.posesPerturbed,
+                                                                                 scene.keyPointInfos,
+                                                                                 0,
+                                                                                 success);
+    std::cout << bundleAdjuster.getSolverInfo() << std::endl;
+
+    ASSERT_TRUE(success);
+    ASSERT_EQ(posesOptimized.size(), scene.posesGroundTruth.size());
+
+    double errorBefore = getMeanTranslationError(getPosesWithoutCameras(scene.posesPerturbed),
+                                                 scene.posesGroundTruth);
+    double errorAfter = getMeanTranslationError(posesOptimized, scene.posesGroundTruth);
+
+    std::cout << "mean translation error before " << errorBefore << ", after " << errorAfter << std::endl;
+
+    ASSERT_LE(errorAfter, 0.5 * errorBefore);
+
+    // only the cluster with fixed pose has constant gauge, other clusters must not drift away
+    // while they are held by consensus on shared points
+    for (int poseIndex = 0; poseIndex < posesOptimized.size(); ++poseIndex) {
+        double errorPose = (posesOptimized[poseIndex].getTranslation()
+                            - scene.posesGroundTruth[poseIndex].getTranslation()).norm();
+        ASSERT_LE(errorPose, errorBefore) << "pose " << poseIndex;
+    }
+}
+
+TEST(testBAOptimized, OutlierRejectionRoundsSynthetic30PosesCorruptedDepth) {
+
+    SyntheticSceneBA scene = getSyntheticSceneBA(30, 1500, 5);
+
+    // every 20th observation gets depth error of 20-50 cm
+    int observationNumber = 0;
+    std::set<std::pair<int, int>> corruptedObservations;
+    for (int poseIndex = 0; poseIndex < scene.keyPointInfos.size(); ++poseIndex) {
+        for (auto &pointIndexAndInfo: scene.keyPointInfos[poseIndex]) {
+            if (observationNumber++ % 20 != 0) {
+                continue;
+            }
+            corruptedObservations.insert(std::make_pair(poseIndex, pointIndexAndInfo.first));
+            auto &keyPointInfo = pointIndexAndInfo.second;
+            gdr::KeyPoint2DAndDepth keyPoint(keyPointInfo.getX(), keyPointInfo.getY(), 1.0, 0.0);
+            keyPoint.setDepth(keyPointInfo.getDepth() + 0.2 + 0.3 * (observationNumber % 7) / 6.0);
+            keyPointInfo = gdr::KeyPointInfo(keyPoint, keyPointInfo.getObservingPoseNumber());
+        }
+    }
+
+    std::vector<double> errorsAfter;
+    std::vector<std::vector<std::pair<int, int>>> outlierObservations;
+
+    for (int maxRounds: {1, 4}) {
+        gdr::BundleDepthAdjuster bundleAdjuster;
+        bundleAdjuster.setOutlierRejection(maxRounds);
+
+        bool success = false;
+        std::vector<gdr::SE3> posesOptimized = bundleAdjuster.optimizePointsAndPoses(scene.pointsPerturbed,
+                                                                                     scene.posesPerturbed,
+                                                                                     scene.keyPointInfos,
+                                                                                     0,
+                                                                                     success);
+        std::cout << bundleAdjuster.getSolverInfo() << std::endl;
+        ASSERT_TRUE(success);
+
+        errorsAfter.emplace_back(getMeanTranslationError(posesOptimized, scene.posesGroundTruth));
+        outlierObservations.emplace_back(bundleAdjuster.getOutlierObservations());
+    }
+
+    std::cout << "mean translation error robust loss only " << errorsAfter[0]
+              << ", with outlier rejection " << errorsAfter[1]
+              << ", removed " << outlierObservations[1].size()
+              << " observations, corrupted " << corruptedObservations.size() << std::endl;
+
+    ASSERT_TRUE(outlierObservations[0].empty());
+
+    // all corrupted observations are removed and only few correct ones are lost
+    std::set<std::pair<int, int>> removedObservations(outlierObservations[1].begin(),
+                                                      outlierObservations[1].end());
+    for (const auto &corruptedObservation: corruptedObservations) {
+        ASSERT_EQ(removedObservations.count(corruptedObservation), 1)
+                                    << "pose " << corruptedObservation.first
+                                    << ", point " << corruptedObservation.second;
+    }
+    ASSERT_LE(removedObservations.size(), 2 * corruptedObservations.size());
+
+    ASSERT_LE(errorsAfter[1], 0.8 * errorsAfter[0]);
+}
+
+/** Reprojection residual of baseline formulation divided only by deviation of keypoint measurement,
+ *      robust scale is applied by Cauchy loss with sigma of reprojection errors */
+struct BaselineReprojectionResidual {
+
+    template<typename T>
+    bool operator()(const T *const point,
+                    const T *const translationWorldToCamera,
+                    const T *const orientationWorldToCamera,
+                    T *residuals) const {
+
+        Eigen::Map<const Eigen::Quaternion<T>> orientation(orientationWorldToCamera);
+        Eigen::Map<const Eigen::Matrix<T, 3, 1>> translation(translationWorldToCamera);
+        Eigen::Map<const Eigen::Matrix<T, 3, 1>> point3d(point);
+
+        Sophus::Vector<T, 2> projected =
+                camera.projectUsingIntrinsics<T>(Sophus::Vector<T, 3>(orientation * point3d + translation));
+
+        residuals[0] = (T(observedX) - projected[0]) / T(deviationDivider);
+        residuals[1] = (T(observedY) - projected[1]) / T(deviationDivider);
+
+        return true;
+    }
+
+    double observedX;
+    double observedY;
+    double deviationDivider;
+    gdr::CameraRGBD camera;
+};
+
+/** Depth residual of baseline formulation, see BaselineReprojectionResidual */
+struct BaselineDepthResidual {
+
+    template<typename T>
+    bool operator()(const T *const point,
+                    const T *const translationWorldToCamera,
+                    const T *const orientationWorldToCamera,
+                    T *residuals) const {
+
+        Eigen::Map<const Eigen::Quaternion<T>> orientation(orientationWorldToCamera);
+        Eigen::Map<const Eigen::Matrix<T, 3, 1>> translation(translationWorldToCamera);
+        Eigen::Map<const Eigen::Matrix<T, 3, 1>> point3d(point);
+
+        Eigen::Matrix<T, 3, 1> pointCamera = orientation * point3d + translation;
+        residuals[0] = (T(observedDepth) - pointCamera[2]) / T(deviationDivider);
+
+        return true;
+    }
+
+    double observedDepth;
+    double deviationDivider;
+};
+
+/** Optimize scene with separate reprojection and depth residuals and Cauchy(sigma) losses on them
+ *      as bundle adjustment did before residuals were fused and whitened,
+ *      sigmas are estimated by medians of initial normalized errors
+ *
+ * @returns optimized camera to world poses
+ */
+std::vector<gdr::SE3> optimizeWithBaselineRobustWeighting(const SyntheticSceneBA &scene,
+                                                          int indexFixed,
+                                                          int maxNumberIterations) {
+
+    int numberOfPoses = static_cast<int>(scene.posesPerturbed.size());
+
+    std::vector<double> pointsXYZ;
+    for (const auto &point: scene.pointsPerturbed) {
+        for (int i = 0; i < 3; ++i) {
+            pointsXYZ.emplace_back(point.getEigenVector3dPointXYZ()[i]);
+        }
+    }
+
+    std::vector<double> translationsWorldToCamera;
+    std::vector<double> orientationsWorldToCameraQxyzw;
+    for (const auto &poseAndCamera: scene.posesPerturbed) {
+        gdr::SE3 poseWorldToCamera = poseAndCamera.first.inverse();
+        Eigen::Vector3d translation = poseWorldToCamera.getTranslation();
+        Eigen::Quaterniond orientation = poseWorldToCamera.getRotationQuatd();
+        translationsWorldToCamera.insert(translationsWorldToCamera.end(), translation.data(), translation.data() + 3);
+        orientationsWorldToCameraQxyzw.insert(orientationsWorldToCameraQxyzw.end(),
+                                              orientation.coeffs().data(), orientation.coeffs().data() + 4);
+    }
+
+    // {pose index, point index, divider of reprojection error, divider of depth error} of each observation
+    std::vector<std::tuple<int, int, double, double>> observations;
+    std::vector<double> errorsNormalizedReprojection;
+    std::vector<double> errorsNormalizedDepth;
+
+    for (int poseIndex = 0; poseIndex < numberOfPoses; ++poseIndex) {
+        const auto &camera = scene.posesPerturbed[poseIndex].second;
+        const auto &estimators = camera.getMeasurementErrorDeviationEstimators();
+        gdr::SE3 poseWorldToCamera = scene.posesPerturbed[poseIndex].first.inverse();
+
+        for (const auto &pointIndexAndInfo: scene.keyPointInfos[poseIndex]) {
+            int pointIndex = pointIndexAndInfo.first;
+            const auto &keyPointInfo = pointIndexAndInfo.second;
+
+            double dividerReprojection = estimators.getDividerReprojectionEstimator()(
+                    keyPointInfo.getScale(), estimators.getParameterNoiseModelReprojection());
+            double dividerDepth = estimators.getDividerDepthErrorEstimator()(
+                    keyPointInfo.getDepth(), estimators.getParameterNoiseModelDepth());
+            observations.emplace_back(std::make_tuple(poseIndex, pointIndex, dividerReprojection, dividerDepth));
+
+            Eigen::Vector3d pointCamera = poseWorldToCamera.getSE3()
+                                          * scene.pointsPerturbed[pointIndex].getEigenVector3dPointXYZ();
+            Eigen::Vector2d projected = camera.projectUsingIntrinsics<double>(pointCamera);
+            errorsNormalizedReprojection.emplace_back(
+                    (Eigen::Vector2d(keyPointInfo.getX(), keyPointInfo.getY()) - projected).norm()
+                    / dividerReprojection);
+            errorsNormalizedDepth.emplace_back(std::abs(keyPointInfo.getDepth() - pointCamera[2]) / dividerDepth);
+        }
+    }
+
+    double sigmaReprojection = 1.4826 * gdr::RobustEstimators::getQuantile(errorsNormalizedReprojection);
+    double sigmaDepth = 1.4826 * gdr::RobustEstimators::getQuantile(errorsNormalizedDepth);
+
+    ceres::CauchyLoss lossReprojection(sigmaReprojection);
+    ceres::CauchyLoss lossDepth(sigmaDepth);
+
+    ceres::Problem::Options problemOptions;
+    problemOptions.loss_function_ownership = ceres::DO_NOT_TAKE_OWNERSHIP;
+    ceres::Problem problem(problemOptions);
+
+    for (const auto &observation: observations) {
+        int poseIndex = std::get<0>(observation);
+        int pointIndex = std::get<1>(observation);
+        const auto &keyPointInfo = scene.keyPointInfos[poseIndex].at(pointIndex);
+
+        double *point = &pointsXYZ[3 * pointIndex];
+        double *translation = &translationsWorldToCamera[3 * poseIndex];
+        double *orientation = &orientationsWorldToCameraQxyzw[4 * poseIndex];
+
+        problem.AddResidualBlock(
+                new ceres::AutoDiffCostFunction<BaselineReprojectionResidual, 2, 3, 3, 4>(
+                        new BaselineReprojectionResidual{keyPointInfo.getX(),
+                                                         keyPointInfo.getY(),
+                                                         std::get<2>(observation),
+                                                         scene.posesPerturbed[poseIndex].second}),
+                &lossReprojection,
+                point, translation, orientation);
+        problem.AddResidualBlock(
+                new ceres::AutoDiffCostFunction<BaselineDepthResidual, 1, 3, 3, 4>(
+                        new BaselineDepthResidual{keyPointInfo.getDepth(),
+                                                  std::get<3>(observation)}),
+                &lossDepth,
+                point, translation, orientation);
+    }
+
+    for (int poseIndex = 0; poseIndex < numberOfPoses; ++poseIndex) {
+        problem.SetParameterization(&orientationsWorldToCameraQxyzw[4 * poseIndex],
+                                    new ceres::EigenQuaternionParameterization);
+    }
+    problem.SetParameterBlockConstant(&translationsWorldToCamera[3 * indexFixed]);
+    problem.SetParameterBlockConstant(&orientationsWorldToCameraQxyzw[4 * indexFixed]);
+
+    ceres::Solver::Options options;
+    options.linear_solver_type = ceres::SPARSE_SCHUR;
+    options.max_num_iterations = maxNumberIterations;
+    options.num_threads = static_cast<int>(std::thread::hardware_concurrency());
+
+    ceres::Solver::Summary summary;
+    ceres::Solve(options, &problem, &summary);
+    assert(summary.IsSolutionUsable());
+
+    std::vector<gdr::SE3> posesOptimized;
+    for (int poseIndex = 0; poseIndex < numberOfPoses; ++poseIndex) {
+        Eigen::Map<const Eigen::Quaterniond> orientation(&orientationsWorldToCameraQxyzw[4 * poseIndex]);
+        Eigen::Map<const Eigen::Vector3d> translation(&translationsWorldToCamera[3 * poseIndex]);
+        posesOptimized.emplace_back(gdr::SE3(orientation.normalized(), translation).inverse());
+    }
+
+    return posesOptimized;
+}
+
+TEST(testBAOptimized, WhitenedRobustLossAsAccurateAsBaselineSynthetic30PosesWrongMatches) {
+
+    SyntheticSceneBA scene = getSyntheticSceneBA(30, 1500, 13);
+
+    std::mt19937 randomNumberGenerator(13);
+    std::normal_distribution<> noisePixels(0.0, 0.5);
+    std::normal_distribution<> noiseDepth(0.0, 0.003);
+
+    // every 10th observation is a wrong match: both keypoint and its depth belong to another surface,
+    // other observations are corrupted by small measurement noise
+    int observationNumber = 0;
+    for (int poseIndex = 0; poseIndex < scene.keyPointInfos.size(); ++poseIndex) {
+        for (auto &pointIndexAndInfo: scene.keyPointInfos[poseIndex]) {
+            auto &keyPointInfo = pointIndexAndInfo.second;
+            double x = keyPointInfo.getX() + noisePixels(randomNumberGenerator);
+            double y = keyPointInfo.getY() + noisePixels(randomNumberGenerator);
+            double depth = keyPointInfo.getDepth() + noiseDepth(randomNumberGenerator);
+
+            if (observationNumber++ % 10 == 0) {
+                double sign = (observationNumber % 20 == 1) ? -1.0 : 1.0;
+                double shift = sign * (15.0 + 25.0 * (observationNumber % 7) / 6.0);
+                x = std::min(639.0, std::max(1.0, x + shift));
+                y = std::min(479.0, std::max(1.0, y + 0.5 * shift));
+                depth += 0.15 + 0.35 * (observationNumber % 5) / 4.0;
+            }
+
+            gdr::KeyPoint2DAndDepth keyPoint(x, y, 1.0, 0.0);
+            keyPoint.setDepth(depth);
+            keyPointInfo = gdr::KeyPointInfo(keyPoint, keyPointInfo.getObservingPoseNumber());
+        }
+    }
+
+    gdr::BundleDepthAdjuster bundleAdjuster;
+    bool success = false;
+    std::vector<gdr::SE3> posesOptimized = bundleAdjuster.optimizePointsAndPoses(scene.pointsPerturbed,
+                                                                                 scene.posesPerturbed,
+                                                                                 scene.keyPointInfos,
+                                                                                 0,
+                                                                                 success);
+    ASSERT_TRUE(success);
+
+    std::vector<gdr::SE3> posesOptimizedBaseline =
+            optimizeWithBaselineRobustWeighting(scene, 0, bundleAdjuster.getMaxNumberIterations());
+
+    double errorBefore = getMeanTranslationError(getPosesWithoutCameras(scene.posesPerturbed),
+                                                 scene.posesGroundTruth);
+    double errorAfter = getMeanTranslationError(posesOptimized, scene.posesGroundTruth);
+    double errorAfterBaseline = getMeanTranslationError(posesOptimizedBaseline, scene.posesGroundTruth);
+
+    std::cout << "mean translation error before " << errorBefore
+              << ", whitened robust loss " << errorAfter
+              << ", baseline robust weighting " << errorAfterBaseline << std::endl;
+
+    ASSERT_LE(errorAfter, 0.5 * errorBefore);
+
+    // sigmas of baseline are estimated by plain medians instead of the adjuster's inlier estimate,
+    // small tolerance covers this difference
+    ASSERT_LE(errorAfter, 1.1 * errorAfterBaseline);
+}
+
+TEST(testBAOptimized, InverseDepthBundleAdjustmentSynthetic20Poses) {
+
+    SyntheticSceneBA scene = getSyntheticSceneBA(20, 1000, 11);
+
+    std::vector<double> errorsAfter;
+
+    for (bool useInverseDepth: {false, true}) {
+        gdr::BundleDepthAdjuster bundleAdjuster;
+        bundleAdjuster.setInverseDepthParameterization(useInverseDepth);
+
+        bool success = false;
+        std::vector<gdr::SE3> posesOptimized = bundleAdjuster.optimizePointsAndPoses(scene.pointsPerturbed,
+                                                                                     scene.posesPerturbed,
+                                                                                     scene.keyPointInfos,
+                                                                                     0,
+                                                                                     success);
+        std::cout << bundleAdjuster.getSolverInfo() << std::endl;
+        ASSERT_TRUE(success);
+        ASSERT_EQ(bundleAdjuster.getOptimizedPoints().size(), scene.pointsPerturbed.size());
+
+        errorsAfter.emplace_back(getMeanTranslationError(posesOptimized, scene.posesGroundTruth));
+    }
+
+    double errorBefore = getMeanTranslationError(getPosesWithoutCameras(scene.posesPerturbed),
+                                                 scene.posesGroundTruth);
+
+    std::cout << "mean translation error before " << errorBefore
+              << ", after x, y, z landmarks " << errorsAfter[0]
+              << ", after inverse depth landmarks " << errorsAfter[1] << std::endl;
+
+    ASSERT_LE(errorsAfter[1], 0.5 * errorBefore);
+}
+
+TEST(testBAOptimized, InverseDepthBundleAdjustmentSynthetic20PosesFixedPoseNotFirst) {
+
+    // orientation of the first pose is added to the problem only as anchor of later observations
+    int indexFixed = 7;
+    SyntheticSceneBA scene = getSyntheticSceneBA(20, 1000, 17, indexFixed);
+
+    std::vector<double> errorsAfter;
+    std::vector<int> numbersOfIterations;
+
+    for (bool useInverseDepth: {false, true}) {
+        gdr::BundleDepthAdjuster bundleAdjuster;
+        bundleAdjuster.setInverseDepthParameterization(useInverseDepth);
+
+        bool success = false;
+        std::vector<gdr::SE3> posesOptimized = bundleAdjuster.optimizePointsAndPoses(scene.pointsPerturbed,
+                                                                                     scene.posesPerturbed,
+                                                                                     scene.keyPointInfos,
+                                                                                     indexFixed,
+                                                                                     success);
+        std::cout << bundleAdjuster.getSolverInfo() << std::endl;
+        ASSERT_TRUE(success);
+        ASSERT_LT(bundleAdjuster.getNumberOfIterations(), bundleAdjuster.getMaxNumberIterations());
+
+        for (int poseIndex = 0; poseIndex < posesOptimized.size(); ++poseIndex) {
+            double errorRotation = (posesOptimized[poseIndex].getSO3().inverse()
+                                    * scene.posesGroundTruth[poseIndex].getSO3()).log().norm();
+            ASSERT_LE(errorRotation, 0.01) << "pose " << poseIndex;
+        }
+
+        errorsAfter.emplace_back(getMeanTranslationError(posesOptimized, scene.posesGroundTruth));
+        numbersOfIterations.emplace_back(bundleAdjuster.getNumberOfIterations());
+    }
+
+    double errorBefore = getMeanTranslationError(getPosesWithoutCameras(scene.posesPerturbed),
+                                                 scene.posesGroundTruth);
+
+    std::cout << "mean translation error before " << errorBefore
+              << ", after x, y, z landmarks " << errorsAfter[0]
+              << " (" << numbersOfIterations[0] << " iterations)"
+              << ", after inverse depth landmarks " << errorsAfter[1]
+              << " (" << numbersOfIterations[1] << " iterations)" << std::endl;
+
+    ASSERT_LE(errorsAfter[1], 0.5 * errorBefore);
+    ASSERT_LE(numbersOfIterations[1], numbersOfIterations[0]);
+}
+
+TEST(testBAOptimized, PoseOnlyRefinementSynthetic30Poses) {
+
+    SyntheticSceneBA scene = getSyntheticSceneBA(30, 1500, 13);
+
+    gdr::PoseOnlyAdjuster poseOnlyAdjuster;
+
+    bool success = false;
+    std::vector<gdr::SE3> posesOptimized = poseOnlyAdjuster.optimizePointsAndPoses(scene.pointsPerturbed,
+                                                                                   scene.posesPerturbed,
+                                                                                   scene.keyPointInfos,
+                                                                                   0,
+                                                                                   success);
+    std::cout << poseOnlyAdjuster.getSolverInfo() << std::endl;
+
+    ASSERT_TRUE(success);
+    ASSERT_EQ(posesOptimized.size(), scene.posesGroundTruth.size());
+    ASSERT_EQ(poseOnlyAdjuster.getOptimizedPoints().size(), scene.pointsPerturbed.size());
+
+    double errorBefore = getMeanTranslationError(getPosesWithoutCameras(scene.posesPerturbed),
+                                                 scene.posesGroundTruth);
+    double errorAfter = getMeanTranslationError(posesOptimized, scene.posesGroundTruth);
+
+    std::cout << "mean translation error before " << errorBefore << ", after " << errorAfter << std::endl;
+
+    ASSERT_LE(errorAfter, 0.5 * errorBefore);
+}
+
+TEST(testBAOptimized, PoseOnlyRefinementInlierMatchesSynthetic30Poses) {
+
+    SyntheticSceneBA scene = getSyntheticSceneBA(30, 1500, 19);
+
+    // matches of each pose with three next poses as produced by relative pose estimation,
+    // every 25th match connects keypoints of different points
+    gdr::KeyPointMatches inlierMatches;
+    int numberOfPoses = static_cast<int>(scene.keyPointInfos.size());
+    int numberOfWrongMatches = 0;
+
+    for (int poseFrom = 0; poseFrom < numberOfPoses; ++poseFrom) {
+        for (int poseTo = poseFrom + 1; poseTo < std::min(numberOfPoses, poseFrom + 4); ++poseTo) {
+            const auto &keyPointsTo = scene.keyPointInfos[poseTo];
+
+            for (const auto &pointIndexAndInfo: scene.keyPointInfos[poseFrom]) {
+                auto foundTo = keyPointsTo.find(pointIndexAndInfo.first);
+                if (foundTo == keyPointsTo.end()) {
+                    continue;
+                }
+
+                if (inlierMatches.size() % 25 == 0) {
+                    foundTo = keyPointsTo.begin();
+                    if (foundTo->first != pointIndexAndInfo.first) {
+                        ++numberOfWrongMatches;
+                    }
+                }
+
+                inlierMatches.emplace_back(std::make_pair(
+                        std::make_pair(std::make_pair(poseFrom, pointIndexAndInfo.first), pointIndexAndInfo.second),
+                        std::make_pair(std::make_pair(poseTo, foundTo->first), foundTo->second)));
+            }
+        }
+    }
+
+    std::unique_ptr<gdr::BundleAdjuster> poseOnlyAdjuster = gdr::BundleAdjusterCreator::getBundleAdjuster(
+            gdr::BundleAdjusterCreator::BundleAdjustmentType::POSES_ONLY_DEPTH_CORRESPONDENCES,
+            0, 1, &inlierMatches);
+
+    bool success = false;
+    std::vector<gdr::SE3> posesOptimized = poseOnlyAdjuster->optimizePointsAndPoses(scene.pointsPerturbed,
+                                                                                    scene.posesPerturbed,
+                                                                                    scene.keyPointInfos,
+                                                                                    0,
+                                                                                    success);
+    std::cout << poseOnlyAdjuster->getSolverInfo() << std::endl;
+
+    ASSERT_TRUE(success);
+    ASSERT_EQ(posesOptimized.size(), scene.posesGroundTruth.size());
+
+    // all matches are used instead of consecutive observations of point tracks
+    auto poseOnlyAdjusterUsed = dynamic_cast<gdr::PoseOnlyAdjuster *>(poseOnlyAdjuster.get());
+    ASSERT_NE(poseOnlyAdjusterUsed, nullptr);
+    ASSERT_EQ(poseOnlyAdjusterUsed->getNumberOfCorrespondences(), inlierMatches.size());
+
+    double errorBefore = getMeanTranslationError(getPosesWithoutCameras(scene.posesPerturbed),
+                                                 scene.posesGroundTruth);
+    double errorAfter = getMeanTranslationError(posesOptimized, scene.posesGroundTruth);
+
+    std::cout << "mean translation error before " << errorBefore << ", after " << errorAfter
+              << ", wrong matches " << numberOfWrongMatches << " of " << inlierMatches.size() << std::endl;
+
+    ASSERT_GT(numberOfWrongMatches, 0);
+    ASSERT_LE(errorAfter, 0.5 * errorBefore);
+}
+
+TEST(testBAOptimized, LandmarkSelectionBoundedAndCoversImage) {
+
+    std::mt19937 randomNumberGenerator(11);
+    std::uniform_real_distribution<> uniformX(1.0, 639.0);
+    std::uniform_real_distribution<> uniformY(1.0, 479.0);
+    std::uniform_real_distribution<> uniformDepth(0.5, 5.0);
+    std::uniform_int_distribution<> uniformTrackLength(1, 6);
+
+    int numberOfPoses = 50;
+    int numberOfPoints = 20000;
+    int maxLandmarksPerPose = 100;
+
+    // point i is observed by consecutive poses starting from i % numberOfPoses,
+    // the left half of each image is textured ten times denser
+    std::vector<std::unordered_map<int, gdr::KeyPointInfo>> keyPointInfoByPose(numberOfPoses);
+
+    for (int pointIndex = 0; pointIndex < numberOfPoints; ++pointIndex) {
+        int trackLength = uniformTrackLength(randomNumberGenerator);
+        bool isDenseHalf = (pointIndex % 11 != 0);
+
+        for (int poseIndex = pointIndex % numberOfPoses;
+             poseIndex < std::min(numberOfPoses, pointIndex % numberOfPoses + trackLength); ++poseIndex) {
+            double x = uniformX(randomNumberGenerator);
+            x = isDenseHalf ? x / 2 : 320 + x / 2;
+            gdr::KeyPoint2DAndDepth keyPoint(x, uniformY(randomNumberGenerator), 1.0, 0.0);
+            keyPoint.setDepth(uniformDepth(randomNumberGenerator));
+            keyPointInfoByPose[poseIndex][pointIndex] = gdr::KeyPointInfo(keyPoint, poseIndex);
+        }
+    }
+
+    std::vector<int> selectedPoints = gdr::LandmarkSelector::selectLandmarks(keyPointInfoByPose,
+                                                                             numberOfPoints,
+                                                                             maxLandmarksPerPose);
+    auto keyPointInfoSelected = gdr::LandmarkSelector::getKeyPointInfoOfSelectedLandmarks(keyPointInfoByPose,
+                                                                                           selectedPoints);
+
+    ASSERT_TRUE(std::is_sorted(selectedPoints.begin(), selectedPoints.end()));
+    ASSERT_LE(selectedPoints.size(), maxLandmarksPerPose * numberOfPoses);
+    ASSERT_LT(selectedPoints.size(), numberOfPoints / 4);
+
+    double sumTrackLengthAll = 0;
+    double sumTrackLengthSelected = 0;
+
+    for (int poseIndex = 0; poseIndex < numberOfPoses; ++poseIndex) {
+        int observationsRightHalf = 0;
+
+        for (const auto &pointIndexAndInfo: keyPointInfoSelected[poseIndex]) {
+            ASSERT_LT(pointIndexAndInfo.first, selectedPoints.size());
+            if (pointIndexAndInfo.second.getX() >= 320) {
+                ++observationsRightHalf;
+            }
+        }
+
+        sumTrackLengthAll += keyPointInfoByPose[poseIndex].size();
+        sumTrackLengthSelected += keyPointInfoSelected[poseIndex].size();
+
+        // each pose observes the requested number of landmarks, sparse half of the image gets much more
+        // than its 1/11 share of raw observations
+        ASSERT_GE(keyPointInfoSelected[poseIndex].size(), maxLandmarksPerPose);
+        ASSERT_GE(observationsRightHalf, 0.25 * keyPointInfoSelected[poseIndex].size());
+    }
+
+    // long tracks are preferred
+    ASSERT_GT(sumTrackLengthSelected / selectedPoints.size(), sumTrackLengthAll / numberOfPoints);
+}
+
 int main(int argc, char *argv[]) {
 
     ::testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,116 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#include <gtest/gtest.h>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+#include "boost/filesystem.hpp"
+
+#include "imageCache/DecodedImageCache.h"
+
+namespace fs = boost::filesystem;
+
+std::string writeSyntheticDepthImage(const fs::path &pathToImages, const std::string &filename) {
+
+    fs::create_directories(pathToImages);
+
+    cv::Mat imageDepth(24, 32, CV_16UC1);
+    cv::RNG randomNumberGenerator(imageDepth.total());
+    randomNumberGenerator.fill(imageDepth, cv::RNG::UNIFORM, 0, 65536);
+
+    std::string pathToImage = (pathToImages / filename).string();
+    bool imageWritten = cv::imwrite(pathToImage, imageDepth);
+    assert(imageWritten);
+
+    return pathToImage;
+}
+
+TEST(testDecodedImageCache, SameFileRequestedAsColourAndDepthIsCachedSeparately) {
+
+    fs::path pathToImages = fs::temp_directory_path() / "gdrDecodedImageCacheTypes";
+    fs::remove_all(pathToImages);
+    std::string pathToImage = writeSyntheticDepthImage(pathToImages, "depth.png");
+
+    auto &decodedImageCache = gdr::DecodedImageCache::getInstance();
+    decodedImageCache.clear();
+
+    cv::Mat imageDepth = decodedImageCache.getImage(pathToImage, gdr::DecodedImageCache::ImageType::DEPTH);
+    cv::Mat imageColor = decodedImageCache.getImage(pathToImage, gdr::DecodedImageCache::ImageType::COLOR);
+    cv::Mat imageGrayscale = decodedImageCache.getImage(pathToImage, gdr::DecodedImageCache::ImageType::GRAYSCALE);
+
+    ASSERT_EQ(imageDepth.type(), CV_16UC1);
+    ASSERT_EQ(imageColor.type(), CV_8UC3);
+    ASSERT_EQ(imageGrayscale.type(), CV_8UC1);
+
+    // grayscale image is converted from cached colour one
+    gdr::DecodedImageCacheStatistics statistics = decodedImageCache.getStatistics();
+    ASSERT_EQ(statistics.misses, 2);
+    ASSERT_EQ(statistics.hits, 1);
+
+    decodedImageCache.clear();
+    fs::remove_all(pathToImages);
+}
+
+TEST(testDecodedImageCache, FailedReadIsNotCached) {
+
+    fs::path pathToImages = fs::temp_directory_path() / "gdrDecodedImageCacheFailedRead";
+    fs::remove_all(pathToImages);
+    std::string pathToImage = (pathToImages / "depth.png").string();
+
+    auto &decodedImageCache = gdr::DecodedImageCache::getInstance();
+    decodedImageCache.clear();
+
+    ASSERT_TRUE(decodedImageCache.getImage(pathToImage, gdr::DecodedImageCache::ImageType::DEPTH).empty());
+    ASSERT_EQ(decodedImageCache.getMemoryUsedBytes(), 0);
+
+    writeSyntheticDepthImage(pathToImages, "depth.png");
+
+    ASSERT_FALSE(decodedImageCache.getImage(pathToImage, gdr::DecodedImageCache::ImageType::DEPTH).empty());
+    ASSERT_EQ(decodedImageCache.getStatistics().misses, 2);
+
+    decodedImageCache.clear();
+    fs::remove_all(pathToImages);
+}
+
+TEST(testDecodedImageCache, PinnedImageIsNotEvictedUntilUnpinned) {
+
+    fs::path pathToImages = fs::temp_directory_path() / "gdrDecodedImageCachePinning";
+    fs::remove_all(pathToImages);
+    std::string pathToImagePinned = writeSyntheticDepthImage(pathToImages, "pinned.png");
+    std::string pathToImageNotPinned = writeSyntheticDepthImage(pathToImages, "notPinned.png");
+
+    auto &decodedImageCache = gdr::DecodedImageCache::getInstance();
+    decodedImageCache.clear();
+    size_t memoryBudgetBytes = decodedImageCache.getMemoryBudgetBytes();
+    decodedImageCache.setMemoryBudgetBytes(0);
+
+    decodedImageCache.pin(pathToImagePinned, gdr::DecodedImageCache::ImageType::DEPTH);
+
+    cv::Mat imagePinned = decodedImageCache.getImage(pathToImagePinned, gdr::DecodedImageCache::ImageType::DEPTH);
+    decodedImageCache.getImage(pathToImageNotPinned, gdr::DecodedImageCache::ImageType::DEPTH);
+
+    ASSERT_EQ(decodedImageCache.getStatistics().evictions, 1);
+    ASSERT_EQ(decodedImageCache.getMemoryUsedBytes(), imagePinned.total() * imagePinned.elemSize());
+
+    decodedImageCache.getImage(pathToImagePinned, gdr::DecodedImageCache::ImageType::DEPTH);
+    ASSERT_EQ(decodedImageCache.getStatistics().hits, 1);
+
+    decodedImageCache.unpin(pathToImagePinned, gdr::DecodedImageCache::ImageType::DEPTH);
+
+    ASSERT_EQ(decodedImageCache.getStatistics().evictions, 2);
+    ASSERT_EQ(decodedImageCache.getMemoryUsedBytes(), 0);
+
+    decodedImageCache.setMemoryBudgetBytes(memoryBudgetBytes);
+    decodedImageCache.clear();
+    fs::remove_all(pathToImages);
+}
+
+int main(int argc, char *argv[]) {
+
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
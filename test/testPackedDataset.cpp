@@ -0,0 +1,205 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#include <gtest/gtest.h>
+#include <cstddef>
+#include <fstream>
+#include <limits>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+#include "boost/filesystem.hpp"
+
+#include "readerDataset/readerPacked/PackedDatasetReader.h"
+#include "readerDataset/readerPacked/PackedDatasetWriter.h"
+#include "imageCache/DecodedImageCache.h"
+
+namespace fs = boost::filesystem;
+
+struct SyntheticImageFiles {
+    gdr::DatasetStructure datasetStructure;
+    std::vector<cv::Mat> imagesRgb;
+    std::vector<cv::Mat> imagesDepth;
+};
+
+SyntheticImageFiles writeSyntheticImageFiles(const fs::path &pathToDataset, int numberOfFrames) {
+
+    fs::create_directories(pathToDataset / "rgb");
+    fs::create_directories(pathToDataset / "depth");
+
+    SyntheticImageFiles imageFiles;
+    cv::RNG randomNumberGenerator(numberOfFrames);
+
+    for (int frame = 0; frame < numberOfFrames; ++frame) {
+        cv::Mat imageRgb(24, 32, CV_8UC3);
+        cv::Mat imageDepth(24, 32, CV_16UC1);
+        randomNumberGenerator.fill(imageRgb, cv::RNG::UNIFORM, 0, 256);
+        randomNumberGenerator.fill(imageDepth, cv::RNG::UNIFORM, 0, 65536);
+
+        std::string filename = std::to_string(frame) + ".png";
+        std::string pathRgb = (pathToDataset / "rgb" / filename).string();
+        std::string pathDepth = (pathToDataset / "depth" / filename).string();
+
+        bool imagesWritten = cv::imwrite(pathRgb, imageRgb) && cv::imwrite(pathDepth, imageDepth);
+        assert(imagesWritten);
+
+        imageFiles.datasetStructure.pathsImagesRgb.emplace_back(pathRgb);
+        imageFiles.datasetStructure.pathsImagesDepth.emplace_back(pathDepth);
+        imageFiles.datasetStructure.timestampsRgbDepth.emplace_back(std::make_pair(0.1 * frame, 0.1 * frame + 0.01));
+        imageFiles.imagesRgb.emplace_back(imageRgb);
+        imageFiles.imagesDepth.emplace_back(imageDepth);
+    }
+
+    return imageFiles;
+}
+
+bool imagesAreEqual(const cv::Mat &lhs, const cv::Mat &rhs) {
+    return lhs.size() == rhs.size() && lhs.type() == rhs.type() && cv::norm(lhs, rhs, cv::NORM_INF) == 0;
+}
+
+TEST(testPackedDataset, WriterReaderRoundTripRawAndPng) {
+
+    fs::path pathToDataset = fs::temp_directory_path() / "gdrPackedDatasetRoundTrip";
+    fs::remove_all(pathToDataset);
+
+    int numberOfFrames = 4;
+    SyntheticImageFiles imageFiles = writeSyntheticImageFiles(pathToDataset, numberOfFrames);
+
+    gdr::CameraRGBD camera(500.0, 16.0, 510.0, 12.0);
+    camera.setDepthPixelDivider(5000.0);
+
+    std::vector<gdr::PoseFullInfo> groundTruthPoses;
+    groundTruthPoses.emplace_back(gdr::PoseFullInfo(0.05, Eigen::Quaterniond(0.5, 0.5, -0.5, 0.5),
+                                                    Eigen::Vector3d(1.0, -2.0, 3.0)));
+    groundTruthPoses.emplace_back(gdr::PoseFullInfo(0.15, Eigen::Quaterniond::Identity(),
+                                                    Eigen::Vector3d(0.5, 0.0, -1.5)));
+
+    for (const auto &frameEncoding: {gdr::PackedFrameEncoding::RAW, gdr::PackedFrameEncoding::PNG}) {
+
+        std::string pathToContainer = (pathToDataset / ("container"
+                + std::to_string(static_cast<int>(frameEncoding)) + ".gdrpack")).string();
+
+        ASSERT_TRUE(gdr::PackedDatasetWriter::writeContainer(imageFiles.datasetStructure,
+                                                             camera,
+                                                             groundTruthPoses,
+                                                             pathToContainer,
+                                                             frameEncoding));
+
+        auto packedDataset = std::make_shared<const gdr::PackedDatasetReader>(pathToContainer);
+        ASSERT_TRUE(packedDataset->isOpened());
+        ASSERT_EQ(packedDataset->getNumberOfFrames(), numberOfFrames);
+        ASSERT_EQ(packedDataset->getFrameEncoding(), frameEncoding);
+
+        gdr::CameraRGBD cameraRead = packedDataset->getCamera();
+        ASSERT_EQ(cameraRead.getFx(), camera.getFx());
+        ASSERT_EQ(cameraRead.getFy(), camera.getFy());
+        ASSERT_EQ(cameraRead.getCx(), camera.getCx());
+        ASSERT_EQ(cameraRead.getCy(), camera.getCy());
+        ASSERT_EQ(cameraRead.getDepthPixelDivider(), camera.getDepthPixelDivider());
+
+        std::vector<gdr::PoseFullInfo> groundTruthPosesRead = packedDataset->getGroundTruthPoses();
+        ASSERT_EQ(groundTruthPosesRead.size(), groundTruthPoses.size());
+
+        for (int poseIndex = 0; poseIndex < groundTruthPoses.size(); ++poseIndex) {
+            ASSERT_EQ(groundTruthPosesRead[poseIndex].getTimestamp(), groundTruthPoses[poseIndex].getTimestamp());
+            ASSERT_LE((groundTruthPosesRead[poseIndex].getTranslation()
+                       - groundTruthPoses[poseIndex].getTranslation()).norm(), 1e-12);
+            ASSERT_LE(groundTruthPosesRead[poseIndex].getOrientationQuat().angularDistance(
+                    groundTruthPoses[poseIndex].getOrientationQuat()), 1e-9);
+        }
+
+        gdr::DatasetStructure datasetStructureRead = packedDataset->getDatasetStructure();
+        ASSERT_EQ(datasetStructureRead.timestampsRgbDepth, imageFiles.datasetStructure.timestampsRgbDepth);
+        ASSERT_EQ(datasetStructureRead.pathsImagesRgb.size(), numberOfFrames);
+        ASSERT_EQ(datasetStructureRead.pathsImagesDepth.size(), numberOfFrames);
+
+        // virtual paths are resolved by the image cache without file system access
+        gdr::DecodedImageCache::getInstance().addPackedDataset(packedDataset);
+
+        for (int frame = 0; frame < numberOfFrames; ++frame) {
+            ASSERT_TRUE(imagesAreEqual(packedDataset->getImageRGB(frame), imageFiles.imagesRgb[frame]));
+            ASSERT_TRUE(imagesAreEqual(packedDataset->getImageDepth(frame), imageFiles.imagesDepth[frame]));
+
+            bool isDepth = true;
+            int frameFound = -1;
+            ASSERT_TRUE(packedDataset->findFrameByPath(datasetStructureRead.pathsImagesRgb[frame],
+                                                       isDepth, frameFound));
+            ASSERT_FALSE(isDepth);
+            ASSERT_EQ(frameFound, frame);
+
+            ASSERT_TRUE(imagesAreEqual(gdr::DecodedImageCache::getInstance().getImage(
+                    datasetStructureRead.pathsImagesDepth[frame], gdr::DecodedImageCache::ImageType::DEPTH),
+                                       imageFiles.imagesDepth[frame]));
+        }
+    }
+
+    fs::remove_all(pathToDataset);
+}
+
+TEST(testPackedDataset, RawImageSizeMismatchIsRejectedOnOpening) {
+
+    fs::path pathToDataset = fs::temp_directory_path() / "gdrPackedDatasetCorrupted";
+    fs::remove_all(pathToDataset);
+
+    SyntheticImageFiles imageFiles = writeSyntheticImageFiles(pathToDataset, 2);
+    std::string pathToContainer = (pathToDataset / "container.gdrpack").string();
+
+    ASSERT_TRUE(gdr::PackedDatasetWriter::writeContainer(imageFiles.datasetStructure,
+                                                         gdr::CameraRGBD(),
+                                                         {},
+                                                         pathToContainer,
+                                                         gdr::PackedFrameEncoding::RAW));
+    ASSERT_TRUE(gdr::PackedDatasetReader(pathToContainer).isOpened());
+
+    {
+        std::fstream container(pathToContainer, std::ios::binary | std::ios::in | std::ios::out);
+        uint32_t imageWidthCorrupted = imageFiles.imagesRgb[0].cols + 1;
+        container.seekp(offsetof(gdr::PackedDatasetHeader, imageWidth));
+        container.write(reinterpret_cast<const char *>(&imageWidthCorrupted), sizeof(imageWidthCorrupted));
+    }
+
+    ASSERT_FALSE(gdr::PackedDatasetReader(pathToContainer).isOpened());
+
+    fs::remove_all(pathToDataset);
+}
+
+TEST(testPackedDataset, WrappingFilenameOffsetIsRejectedOnOpening) {
+
+    fs::path pathToDataset = fs::temp_directory_path() / "gdrPackedDatasetFilenameOffset";
+    fs::remove_all(pathToDataset);
+
+    SyntheticImageFiles imageFiles = writeSyntheticImageFiles(pathToDataset, 2);
+    std::string pathToContainer = (pathToDataset / "container.gdrpack").string();
+
+    ASSERT_TRUE(gdr::PackedDatasetWriter::writeContainer(imageFiles.datasetStructure,
+                                                         gdr::CameraRGBD(),
+                                                         {},
+                                                         pathToContainer,
+                                                         gdr::PackedFrameEncoding::PNG));
+    ASSERT_TRUE(gdr::PackedDatasetReader(pathToContainer).isOpened());
+
+    {
+        std::fstream container(pathToContainer, std::ios::binary | std::ios::in | std::ios::out);
+        gdr::PackedDatasetHeader header{};
+        container.read(reinterpret_cast<char *>(&header), sizeof(header));
+
+        // offset + length of the filename wraps around to a small value
+        uint64_t offsetFilenameCorrupted = std::numeric_limits<uint64_t>::max();
+        container.seekp(header.offsetFrameIndex + offsetof(gdr::PackedFrameIndexEntry, offsetFilenameRgb));
+        container.write(reinterpret_cast<const char *>(&offsetFilenameCorrupted), sizeof(offsetFilenameCorrupted));
+    }
+
+    ASSERT_FALSE(gdr::PackedDatasetReader(pathToContainer).isOpened());
+
+    fs::remove_all(pathToDataset);
+}
+
+int main(int argc, char *argv[]) {
+
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,154 @@
+//
+// Copyright (c) Leonid Seniukov. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+//
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+#include "boost/filesystem.hpp"
+
+#include "parametrization/MatchableInfo.h"
+#include "relativePoseRefinement/RefinerDenseRGBD.h"
+
+namespace fs = boost::filesystem;
+
+double getTextureIntensity(const Eigen::Vector3d &pointWorld) {
+    return 0.5
+           + 0.2 * std::sin(9.0 * pointWorld.x()) * std::cos(7.0 * pointWorld.y())
+           + 0.15 * std::sin(4.0 * pointWorld.x() + 6.0 * pointWorld.y() + 1.0)
+           + 0.1 * std::sin(25.0 * pointWorld.x() - 18.0 * pointWorld.y());
+}
+
+/** Ray cast textured plane n * X = d from camera with given camera to world pose */
+void renderPlaneRGBD(const gdr::SE3 &poseCameraToWorld,
+                     const gdr::CameraRGBD &camera,
+                     int width, int height,
+                     const std::string &pathRGB,
+                     const std::string &pathD) {
+
+    Eigen::Vector3d normal = Eigen::Vector3d(0.2, -0.1, -1.0).normalized();
+    double distance = normal.dot(Eigen::Vector3d(0.0, 0.0, 1.5));
+
+    Eigen::Matrix3d rotation = poseCameraToWorld.getRotationQuatd().toRotationMatrix();
+    Eigen::Vector3d center = poseCameraToWorld.getTranslation();
+
+    cv::Mat imageRGB(height, width, CV_8UC3);
+    cv::Mat imageD(height, width, CV_16UC1);
+
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            Eigen::Vector3d directionCamera((x - camera.getCx()) / camera.getFx(),
+                                            (y - camera.getCy()) / camera.getFy(),
+                                            1.0);
+            Eigen::Vector3d directionWorld = rotation * directionCamera;
+
+            // depth along optical axis equals ray parameter because direction has unit z coordinate
+            double depth = (distance - normal.dot(center)) / normal.dot(directionWorld);
+            double intensity = getTextureIntensity(center + depth * directionWorld);
+            auto intensity8bit = static_cast<uchar>(std::round(255.0 * std::min(1.0, std::max(0.0, intensity))));
+
+            imageRGB.at<cv::Vec3b>(y, x) = cv::Vec3b(intensity8bit, intensity8bit, intensity8bit);
+            imageD.at<uint16_t>(y, x) = static_cast<uint16_t>(std::round(depth * camera.getDepthPixelDivider()));
+        }
+    }
+
+    bool imagesWritten = cv::imwrite(pathRGB, imageRGB) && cv::imwrite(pathD, imageD);
+    assert(imagesWritten);
+}
+
+TEST(testRelativePoseRefinement, DenseRGBDConvergesOnSyntheticWarpedPlane) {
+
+    fs::path pathToImages = fs::temp_directory_path() / "gdrDenseRGBDRefinement";
+    fs::remove_all(pathToImages);
+    fs::create_directories(pathToImages);
+
+    int width = 160;
+    int height = 120;
+    gdr::CameraRGBD camera(160.0, 79.5, 160.0, 59.5);
+    camera.setDepthPixelDivider(5000.0);
+
+    gdr::SE3 poseDestination;
+    gdr::SE3 poseToBeTransformed(
+            Eigen::Quaterniond(Eigen::AngleAxisd(0.03, Eigen::Vector3d(1.0, 2.0, -1.0).normalized())),
+            Eigen::Vector3d(0.04, -0.03, 0.02));
+
+    std::string pathRGBDestination = (pathToImages / "rgbDestination.png").string();
+    std::string pathDDestination = (pathToImages / "depthDestination.png").string();
+    std::string pathRGBToBeTransformed = (pathToImages / "rgbToBeTransformed.png").string();
+    std::string pathDToBeTransformed = (pathToImages / "depthToBeTransformed.png").string();
+
+    renderPlaneRGBD(poseDestination, camera, width, height, pathRGBDestination, pathDDestination);
+    renderPlaneRGBD(poseToBeTransformed, camera, width, height, pathRGBToBeTransformed, pathDToBeTransformed);
+
+    std::vector<gdr::KeyPoint2DAndDepth> keyPointsEmpty;
+    gdr::MatchableInfo infoDestination(pathRGBDestination, pathDDestination, keyPointsEmpty, camera);
+    gdr::MatchableInfo infoToBeTransformed(pathRGBToBeTransformed, pathDToBeTransformed, keyPointsEmpty, camera);
+
+    // relative pose maps points from camera to be transformed to destination camera
+    gdr::SE3 relativePoseGroundTruth = poseDestination.inverse() * poseToBeTransformed;
+
+    gdr::SE3 relativePoseRefined;
+    double durationSeconds = 0;
+    gdr::RefinerDenseRGBD refiner;
+
+    bool converged = refiner.refineRelativePose(infoToBeTransformed,
+                                                infoDestination,
+                                                gdr::KeyPointMatches(),
+                                                relativePoseRefined,
+                                                durationSeconds,
+                                                0);
+
+    gdr::SE3 errorBefore = relativePoseGroundTruth.inverse();
+    gdr::SE3 errorAfter = relativePoseGroundTruth.inverse() * relativePoseRefined;
+    double errorRotationAfter = Eigen::AngleAxisd(errorAfter.getRotationQuatd()).angle();
+
+    std::cout << "dense RGB-D refinement: " << durationSeconds << " s, translation error "
+              << errorBefore.getTranslation().norm() << " -> " << errorAfter.getTranslation().norm()
+              << ", rotation error " << Eigen::AngleAxisd(errorBefore.getRotationQuatd()).angle()
+              << " -> " << errorRotationAfter << std::endl;
+
+    ASSERT_TRUE(converged);
+    ASSERT_LE(errorAfter.getTranslation().norm(), 0.1 * errorBefore.getTranslation().norm());
+    ASSERT_LE(errorAfter.getTranslation().norm(), 0.005);
+    ASSERT_LE(errorRotationAfter, 0.003);
+
+    fs::remove_all(pathToImages);
+}
+
+TEST(testRelativePoseRefinement, DenseRGBDReportsFailureAndKeepsInitialPoseIfImagesAreMissing) {
+
+    fs::path pathToImages = fs::temp_directory_path() / "gdrDenseRGBDRefinementMissing";
+    fs::remove_all(pathToImages);
+
+    std::string pathRGB = (pathToImages / "rgb.png").string();
+    std::string pathD = (pathToImages / "depth.png").string();
+
+    gdr::CameraRGBD camera(160.0, 79.5, 160.0, 59.5);
+    std::vector<gdr::KeyPoint2DAndDepth> keyPointsEmpty;
+    gdr::MatchableInfo info(pathRGB, pathD, keyPointsEmpty, camera);
+
+    gdr::SE3 relativePoseInitial(Eigen::Quaterniond(Eigen::AngleAxisd(0.1, Eigen::Vector3d::UnitY())),
+                                 Eigen::Vector3d(0.1, 0.2, 0.3));
+    gdr::SE3 relativePose = relativePoseInitial;
+    double durationSeconds = 0;
+    gdr::RefinerDenseRGBD refiner;
+
+    ASSERT_FALSE(refiner.refineRelativePose(info, info, gdr::KeyPointMatches(), relativePose, durationSeconds, 0));
+    ASSERT_LE((relativePose.getTranslation() - relativePoseInitial.getTranslation()).norm(),
+              std::numeric_limits<double>::epsilon());
+    ASSERT_LE(relativePose.getRotationQuatd().angularDistance(relativePoseInitial.getRotationQuatd()),
+              std::numeric_limits<double>::epsilon());
+}
+
+int main(int argc, char *argv[]) {
+
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -6,15 +6,23 @@
 #include <gtest/gtest.h>
 #include <vector>
 #include <random>
+#include <chrono>
+
+#include <tbb/global_control.h>
 
 #include "readerDataset/readerTUM/ReaderTum.h"
 #include "absolutePoseEstimation/rotationAveraging/RotationAverager.h"
+#include "absolutePoseEstimation/hierarchicalAveraging/HierarchicalAverager.h"
+#include "absolutePoseEstimation/hierarchicalAveraging/PoseGraphPartitioner.h"
 
 #include "readerDataset/readerTUM/Evaluator.h"
 
 void testRotationAveragingTemplate(const std::string &absolutePosesFile,
                                    double meanErrorThreshold = 0.02,
-                                   int totalIterations = 3) {
+                                   int totalIterations = 3,
+                                   const gdr::RotationAverager::RotationAveragingType &averagingType =
+                                   gdr::RotationAverager::RotationAveragingType::SHONAN,
+                                   int numberOfShonanStarts = 1) {
 
     for (int iterations = 0; iterations < totalIterations; ++iterations) {
 
@@ -49,9 +57,11 @@ void testRotationAveragingTemplate(const std::string &absolutePosesFile,
         }
 
         std::vector<gdr::SO3> absoluteRotations =
-                gdr::RotationAverager::shanonAveraging(relativeRs,
-                                                       indexPoseFixed,
-                                                       "test_RelativeRotations.txt");
+                gdr::RotationAverager::averageRotations(relativeRs,
+                                                        indexPoseFixed,
+                                                        averagingType,
+                                                        "test_RelativeRotations.txt",
+                                                        numberOfShonanStarts);
         ASSERT_EQ(absoluteRotations.size(), absolutePosesInfo.size());
 
         double sumError = 0;
@@ -77,6 +87,222 @@ TEST(testRotationAveraging, Poses19FromFileCorrespondencesPerVertex3AllInliers)
     testRotationAveragingTemplate("../../data/files/absolutePoses_19.txt", 0.02, 10);
 }
 
+TEST(testRotationAveraging, Poses19FromFileChordalCorrespondencesPerVertex3AllInliers) {
+
+    testRotationAveragingTemplate("../../data/files/absolutePoses_19.txt", 0.02, 10,
+                                  gdr::RotationAverager::RotationAveragingType::CHORDAL);
+}
+
+TEST(testRotationAveraging, Poses19FromFileChordalShonanCorrespondencesPerVertex3AllInliers) {
+
+    testRotationAveragingTemplate("../../data/files/absolutePoses_19.txt", 0.02, 10,
+                                  gdr::RotationAverager::RotationAveragingType::CHORDAL_SHONAN);
+}
+
+TEST(testRotationAveraging, Poses19FromFileMultiStartShonanCorrespondencesPerVertex3AllInliers) {
+
+    testRotationAveragingTemplate("../../data/files/absolutePoses_19.txt", 0.02, 10,
+                                  gdr::RotationAverager::RotationAveragingType::SHONAN, 4);
+}
+
+double getMeanRotationErrorSyntheticGraph(const std::vector<gdr::SO3> &absoluteRotations,
+                                          const std::vector<gdr::SO3> &absoluteRotationsGroundTruth,
+                                          int indexPoseFixed) {
+    double sumError = 0;
+    gdr::SO3 rotationFixedInversed = absoluteRotationsGroundTruth[indexPoseFixed].inverse();
+
+    for (int i = 0; i < absoluteRotations.size(); ++i) {
+        sumError += absoluteRotations[i].getUnitQuaternion().angularDistance(
+                (rotationFixedInversed * absoluteRotationsGroundTruth[i]).getUnitQuaternion());
+    }
+
+    return sumError / absoluteRotations.size();
+}
+
+/** Random absolute rotations connected by noisy sequential measurements and random loop closures
+ *
+ * @param absoluteRotationsGroundTruth[out] random absolute rotations of all poses
+ * @returns relative rotation measurements
+ */
+std::vector<gdr::RotationMeasurement> getSyntheticRelativeRotations(
+        int numberOfPoses,
+        double noiseSigmaRadians,
+        std::vector<gdr::SO3> &absoluteRotationsGroundTruth) {
+
+    std::mt19937 randomNumberGenerator(numberOfPoses);
+    std::normal_distribution<double> noise(0.0, noiseSigmaRadians);
+    std::uniform_int_distribution<int> randomPose(0, numberOfPoses - 1);
+    std::uniform_int_distribution<int> randomNumberOfInliers(10, 100);
+
+    absoluteRotationsGroundTruth.clear();
+    for (int i = 0; i < numberOfPoses; ++i) {
+        absoluteRotationsGroundTruth.emplace_back(gdr::SO3(gdr::SO3::getRandomUnitQuaternion()));
+    }
+
+    std::vector<gdr::RotationMeasurement> relativeRs;
+    auto addMeasurement = [&](int indexFrom, int indexTo) {
+        Sophus::SO3d rotationNoise = Sophus::SO3d::exp(Eigen::Vector3d(noise(randomNumberGenerator),
+                                                                       noise(randomNumberGenerator),
+                                                                       noise(randomNumberGenerator)));
+        gdr::SO3 relativeRotation = absoluteRotationsGroundTruth[indexFrom].inverse()
+                                    * absoluteRotationsGroundTruth[indexTo];
+        relativeRs.emplace_back(gdr::RotationMeasurement(
+                gdr::SO3(relativeRotation.getRotationSophus() * rotationNoise),
+                indexFrom, indexTo, randomNumberOfInliers(randomNumberGenerator)));
+    };
+
+    // sequential edges and random loop closures
+    for (int indexFrom = 0; indexFrom < numberOfPoses; ++indexFrom) {
+        for (int indexTo = indexFrom + 1; indexTo < std::min(numberOfPoses, indexFrom + 4); ++indexTo) {
+            addMeasurement(indexFrom, indexTo);
+        }
+    }
+    for (int i = 0; i < numberOfPoses; ++i) {
+        int indexFirst = randomPose(randomNumberGenerator);
+        int indexSecond = randomPose(randomNumberGenerator);
+
+        if (indexFirst != indexSecond) {
+            addMeasurement(std::min(indexFirst, indexSecond), std::max(indexFirst, indexSecond));
+        }
+    }
+
+    return relativeRs;
+}
+
+void testRotationAveragingSyntheticGraphTemplate(int numberOfPoses,
+                                                 bool runShonanWarmStarted,
+                                                 double meanErrorThreshold = 0.03,
+                                                 double noiseSigmaRadians = 0.01,
+                                                 int maxPosesPerCluster = 0) {
+
+    std::vector<gdr::SO3> absoluteRotationsGroundTruth;
+    std::vector<gdr::RotationMeasurement> relativeRs = getSyntheticRelativeRotations(numberOfPoses,
+                                                                                     noiseSigmaRadians,
+                                                                                     absoluteRotationsGroundTruth);
+
+    int indexPoseFixed = 0;
+
+    auto timeStartChordal = std::chrono::high_resolution_clock::now();
+    std::vector<gdr::SO3> rotationsChordal = gdr::RotationAverager::chordalAveraging(relativeRs, indexPoseFixed);
+    auto timeEndChordal = std::chrono::high_resolution_clock::now();
+
+    ASSERT_EQ(rotationsChordal.size(), numberOfPoses);
+    double errorChordal = getMeanRotationErrorSyntheticGraph(rotationsChordal,
+                                                             absoluteRotationsGroundTruth,
+                                                             indexPoseFixed);
+    std::cout << "poses: " << numberOfPoses << ", measurements: " << relativeRs.size()
+              << ", chordal: " << std::chrono::duration<double>(timeEndChordal - timeStartChordal).count()
+              << " s, mean error " << errorChordal << std::endl;
+    ASSERT_LE(errorChordal, meanErrorThreshold);
+
+    if (maxPosesPerCluster > 0) {
+        std::vector<std::pair<int, int>> edges;
+        std::vector<int> edgeWeights;
+
+        for (const auto &relativeRotation: relativeRs) {
+            edges.emplace_back(std::make_pair(relativeRotation.getIndexFromDestination(),
+                                              relativeRotation.getIndexToToBeTransformed()));
+            edgeWeights.emplace_back(static_cast<int>(relativeRotation.getWeight()));
+        }
+
+        auto timeStartHierarchical = std::chrono::high_resolution_clock::now();
+        std::vector<int> clusterByPose = gdr::PoseGraphPartitioner::partition(numberOfPoses,
+                                                                              edges,
+                                                                              edgeWeights,
+                                                                              maxPosesPerCluster);
+        std::vector<gdr::SO3> rotationsHierarchical = gdr::HierarchicalAverager::averageRotations(
+                relativeRs, indexPoseFixed, clusterByPose,
+                gdr::RotationAverager::RotationAveragingType::CHORDAL);
+        auto timeEndHierarchical = std::chrono::high_resolution_clock::now();
+
+        ASSERT_EQ(rotationsHierarchical.size(), numberOfPoses);
+        double errorHierarchical = getMeanRotationErrorSyntheticGraph(rotationsHierarchical,
+                                                                      absoluteRotationsGroundTruth,
+                                                                      indexPoseFixed);
+        std::cout << "poses: " << numberOfPoses << ", clusters: "
+                  << gdr::PoseGraphPartitioner::getPosesByCluster(clusterByPose).size()
+                  << ", hierarchical: "
+                  << std::chrono::duration<double>(timeEndHierarchical - timeStartHierarchical).count()
+                  << " s, mean error " << errorHierarchical << std::endl;
+        ASSERT_LE(errorHierarchical, meanErrorThreshold);
+    }
+
+    if (!runShonanWarmStarted) {
+        return;
+    }
+
+    auto timeStartShonan = std::chrono::high_resolution_clock::now();
+    std::vector<gdr::SO3> rotationsShonan =
+            gdr::RotationAverager::shanonAveraging(relativeRs, indexPoseFixed, "", 10, rotationsChordal);
+    auto timeEndShonan = std::chrono::high_resolution_clock::now();
+
+    ASSERT_EQ(rotationsShonan.size(), numberOfPoses);
+    double errorShonan = getMeanRotationErrorSyntheticGraph(rotationsShonan,
+                                                            absoluteRotationsGroundTruth,
+                                                            indexPoseFixed);
+    std::cout << "poses: " << numberOfPoses
+              << ", warm started Shonan: " << std::chrono::duration<double>(timeEndShonan - timeStartShonan).count()
+              << " s, mean error " << errorShonan << std::endl;
+    ASSERT_LE(errorShonan, meanErrorThreshold);
+}
+
+TEST(testRotationAveraging, SyntheticGraph1000PosesChordalAndShonanWarmStart) {
+
+    testRotationAveragingSyntheticGraphTemplate(1000, true);
+}
+
+TEST(testRotationAveraging, SyntheticGraph10000PosesChordalAndShonanWarmStart) {
+
+    testRotationAveragingSyntheticGraphTemplate(10000, true);
+}
+
+TEST(testRotationAveraging, SyntheticGraph10000PosesHierarchicalClusters1000) {
+
+    testRotationAveragingSyntheticGraphTemplate(10000, false, 0.03, 0.01, 1000);
+}
+
+TEST(testRotationAveraging, SyntheticGraph200PosesMultiStartShonanCancelledAfterCertifiedWarmStart) {
+
+    int numberOfPoses = 200;
+    int indexPoseFixed = 0;
+    int numberOfStarts = 4;
+
+    std::vector<gdr::SO3> absoluteRotationsGroundTruth;
+    std::vector<gdr::RotationMeasurement> relativeRs = getSyntheticRelativeRotations(numberOfPoses,
+                                                                                     0.01,
+                                                                                     absoluteRotationsGroundTruth);
+    std::vector<gdr::SO3> rotationsChordal = gdr::RotationAverager::chordalAveraging(relativeRs, indexPoseFixed);
+
+    std::vector<gdr::SO3> rotationsSingleStart =
+            gdr::RotationAverager::shanonAveraging(relativeRs, indexPoseFixed, "", 10, rotationsChordal);
+
+    // with one thread runs are executed in order, so warm started run is certified
+    // before random runs start their first level and they have to be cancelled
+    tbb::global_control oneThread(tbb::global_control::max_allowed_parallelism, 1);
+
+    std::vector<gdr::RotationAverager::ShonanStartStatus> statusByStart;
+    std::vector<gdr::SO3> rotationsMultiStart =
+            gdr::RotationAverager::shanonAveraging(relativeRs, indexPoseFixed, "", 10, rotationsChordal,
+                                                   numberOfStarts, &statusByStart);
+
+    ASSERT_EQ(statusByStart.size(), numberOfStarts);
+    ASSERT_EQ(statusByStart[0], gdr::RotationAverager::ShonanStartStatus::CERTIFIED);
+
+    for (int startIndex = 1; startIndex < numberOfStarts; ++startIndex) {
+        ASSERT_EQ(statusByStart[startIndex], gdr::RotationAverager::ShonanStartStatus::CANCELLED)
+                                    << "start " << startIndex;
+    }
+
+    // result is computed only from the certified run
+    ASSERT_EQ(rotationsMultiStart.size(), rotationsSingleStart.size());
+    for (int poseIndex = 0; poseIndex < numberOfPoses; ++poseIndex) {
+        ASSERT_LE(rotationsMultiStart[poseIndex].getUnitQuaternion().angularDistance(
+                rotationsSingleStart[poseIndex].getUnitQuaternion()), 1e-9) << "pose " << poseIndex;
+    }
+    ASSERT_LE(getMeanRotationErrorSyntheticGraph(rotationsMultiStart, absoluteRotationsGroundTruth, indexPoseFixed),
+              0.03);
+}
+
 int main(int argc, char *argv[]) {
 
     ::testing::InitGoogleTest(&argc, argv);
@@ -9,6 +9,9 @@
 
 #include "readerDataset/readerTUM/ReaderTum.h"
 #include "absolutePoseEstimation/rotationAveraging/RotationRobustOptimizerLogSO3.h"
+#include "absolutePoseEstimation/rotationAveraging/RotationRobustOptimizerCreator.h"
+#include "absolutePoseEstimation/rotationAveraging/RelativeRotationError.h"
+#include "absolutePoseEstimation/rotationAveraging/RelativeRotationErrorAnalytic.h"
 #include "absolutePoseEstimation/rotationAveraging/RotationAverager.h"
 
 #include "readerDataset/readerTUM/Evaluator.h"
@@ -18,7 +21,9 @@ void testRotationRobustOptimizationTemplate(const std::string &absolutePosesFile
                                             double maxRotationErrorCoordinate = 0.05,
                                             int inlierRelativePosesPerVertex = 6,
                                             int outlierRelativePosesPerVertex = 1,
-                                            int totalIterations = 20) {
+                                            int totalIterations = 20,
+                                            const gdr::RotationRobustOptimizerCreator::RobustParameterType &robustType =
+                                            gdr::RotationRobustOptimizerCreator::RobustParameterType::DEFAULT) {
 
     for (int iterations = 0; iterations < totalIterations; ++iterations) {
 
@@ -112,9 +117,9 @@ void testRotationRobustOptimizationTemplate(const std::string &absolutePosesFile
 
         ASSERT_EQ(orientationsAveraged.size(), absolutePosesGroundTruth.size());
 
-        gdr::RotationRobustOptimizerLogSO3 optimizerRobust;
+        auto optimizerRobust = gdr::RotationRobustOptimizerCreator::getRefiner(robustType);
         std::vector<gdr::SO3> absoluteRotations =
-                optimizerRobust.getOptimizedOrientation(orientationsAveraged, relativeRs, indexPoseFixed);
+                optimizerRobust->getOptimizedOrientation(orientationsAveraged, relativeRs, indexPoseFixed);
 
         ASSERT_EQ(absoluteRotations.size(), absolutePosesInfo.size());
 
@@ -141,6 +146,54 @@ TEST(testRotationAveraging, Poses19FromFileCorrespondencesPerVertexInliers3Outli
     testRotationRobustOptimizationTemplate("../../data/files/absolutePoses_19.txt");
 }
 
+TEST(testRotationAveraging, Poses19FromFileCorrespondencesPerVertexInliers3Outlier1L1IRLS) {
+
+    testRotationRobustOptimizationTemplate("../../data/files/absolutePoses_19.txt", 0.02, 0.05, 6, 1, 20,
+                                           gdr::RotationRobustOptimizerCreator::RobustParameterType::L1_IRLS);
+}
+
+TEST(testRotationAveraging, RelativeRotationAnalyticJacobiansMatchAutoDiff) {
+
+    ceres::EigenQuaternionParameterization quaternionParameterization;
+
+    for (int iteration = 0; iteration < 100; ++iteration) {
+        gdr::SO3 rotationFrom(gdr::SO3::getRandomUnitQuaternion());
+        gdr::SO3 rotationTo(gdr::SO3::getRandomUnitQuaternion());
+        gdr::SO3 relativeRotation(gdr::SO3::getRandomUnitQuaternion());
+
+        std::unique_ptr<ceres::CostFunction> costAutoDiff(gdr::RelativeRotationError::Create(relativeRotation));
+        std::unique_ptr<ceres::CostFunction> costAnalytic(
+                gdr::RelativeRotationErrorAnalytic::Create(relativeRotation));
+
+        Eigen::Quaterniond quaternionFrom = rotationFrom.getUnitQuaternion();
+        Eigen::Quaterniond quaternionTo = rotationTo.getUnitQuaternion();
+        const double *parameters[2] = {quaternionFrom.coeffs().data(), quaternionTo.coeffs().data()};
+
+        Eigen::Vector3d residualsAutoDiff;
+        Eigen::Vector3d residualsAnalytic;
+        Eigen::Matrix<double, 3, 4, Eigen::RowMajor> jacobiansAutoDiff[2];
+        Eigen::Matrix<double, 3, 4, Eigen::RowMajor> jacobiansAnalytic[2];
+        double *jacobiansAutoDiffRaw[2] = {jacobiansAutoDiff[0].data(), jacobiansAutoDiff[1].data()};
+        double *jacobiansAnalyticRaw[2] = {jacobiansAnalytic[0].data(), jacobiansAnalytic[1].data()};
+
+        ASSERT_TRUE(costAutoDiff->Evaluate(parameters, residualsAutoDiff.data(), jacobiansAutoDiffRaw));
+        ASSERT_TRUE(costAnalytic->Evaluate(parameters, residualsAnalytic.data(), jacobiansAnalyticRaw));
+
+        ASSERT_LE((residualsAutoDiff - residualsAnalytic).norm(), 1e-9);
+
+        // only Jacobians in tangent space are expected to be equal
+        for (int parameterBlock = 0; parameterBlock < 2; ++parameterBlock) {
+            Eigen::Matrix<double, 4, 3, Eigen::RowMajor> plusJacobian;
+            quaternionParameterization.ComputeJacobian(parameters[parameterBlock], plusJacobian.data());
+
+            Eigen::Matrix3d tangentAutoDiff = jacobiansAutoDiff[parameterBlock] * plusJacobian;
+            Eigen::Matrix3d tangentAnalytic = jacobiansAnalytic[parameterBlock] * plusJacobian;
+
+            ASSERT_LE((tangentAutoDiff - tangentAnalytic).norm(), 1e-6);
+        }
+    }
+}
+
 int main(int argc, char *argv[]) {
 
     ::testing::InitGoogleTest(&argc, argv);
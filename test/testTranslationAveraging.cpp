@@ -6,9 +6,15 @@
 #include <gtest/gtest.h>
 #include <vector>
 #include <random>
+#include <chrono>
+#include <set>
 
 #include "readerDataset/readerTUM/ReaderTum.h"
 #include "absolutePoseEstimation/translationAveraging/TranslationAverager.h"
+#include "absolutePoseEstimation/hierarchicalAveraging/HierarchicalAverager.h"
+#include "absolutePoseEstimation/hierarchicalAveraging/PoseGraphPartitioner.h"
+#include "absolutePoseEstimation/poseGraphOptimization/PoseGraphOptimizer.h"
+#include "poseGraph/graphAlgorithms/CycleConsistencyFilter.h"
 
 #include "readerDataset/readerTUM/Evaluator.h"
 
@@ -127,6 +133,461 @@ TEST(testTranslationAveraging, IRLS19PosesFromFileCorrespondencesPerVertex4SomeO
     ASSERT_LE(medianErrorIRL, medianErrorPCG);
 }
 
+TEST(testTranslationAveraging, NormalEquationsSolversMatchLeastSquaresCG19Poses) {
+
+    std::vector<gdr::PoseFullInfo> absolutePosesInfo = gdr::ReaderTUM::getPoseInfoTimeTranslationOrientation(
+            "../../data/files/absolutePoses_19.txt");
+    std::vector<gdr::SE3> absolutePosesGroundTruth;
+
+    for (const auto &poseGT: absolutePosesInfo) {
+        absolutePosesGroundTruth.emplace_back(gdr::SE3(poseGT.getSophusPose()));
+    }
+
+    std::mt19937 randomNumberGenerator(19);
+    std::normal_distribution<> noise(0.0, 0.01);
+    std::vector<gdr::TranslationMeasurement> relativeTs;
+
+    for (int indexFrom = 0; indexFrom < absolutePosesGroundTruth.size() - 1; ++indexFrom) {
+        int indexToMax = std::min(indexFrom + 4, static_cast<int>(absolutePosesGroundTruth.size()));
+
+        for (int indexTo = indexFrom + 1; indexTo < indexToMax; ++indexTo) {
+            Eigen::Vector3d translationNoise(noise(randomNumberGenerator),
+                                             noise(randomNumberGenerator),
+                                             noise(randomNumberGenerator));
+            relativeTs.emplace_back(gdr::TranslationMeasurement(
+                    (absolutePosesGroundTruth[indexFrom].inverse()
+                     * absolutePosesGroundTruth[indexTo]).getTranslation() + translationNoise,
+                    indexFrom,
+                    indexTo));
+        }
+    }
+
+    for (int indexPoseFixed = 0; indexPoseFixed < absolutePosesGroundTruth.size(); ++indexPoseFixed) {
+        using SolverType = gdr::TranslationAverager::TranslationSolverType;
+
+        gdr::Vectors3d translationsCG = gdr::TranslationAverager::recoverTranslations(
+                relativeTs, absolutePosesGroundTruth, indexPoseFixed, SolverType::LEAST_SQUARES_CG);
+        gdr::Vectors3d translationsCholesky = gdr::TranslationAverager::recoverTranslations(
+                relativeTs, absolutePosesGroundTruth, indexPoseFixed, SolverType::SPARSE_CHOLESKY);
+
+        gdr::Vectors3d translationsPCG = gdr::TranslationAverager::recoverTranslations(
+                relativeTs, absolutePosesGroundTruth, indexPoseFixed, SolverType::BLOCK_JACOBI_PCG);
+
+        ASSERT_LE((translationsCG.getVectorRaw() - translationsCholesky.getVectorRaw()).norm(), 1e-6);
+        ASSERT_LE((translationsPCG.getVectorRaw() - translationsCholesky.getVectorRaw()).norm(), 1e-6);
+
+        for (const auto &solverType: {SolverType::SPARSE_CHOLESKY, SolverType::BLOCK_JACOBI_PCG}) {
+            bool successIRLS = false;
+            std::vector<Eigen::Vector3d> translationsIRLS = gdr::TranslationAverager::recoverTranslationsIRLS(
+                    relativeTs, absolutePosesGroundTruth, translationsCholesky, indexPoseFixed, successIRLS,
+                    5, 1e-6, solverType).toVectorOfVectors();
+
+            ASSERT_TRUE(successIRLS);
+            ASSERT_LE(translationsIRLS[indexPoseFixed].norm(), std::numeric_limits<double>::epsilon());
+
+            double sumError = 0;
+            for (int j = 0; j < translationsIRLS.size(); ++j) {
+                Eigen::Vector3d translationGroundTruth = absolutePosesGroundTruth[j].getTranslation()
+                                                         - absolutePosesGroundTruth[indexPoseFixed].getTranslation();
+                sumError += (translationsIRLS[j] - translationGroundTruth).norm();
+            }
+
+            ASSERT_LE(sumError / translationsIRLS.size(), 0.05);
+        }
+    }
+}
+
+TEST(testTranslationAveraging, QualityWeightedInitialSolution19PosesSomeOutliers) {
+
+    std::vector<gdr::PoseFullInfo> absolutePosesInfo = gdr::ReaderTUM::getPoseInfoTimeTranslationOrientation(
+            "../../data/files/absolutePoses_19.txt");
+    std::vector<gdr::SE3> absolutePosesGroundTruth;
+
+    for (const auto &poseGT: absolutePosesInfo) {
+        absolutePosesGroundTruth.emplace_back(gdr::SE3(poseGT.getSophusPose()));
+    }
+
+    std::mt19937 randomNumberGenerator(19);
+    std::normal_distribution<> noise(0.0, 0.005);
+    std::uniform_real_distribution<> outlierCoordinate(-0.2, 0.2);
+
+    // the same measurements with and without pairwise estimation statistics
+    std::vector<gdr::TranslationMeasurement> relativeTsWithQuality;
+    std::vector<gdr::TranslationMeasurement> relativeTsWithoutQuality;
+
+    gdr::RelativePoseQuality qualityInlier(100, 0.005, true);
+    gdr::RelativePoseQuality qualityOutlier(15, 0.02, false);
+
+    for (int indexFrom = 0; indexFrom < absolutePosesGroundTruth.size() - 1; ++indexFrom) {
+        for (int indexTo = indexFrom + 1; indexTo < absolutePosesGroundTruth.size(); ++indexTo) {
+            if (indexTo <= indexFrom + 3) {
+                Eigen::Vector3d relativeT = (absolutePosesGroundTruth[indexFrom].inverse()
+                                             * absolutePosesGroundTruth[indexTo]).getTranslation()
+                                            + Eigen::Vector3d(noise(randomNumberGenerator),
+                                                              noise(randomNumberGenerator),
+                                                              noise(randomNumberGenerator));
+                relativeTsWithQuality.emplace_back(
+                        gdr::TranslationMeasurement(relativeT, indexFrom, indexTo, qualityInlier));
+                relativeTsWithoutQuality.emplace_back(gdr::TranslationMeasurement(relativeT, indexFrom, indexTo));
+            }
+
+            if (indexTo == indexFrom + 4) {
+                Eigen::Vector3d outlierT(outlierCoordinate(randomNumberGenerator),
+                                         outlierCoordinate(randomNumberGenerator),
+                                         outlierCoordinate(randomNumberGenerator));
+                relativeTsWithQuality.emplace_back(
+                        gdr::TranslationMeasurement(outlierT, indexFrom, indexTo, qualityOutlier));
+                relativeTsWithoutQuality.emplace_back(gdr::TranslationMeasurement(outlierT, indexFrom, indexTo));
+            }
+        }
+    }
+
+    auto getMeanError = [&absolutePosesGroundTruth](const std::vector<Eigen::Vector3d> &translations,
+                                                    int indexPoseFixed) {
+        double sumError = 0;
+        for (int j = 0; j < translations.size(); ++j) {
+            sumError += (translations[j] - absolutePosesGroundTruth[j].getTranslation()
+                         + absolutePosesGroundTruth[indexPoseFixed].getTranslation()).norm();
+        }
+        return sumError / translations.size();
+    };
+
+    for (int indexPoseFixed = 0; indexPoseFixed < absolutePosesGroundTruth.size(); ++indexPoseFixed) {
+        gdr::Vectors3d translationsWithQuality = gdr::TranslationAverager::recoverTranslations(
+                relativeTsWithQuality, absolutePosesGroundTruth, indexPoseFixed);
+        gdr::Vectors3d translationsWithoutQuality = gdr::TranslationAverager::recoverTranslations(
+                relativeTsWithoutQuality, absolutePosesGroundTruth, indexPoseFixed);
+
+        double errorWithQuality = getMeanError(translationsWithQuality.toVectorOfVectors(), indexPoseFixed);
+        double errorWithoutQuality = getMeanError(translationsWithoutQuality.toVectorOfVectors(), indexPoseFixed);
+
+        ASSERT_LE(errorWithQuality, 0.02);
+        ASSERT_LE(errorWithQuality, errorWithoutQuality);
+
+        // single IRLS iteration is enough when initial solution is weighted
+        bool successIRLS = false;
+        std::vector<Eigen::Vector3d> translationsIRLS = gdr::TranslationAverager::recoverTranslationsIRLS(
+                relativeTsWithQuality, absolutePosesGroundTruth, translationsWithQuality, indexPoseFixed,
+                successIRLS, 1).toVectorOfVectors();
+
+        ASSERT_TRUE(successIRLS);
+        ASSERT_LE(getMeanError(translationsIRLS, indexPoseFixed), 0.02);
+    }
+}
+
+TEST(testTranslationAveraging, PoseGraphOptimization19PosesFromFileSomeOutliers) {
+
+    std::vector<gdr::PoseFullInfo> absolutePosesInfo = gdr::ReaderTUM::getPoseInfoTimeTranslationOrientation(
+            "../../data/files/absolutePoses_19.txt");
+    std::vector<gdr::SE3> absolutePosesGroundTruth;
+
+    for (const auto &poseGT: absolutePosesInfo) {
+        absolutePosesGroundTruth.emplace_back(gdr::SE3(poseGT.getSophusPose()));
+    }
+
+    int indexPoseFixed = 0;
+    std::mt19937 randomNumberGenerator(49);
+    std::normal_distribution<> noiseTranslation(0.0, 0.005);
+    std::normal_distribution<> noiseRotation(0.0, 0.002);
+    std::normal_distribution<> perturbationTranslation(0.0, 0.05);
+    std::normal_distribution<> perturbationRotation(0.0, 0.03);
+
+    auto getNoisySE3 = [&randomNumberGenerator](const Sophus::SE3d &pose,
+                                                std::normal_distribution<> &rotationDeviation,
+                                                std::normal_distribution<> &translationDeviation) {
+        Sophus::SE3d::Tangent noise;
+        noise << translationDeviation(randomNumberGenerator),
+                translationDeviation(randomNumberGenerator),
+                translationDeviation(randomNumberGenerator),
+                rotationDeviation(randomNumberGenerator),
+                rotationDeviation(randomNumberGenerator),
+                rotationDeviation(randomNumberGenerator);
+        return gdr::SE3(pose * Sophus::SE3d::exp(noise));
+    };
+
+    gdr::RelativePoseQuality qualityInlier(100, 0.005, true);
+    gdr::RelativePoseQuality qualityOutlier(15, 0.02, false);
+    std::vector<gdr::RelativeSE3> relativePoses;
+
+    for (int indexFrom = 0; indexFrom < absolutePosesGroundTruth.size() - 1; ++indexFrom) {
+        for (int indexTo = indexFrom + 1; indexTo < absolutePosesGroundTruth.size(); ++indexTo) {
+            Sophus::SE3d relativePoseGroundTruth = absolutePosesGroundTruth[indexFrom].getSE3().inverse()
+                                                   * absolutePosesGroundTruth[indexTo].getSE3();
+
+            if (indexTo <= indexFrom + 3) {
+                relativePoses.emplace_back(gdr::RelativeSE3(indexFrom, indexTo,
+                                                            getNoisySE3(relativePoseGroundTruth,
+                                                                        noiseRotation,
+                                                                        noiseTranslation),
+                                                            qualityInlier));
+            }
+
+            if (indexTo == indexFrom + 4) {
+                relativePoses.emplace_back(gdr::RelativeSE3(indexFrom, indexTo,
+                                                            gdr::SE3::getRandomSE3(0.2),
+                                                            qualityOutlier));
+            }
+        }
+    }
+
+    std::vector<gdr::SE3> posesInitial;
+
+    for (int poseIndex = 0; poseIndex < absolutePosesGroundTruth.size(); ++poseIndex) {
+        posesInitial.emplace_back(poseIndex == indexPoseFixed ?
+                                  absolutePosesGroundTruth[poseIndex] :
+                                  getNoisySE3(absolutePosesGroundTruth[poseIndex].getSE3(),
+                                              perturbationRotation,
+                                              perturbationTranslation));
+    }
+
+    auto getMeanErrors = [&absolutePosesGroundTruth](const std::vector<gdr::SE3> &poses) {
+        double sumErrorTranslation = 0;
+        double sumErrorRotation = 0;
+        for (int j = 0; j < poses.size(); ++j) {
+            sumErrorTranslation += (poses[j].getTranslation()
+                                    - absolutePosesGroundTruth[j].getTranslation()).norm();
+            sumErrorRotation += (poses[j].getSO3().inverse()
+                                 * absolutePosesGroundTruth[j].getSO3()).log().norm();
+        }
+        return std::make_pair(sumErrorTranslation / poses.size(), sumErrorRotation / poses.size());
+    };
+
+    gdr::PoseGraphOptimizer poseGraphOptimizer;
+    bool success = false;
+    std::vector<gdr::SE3> posesOptimized = poseGraphOptimizer.getOptimizedPoses(posesInitial,
+                                                                               relativePoses,
+                                                                               indexPoseFixed,
+                                                                               success);
+    ASSERT_TRUE(success);
+    ASSERT_EQ(posesOptimized.size(), posesInitial.size());
+
+    auto errorsInitial = getMeanErrors(posesInitial);
+    auto errorsOptimized = getMeanErrors(posesOptimized);
+
+    std::cout << "mean errors [translation, rotation] before: " << errorsInitial.first << ", "
+              << errorsInitial.second << " after: " << errorsOptimized.first << ", "
+              << errorsOptimized.second << std::endl;
+    std::cout << poseGraphOptimizer.getSolverInfo() << std::endl;
+
+    ASSERT_LE(errorsOptimized.first, 0.02);
+    ASSERT_LE(errorsOptimized.second, 0.01);
+    ASSERT_LE((posesOptimized[indexPoseFixed].getTranslation()
+               - absolutePosesGroundTruth[indexPoseFixed].getTranslation()).norm(),
+              std::numeric_limits<double>::epsilon());
+}
+
+TEST(testTranslationAveraging, CycleConsistencyFilterSyntheticGraph2000PosesSomeOutliers) {
+
+    int numberOfPoses = 2000;
+    double outlierProbability = 0.1;
+
+    std::mt19937 randomNumberGenerator(numberOfPoses);
+    std::normal_distribution<> noise(0.0, 0.005);
+    std::uniform_real_distribution<> uniform(0.0, 1.0);
+
+    std::vector<gdr::SE3> absolutePosesGroundTruth;
+    for (int i = 0; i < numberOfPoses; ++i) {
+        absolutePosesGroundTruth.emplace_back(gdr::SE3::getRandomSE3(1.0));
+    }
+
+    std::vector<std::pair<int, int>> edges;
+    std::vector<gdr::SE3> relativePoses;
+    std::set<int> outlierEdges;
+
+    for (int indexFrom = 0; indexFrom < numberOfPoses; ++indexFrom) {
+        for (int indexTo = indexFrom + 1; indexTo < std::min(numberOfPoses, indexFrom + 5); ++indexTo) {
+            gdr::SE3 relativePose = absolutePosesGroundTruth[indexFrom].inverse() * absolutePosesGroundTruth[indexTo];
+            Eigen::Quaterniond rotationNoise(Eigen::AngleAxisd(noise(randomNumberGenerator),
+                                                               Eigen::Vector3d::UnitX()));
+            Eigen::Vector3d translationNoise(noise(randomNumberGenerator),
+                                             noise(randomNumberGenerator),
+                                             noise(randomNumberGenerator));
+
+            if (uniform(randomNumberGenerator) < outlierProbability) {
+                outlierEdges.insert(edges.size());
+                relativePose = gdr::SE3::getRandomSE3(1.0);
+            }
+
+            edges.emplace_back(std::make_pair(indexFrom, indexTo));
+            relativePoses.emplace_back(gdr::SE3(relativePose.getRotationQuatd() * rotationNoise,
+                                                relativePose.getTranslation() + translationNoise));
+        }
+    }
+
+    auto timeStartFiltering = std::chrono::high_resolution_clock::now();
+    std::vector<int> edgesToRemove = gdr::CycleConsistencyFilter::getInconsistentEdges(numberOfPoses,
+                                                                                       edges,
+                                                                                       relativePoses);
+    auto timeEndFiltering = std::chrono::high_resolution_clock::now();
+
+    int numberOfOutliersRemoved = 0;
+    for (int edgeIndex: edgesToRemove) {
+        numberOfOutliersRemoved += static_cast<int>(outlierEdges.count(edgeIndex));
+    }
+
+    std::cout << "edges: " << edges.size() << ", outliers: " << outlierEdges.size()
+              << ", removed: " << edgesToRemove.size() << " (" << numberOfOutliersRemoved << " outliers) in "
+              << std::chrono::duration<double>(timeEndFiltering - timeStartFiltering).count() << " s" << std::endl;
+
+    ASSERT_GE(numberOfOutliersRemoved, 0.95 * outlierEdges.size());
+    ASSERT_GE(numberOfOutliersRemoved, 0.9 * edgesToRemove.size());
+
+    // translation threshold is relative to median edge length so scaled scene gives the same edges
+    std::vector<gdr::SE3> relativePosesScaled;
+    for (const auto &relativePose: relativePoses) {
+        relativePosesScaled.emplace_back(gdr::SE3(relativePose.getRotationQuatd(),
+                                                  100.0 * relativePose.getTranslation()));
+    }
+    ASSERT_EQ(gdr::CycleConsistencyFilter::getInconsistentEdges(numberOfPoses, edges, relativePosesScaled),
+              edgesToRemove);
+
+    std::vector<gdr::TranslationMeasurement> relativeTsAll;
+    std::vector<gdr::TranslationMeasurement> relativeTsFiltered;
+    std::set<int> edgesRemoved(edgesToRemove.begin(), edgesToRemove.end());
+
+    for (int edgeIndex = 0; edgeIndex < edges.size(); ++edgeIndex) {
+        gdr::TranslationMeasurement relativeT(relativePoses[edgeIndex].getTranslation(),
+                                              edges[edgeIndex].first,
+                                              edges[edgeIndex].second);
+        relativeTsAll.emplace_back(relativeT);
+
+        if (edgesRemoved.find(edgeIndex) == edgesRemoved.end()) {
+            relativeTsFiltered.emplace_back(relativeT);
+        }
+    }
+
+    int indexPoseFixed = 0;
+
+    auto getMeanError = [&](const std::vector<gdr::TranslationMeasurement> &relativeTs, double &timeSeconds) {
+        auto timeStart = std::chrono::high_resolution_clock::now();
+        gdr::Vectors3d translationsL2 = gdr::TranslationAverager::recoverTranslations(
+                relativeTs, absolutePosesGroundTruth, indexPoseFixed);
+        bool successIRLS = false;
+        std::vector<Eigen::Vector3d> translationsIRLS = gdr::TranslationAverager::recoverTranslationsIRLS(
+                relativeTs, absolutePosesGroundTruth, translationsL2, indexPoseFixed,
+                successIRLS).toVectorOfVectors();
+        timeSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - timeStart).count();
+
+        double sumError = 0;
+        for (int j = 0; j < translationsIRLS.size(); ++j) {
+            sumError += (translationsIRLS[j] - absolutePosesGroundTruth[j].getTranslation()
+                         + absolutePosesGroundTruth[indexPoseFixed].getTranslation()).norm();
+        }
+        return sumError / translationsIRLS.size();
+    };
+
+    double timeAll = 0;
+    double timeFiltered = 0;
+    double errorAll = getMeanError(relativeTsAll, timeAll);
+    double errorFiltered = getMeanError(relativeTsFiltered, timeFiltered);
+
+    std::cout << "translation averaging without filtering: " << timeAll << " s, mean error " << errorAll
+              << std::endl;
+    std::cout << "translation averaging after filtering: " << timeFiltered << " s, mean error " << errorFiltered
+              << ", time saved " << timeAll - timeFiltered << " s" << std::endl;
+
+    ASSERT_LE(errorFiltered, 0.5 * errorAll);
+}
+
+TEST(testTranslationAveraging, HierarchicalIRLSSyntheticGraph2000PosesClusters250SomeOutliers) {
+
+    int numberOfPoses = 2000;
+    int maxPosesPerCluster = 250;
+    double outlierProbability = 0.05;
+
+    std::mt19937 randomNumberGenerator(numberOfPoses);
+    std::normal_distribution<> noise(0.0, 0.005);
+    std::uniform_real_distribution<> uniform(0.0, 1.0);
+    std::uniform_int_distribution<> randomPose(0, numberOfPoses - 1);
+
+    std::vector<gdr::SE3> absolutePosesGroundTruth;
+    for (int i = 0; i < numberOfPoses; ++i) {
+        absolutePosesGroundTruth.emplace_back(gdr::SE3::getRandomSE3(1.0));
+    }
+
+    std::vector<gdr::TranslationMeasurement> relativeTs;
+    std::vector<std::pair<int, int>> edges;
+
+    auto addMeasurement = [&](int indexFrom, int indexTo) {
+        gdr::SE3 relativePose = absolutePosesGroundTruth[indexFrom].inverse() * absolutePosesGroundTruth[indexTo];
+        Eigen::Vector3d relativeTranslation = relativePose.getTranslation()
+                                              + Eigen::Vector3d(noise(randomNumberGenerator),
+                                                                noise(randomNumberGenerator),
+                                                                noise(randomNumberGenerator));
+
+        if (uniform(randomNumberGenerator) < outlierProbability) {
+            relativeTranslation = gdr::SE3::getRandomSE3(1.0).getTranslation();
+        }
+
+        relativeTs.emplace_back(gdr::TranslationMeasurement(relativeTranslation, indexFrom, indexTo));
+        edges.emplace_back(std::make_pair(indexFrom, indexTo));
+    };
+
+    for (int indexFrom = 0; indexFrom < numberOfPoses; ++indexFrom) {
+        for (int indexTo = indexFrom + 1; indexTo < std::min(numberOfPoses, indexFrom + 5); ++indexTo) {
+            addMeasurement(indexFrom, indexTo);
+        }
+    }
+    for (int i = 0; i < numberOfPoses; ++i) {
+        int indexFirst = randomPose(randomNumberGenerator);
+        int indexSecond = randomPose(randomNumberGenerator);
+
+        if (indexFirst != indexSecond) {
+            addMeasurement(std::min(indexFirst, indexSecond), std::max(indexFirst, indexSecond));
+        }
+    }
+
+    int indexPoseFixed = numberOfPoses / 3;
+
+    auto getMeanError = [&](const std::vector<Eigen::Vector3d> &translations) {
+        double sumError = 0;
+        for (int j = 0; j < translations.size(); ++j) {
+            sumError += (translations[j] - absolutePosesGroundTruth[j].getTranslation()
+                         + absolutePosesGroundTruth[indexPoseFixed].getTranslation()).norm();
+        }
+        return sumError / translations.size();
+    };
+
+    auto timeStartFlat = std::chrono::high_resolution_clock::now();
+    gdr::Vectors3d translationsL2 = gdr::TranslationAverager::recoverTranslations(
+            relativeTs, absolutePosesGroundTruth, indexPoseFixed);
+    bool successIRLS = false;
+    std::vector<Eigen::Vector3d> translationsFlat = gdr::TranslationAverager::recoverTranslationsIRLS(
+            relativeTs, absolutePosesGroundTruth, translationsL2, indexPoseFixed,
+            successIRLS).toVectorOfVectors();
+    auto timeEndFlat = std::chrono::high_resolution_clock::now();
+
+    auto timeStartHierarchical = std::chrono::high_resolution_clock::now();
+    std::vector<int> clusterByPose = gdr::PoseGraphPartitioner::partition(numberOfPoses,
+                                                                          edges,
+                                                                          std::vector<int>(edges.size(), 1),
+                                                                          maxPosesPerCluster);
+    std::vector<Eigen::Vector3d> translationsHierarchical = gdr::HierarchicalAverager::averageTranslations(
+            relativeTs, absolutePosesGroundTruth, indexPoseFixed, clusterByPose);
+    auto timeEndHierarchical = std::chrono::high_resolution_clock::now();
+
+    ASSERT_TRUE(successIRLS);
+    ASSERT_EQ(translationsFlat.size(), numberOfPoses);
+    ASSERT_EQ(translationsHierarchical.size(), numberOfPoses);
+    ASSERT_GT(gdr::PoseGraphPartitioner::getPosesByCluster(clusterByPose).size(), 1);
+    ASSERT_LE(translationsHierarchical[indexPoseFixed].norm(), std::numeric_limits<double>::epsilon());
+
+    double errorFlat = getMeanError(translationsFlat);
+    double errorHierarchical = getMeanError(translationsHierarchical);
+
+    std::cout << "poses: " << numberOfPoses << ", measurements: " << relativeTs.size()
+              << ", flat IRLS: " << std::chrono::duration<double>(timeEndFlat - timeStartFlat).count()
+              << " s, mean error " << errorFlat
+              << ", hierarchical: "
+              << std::chrono::duration<double>(timeEndHierarchical - timeStartHierarchical).count()
+              << " s, mean error " << errorHierarchical << std::endl;
+
+    // cluster offsets are aligned without refining poses inside clusters, so some accuracy is traded for time
+    ASSERT_LE(errorFlat, 0.02);
+    ASSERT_LE(errorHierarchical, 0.04);
+    ASSERT_LE(errorHierarchical, 3.0 * errorFlat);
+}
+
 int main(int argc, char *argv[]) {
 
     ::testing::InitGoogleTest(&argc, argv);